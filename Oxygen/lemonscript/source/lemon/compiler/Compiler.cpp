@@ -13,6 +13,7 @@
 #include "lemon/compiler/frontend/CompilerFrontend.h"
 #include "lemon/program/Module.h"
 #include "lemon/translator/Translator.h"
+#include "lemon/utility/WorkStealingPool.h"
 
 
 namespace lemon
@@ -317,12 +318,15 @@ namespace lemon
 	void Compiler::runCompilerBackend(std::vector<FunctionNode*>& functionNodes)
 	{
 		// Backend part: Compile function contents into opcodes
-		for (FunctionNode* node : functionNodes)
+		//  -> Each function only writes to its own opcodes, so this can be done on multiple threads
+		//  -> In case of errors, the one of the first function in order gets thrown, just like when compiling serially
+		WorkStealingPool::runParallel(functionNodes.size(), [&](size_t index)
 		{
-			FunctionCompiler functionCompiler(*node->mFunction, mCompileOptions, mGlobalsLookup);
+			FunctionNode& node = *functionNodes[index];
+			FunctionCompiler functionCompiler(*node.mFunction, mCompileOptions, mGlobalsLookup);
 			functionCompiler.processParameters();
-			functionCompiler.buildOpcodesForFunction(*node->mContent);
-		}
+			functionCompiler.buildOpcodesForFunction(*node.mContent);
+		});
 
 	#if 0
 		// Just for debugging: Build compiled hash
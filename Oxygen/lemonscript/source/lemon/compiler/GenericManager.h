@@ -9,6 +9,7 @@
 #pragma once
 
 #include <rmxbase.h>
+#include <mutex>
 
 
 namespace genericmanager
@@ -177,6 +178,7 @@ namespace genericmanager
 
 
 	// Element manager base class
+	//  -> Creation and destruction of elements are thread-safe, as the parser runs on multiple threads
 	template<class ELEMENT>
 	class Manager
 	{
@@ -189,12 +191,14 @@ namespace genericmanager
 		template<typename TYPE>
 		static TYPE& create()
 		{
+			std::lock_guard<std::recursive_mutex> lock(mMutex);
 			detail::ElementFactoryBase<ELEMENT>& factory = mFactoryMap.template getOrCreateElementFactory<TYPE>();
 			return static_cast<TYPE&>(factory.create());
 		}
 
 		static void shrinkAllPools()
 		{
+			std::lock_guard<std::recursive_mutex> lock(mMutex);
 			mFactoryMap.shrinkAllPools();
 		}
 
@@ -202,12 +206,14 @@ namespace genericmanager
 		static void destroy(Element<ELEMENT>& element)
 		{
 			RMX_ASSERT(element.getReferenceCounter() == 0, "Element still has references");
+			std::lock_guard<std::recursive_mutex> lock(mMutex);
 			detail::ElementFactoryBase<ELEMENT>& factory = mFactoryMap.getElementFactory(element.getType());
 			factory.destroy(static_cast<ELEMENT&>(element));
 		}
 
 	private:
 		static inline detail::ElementFactoryMap<ELEMENT> mFactoryMap;
+		static inline std::recursive_mutex mMutex;		// Recursive, as destroying an element can lead to destruction of its child elements
 	};
 
 
@@ -949,7 +949,7 @@ namespace lemon
 			anotherRun = false;
 
 			// Build up a list of jump targets
-			static std::vector<bool> isOpcodeJumpTarget;
+			thread_local std::vector<bool> isOpcodeJumpTarget;
 			{
 				isOpcodeJumpTarget.clear();
 				isOpcodeJumpTarget.resize(mOpcodes.size(), false);
@@ -1139,7 +1139,7 @@ namespace lemon
 				mOpcodes[i].mFlags.set(Opcode::Flag::TEMP_FLAG);
 			}
 
-			static std::vector<size_t> openSeeds;
+			thread_local std::vector<size_t> openSeeds;
 			openSeeds.clear();
 			openSeeds.push_back(0);
 			for (const ScriptFunction::Label& label : mFunction.mLabels)
@@ -1232,7 +1232,7 @@ namespace lemon
 	void FunctionCompiler::cleanupNOPs()
 	{
 		// Remove all NOPs and update all jump targets etc. appropriately
-		static std::vector<int> indexRemap;
+		thread_local std::vector<int> indexRemap;
 		indexRemap.clear();
 		indexRemap.resize(mOpcodes.size());
 		size_t newSize = 0;
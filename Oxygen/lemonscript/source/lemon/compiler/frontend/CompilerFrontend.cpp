@@ -17,6 +17,7 @@
 #include "lemon/compiler/parser/ParserTokens.h"
 #include "lemon/program/GlobalsLookup.h"
 #include "lemon/program/Module.h"
+#include "lemon/utility/WorkStealingPool.h"
 
 
 namespace lemon
@@ -144,141 +145,170 @@ namespace lemon
 	void CompilerFrontend::buildNodesFromCodeLines(BlockNode& rootNode, const std::vector<std::string_view>& lines)
 	{
 		// Parse text lines and build blocks hierarchy
-		Parser parser;
-		ParserTokenList parserTokens;
+		//  -> Parsing of text lines does not depend on other lines, so it's done in batches of lines distributed over multiple threads
+		//  -> Building the hierarchy from the parsed lines stays serial, so the output does not differ from a serial run in any way
+		const constexpr size_t LINES_PER_BATCH = 0x2000;
+		const constexpr size_t LINES_PER_TASK = 0x80;
+		std::vector<ParserTokenList> batchParserTokens(std::min(lines.size(), LINES_PER_BATCH));
+		std::vector<std::exception_ptr> batchParserErrors(batchParserTokens.size());
 
 		std::vector<BlockNode*> blockStack = { &rootNode };
 		uint32 lineNumber = 0;
 
-		for (const std::string_view line : lines)
+		for (size_t batchStart = 0; batchStart < lines.size(); batchStart += LINES_PER_BATCH)
 		{
-			++lineNumber;	// First line will have number 1
-
-			// Parse text line
-			parserTokens.clear();
-			parser.splitLineIntoTokens(line, lineNumber, parserTokens);
-			if (parserTokens.empty())
-				continue;
-
-			// Check for block begin and end
-			bool isUndefined = true;
-			if (parserTokens[0].isA<KeywordParserToken>())
+			// Parse text lines of this batch
+			const size_t batchSize = std::min(lines.size() - batchStart, LINES_PER_BATCH);
+			WorkStealingPool::runParallel((batchSize + LINES_PER_TASK - 1) / LINES_PER_TASK, [&](size_t taskIndex)
 			{
-				const Keyword keyword = parserTokens[0].as<KeywordParserToken>().mKeyword;
-				switch (keyword)
+				Parser parser;
+				const size_t endIndex = std::min((taskIndex + 1) * LINES_PER_TASK, batchSize);
+				for (size_t index = taskIndex * LINES_PER_TASK; index < endIndex; ++index)
 				{
-					case Keyword::BLOCK_BEGIN:
+					batchParserTokens[index].clear();
+					batchParserErrors[index] = nullptr;
+					try
 					{
-						CHECK_ERROR(parserTokens.size() == 1, "Curly brace must use its own line", lineNumber);
-
-						// Start new block
-						BlockNode& node = addNode<BlockNode>(blockStack, lineNumber);
-						blockStack.push_back(&node);
-
-						isUndefined = false;
-						break;
+						parser.splitLineIntoTokens(lines[batchStart + index], (uint32)(batchStart + index + 1), batchParserTokens[index]);
 					}
-
-					case Keyword::BLOCK_END:
+					catch (...)
 					{
-						CHECK_ERROR(parserTokens.size() == 1, "Curly brace must use its own line", lineNumber);
-
-						// Close block
-						blockStack.pop_back();
-
-						CHECK_ERROR(!blockStack.empty(), "Closed too many blocks", lineNumber);
-
-						isUndefined = false;
-						break;
+						// Rethrow only when getting to this line below, so that errors in earlier lines get reported first
+						batchParserErrors[index] = std::current_exception();
 					}
-
-					default:
-						break;
 				}
-			}
+			});
 
-			// Check for pragma
-			if (parserTokens[0].isA<PragmaParserToken>())
+			for (size_t index = 0; index < batchSize; ++index)
 			{
-				std::string& content = parserTokens[0].as<PragmaParserToken>().mContent;
-				if (!processGlobalPragma(content))
-				{
-					PragmaNode& node = addNode<PragmaNode>(blockStack, lineNumber);
-					node.mContent.swap(content);
-				}
-				isUndefined = false;
-			}
+				++lineNumber;	// First line will have number 1
+				if (nullptr != batchParserErrors[index])
+					std::rethrow_exception(batchParserErrors[index]);
 
-			if (isUndefined)
-			{
-				// Add undefined node containing the token list, translated from parser token to (compiler) tokens
-				UndefinedNode& node = addNode<UndefinedNode>(blockStack, lineNumber);
-				node.mTokenList.reserve(parserTokens.size());
-				for (size_t i = 0; i < parserTokens.size(); ++i)
+				ParserTokenList& parserTokens = batchParserTokens[index];
+				if (parserTokens.empty())
+					continue;
+
+				// Check for block begin and end
+				bool isUndefined = true;
+				if (parserTokens[0].isA<KeywordParserToken>())
 				{
-					ParserToken& parserToken = parserTokens[i];
-					switch (parserToken.getType())
+					const Keyword keyword = parserTokens[0].as<KeywordParserToken>().mKeyword;
+					switch (keyword)
 					{
-						case ParserToken::Type::KEYWORD:
+						case Keyword::BLOCK_BEGIN:
 						{
-							node.mTokenList.createBack<KeywordToken>().mKeyword = parserToken.as<KeywordParserToken>().mKeyword;
-							break;
-						}
+							CHECK_ERROR(parserTokens.size() == 1, "Curly brace must use its own line", lineNumber);
 
-						case ParserToken::Type::VARTYPE:
-						{
-							node.mTokenList.createBack<VarTypeToken>().mDataType = parserToken.as<VarTypeParserToken>().mDataType;
-							break;
-						}
+							// Start new block
+							BlockNode& node = addNode<BlockNode>(blockStack, lineNumber);
+							blockStack.push_back(&node);
 
-						case ParserToken::Type::OPERATOR:
-						{
-							node.mTokenList.createBack<OperatorToken>().mOperator = parserToken.as<OperatorParserToken>().mOperator;
+							isUndefined = false;
 							break;
 						}
 
-						case ParserToken::Type::LABEL:
+						case Keyword::BLOCK_END:
 						{
-							node.mTokenList.createBack<LabelToken>().mName = parserToken.as<LabelParserToken>().mName;
-							break;
-						}
+							CHECK_ERROR(parserTokens.size() == 1, "Curly brace must use its own line", lineNumber);
 
-						case ParserToken::Type::PRAGMA:
-						{
-							// Just ignore this one
+							// Close block
+							blockStack.pop_back();
+
+							CHECK_ERROR(!blockStack.empty(), "Closed too many blocks", lineNumber);
+
+							isUndefined = false;
 							break;
 						}
 
-						case ParserToken::Type::CONSTANT:
-						{
-							const ConstantParserToken& input = parserToken.as<ConstantParserToken>();
-							ConstantToken& constantToken = node.mTokenList.createBack<ConstantToken>();
-							constantToken.mValue = input.mValue;
-							constantToken.mDataType = (input.mBaseType == BaseType::FLOAT)  ? static_cast<const DataTypeDefinition*>(&PredefinedDataTypes::FLOAT) :
-													  (input.mBaseType == BaseType::DOUBLE) ? static_cast<const DataTypeDefinition*>(&PredefinedDataTypes::DOUBLE) : static_cast<const DataTypeDefinition*>(&PredefinedDataTypes::CONST_INT);
+						default:
 							break;
-						}
+					}
+				}
+
+				// Check for pragma
+				if (parserTokens[0].isA<PragmaParserToken>())
+				{
+					std::string& content = parserTokens[0].as<PragmaParserToken>().mContent;
+					if (!processGlobalPragma(content))
+					{
+						PragmaNode& node = addNode<PragmaNode>(blockStack, lineNumber);
+						node.mContent.swap(content);
+					}
+					isUndefined = false;
+				}
 
-						case ParserToken::Type::STRING_LITERAL:
+				if (isUndefined)
+				{
+					// Add undefined node containing the token list, translated from parser token to (compiler) tokens
+					UndefinedNode& node = addNode<UndefinedNode>(blockStack, lineNumber);
+					node.mTokenList.reserve(parserTokens.size());
+					for (size_t i = 0; i < parserTokens.size(); ++i)
+					{
+						ParserToken& parserToken = parserTokens[i];
+						switch (parserToken.getType())
 						{
-							const FlyweightString str = parserToken.as<StringLiteralParserToken>().mString;
-							const FlyweightString* existingString = mGlobalsLookup.getStringLiteralByHash(str.getHash());
-							if (nullptr == existingString)
+							case ParserToken::Type::KEYWORD:
 							{
-								// Add as a new string literal to the module
-								mModule.addStringLiteral(str);
+								node.mTokenList.createBack<KeywordToken>().mKeyword = parserToken.as<KeywordParserToken>().mKeyword;
+								break;
 							}
-							ConstantToken& constantToken = node.mTokenList.createBack<ConstantToken>();
-							constantToken.mValue.set(str.getHash());
-							constantToken.mDataType = &PredefinedDataTypes::STRING;
-							break;
-						}
 
-						case ParserToken::Type::IDENTIFIER:
-						{
-							IdentifierToken& token = node.mTokenList.createBack<IdentifierToken>();
-							token.mName = parserToken.as<IdentifierParserToken>().mName;
-							break;
+							case ParserToken::Type::VARTYPE:
+							{
+								node.mTokenList.createBack<VarTypeToken>().mDataType = parserToken.as<VarTypeParserToken>().mDataType;
+								break;
+							}
+
+							case ParserToken::Type::OPERATOR:
+							{
+								node.mTokenList.createBack<OperatorToken>().mOperator = parserToken.as<OperatorParserToken>().mOperator;
+								break;
+							}
+
+							case ParserToken::Type::LABEL:
+							{
+								node.mTokenList.createBack<LabelToken>().mName = parserToken.as<LabelParserToken>().mName;
+								break;
+							}
+
+							case ParserToken::Type::PRAGMA:
+							{
+								// Just ignore this one
+								break;
+							}
+
+							case ParserToken::Type::CONSTANT:
+							{
+								const ConstantParserToken& input = parserToken.as<ConstantParserToken>();
+								ConstantToken& constantToken = node.mTokenList.createBack<ConstantToken>();
+								constantToken.mValue = input.mValue;
+								constantToken.mDataType = (input.mBaseType == BaseType::FLOAT)  ? static_cast<const DataTypeDefinition*>(&PredefinedDataTypes::FLOAT) :
+														  (input.mBaseType == BaseType::DOUBLE) ? static_cast<const DataTypeDefinition*>(&PredefinedDataTypes::DOUBLE) : static_cast<const DataTypeDefinition*>(&PredefinedDataTypes::CONST_INT);
+								break;
+							}
+
+							case ParserToken::Type::STRING_LITERAL:
+							{
+								const FlyweightString str = parserToken.as<StringLiteralParserToken>().mString;
+								const FlyweightString* existingString = mGlobalsLookup.getStringLiteralByHash(str.getHash());
+								if (nullptr == existingString)
+								{
+									// Add as a new string literal to the module
+									mModule.addStringLiteral(str);
+								}
+								ConstantToken& constantToken = node.mTokenList.createBack<ConstantToken>();
+								constantToken.mValue.set(str.getHash());
+								constantToken.mDataType = &PredefinedDataTypes::STRING;
+								break;
+							}
+
+							case ParserToken::Type::IDENTIFIER:
+							{
+								IdentifierToken& token = node.mTokenList.createBack<IdentifierToken>();
+								token.mName = parserToken.as<IdentifierParserToken>().mName;
+								break;
+							}
 						}
 					}
 				}
@@ -78,7 +78,15 @@ namespace lemon
 			"ref",
 			"typeof",
 		};
-		static std::map<uint64, std::string> reservedKeywordLookup;
+		static const std::map<uint64, std::string> reservedKeywordLookup = []()
+		{
+			std::map<uint64, std::string> lookup;
+			for (const std::string& str : reservedKeywords)
+			{
+				lookup.emplace(rmx::getMurmur2_64(str), str);
+			}
+			return lookup;
+		}();
 
 		void analyseIdentifier(const std::string_view& identifier, ParserTokenList& outTokens, uint32 lineNumber)
 		{
@@ -108,16 +116,10 @@ namespace lemon
 
 			// Check for reserved identifier
 			{
-				if (reservedKeywordLookup.empty())
-				{
-					for (const std::string& str : reservedKeywords)
-					{
-						reservedKeywordLookup.emplace(rmx::getMurmur2_64(str), str);
-					}
-				}
-				if (reservedKeywordLookup.count(identifierHash) > 0)
+				const auto it = reservedKeywordLookup.find(identifierHash);
+				if (it != reservedKeywordLookup.end())
 				{
-					CHECK_ERROR(false, "Reserved keyword '" << reservedKeywordLookup[identifierHash] << "' cannot be used as an identifier, please rename", lineNumber);
+					CHECK_ERROR(false, "Reserved keyword '" << it->second << "' cannot be used as an identifier, please rename", lineNumber);
 					return;
 				}
 			}
@@ -139,6 +139,8 @@ namespace lemon
 		struct OperatorLookup
 		{
 		public:
+			inline OperatorLookup()  { initialize(); }	// Initialize right away instead of on first use, as the parser runs on multiple threads
+
 			bool isOperatorCharacter(char ch);
 			size_t lookup(std::string_view input, Operator& outOperator);
 
@@ -71,7 +71,7 @@ namespace lemon
 	{
 		if (mSignatureHash == 0)
 		{
-			static SignatureBuilder builder;
+			thread_local SignatureBuilder builder;
 			builder.clear(*mReturnType);
 			for (const Parameter& parameter : mParameters)
 				builder.addParameterType(*parameter.mDataType);
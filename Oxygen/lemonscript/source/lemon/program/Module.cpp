@@ -456,4 +456,93 @@ namespace lemon
 		return ModuleSerializer::serialize(*this, outerSerializer, globalsLookup, dependencyHash, appVersion);
 	}
 
+	uint64 Module::buildInterfaceHash(const GlobalsLookup& globalsLookup)
+	{
+		return ModuleSerializer::buildInterfaceHash(*this, globalsLookup);
+	}
+
+	void Module::takeOverCompiledCode(const Module& recompiledModule, std::vector<const ScriptFunction*>& outChangedFunctions)
+	{
+		// This is only valid if both modules share the same interface, see "buildInterfaceHash"
+		//  -> In that case, only the function bodies can differ, and all references from the outside stay valid
+		RMX_CHECK(recompiledModule.mScriptFunctions.size() == mScriptFunctions.size(), "Recompiled module has a different number of script functions", return);
+		for (size_t i = 0; i < mScriptFunctions.size(); ++i)
+		{
+			RMX_CHECK(recompiledModule.mScriptFunctions[i]->getNameAndSignatureHash() == mScriptFunctions[i]->getNameAndSignatureHash(), "Recompiled module has different script functions", return);
+		}
+
+		// Map source file infos by their path, adding new ones for new included files
+		std::vector<const SourceFileInfo*> sourceFileMapping;
+		sourceFileMapping.reserve(recompiledModule.mAllSourceFiles.size());
+		for (const SourceFileInfo* sourceFileInfo : recompiledModule.mAllSourceFiles)
+		{
+			const SourceFileInfo* mapped = nullptr;
+			for (const SourceFileInfo* ownSourceFileInfo : mAllSourceFiles)
+			{
+				if (ownSourceFileInfo->mFilename == sourceFileInfo->mFilename && ownSourceFileInfo->mLocalPath == sourceFileInfo->mLocalPath)
+				{
+					mapped = ownSourceFileInfo;
+					break;
+				}
+			}
+			sourceFileMapping.push_back((nullptr != mapped) ? mapped : &addSourceFileInfo(sourceFileInfo->mLocalPath, sourceFileInfo->mFilename));
+		}
+		const auto mapSourceFileInfo = [&](const SourceFileInfo* sourceFileInfo)
+		{
+			return (nullptr != sourceFileInfo && sourceFileInfo->mModule == &recompiledModule) ? sourceFileMapping[sourceFileInfo->mIndex] : sourceFileInfo;
+		};
+
+		// Custom data types of the recompiled module have to be replaced by the equivalent ones in this module
+		const auto mapDataType = [&](const DataTypeDefinition* dataType)
+		{
+			const size_t index = (size_t)dataType->getID() - (size_t)recompiledModule.mFirstDataTypeID;
+			return (dataType->getID() >= recompiledModule.mFirstDataTypeID && index < recompiledModule.mDataTypes.size() && recompiledModule.mDataTypes[index] == dataType) ? mDataTypes[index] : dataType;
+		};
+
+		for (size_t i = 0; i < mScriptFunctions.size(); ++i)
+		{
+			ScriptFunction& function = *mScriptFunctions[i];
+			const ScriptFunction& recompiledFunction = *recompiledModule.mScriptFunctions[i];
+
+			// Take over the code of all functions, not only the changed ones, as line numbers may have changed anyway
+			const bool codeChanged = (function.addToCompiledHash(rmx::startFNV1a_64()) != recompiledFunction.addToCompiledHash(rmx::startFNV1a_64()));
+			function.mOpcodes = recompiledFunction.mOpcodes;
+			function.mLabels = recompiledFunction.mLabels;
+			function.mSourceFileInfo = mapSourceFileInfo(recompiledFunction.mSourceFileInfo);
+			function.mStartLineNumber = recompiledFunction.mStartLineNumber;
+			function.mSourceBaseLineOffset = recompiledFunction.mSourceBaseLineOffset;
+
+			for (LocalVariable* variable : function.mLocalVariablesByID)
+			{
+				destroyLocalVariable(*variable);
+			}
+			function.mLocalVariablesByIdentifier.clear();
+			function.mLocalVariablesByID.clear();
+			for (const LocalVariable* variable : recompiledFunction.mLocalVariablesByID)
+			{
+				function.addLocalVariable(variable->getName(), mapDataType(variable->getDataType()), 0);
+			}
+
+			if (codeChanged)
+				outChangedFunctions.push_back(&function);
+		}
+
+		// Add new string literals, but keep the old ones, as they might still be referenced by strings in variables
+		std::unordered_set<uint64> stringLiteralHashes;
+		for (FlyweightString str : mStringLiterals)
+			stringLiteralHashes.insert(str.getHash());
+		for (FlyweightString str : recompiledModule.mStringLiterals)
+		{
+			if (stringLiteralHashes.insert(str.getHash()).second)
+				addStringLiteral(str);
+		}
+
+		mWarnings = recompiledModule.mWarnings;
+		for (CompilerWarning& warning : mWarnings)
+		{
+			for (CompilerWarning::Occurrence& occurrence : warning.mOccurrences)
+				occurrence.mSourceFileInfo = mapSourceFileInfo(occurrence.mSourceFileInfo);
+		}
+	}
+
 }
@@ -104,6 +104,10 @@ namespace lemon
 
 		inline const std::vector<CompilerWarning>& getWarnings() const  { return mWarnings; }
 
+		// Incremental updates
+		uint64 buildInterfaceHash(const GlobalsLookup& globalsLookup);
+		void takeOverCompiledCode(const Module& recompiledModule, std::vector<const ScriptFunction*>& outChangedFunctions);
+
 	private:
 		void addFunctionInternal(Function& func);
 		void addGlobalVariable(Variable& variable, FlyweightString name, const DataTypeDefinition* dataType);
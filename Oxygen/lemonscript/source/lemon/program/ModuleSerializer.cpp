@@ -381,6 +381,115 @@ namespace lemon
 		return true;
 	}
 
+	uint64 ModuleSerializer::buildInterfaceHash(Module& module, const GlobalsLookup& globalsLookup)
+	{
+		// Write out everything that other modules or the runtime may depend on, i.e. everything except for the function bodies
+		std::vector<uint8> buffer;
+		VectorBinarySerializer serializer(false, buffer);
+
+		serializer.write(module.mFirstFunctionID);
+		serializer.write(module.mFirstVariableID);
+		serializer.write(module.mFirstConstantArrayID);
+		serializer.write(module.mFirstDataTypeID);
+
+		// Preprocessor definitions
+		serializer.writeAs<uint32>(module.mPreprocessorDefinitions.size());
+		for (const Constant* constant : module.mPreprocessorDefinitions)
+		{
+			serializer.write(constant->getName().getHash());
+			serializer.write(constant->mValue.get<uint64>());
+		}
+
+		// Function headers
+		serializer.writeAs<uint32>(module.mFunctions.size());
+		for (const Function* function : module.mFunctions)
+		{
+			serializer.writeAs<uint8>(function->getType());
+			serializer.write(function->mContext.getHash());
+			serializer.write(function->mNameAndSignatureHash);
+			serializer.writeAs<uint32>(function->mFlags.getValue());
+			serializer.writeAs<uint32>(function->mAliasNames.size());
+			for (const Function::AliasName& aliasName : function->mAliasNames)
+			{
+				serializer.write(aliasName.mName.getHash());
+				serializer.write(aliasName.mIsDeprecated);
+			}
+
+			if (function->getType() == Function::Type::SCRIPT)
+			{
+				// Address hooks and pragmas are evaluated outside of the function itself
+				const ScriptFunction& scriptFunc = static_cast<const ScriptFunction&>(*function);
+				serializer.writeAs<uint32>(scriptFunc.mAddressHooks.size());
+				for (uint32 addressHook : scriptFunc.mAddressHooks)
+					serializer.write(addressHook);
+				serializer.writeAs<uint32>(scriptFunc.mPragmas.size());
+				for (const std::string& pragma : scriptFunc.mPragmas)
+					serializer.write(pragma);
+			}
+		}
+
+		// Callable function addresses, sorted as the unordered map gives no guarantees about the order
+		{
+			std::vector<std::pair<uint32, uint64>> callableFunctions(module.mCallableFunctions.begin(), module.mCallableFunctions.end());
+			std::sort(callableFunctions.begin(), callableFunctions.end());
+			serializer.writeAs<uint32>(callableFunctions.size());
+			for (const auto& [address, nameHash] : callableFunctions)
+			{
+				serializer.write(address);
+				serializer.write(nameHash);
+			}
+		}
+
+		// Global variables
+		serializer.writeAs<uint32>(module.mGlobalVariables.size());
+		for (const Variable* variable : module.mGlobalVariables)
+		{
+			serializer.writeAs<uint8>(variable->getType());
+			serializer.write(variable->getName().getHash());
+			serializer.write(variable->getDataType()->getID());
+			if (variable->getType() == Variable::Type::GLOBAL)
+				serializer.write(static_cast<const GlobalVariable*>(variable)->mInitialValue.get<int64>());
+		}
+
+		// Constants
+		serializer.writeAs<uint32>(module.mConstants.size());
+		for (const Constant* constant : module.mConstants)
+		{
+			serializer.write(constant->getName().getHash());
+			serializer.write(constant->getDataType()->getID());
+			serializer.write(constant->mValue.get<uint64>());
+		}
+
+		// Constant arrays
+		serializer.writeAs<uint32>(module.mConstantArrays.size());
+		serializer.writeAs<uint32>(module.mNumGlobalConstantArrays);
+		for (ConstantArray* constantArray : module.mConstantArrays)
+		{
+			serializer.write(constantArray->getName().getHash());
+			serializer.write(constantArray->getElementDataType()->getID());
+			constantArray->serializeData(serializer);
+		}
+
+		// Defines
+		serializer.writeAs<uint32>(module.mDefines.size());
+		for (Define* define : module.mDefines)
+		{
+			serializer.write(define->getName().getHash());
+			serializer.write(define->getDataType()->getID());
+			TokenSerializer::serializeTokenList(serializer, define->mContent, globalsLookup);
+		}
+
+		// Data types
+		serializer.writeAs<uint32>(module.mDataTypes.size());
+		for (const CustomDataType* dataType : module.mDataTypes)
+		{
+			serializer.write(dataType->getName().getHash());
+			serializer.writeAs<uint8>(dataType->getBaseType());
+		}
+
+		return buffer.empty() ? rmx::startFNV1a_64() : rmx::getFNV1a_64(&buffer[0], buffer.size());
+	}
+
 	void ModuleSerializer::serializeFunctions(Module& module, VectorBinarySerializer& serializer, const GlobalsLookup& globalsLookup)
 	{
 		uint32 numberOfFunctions = (uint32)module.mFunctions.size();
@@ -20,6 +20,7 @@ namespace lemon
 	{
 	public:
 		static bool serialize(Module& module, VectorBinarySerializer& outerSerializer, const GlobalsLookup& globalsLookup, uint32 dependencyHash, uint32 appVersion);
+		static uint64 buildInterfaceHash(Module& module, const GlobalsLookup& globalsLookup);
 
 	private:
 		static void serializeFunctions(Module& module, VectorBinarySerializer& serializer, const GlobalsLookup& globalsLookup);
@@ -204,6 +204,94 @@ namespace lemon
 		}
 	}
 
+	void Runtime::rebuildRuntimeFunctions(const std::vector<const ScriptFunction*>& scriptFunctions)
+	{
+		// This is meant for script functions whose code got replaced, while the rest of the program stayed the same
+		//  -> Runtime functions get rebuilt in place, so all pointers to them (e.g. in call opcodes of other functions) stay valid
+		//  -> Memory of the old runtime opcodes stays in the pool until the next reset
+		std::unordered_set<const RuntimeFunction*> runtimeFunctions;
+		for (const ScriptFunction* scriptFunction : scriptFunctions)
+		{
+			const auto it = mRuntimeFunctionsMapped.find(scriptFunction);
+			if (it != mRuntimeFunctionsMapped.end())
+				runtimeFunctions.insert(it->second);
+		}
+		if (runtimeFunctions.empty())
+			return;
+
+		// Remember the original program counters of all call stack entries that are affected, while the old runtime opcodes are still there
+		std::vector<std::vector<size_t>> originalProgramCounters(mControlFlows.size());
+		for (size_t index = 0; index < mControlFlows.size(); ++index)
+		{
+			const ControlFlow& controlFlow = *mControlFlows[index];
+			originalProgramCounters[index].resize(controlFlow.mCallStack.count, 0);
+			for (size_t k = 0; k < controlFlow.mCallStack.count; ++k)
+			{
+				const ControlFlow::State& state = controlFlow.mCallStack[k];
+				if (runtimeFunctions.count(state.mRuntimeFunction) != 0)
+					originalProgramCounters[index][k] = state.mRuntimeFunction->translateFromRuntimeProgramCounter(state.mProgramCounter);
+			}
+		}
+
+		for (const RuntimeFunction* runtimeFunction : runtimeFunctions)
+		{
+			RuntimeFunction& runtimeFunc = const_cast<RuntimeFunction&>(*runtimeFunction);
+			runtimeFunc.mRuntimeOpcodeBuffer.clear();
+			runtimeFunc.mProgramCounterByOpcodeIndex.clear();
+			runtimeFunc.build(*this);
+		}
+
+		// Fix the call stacks
+		for (size_t index = 0; index < mControlFlows.size(); ++index)
+		{
+			ControlFlow& controlFlow = *mControlFlows[index];
+			if (controlFlow.mCallStack.count == 0)
+				continue;
+
+			// Set the program counters to their old opcode indices, and for callers, search for the nearest matching call (same as in state deserialization)
+			for (size_t k = 0; k < controlFlow.mCallStack.count; ++k)
+			{
+				ControlFlow::State& state = controlFlow.mCallStack[k];
+				if (runtimeFunctions.count(state.mRuntimeFunction) == 0)
+					continue;
+
+				const size_t numOpcodes = state.mRuntimeFunction->mFunction->mOpcodes.size();
+				const size_t programCounter = std::min(originalProgramCounters[index][k], (numOpcodes > 0) ? (numOpcodes - 1) : 0);
+				state.mProgramCounter = state.mRuntimeFunction->translateToRuntimeProgramCounter(programCounter);
+				if (k + 1 < controlFlow.mCallStack.count)
+				{
+					const size_t opcodeIndex = (size_t)matchCallerProgramCounter(*mProgram, state, controlFlow.mCallStack[k + 1]);
+					state.mProgramCounter = state.mRuntimeFunction->translateToRuntimeProgramCounter(opcodeIndex);
+				}
+			}
+
+			// Make sure the local variable frames of affected functions are large enough for all of their local variables
+			//  -> The new code might expect more variables to be allocated at its current position than the old code did
+			//  -> Never shrink frames, so that a scope's end can't move the local variables size below the frame start
+			std::vector<int64> oldLocalVariables(controlFlow.mLocalVariablesBuffer, controlFlow.mLocalVariablesBuffer + controlFlow.mLocalVariablesSize);
+			size_t position = 0;
+			for (size_t k = 0; k < controlFlow.mCallStack.count; ++k)
+			{
+				ControlFlow::State& state = controlFlow.mCallStack[k];
+				const size_t oldStart = state.mLocalVariablesStart;
+				const size_t oldEnd = (k + 1 < controlFlow.mCallStack.count) ? controlFlow.mCallStack[k + 1].mLocalVariablesStart : oldLocalVariables.size();
+				const size_t oldSize = oldEnd - oldStart;
+				const size_t newSize = (runtimeFunctions.count(state.mRuntimeFunction) != 0) ? std::max(oldSize, state.mRuntimeFunction->mFunction->mLocalVariablesByID.size()) : oldSize;
+				RMX_CHECK(position + newSize <= ControlFlow::VAR_STACK_LIMIT, "Reached var stack limit, probably due to recursive function calls", RMX_REACT_THROW);
+
+				memcpy(&controlFlow.mLocalVariablesBuffer[position], &oldLocalVariables[oldStart], oldSize * sizeof(int64));
+				memset(&controlFlow.mLocalVariablesBuffer[position + oldSize], 0, (newSize - oldSize) * sizeof(int64));
+				state.mLocalVariablesStart = position;
+				position += newSize;
+			}
+			controlFlow.mLocalVariablesSize = position;
+			controlFlow.mCurrentLocalVariables = &controlFlow.mLocalVariablesBuffer[controlFlow.mCallStack.back().mLocalVariablesStart];
+		}
+
+		// There may be new string literals
+		mProgram->collectAllStringLiterals(mStrings);
+	}
+
 	RuntimeFunction* Runtime::getRuntimeFunction(const ScriptFunction& scriptFunction)
 	{
 		const auto it = mRuntimeFunctionsMapped.find(&scriptFunction);
@@ -146,6 +146,7 @@ namespace lemon
 		void resetRuntimeState();
 
 		void buildAllRuntimeFunctions();
+		void rebuildRuntimeFunctions(const std::vector<const ScriptFunction*>& scriptFunctions);
 
 		RuntimeFunction* getRuntimeFunction(const ScriptFunction& scriptFunction);
 		RuntimeFunction* getRuntimeFunctionBySignature(uint64 signatureHash, size_t index = 0);
@@ -182,8 +183,8 @@ namespace lemon
 		void setupGlobalVariables();
 
 	private:
-		inline static ControlFlow* mActiveControlFlow = nullptr;
-		inline static const Environment* mActiveEnvironment = nullptr;
+		inline static thread_local ControlFlow* mActiveControlFlow = nullptr;			// Thread-local, so that multiple runtimes can execute in parallel on different threads
+		inline static thread_local const Environment* mActiveEnvironment = nullptr;
 
 	private:
 		const Program* mProgram = nullptr;
@@ -14,6 +14,7 @@
 #include "lemon/runtime/provider/DefaultOpcodeProvider.h"
 #include "lemon/runtime/provider/OptimizedOpcodeProvider.h"
 #include "lemon/runtime/provider/NativizedOpcodeProvider.h"
+#include "lemon/runtime/provider/RegisterOpcodeProvider.h"
 #include "lemon/program/Program.h"
 
 
@@ -100,11 +101,11 @@ namespace lemon
 			const size_t numOpcodes = opcodes.size();
 
 			// Preparation: Build some useful information about opcodes
-			static std::vector<OpcodeProcessor::OpcodeData> opcodeData;
+			thread_local std::vector<OpcodeProcessor::OpcodeData> opcodeData;
 			OpcodeProcessor::buildOpcodeData(opcodeData, *mFunction);
 
-			// Using a static buffer as temporary buffer before knowing the final size
-			static RuntimeOpcodeBuffer tempBuffer;
+			// Using a thread-local buffer as temporary buffer before knowing the final size
+			thread_local RuntimeOpcodeBuffer tempBuffer;
 			tempBuffer.clear();
 			tempBuffer.reserveForOpcodes(numOpcodes);
 
@@ -246,6 +247,14 @@ namespace lemon
 				return;
 		}
 
+		// Register-based superinstructions for longer straight-line opcode sequences
+		if (program.getOptimizationLevel() >= 4)
+		{
+			const bool success = RegisterOpcodeProvider::buildRuntimeOpcodeStatic(buffer, opcodes, numOpcodesAvailable, firstOpcodeIndex, outNumOpcodesConsumed, runtime);
+			if (success)
+				return;
+		}
+
 		// Runtime opcode generation by merging multiple opcodes where possible
 		if (program.getOptimizationLevel() >= 1)
 		{
@@ -117,7 +117,7 @@ namespace lemon
 			RMX_ASSERT(nullptr != runtime, "No lemon script runtime active");
 			RMX_CHECK(format.isValid(), "Unable to resolve format string", return StringRef());
 
-			static detail::FastStringStream result;
+			thread_local detail::FastStringStream result;
 			result.clear();
 			StringFormatterLegacy::buildFormattedString(result, format.getString(), numArguments, args);
 
@@ -223,7 +223,7 @@ namespace lemon
 			RMX_ASSERT(nullptr != runtime, "No lemon script runtime active");
 			RMX_CHECK(format.isValid(), "Unable to resolve format string", return StringRef());
 
-			static detail::FastStringStream result;
+			thread_local detail::FastStringStream result;
 			result.clear();
 			StringFormatter::buildFormattedString(result, format.getString(), numArguments, args);
 
@@ -22,6 +22,14 @@ namespace lemon
 		(*buildFunction)(mLookupDictionary);
 	}
 
+	void NativizedOpcodeProvider::mergeLookup(BuildFunction buildFunction)
+	{
+		// Build into a separate dictionary first, as loading the parameter info would overwrite the existing one otherwise
+		Nativizer::LookupDictionary dict;
+		(*buildFunction)(dict);
+		mLookupDictionary.merge(dict);
+	}
+
 	bool NativizedOpcodeProvider::buildRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int firstOpcodeIndex, int& outNumOpcodesConsumed, const Runtime& runtime)
 	{
 		if (mLookupDictionary.mEntries.empty() || numOpcodesAvailable < (int)Nativizer::MIN_OPCODES)
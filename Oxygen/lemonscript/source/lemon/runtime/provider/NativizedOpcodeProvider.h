@@ -24,6 +24,7 @@ namespace lemon
 
 		inline bool isValid() const  { return !mLookupDictionary.mEntries.empty(); }
 		void buildLookup(BuildFunction buildFunction);
+		void mergeLookup(BuildFunction buildFunction);
 
 		bool buildRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int firstOpcodeIndex, int& outNumOpcodesConsumed, const Runtime& runtime) override;
 
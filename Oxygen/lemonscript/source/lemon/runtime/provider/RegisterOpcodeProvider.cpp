@@ -0,0 +1,645 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "lemon/pch.h"
+#include "lemon/runtime/provider/RegisterOpcodeProvider.h"
+#include "lemon/runtime/RuntimeFunction.h"
+#include "lemon/runtime/RuntimeOpcodeContext.h"
+#include "lemon/runtime/OpcodeExecUtils.h"
+#include "lemon/program/Program.h"
+
+
+namespace lemon
+{
+
+	#define SELECT_REGISTER_FUNC_BY_DATATYPE_INT(_function_, _datatype_) \
+	{ \
+		switch (_datatype_) \
+		{ \
+			case BaseType::INT_8:		instruction.mExecFunc = &_function_<int8>;		break; \
+			case BaseType::INT_16:		instruction.mExecFunc = &_function_<int16>;		break; \
+			case BaseType::INT_32:		instruction.mExecFunc = &_function_<int32>;		break; \
+			case BaseType::INT_64:		instruction.mExecFunc = &_function_<int64>;		break; \
+			case BaseType::UINT_8:		instruction.mExecFunc = &_function_<uint8>;		break; \
+			case BaseType::UINT_16:		instruction.mExecFunc = &_function_<uint16>;	break; \
+			case BaseType::UINT_32:		instruction.mExecFunc = &_function_<uint32>;	break; \
+			case BaseType::UINT_64:		instruction.mExecFunc = &_function_<uint64>;	break; \
+			case BaseType::INT_CONST:	instruction.mExecFunc = &_function_<uint64>;	break; \
+			default: \
+				return false; \
+		} \
+	}
+
+	#define SELECT_REGISTER_FUNC_BY_SIZE(_function_, _size_) \
+	{ \
+		switch (_size_) \
+		{ \
+			case 1:  instruction.mExecFunc = &_function_<uint8>;   break; \
+			case 2:  instruction.mExecFunc = &_function_<uint16>;  break; \
+			case 4:  instruction.mExecFunc = &_function_<uint32>;  break; \
+			case 8:  instruction.mExecFunc = &_function_<uint64>;  break; \
+			default: \
+				return false; \
+		} \
+	}
+
+
+	class RegisterOpcodeExec
+	{
+	public:
+		static const constexpr size_t MAX_REGISTERS = 8;
+		static const constexpr size_t MAX_INSTRUCTIONS = 6;		// Limited by the maximum runtime opcode size of 0xc0 bytes
+
+		struct Instruction;
+		typedef void(*InstructionFunc)(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow);
+
+		struct Instruction
+		{
+			InstructionFunc mExecFunc = nullptr;
+			uint8 mTarget = 0;
+			uint8 mSourceA = 0;
+			uint8 mSourceB = 0;
+			uint32 mIndex = 0;		// Local variable index
+			int64 mConstant = 0;	// Constant operand, or pointer in case of global or external variables
+		};
+
+		struct BlockHeader
+		{
+			uint8 mNumInstructions = 0;
+			uint8 mNumResults = 0;	// Number of registers that get pushed onto the value stack at the end
+			uint8 mPadding[6] = { 0 };
+		};
+
+	public:
+		static void exec_REGISTER_BLOCK(const RuntimeOpcodeContext context)
+		{
+			const uint8* parameters = (const uint8*)context.mOpcode + RuntimeOpcode::PARAMETER_OFFSET;
+			const BlockHeader& header = *reinterpret_cast<const BlockHeader*>(parameters);
+			const Instruction* instructions = reinterpret_cast<const Instruction*>(parameters + sizeof(BlockHeader));
+
+			uint64 registers[MAX_REGISTERS];
+			ControlFlow& controlFlow = *context.mControlFlow;
+			for (uint8 i = 0; i < header.mNumInstructions; ++i)
+			{
+				(*instructions[i].mExecFunc)(registers, instructions[i], controlFlow);
+			}
+
+			// Hand the remaining values over to the value stack, as if the original opcodes were executed
+			for (uint8 i = 0; i < header.mNumResults; ++i)
+			{
+				*controlFlow.mValueStackPtr = registers[i];
+				++controlFlow.mValueStackPtr;
+			}
+		}
+
+		static void op_LOAD_CONSTANT(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			registers[instruction.mTarget] = (uint64)instruction.mConstant;
+		}
+
+		static void op_LOAD_LOCAL(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			registers[instruction.mTarget] = (uint64)controlFlow.mCurrentLocalVariables[instruction.mIndex];
+		}
+
+		static void op_STORE_LOCAL(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			controlFlow.mCurrentLocalVariables[instruction.mIndex] = (int64)registers[instruction.mSourceA];
+		}
+
+		template<typename T>
+		static void op_LOAD_EXTERNAL(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			registers[instruction.mTarget] = *reinterpret_cast<const T*>(instruction.mConstant);
+		}
+
+		template<typename T>
+		static void op_STORE_EXTERNAL(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			*reinterpret_cast<T*>(instruction.mConstant) = (T)registers[instruction.mSourceA];
+		}
+
+		template<typename T>
+		static void op_READ_MEMORY(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			registers[instruction.mTarget] = OpcodeExecUtils::readMemory<T>(controlFlow, registers[instruction.mSourceA]);
+		}
+
+		template<typename T>
+		static void op_WRITE_MEMORY(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			// Value in source A, address in source B
+			OpcodeExecUtils::writeMemory<T>(controlFlow, registers[instruction.mSourceB], (T)registers[instruction.mSourceA]);
+		}
+
+		template<typename T>
+		static void op_WRITE_MEMORY_EXCHANGED(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			// Address in source A, value in source B
+			const T value = (T)registers[instruction.mSourceB];
+			OpcodeExecUtils::writeMemory<T>(controlFlow, registers[instruction.mSourceA], value);
+			registers[instruction.mTarget] = value;
+		}
+
+		template<typename S, typename T>
+		static void op_CAST_VALUE(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			const S value = BaseTypeConversion::convert<uint64, S>(registers[instruction.mSourceA]);
+			registers[instruction.mTarget] = BaseTypeConversion::convert<T, uint64>(static_cast<T>(value));
+		}
+
+		static void op_MAKE_BOOL(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			registers[instruction.mTarget] = (registers[instruction.mSourceA] != 0) ? 1 : 0;
+		}
+
+	#define REGISTER_BINARY_OP(_name_, _expression_) \
+		template<typename T> \
+		static void op_##_name_(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow) \
+		{ \
+			const T a = BaseTypeConversion::convert<uint64, T>(registers[instruction.mSourceA]); \
+			const T b = BaseTypeConversion::convert<uint64, T>(registers[instruction.mSourceB]); \
+			registers[instruction.mTarget] = BaseTypeConversion::convert<T, uint64>((T)(_expression_)); \
+		} \
+		template<typename T> \
+		static void op_##_name_##_CONSTANT(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow) \
+		{ \
+			const T a = BaseTypeConversion::convert<uint64, T>(registers[instruction.mSourceA]); \
+			const T b = (T)instruction.mConstant; \
+			registers[instruction.mTarget] = BaseTypeConversion::convert<T, uint64>((T)(_expression_)); \
+		}
+
+	#define REGISTER_COMPARE_OP(_name_, _operator_) \
+		template<typename T> \
+		static void op_##_name_(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow) \
+		{ \
+			const T a = BaseTypeConversion::convert<uint64, T>(registers[instruction.mSourceA]); \
+			const T b = BaseTypeConversion::convert<uint64, T>(registers[instruction.mSourceB]); \
+			registers[instruction.mTarget] = (a _operator_ b) ? 1 : 0; \
+		} \
+		template<typename T> \
+		static void op_##_name_##_CONSTANT(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow) \
+		{ \
+			const T a = BaseTypeConversion::convert<uint64, T>(registers[instruction.mSourceA]); \
+			const T b = (T)instruction.mConstant; \
+			registers[instruction.mTarget] = (a _operator_ b) ? 1 : 0; \
+		}
+
+		REGISTER_BINARY_OP(ADD, a + b)
+		REGISTER_BINARY_OP(SUB, a - b)
+		REGISTER_BINARY_OP(MUL, a * b)
+		REGISTER_BINARY_OP(DIV, OpcodeExecUtils::safeDivide(a, b))
+		REGISTER_BINARY_OP(MOD, OpcodeExecUtils::safeModulo(a, b))
+		REGISTER_BINARY_OP(AND, a & b)
+		REGISTER_BINARY_OP(OR,  a | b)
+		REGISTER_BINARY_OP(XOR, a ^ b)
+		REGISTER_BINARY_OP(SHL, a << (b & (sizeof(T) * 8 - 1)))
+		REGISTER_BINARY_OP(SHR, a >> (b & (sizeof(T) * 8 - 1)))
+
+		REGISTER_COMPARE_OP(CMP_EQ,  ==)
+		REGISTER_COMPARE_OP(CMP_NEQ, !=)
+		REGISTER_COMPARE_OP(CMP_LT,  <)
+		REGISTER_COMPARE_OP(CMP_LE,  <=)
+		REGISTER_COMPARE_OP(CMP_GT,  >)
+		REGISTER_COMPARE_OP(CMP_GE,  >=)
+
+	#undef REGISTER_BINARY_OP
+	#undef REGISTER_COMPARE_OP
+
+		template<typename T>
+		static void op_NEG(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			const T a = BaseTypeConversion::convert<uint64, T>(registers[instruction.mSourceA]);
+			registers[instruction.mTarget] = BaseTypeConversion::convert<T, uint64>((T)-a);
+		}
+
+		template<typename T>
+		static void op_NOT(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			const T a = BaseTypeConversion::convert<uint64, T>(registers[instruction.mSourceA]);
+			registers[instruction.mTarget] = (a == 0) ? 1 : 0;
+		}
+
+		template<typename T>
+		static void op_BITNOT(uint64* registers, const Instruction& instruction, ControlFlow& controlFlow)
+		{
+			const T a = BaseTypeConversion::convert<uint64, T>(registers[instruction.mSourceA]);
+			registers[instruction.mTarget] = BaseTypeConversion::convert<T, uint64>((T)~a);
+		}
+	};
+
+
+	namespace detail
+	{
+		// Translates stack-based opcodes into register instructions, using the value stack position as register index
+		//  -> Constants get pushed lazily, so that they can be used as immediate operands in most cases
+		struct RegisterBlockBuilder
+		{
+			typedef RegisterOpcodeExec::Instruction Instruction;
+
+			struct StackEntry
+			{
+				bool mIsConstant = false;
+				int64 mConstant = 0;
+			};
+
+			Instruction mInstructions[RegisterOpcodeExec::MAX_INSTRUCTIONS + RegisterOpcodeExec::MAX_REGISTERS];
+			size_t mNumInstructions = 0;
+			StackEntry mStack[RegisterOpcodeExec::MAX_REGISTERS];
+			size_t mStackSize = 0;
+
+			size_t getNumPendingConstants() const
+			{
+				size_t count = 0;
+				for (size_t i = 0; i < mStackSize; ++i)
+				{
+					if (mStack[i].mIsConstant)
+						++count;
+				}
+				return count;
+			}
+
+			Instruction& addInstruction(uint8 target, uint8 sourceA = 0, uint8 sourceB = 0)
+			{
+				Instruction& instruction = mInstructions[mNumInstructions];
+				++mNumInstructions;
+				instruction = Instruction();
+				instruction.mTarget = target;
+				instruction.mSourceA = sourceA;
+				instruction.mSourceB = sourceB;
+				return instruction;
+			}
+
+			void materialize(size_t position)
+			{
+				if (mStack[position].mIsConstant)
+				{
+					Instruction& instruction = addInstruction((uint8)position);
+					instruction.mExecFunc = &RegisterOpcodeExec::op_LOAD_CONSTANT;
+					instruction.mConstant = mStack[position].mConstant;
+					mStack[position].mIsConstant = false;
+				}
+			}
+
+			void materializeAll()
+			{
+				for (size_t i = 0; i < mStackSize; ++i)
+					materialize(i);
+			}
+
+			bool pushRegister()
+			{
+				if (mStackSize >= RegisterOpcodeExec::MAX_REGISTERS)
+					return false;
+				mStack[mStackSize] = StackEntry();
+				++mStackSize;
+				return true;
+			}
+
+			bool getExternalPointer(uint32 variableId, BaseType dataType, const Runtime& runtime, int64& outPointer, size_t& outSize)
+			{
+				const Variable::Type type = (Variable::Type)(variableId >> 28);
+				switch (type)
+				{
+					case Variable::Type::GLOBAL:
+					{
+						outPointer = (int64)const_cast<Runtime&>(runtime).accessGlobalVariableValue(runtime.getProgram().getGlobalVariableByID(variableId));
+						outSize = DataTypeHelper::getSizeOfBaseType(dataType);
+						return true;
+					}
+
+					case Variable::Type::EXTERNAL:
+					{
+						const ExternalVariable& variable = static_cast<ExternalVariable&>(runtime.getProgram().getGlobalVariableByID(variableId));
+						outPointer = (int64)variable.mAccessor();
+						outSize = variable.getDataType()->getBytes();
+						return true;
+					}
+
+					default:
+						return false;
+				}
+			}
+
+			bool addOpcode(const Opcode& opcode, const Runtime& runtime)
+			{
+				switch (opcode.mType)
+				{
+					case Opcode::Type::NOP:
+						return true;
+
+					case Opcode::Type::MOVE_STACK:
+					{
+						if (opcode.mParameter >= 0 || -opcode.mParameter > (int64)mStackSize)
+							return false;
+						mStackSize -= (size_t)(-opcode.mParameter);
+						return true;
+					}
+
+					case Opcode::Type::PUSH_CONSTANT:
+					{
+						if (!pushRegister())
+							return false;
+						mStack[mStackSize-1].mIsConstant = true;
+						mStack[mStackSize-1].mConstant = opcode.mParameter;
+						return true;
+					}
+
+					case Opcode::Type::GET_VARIABLE_VALUE:
+					{
+						const uint32 variableId = (uint32)opcode.mParameter;
+						if ((Variable::Type)(variableId >> 28) == Variable::Type::LOCAL)
+						{
+							if (!pushRegister())
+								return false;
+							Instruction& instruction = addInstruction((uint8)(mStackSize-1));
+							instruction.mExecFunc = &RegisterOpcodeExec::op_LOAD_LOCAL;
+							instruction.mIndex = variableId;
+							return true;
+						}
+
+						int64 pointer = 0;
+						size_t size = 0;
+						if (!getExternalPointer(variableId, opcode.mDataType, runtime, pointer, size))
+							return false;
+						if (!pushRegister())
+							return false;
+						Instruction& instruction = addInstruction((uint8)(mStackSize-1));
+						instruction.mConstant = pointer;
+						SELECT_REGISTER_FUNC_BY_SIZE(RegisterOpcodeExec::op_LOAD_EXTERNAL, size);
+						return true;
+					}
+
+					case Opcode::Type::SET_VARIABLE_VALUE:
+					{
+						if (mStackSize < 1)
+							return false;
+
+						const uint32 variableId = (uint32)opcode.mParameter;
+						const uint8 top = (uint8)(mStackSize-1);
+						if ((Variable::Type)(variableId >> 28) == Variable::Type::LOCAL)
+						{
+							materialize(top);
+							Instruction& instruction = addInstruction(top, top);
+							instruction.mExecFunc = &RegisterOpcodeExec::op_STORE_LOCAL;
+							instruction.mIndex = variableId;
+							return true;
+						}
+
+						int64 pointer = 0;
+						size_t size = 0;
+						if (!getExternalPointer(variableId, opcode.mDataType, runtime, pointer, size))
+							return false;
+						materialize(top);
+						Instruction& instruction = addInstruction(top, top);
+						instruction.mConstant = pointer;
+						SELECT_REGISTER_FUNC_BY_SIZE(RegisterOpcodeExec::op_STORE_EXTERNAL, size);
+						return true;
+					}
+
+					case Opcode::Type::READ_MEMORY:
+					{
+						if (mStackSize < 1)
+							return false;
+
+						const uint8 top = (uint8)(mStackSize-1);
+						materialize(top);
+						if (opcode.mParameter != 0)
+						{
+							// Variant that does not consume the address
+							if (!pushRegister())
+								return false;
+						}
+						Instruction& instruction = addInstruction((uint8)(mStackSize-1), top);
+						SELECT_REGISTER_FUNC_BY_DATATYPE_INT(RegisterOpcodeExec::op_READ_MEMORY, opcode.mDataType);
+						return true;
+					}
+
+					case Opcode::Type::WRITE_MEMORY:
+					{
+						if (mStackSize < 2)
+							return false;
+
+						const uint8 first = (uint8)(mStackSize-2);
+						const uint8 second = (uint8)(mStackSize-1);
+						materialize(first);
+						materialize(second);
+						Instruction& instruction = addInstruction(first, first, second);
+						if (opcode.mParameter == 0)
+						{
+							SELECT_REGISTER_FUNC_BY_DATATYPE_INT(RegisterOpcodeExec::op_WRITE_MEMORY, opcode.mDataType);
+						}
+						else
+						{
+							SELECT_REGISTER_FUNC_BY_DATATYPE_INT(RegisterOpcodeExec::op_WRITE_MEMORY_EXCHANGED, opcode.mDataType);
+						}
+						--mStackSize;
+						return true;
+					}
+
+					case Opcode::Type::CAST_VALUE:
+					{
+						if (mStackSize < 1)
+							return false;
+
+						const uint8 top = (uint8)(mStackSize-1);
+						materialize(top);
+						Instruction& instruction = addInstruction(top, top);
+						switch (static_cast<BaseCastType>(opcode.mParameter))
+						{
+							case BaseCastType::INT_16_TO_8:   instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint16, uint8>;   break;
+							case BaseCastType::INT_32_TO_8:   instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint32, uint8>;   break;
+							case BaseCastType::INT_64_TO_8:   instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint64, uint8>;   break;
+							case BaseCastType::INT_32_TO_16:  instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint32, uint16>;  break;
+							case BaseCastType::INT_64_TO_16:  instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint64, uint16>;  break;
+							case BaseCastType::INT_64_TO_32:  instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint64, uint32>;  break;
+
+							case BaseCastType::UINT_8_TO_16:  instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint8, uint16>;   break;
+							case BaseCastType::UINT_8_TO_32:  instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint8, uint32>;   break;
+							case BaseCastType::UINT_8_TO_64:  instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint8, uint64>;   break;
+							case BaseCastType::UINT_16_TO_32: instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint16, uint32>;  break;
+							case BaseCastType::UINT_16_TO_64: instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint16, uint64>;  break;
+							case BaseCastType::UINT_32_TO_64: instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<uint32, uint64>;  break;
+
+							case BaseCastType::SINT_8_TO_16:  instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<int8, int16>;     break;
+							case BaseCastType::SINT_8_TO_32:  instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<int8, int32>;     break;
+							case BaseCastType::SINT_8_TO_64:  instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<int8, int64>;     break;
+							case BaseCastType::SINT_16_TO_32: instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<int16, int32>;    break;
+							case BaseCastType::SINT_16_TO_64: instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<int16, int64>;    break;
+							case BaseCastType::SINT_32_TO_64: instruction.mExecFunc = &RegisterOpcodeExec::op_CAST_VALUE<int32, int64>;    break;
+
+							default:
+								// Casts involving floating point types are left to the other providers
+								return false;
+						}
+						return true;
+					}
+
+					case Opcode::Type::MAKE_BOOL:
+					{
+						if (mStackSize < 1)
+							return false;
+
+						const uint8 top = (uint8)(mStackSize-1);
+						materialize(top);
+						Instruction& instruction = addInstruction(top, top);
+						instruction.mExecFunc = &RegisterOpcodeExec::op_MAKE_BOOL;
+						return true;
+					}
+
+					case Opcode::Type::ARITHM_ADD:
+					case Opcode::Type::ARITHM_SUB:
+					case Opcode::Type::ARITHM_MUL:
+					case Opcode::Type::ARITHM_DIV:
+					case Opcode::Type::ARITHM_MOD:
+					case Opcode::Type::ARITHM_AND:
+					case Opcode::Type::ARITHM_OR:
+					case Opcode::Type::ARITHM_XOR:
+					case Opcode::Type::ARITHM_SHL:
+					case Opcode::Type::ARITHM_SHR:
+					case Opcode::Type::COMPARE_EQ:
+					case Opcode::Type::COMPARE_NEQ:
+					case Opcode::Type::COMPARE_LT:
+					case Opcode::Type::COMPARE_LE:
+					case Opcode::Type::COMPARE_GT:
+					case Opcode::Type::COMPARE_GE:
+					{
+						if (mStackSize < 2)
+							return false;
+
+						const uint8 first = (uint8)(mStackSize-2);
+						const uint8 second = (uint8)(mStackSize-1);
+						const bool useConstant = mStack[second].mIsConstant;
+						materialize(first);
+						if (!useConstant)
+							materialize(second);
+
+						Instruction& instruction = addInstruction(first, first, second);
+						instruction.mConstant = mStack[second].mConstant;
+						if (!selectBinaryOperation(instruction, opcode, useConstant))
+							return false;
+						--mStackSize;
+						return true;
+					}
+
+					case Opcode::Type::ARITHM_NEG:
+					case Opcode::Type::ARITHM_NOT:
+					case Opcode::Type::ARITHM_BITNOT:
+					{
+						if (mStackSize < 1)
+							return false;
+
+						const uint8 top = (uint8)(mStackSize-1);
+						materialize(top);
+						Instruction& instruction = addInstruction(top, top);
+						switch (opcode.mType)
+						{
+							case Opcode::Type::ARITHM_NEG:		SELECT_REGISTER_FUNC_BY_DATATYPE_INT(RegisterOpcodeExec::op_NEG, BaseTypeHelper::makeIntegerSigned(opcode.mDataType));	break;
+							case Opcode::Type::ARITHM_NOT:		SELECT_REGISTER_FUNC_BY_DATATYPE_INT(RegisterOpcodeExec::op_NOT, opcode.mDataType);		break;
+							case Opcode::Type::ARITHM_BITNOT:	SELECT_REGISTER_FUNC_BY_DATATYPE_INT(RegisterOpcodeExec::op_BITNOT, opcode.mDataType);	break;
+							default:
+								return false;
+						}
+						return true;
+					}
+
+					default:
+						// Everything else (especially control flow and calls) ends the block
+						return false;
+				}
+			}
+
+			bool selectBinaryOperation(Instruction& instruction, const Opcode& opcode, bool useConstant)
+			{
+			#define SELECT_BINARY_OPERATION(_name_) \
+				if (useConstant) \
+					SELECT_REGISTER_FUNC_BY_DATATYPE_INT(RegisterOpcodeExec::op_##_name_##_CONSTANT, opcode.mDataType) \
+				else \
+					SELECT_REGISTER_FUNC_BY_DATATYPE_INT(RegisterOpcodeExec::op_##_name_, opcode.mDataType)
+
+				switch (opcode.mType)
+				{
+					case Opcode::Type::ARITHM_ADD:	SELECT_BINARY_OPERATION(ADD);		break;
+					case Opcode::Type::ARITHM_SUB:	SELECT_BINARY_OPERATION(SUB);		break;
+					case Opcode::Type::ARITHM_MUL:	SELECT_BINARY_OPERATION(MUL);		break;
+					case Opcode::Type::ARITHM_DIV:	SELECT_BINARY_OPERATION(DIV);		break;
+					case Opcode::Type::ARITHM_MOD:	SELECT_BINARY_OPERATION(MOD);		break;
+					case Opcode::Type::ARITHM_AND:	SELECT_BINARY_OPERATION(AND);		break;
+					case Opcode::Type::ARITHM_OR:	SELECT_BINARY_OPERATION(OR);		break;
+					case Opcode::Type::ARITHM_XOR:	SELECT_BINARY_OPERATION(XOR);		break;
+					case Opcode::Type::ARITHM_SHL:	SELECT_BINARY_OPERATION(SHL);		break;
+					case Opcode::Type::ARITHM_SHR:	SELECT_BINARY_OPERATION(SHR);		break;
+					case Opcode::Type::COMPARE_EQ:	SELECT_BINARY_OPERATION(CMP_EQ);	break;
+					case Opcode::Type::COMPARE_NEQ:	SELECT_BINARY_OPERATION(CMP_NEQ);	break;
+					case Opcode::Type::COMPARE_LT:	SELECT_BINARY_OPERATION(CMP_LT);	break;
+					case Opcode::Type::COMPARE_LE:	SELECT_BINARY_OPERATION(CMP_LE);	break;
+					case Opcode::Type::COMPARE_GT:	SELECT_BINARY_OPERATION(CMP_GT);	break;
+					case Opcode::Type::COMPARE_GE:	SELECT_BINARY_OPERATION(CMP_GE);	break;
+					default:
+						return false;
+				}
+				return true;
+
+			#undef SELECT_BINARY_OPERATION
+			}
+		};
+	}
+
+
+	bool RegisterOpcodeProvider::buildRuntimeOpcodeStatic(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int firstOpcodeIndex, int& outNumOpcodesConsumed, const Runtime& runtime)
+	{
+		// Only worth it if enough opcodes get merged, otherwise let the optimized opcode provider handle it
+		const constexpr int MIN_OPCODES_CONSUMED = 3;
+		if (numOpcodesAvailable < MIN_OPCODES_CONSUMED)
+			return false;
+
+		detail::RegisterBlockBuilder builder;
+		int numOpcodesConsumed = 0;
+		while (numOpcodesConsumed < numOpcodesAvailable)
+		{
+			// Take a backup to roll back to in case this opcode can't be added
+			const detail::RegisterBlockBuilder backup = builder;
+			if (!builder.addOpcode(opcodes[numOpcodesConsumed], runtime) ||
+				builder.mNumInstructions + builder.getNumPendingConstants() > RegisterOpcodeExec::MAX_INSTRUCTIONS)
+			{
+				builder = backup;
+				break;
+			}
+			++numOpcodesConsumed;
+		}
+
+		if (numOpcodesConsumed < MIN_OPCODES_CONSUMED)
+			return false;
+
+		// Constants that are still left on the stack need to be loaded into their registers now
+		builder.materializeAll();
+
+		// Each consumed opcode produces at most one instruction, so this always fits into the space reserved for the consumed opcodes
+		const size_t parameterSize = sizeof(RegisterOpcodeExec::BlockHeader) + builder.mNumInstructions * sizeof(RegisterOpcodeExec::Instruction);
+		RuntimeOpcode& runtimeOpcode = buffer.addOpcode(parameterSize);
+		runtimeOpcode.mExecFunc = &RegisterOpcodeExec::exec_REGISTER_BLOCK;
+
+		RegisterOpcodeExec::BlockHeader header;
+		header.mNumInstructions = (uint8)builder.mNumInstructions;
+		header.mNumResults = (uint8)builder.mStackSize;
+		uint8* parameters = (uint8*)&runtimeOpcode + RuntimeOpcode::PARAMETER_OFFSET;
+		memcpy(parameters, &header, sizeof(header));
+		memcpy(parameters + sizeof(header), builder.mInstructions, builder.mNumInstructions * sizeof(RegisterOpcodeExec::Instruction));
+
+		outNumOpcodesConsumed = numOpcodesConsumed;
+		return true;
+	}
+
+	bool RegisterOpcodeProvider::buildRuntimeOpcode(RuntimeOpcodeBuffer& buffer, const Opcode* opcodes, int numOpcodesAvailable, int firstOpcodeIndex, int& outNumOpcodesConsumed, const Runtime& runtime)
+	{
+		return buildRuntimeOpcodeStatic(buffer, opcodes, numOpcodesAvailable, firstOpcodeIndex, outNumOpcodesConsumed, runtime);
+	}
+
+	#undef SELECT_REGISTER_FUNC_BY_DATATYPE_INT
+	#undef SELECT_REGISTER_FUNC_BY_SIZE
+}
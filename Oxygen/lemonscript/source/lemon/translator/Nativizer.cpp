@@ -85,6 +85,25 @@ namespace lemon
 		}
 	}
 
+	void Nativizer::LookupDictionary::merge(const LookupDictionary& other)
+	{
+		// Parameter data of the other dictionary gets appended, so its start indices need to be shifted accordingly
+		const size_t parameterOffset = mParameterData.size();
+		mParameterData.insert(mParameterData.end(), other.mParameterData.begin(), other.mParameterData.end());
+
+		mEntries.reserve(mEntries.size() + other.mEntries.size());
+		for (const std::pair<uint64, LookupEntry>& pair : other.mEntries)
+		{
+			// Existing functions take precedence, but empty entries (marking partial hashes) can be filled
+			LookupEntry& entry = mEntries[pair.first];
+			if (nullptr == entry.mExecFunc && nullptr != pair.second.mExecFunc)
+			{
+				entry.mExecFunc = pair.second.mExecFunc;
+				entry.mParameterStart = pair.second.mParameterStart + parameterOffset;
+			}
+		}
+	}
+
 
 	void Nativizer::getOpcodeSubtypeInfo(OpcodeSubtypeInfo& outInfo, const Opcode* opcodes, size_t numOpcodesAvailable, MemoryAccessHandler& memoryAccessHandler)
 	{
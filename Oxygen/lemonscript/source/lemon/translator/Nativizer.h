@@ -78,6 +78,7 @@ namespace lemon
 			void addEmptyEntries(const uint64* hashes, size_t numHashes);
 			void loadFunctions(const CompactFunctionEntry* entries, size_t numEntries);
 			void loadParameterInfo(const uint8* data, size_t count);
+			void merge(const LookupDictionary& other);
 
 			std::unordered_map<uint64, LookupEntry> mEntries;
 			std::vector<LookupEntry::ParameterInfo> mParameterData;
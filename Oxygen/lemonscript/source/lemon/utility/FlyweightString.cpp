@@ -23,6 +23,7 @@ namespace lemon
 
 	void FlyweightString::set(uint64 hash)
 	{
+		std::lock_guard<std::mutex> lock(mManager.mMutex);
 		const auto it = mManager.mEntryMap.find(hash);
 		mEntry = (it == mManager.mEntryMap.end()) ? nullptr : it->second;
 	}
@@ -31,6 +32,7 @@ namespace lemon
 	{
 		using Entry = detail::FlyweightStringManager::Entry;
 
+		std::lock_guard<std::mutex> lock(mManager.mMutex);
 		Entry*& entry = mManager.mEntryMap[hash];
 		if (nullptr == entry)
 		{
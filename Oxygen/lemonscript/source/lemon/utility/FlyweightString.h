@@ -9,6 +9,7 @@
 #pragma once
 
 #include <rmxbase.h>
+#include <mutex>
 
 
 namespace lemon
@@ -30,6 +31,7 @@ namespace lemon
 		public:
 			rmx::OneTimeAllocPool mAllocPool;
 			std::unordered_map<uint64, Entry*> mEntryMap;
+			std::mutex mMutex;		// Flyweight strings get created by the parser on multiple threads
 		};
 	}
 
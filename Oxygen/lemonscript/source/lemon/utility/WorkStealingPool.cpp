@@ -0,0 +1,242 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "lemon/pch.h"
+#include "lemon/utility/WorkStealingPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+namespace lemon
+{
+	namespace
+	{
+		// Range of indices still to be processed by one thread
+		//  -> The owning thread takes indices from the front, other threads steal from the back
+		struct WorkerRange
+		{
+			std::mutex mMutex;
+			size_t mBegin = 0;
+			size_t mEnd = 0;
+
+			bool popFront(size_t& outIndex)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (mBegin >= mEnd)
+					return false;
+				outIndex = mBegin;
+				++mBegin;
+				return true;
+			}
+
+			bool stealBack(size_t& outBegin, size_t& outEnd)
+			{
+				// Steal the back half of the remaining indices
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (mBegin >= mEnd)
+					return false;
+				const size_t count = (mEnd - mBegin + 1) / 2;
+				outEnd = mEnd;
+				mEnd -= count;
+				outBegin = mEnd;
+				return true;
+			}
+
+			void set(size_t begin, size_t end)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mBegin = begin;
+				mEnd = end;
+			}
+		};
+
+		// Persistent worker threads, which sleep between the calls to "runParallel"
+		class WorkerThreads
+		{
+		public:
+			~WorkerThreads()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					mShutdown = true;
+				}
+				mWakeUp.notify_all();
+				for (std::thread& thread : mThreads)
+					thread.join();
+			}
+
+			std::mutex& getRunMutex()  { return mRunMutex; }
+
+			// Runs the worker function on the calling thread with index 0, and on worker threads with indices 1 up to numThreads-1
+			//  -> This must only be called while holding the run mutex
+			void run(size_t numThreads, const std::function<void(size_t)>& workerFunc)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					while (mThreads.size() + 1 < numThreads)
+					{
+						const size_t threadIndex = mThreads.size() + 1;
+						mThreads.emplace_back([this, threadIndex]() { threadFunc(threadIndex); });
+					}
+					mWorkerFunc = &workerFunc;
+					mNumParticipants = numThreads - 1;
+					mNumFinished = 0;
+					++mGeneration;
+				}
+				mWakeUp.notify_all();
+
+				workerFunc(0);
+
+				std::unique_lock<std::mutex> lock(mMutex);
+				mAllFinished.wait(lock, [this]() { return mNumFinished >= mNumParticipants; });
+				mWorkerFunc = nullptr;
+			}
+
+		private:
+			void threadFunc(size_t threadIndex)
+			{
+				uint64 lastGeneration = 0;
+				std::unique_lock<std::mutex> lock(mMutex);
+				while (true)
+				{
+					mWakeUp.wait(lock, [&]() { return mShutdown || mGeneration != lastGeneration; });
+					if (mShutdown)
+						return;
+
+					// Threads with higher indices don't take part if the last call used less threads
+					lastGeneration = mGeneration;
+					if (threadIndex > mNumParticipants)
+						continue;
+
+					const std::function<void(size_t)>& workerFunc = *mWorkerFunc;
+					lock.unlock();
+					workerFunc(threadIndex);
+					lock.lock();
+
+					++mNumFinished;
+					if (mNumFinished >= mNumParticipants)
+						mAllFinished.notify_one();
+				}
+			}
+
+		private:
+			std::mutex mRunMutex;
+			std::mutex mMutex;
+			std::condition_variable mWakeUp;
+			std::condition_variable mAllFinished;
+			std::vector<std::thread> mThreads;
+			const std::function<void(size_t)>* mWorkerFunc = nullptr;
+			uint64 mGeneration = 0;
+			size_t mNumParticipants = 0;
+			size_t mNumFinished = 0;
+			bool mShutdown = false;
+		};
+
+		WorkerThreads& getWorkerThreads()
+		{
+			static WorkerThreads workerThreads;
+			return workerThreads;
+		}
+	}
+
+
+	void WorkStealingPool::setMaxThreads(int count)
+	{
+		mMaxThreads = std::max(count, 0);
+	}
+
+	void WorkStealingPool::runParallel(size_t numItems, const std::function<void(size_t)>& function)
+	{
+		size_t numThreads = (size_t)std::max(std::thread::hardware_concurrency(), 1u);
+		if (mMaxThreads > 0)
+			numThreads = std::min(numThreads, (size_t)mMaxThreads);
+		numThreads = std::min(numThreads, numItems);
+
+		// Worker threads are busy if this gets called from multiple threads at once, or from inside the function
+		WorkerThreads& workerThreads = getWorkerThreads();
+		std::unique_lock<std::mutex> runLock(workerThreads.getRunMutex(), std::try_to_lock);
+		if (!runLock.owns_lock())
+			numThreads = 1;
+
+		if (numThreads <= 1)
+		{
+			// Not worth the overhead
+			for (size_t index = 0; index < numItems; ++index)
+				function(index);
+			return;
+		}
+
+		// Initial distribution: Each thread gets an equally sized contiguous range
+		std::vector<WorkerRange> ranges(numThreads);
+		for (size_t k = 0; k < numThreads; ++k)
+		{
+			ranges[k].mBegin = numItems * k / numThreads;
+			ranges[k].mEnd = numItems * (k + 1) / numThreads;
+		}
+
+		// Only the exception of the lowest index is of interest, which is the one a serial execution would have thrown as well
+		std::atomic<size_t> firstErrorIndex = std::numeric_limits<size_t>::max();
+		std::exception_ptr firstErrorException;
+		std::mutex errorMutex;
+
+		const std::function<void(size_t)> workerFunc = [&](size_t threadIndex)
+		{
+			WorkerRange& ownRange = ranges[threadIndex];
+			while (true)
+			{
+				size_t index;
+				while (ownRange.popFront(index))
+				{
+					// No need to process items behind an error
+					if (index > firstErrorIndex.load(std::memory_order_relaxed))
+						continue;
+
+					try
+					{
+						function(index);
+					}
+					catch (...)
+					{
+						std::lock_guard<std::mutex> lock(errorMutex);
+						if (index < firstErrorIndex)
+						{
+							firstErrorIndex = index;
+							firstErrorException = std::current_exception();
+						}
+					}
+				}
+
+				// Out of work, try to steal from the other threads
+				//  -> If there's nothing left anywhere, we're done, as no new work can get added while running
+				bool stolen = false;
+				for (size_t k = 1; k < numThreads; ++k)
+				{
+					size_t begin, end;
+					if (ranges[(threadIndex + k) % numThreads].stealBack(begin, end))
+					{
+						ownRange.set(begin, end);
+						stolen = true;
+						break;
+					}
+				}
+				if (!stolen)
+					break;
+			}
+		};
+
+		// The calling thread takes part as well
+		workerThreads.run(numThreads, workerFunc);
+		runLock.unlock();
+
+		if (firstErrorException)
+			std::rethrow_exception(firstErrorException);
+	}
+}
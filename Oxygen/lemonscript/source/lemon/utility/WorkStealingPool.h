@@ -0,0 +1,34 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <rmxbase.h>
+#include <functional>
+
+
+namespace lemon
+{
+	class WorkStealingPool
+	{
+	public:
+		// Sets the maximum number of threads to use, including the calling thread; 0 means to use all hardware threads
+		static void setMaxThreads(int count);
+
+		// Calls the function for each index in [0, numItems), distributed over multiple threads
+		//  - The worker threads get started on first use and then stay alive, waiting for the next call
+		//  - Each thread starts with a contiguous range of indices and steals from other threads when running out of work
+		//  - Calls from multiple threads (or nested calls) don't share the workers; all but the first one get processed on the calling thread only
+		//  - Returns only after all items are processed
+		//  - If any calls throw an exception, the one with the lowest index gets rethrown, so the result does not depend on scheduling
+		static void runParallel(size_t numItems, const std::function<void(size_t)>& function);
+
+	private:
+		static inline int mMaxThreads = 0;
+	};
+}
@@ -86,6 +86,15 @@ void EngineDelegate::onPreSaveStateLoad()
 {
 }
 
+bool EngineDelegate::supportsParallelSimulations()
+{
+#ifdef USE_EXPERIMENTS
+	return false;	// Experiments have their own state
+#else
+	return true;
+#endif
+}
+
 bool EngineDelegate::mayLoadScriptMods()
 {
 	return true;
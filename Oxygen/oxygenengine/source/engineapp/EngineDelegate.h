@@ -29,6 +29,7 @@ public:
 	void onPostFrameUpdate() override;
 	void onControlsUpdate() override;
 	void onPreSaveStateLoad() override;
+	bool supportsParallelSimulations() override;
 
 	bool mayLoadScriptMods() override;
 	bool allowModdedData() override;
@@ -34,12 +34,13 @@ int main(int argc, char** argv)
 	PlatformFunctions::changeWorkingDirectory(arguments.mExecutableCallPath);
 
 	// Create engine delegate and angine main instance
+	int exitCode = 0;
 	{
 		EngineDelegate myDelegate;
 		EngineMain myMain(myDelegate, arguments);
 
-		myMain.execute();
+		exitCode = myMain.execute();
 	}
 
-	return 0;
+	return exitCode;
 }
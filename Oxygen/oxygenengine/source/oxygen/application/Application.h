@@ -28,6 +28,8 @@ class TouchControlsOverlay;
 
 class Application : public GuiBase, public SingleInstance<Application>
 {
+friend class HeadlessRunner;	// For access to updateLoading
+
 public:
 	using WindowMode = Configuration::WindowMode;
 
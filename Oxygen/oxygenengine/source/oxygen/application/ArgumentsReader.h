@@ -13,10 +13,27 @@
 
 class ArgumentsReader
 {
+public:
+	struct Headless
+	{
+		bool mEnabled = false;			// "-headless": Run the simulation without window and audio device, see "HeadlessRunner"
+		std::wstring mGameRecording;	// "-gamerec=<file>": Game recording to play back
+		std::wstring mInputRecording;	// "-inputrec=<name>": Input recording to play back instead
+		int mNumFrames = 0;				// "-frames=<count>": Number of frames to simulate
+		bool mRender = false;			// "-render": Include rendering of the game screen
+		bool mRenderCheck = false;		// "-rendercheck": Check each frame rendered by the frame pipeline with multiple bands against serial rendering (implies "-render")
+		bool mAudio = false;			// "-audio": Include audio generation
+		bool mDeltaStateCheck = false;	// "-deltastatecheck": Check delta save states against full save states after each frame
+		std::wstring mBatchDirectory;	// "-batch=<directory>": Play back all game recordings in the directory
+		int mNumThreads = 0;			// "-threads=<count>": Number of simulations to run in parallel in batch mode
+		bool mKernelBenchmark = false;	// "-kernelbenchmark": Run the micro-benchmarks of the software renderer's pixel kernels and pattern cache, and of the sound emulation and audio mixing instead (implies "-headless")
+	};
+
 public:
 	std::wstring mExecutableCallPath;
 	std::wstring mProjectPath;
 	int mDisplayIndex = -1;
+	Headless mHeadless;
 
 public:
 	virtual ~ArgumentsReader()  {}
@@ -37,6 +54,54 @@ public:
 			{
 				mDisplayIndex = (int)rmx::parseInteger(parameter.substr(9));;
 			}
+			else if (parameter == "-headless")
+			{
+				mHeadless.mEnabled = true;
+			}
+			else if (rmx::startsWith(parameter, "-gamerec="))
+			{
+				mHeadless.mGameRecording = String(parameter.substr(9)).toStdWString();
+			}
+			else if (rmx::startsWith(parameter, "-inputrec="))
+			{
+				mHeadless.mInputRecording = String(parameter.substr(10)).toStdWString();
+			}
+			else if (rmx::startsWith(parameter, "-frames="))
+			{
+				mHeadless.mNumFrames = (int)rmx::parseInteger(parameter.substr(8));
+			}
+			else if (parameter == "-render")
+			{
+				mHeadless.mRender = true;
+			}
+			else if (parameter == "-rendercheck")
+			{
+				mHeadless.mRender = true;
+				mHeadless.mRenderCheck = true;
+			}
+			else if (parameter == "-audio")
+			{
+				mHeadless.mAudio = true;
+			}
+			else if (parameter == "-deltastatecheck")
+			{
+				mHeadless.mDeltaStateCheck = true;
+			}
+			else if (rmx::startsWith(parameter, "-batch="))
+			{
+				std::wstring path = String(parameter.substr(7)).toStdWString();
+				FTX::FileSystem->normalizePath(path, true);
+				mHeadless.mBatchDirectory = path;
+			}
+			else if (rmx::startsWith(parameter, "-threads="))
+			{
+				mHeadless.mNumThreads = (int)rmx::parseInteger(parameter.substr(9));
+			}
+			else if (parameter == "-kernelbenchmark")
+			{
+				mHeadless.mEnabled = true;
+				mHeadless.mKernelBenchmark = true;
+			}
 			else if (parameter[0] == '-')
 			{
 				readParameter(parameter);
@@ -244,6 +244,7 @@ Configuration::Configuration()
 #if defined(PLATFORM_WEB)
 	// Threading in general is not (afaik) supported by emscripten
 	mUseAudioThreading = false;
+	mSoftwareRendererThreads = 1;
 #endif
 
 #if defined(PLATFORM_ANDROID)
@@ -506,10 +507,15 @@ void Configuration::loadConfigurationProperties(JsonSerializer& serializer)
 	serializer.serialize("Scanlines", mScanlines);
 	serializer.serialize("BackgroundBlur", mBackgroundBlur);
 	serializer.serialize("PerformanceDisplay", mPerformanceDisplay);
+#if !defined(PLATFORM_WEB)
+	serializer.serialize("SoftwareRendererThreads", mSoftwareRendererThreads);
+	serializer.serialize("FramePipelining", mFramePipelining);
+#endif
 	tryReadRenderMethod(serializer, mFailSafeMode, mRenderMethod, mAutoDetectRenderMethod);
 
 	// Audio
 	serializer.serialize("AudioSampleRate", mAudioSampleRate);
+	serializer.serialize("EmulatedSoundCache", mUseEmulatedSoundCache);
 
 	// Input recorder
 	if (mDevMode.mEnabled)
@@ -526,6 +532,27 @@ void Configuration::loadConfigurationProperties(JsonSerializer& serializer)
 	// Script
 	serializer.serialize("CompileScripts", mForceCompileScripts);
 #endif
+
+	// Script mod caching and nativization
+	if (serializer.beginObject("ModScriptCache"))
+	{
+		serializer.serialize("Enabled", mUseModScriptCache);
+		serializer.serialize("SizeLimitMB", mModScriptCacheSizeLimit);
+		serializer.endObject();
+	}
+	if (serializer.beginObject("SpriteImageCache"))
+	{
+		serializer.serialize("Enabled", mUseSpriteImageCache);
+		serializer.endObject();
+	}
+	if (serializer.beginObject("ModNativization"))
+	{
+		serializer.serialize("Mode", mModScriptNativization);
+		serializer.serialize("Compiler", mModNativizationCompiler);
+		serializer.serialize("CompilerFlags", mModNativizationCompilerFlags);
+		serializer.serialize("SourcePath", mModNativizationSourcePath);
+		serializer.endObject();
+	}
 }
 
 void Configuration::serializeStandardSettings(JsonSerializer& serializer)
@@ -599,6 +626,7 @@ void Configuration::serializeStandardSettings(JsonSerializer& serializer)
 
 	// Script
 	serializer.serialize("ScriptOptimizationLevel", mScriptOptimizationLevel);
+	serializer.serialize("ScriptCompilerThreads", mScriptCompilerThreads);
 
 	// Game server
 	if (serializer.beginObject("GameServer"))
@@ -626,6 +654,7 @@ void Configuration::serializeDevMode(JsonSerializer& serializer)
 		}
 
 		serializer.serialize("EnableROMDataAnalyser", mEnableROMDataAnalyser);
+		serializer.serialize("IncrementalScriptReload", mDevMode.mIncrementalScriptReload);
 
 		if (serializer.beginObject("DevModeUI"))
 		{
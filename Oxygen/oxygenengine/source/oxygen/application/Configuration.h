@@ -73,6 +73,7 @@ public:
 		int mActiveMainWindowTab = 0;
 		ExternalCodeEditor mExternalCodeEditor;
 		bool mApplyModSettingsAfterLoadState = false;
+		bool mIncrementalScriptReload = true;		// Script reloads recompile only modules with changes, and keep the runtime state if possible
 	};
 
 	struct GameRecorder
@@ -81,6 +82,21 @@ public:
 		bool mEnablePlayback = false;
 		int mPlaybackStartFrame = 0;
 		bool mPlaybackIgnoreKeys = false;
+		std::wstring mPlaybackFilename;		// Game recording to play back; if empty, "gamerecording.bin" or "gamerec.bin" get used
+	};
+
+	struct Headless
+	{
+		bool mEnabled = false;			// Simulate as fast as possible without window or audio device, and print a performance report
+		std::wstring mInputRecording;	// Name of an input recording to play back, as an alternative to a game recording
+		int  mNumFrames = 0;			// Number of frames to simulate, or 0 to run until the end of the game recording (or 3600 frames without one)
+		bool mRender = false;			// Render each frame into the game screen texture
+		bool mRenderCheck = false;		// Check each rendered frame against the frame pipeline with multiple bands, see "VideoOut::checkFramePipeline"
+		bool mAudio = false;			// Generate audio output for each frame (which then gets discarded)
+		bool mDeltaStateCheck = false;	// Save and load delta save states after each frame, and compare them with full save states
+		std::wstring mBatchDirectory;	// Directory with game recordings to play back one after the other, instead of a single game recording
+		int  mNumThreads = 0;			// Number of simulations to run in parallel in batch mode, or 0 to use all hardware threads
+		bool mKernelBenchmark = false;	// Run the micro-benchmarks of the software renderer's pixel kernels and pattern cache, and of the sound emulation and audio mixing instead of a simulation
 	};
 
 	struct VirtualGamepad
@@ -199,11 +215,14 @@ public:
 	int   mScanlines = 0;
 	int   mBackgroundBlur = 0;
 	int   mPerformanceDisplay = 0;
+	int   mSoftwareRendererThreads = 0;	// Number of threads for the software renderer, 0 = automatic, 1 = no multi-threading
+	bool  mFramePipelining = false;		// Software renderer only: Render the game screen on an own thread while the next frame gets simulated, at the cost of one frame of latency
 
 	// Audio
 	int   mAudioSampleRate = 48000;
 	float mAudioVolume = 1.0f;
 	bool  mUseAudioThreading = true;		// Disabled in constructor for platforms that don't support it
+	bool  mUseEmulatedSoundCache = true;	// Store the output of emulated sounds that don't change between playbacks in an on-disk cache
 
 	// Input
 	std::vector<InputConfig::DeviceDefinition> mInputDeviceDefinitions;
@@ -223,13 +242,22 @@ public:
 	GameServerBase mGameServerBase;
 
 	// Internal
+	Headless mHeadless;
 	bool mForceCompileScripts = false;
-	int mScriptOptimizationLevel = -1;		// -1: Auto, 0: No optimization at all, up to 3: Full optimization
+	int mScriptOptimizationLevel = -1;		// -1: Auto, 0: No optimization at all, up to 3: Full optimization, 4: Additionally use register-based superinstructions
+	int mScriptCompilerThreads = 0;			// Maximum number of threads used for script compilation, 0: Use all hardware threads
 	std::wstring mCompiledScriptSavePath;
+	bool mUseModScriptCache = true;
+	int mModScriptCacheSizeLimit = 64;		// In MB
+	bool mUseSpriteImageCache = true;
 	bool mEnableROMDataAnalyser = false;
 	bool mExitAfterScriptLoading = false;
 	int mRunScriptNativization = 0;			// 0: Disabled, 1: Run nativization, 2: Nativization done
 	std::wstring mScriptNativizationOutput;
+	int mModScriptNativization = 0;			// 0: Disabled, 1: Use cached native modules for script mods, 2: Additionally build missing native modules with the system compiler
+	std::string mModNativizationCompiler = "c++";
+	std::string mModNativizationCompilerFlags = "-O2";		// Separated by spaces, no shell quoting
+	std::wstring mModNativizationSourcePath;	// Directory containing the "Oxygen" and "librmx" sources needed for building native modules; if empty, it gets searched for upwards from the executable
 	std::wstring mDumpCppDefinitionsOutput;
 
 	// Mod settings
@@ -12,7 +12,9 @@
 #include "oxygen/application/ArgumentsReader.h"
 #include "oxygen/application/Configuration.h"
 #include "oxygen/application/GameProfile.h"
+#include "oxygen/application/HeadlessRunner.h"
 #include "oxygen/application/audio/AudioOutBase.h"
+#include "oxygen/application/audio/EmulationAudioSource.h"
 #include "oxygen/application/input/ControlsIn.h"
 #include "oxygen/application/input/InputManager.h"
 #include "oxygen/application/modding/ModManager.h"
@@ -31,9 +33,12 @@
 #include "oxygen/resources/FontCollection.h"
 #include "oxygen/resources/ResourcesCache.h"
 #include "oxygen/rendering/RenderResources.h"
+#include "oxygen/rendering/parts/PatternManager.h"
+#include "oxygen/rendering/utils/PixelKernels.h"
 #include "oxygen/simulation/LogDisplay.h"
 #include "oxygen/simulation/PersistentData.h"
 #include "oxygen/simulation/Simulation.h"
+#include "oxygen/simulation/sound/SoundEmulation.h"
 #if defined(PLATFORM_ANDROID)
 	#include "oxygen/platform/AndroidJavaInterface.h"
 #endif
@@ -95,17 +100,29 @@ EngineMain::~EngineMain()
 	delete &mInternal;
 }
 
-void EngineMain::execute()
+int EngineMain::execute()
 {
+	int exitCode = 0;
+
 	// Startup the Oxygen engine part that is independent from the application / project
 	if (startupEngine())
 	{
-		// Enter the application run loop
-		run();
+		// Enter the application run loop, or just run the simulation in headless mode
+		if (Configuration::instance().mHeadless.mEnabled)
+		{
+			// A failed headless run gets reported via the exit code, so that scripts calling it can react
+			if (!runHeadless())
+				exitCode = 1;
+		}
+		else
+		{
+			run();
+		}
 	}
 
 	// Done, now shut everything down
 	shutdown();
+	return exitCode;
 }
 
 void EngineMain::onActiveModsChanged()
@@ -291,7 +308,7 @@ bool EngineMain::startupEngine()
 	mAudioOut->startup();
 
 	// ImGui integration
-	ImGuiIntegration::setEnabled(config.mDevMode.mEnabled);
+	ImGuiIntegration::setEnabled(config.mDevMode.mEnabled && !config.mHeadless.mEnabled);
 	ImGuiIntegration::startup();
 
 	// Done
@@ -310,6 +327,25 @@ void EngineMain::run()
 	FTX::System->run(application);
 }
 
+bool EngineMain::runHeadless()
+{
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("--- HEADLESS RUN ---");
+
+	if (Configuration::instance().mHeadless.mKernelBenchmark)
+	{
+		PixelKernels::runBenchmark();
+		PatternManager::runBenchmark();
+		const bool soundEmulationMatching = SoundEmulation::runBenchmark();
+		EmulationAudioSource::runBenchmark();
+		mAudioOut->runBenchmark();
+		return soundEmulationMatching;
+	}
+
+	HeadlessRunner headlessRunner;
+	return headlessRunner.run();
+}
+
 void EngineMain::shutdown()
 {
 	ImGuiIntegration::shutdown();
@@ -448,6 +484,41 @@ bool EngineMain::initConfigAndSettings()
 		config.mDisplayIndex = mArguments.mDisplayIndex;
 	}
 
+	// Setup headless mode if requested on the command line
+	if (mArguments.mHeadless.mEnabled)
+	{
+		RMX_LOG_INFO("Using headless mode");
+		config.mHeadless.mEnabled = true;
+		config.mHeadless.mInputRecording = mArguments.mHeadless.mInputRecording;
+		config.mHeadless.mNumFrames = mArguments.mHeadless.mNumFrames;
+		config.mHeadless.mRender = mArguments.mHeadless.mRender;
+		config.mHeadless.mRenderCheck = mArguments.mHeadless.mRenderCheck;
+		config.mHeadless.mAudio = mArguments.mHeadless.mAudio;
+		config.mHeadless.mDeltaStateCheck = mArguments.mHeadless.mDeltaStateCheck;
+		config.mHeadless.mBatchDirectory = mArguments.mHeadless.mBatchDirectory;
+		config.mHeadless.mNumThreads = mArguments.mHeadless.mNumThreads;
+		config.mHeadless.mKernelBenchmark = mArguments.mHeadless.mKernelBenchmark;
+
+		// Only the game recording's initial keyframe gets loaded, everything after that gets simulated from the recorded inputs
+		config.mGameRecorder.mRecordingMode = 0;
+		config.mGameRecorder.mEnablePlayback = !mArguments.mHeadless.mGameRecording.empty() || !mArguments.mHeadless.mBatchDirectory.empty();
+		config.mGameRecorder.mPlaybackFilename = mArguments.mHeadless.mGameRecording;
+		config.mGameRecorder.mPlaybackStartFrame = 0;
+		config.mGameRecorder.mPlaybackIgnoreKeys = true;
+		config.mInputRecorderInput = mArguments.mHeadless.mInputRecording;
+		config.mInputRecorderOutput.clear();
+
+		// No actual window or audio device needed, but it's easiest to let SDL use its dummy drivers
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", true);
+		SDL_setenv("SDL_AUDIODRIVER", "dummy", true);
+		config.mRenderMethod = Configuration::RenderMethod::SOFTWARE;
+		config.mWindowMode = Configuration::WindowMode::WINDOWED;
+		config.mFrameSync = Configuration::FrameSyncType::VSYNC_OFF;
+
+		// Don't write any of the changes above into the settings
+		config.setSettingsReadOnly(true);
+	}
+
 	// Evaluate fail-safe mode
 	if (config.mFailSafeMode)
 	{
@@ -61,6 +61,9 @@ public:
 	virtual void onPreSaveStateLoad() = 0;
 
 	virtual void onApplicationLostFocus() {}
+	virtual bool supportsParallelSimulations() { return false; }	// Return true only if the game's script bindings and frame update callbacks (which get called for each simulation) don't depend on any state outside of the simulation
+	virtual void startupParallelSimulation() {}		// Called on the simulation's own thread, before the simulation gets created
+	virtual void shutdownParallelSimulation() {}	// Called on the simulation's own thread, after the simulation got destroyed
 
 	virtual bool mayLoadScriptMods() = 0;
 	virtual bool allowModdedData() = 0;
@@ -89,7 +92,7 @@ public:
 	EngineMain(EngineDelegateInterface& delegate_, ArgumentsReader& arguments);
 	~EngineMain();
 
-	void execute();
+	int execute();		// Returns the process exit code
 
 	void onActiveModsChanged();
 	bool reloadFilePackage(std::wstring_view packageName, bool forceReload);
@@ -106,6 +109,7 @@ public:
 private:
 	bool startupEngine();
 	void run();
+	bool runHeadless();
 	void shutdown();
 
 	void initDirectories();
@@ -0,0 +1,408 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/application/HeadlessRunner.h"
+#include "oxygen/application/Application.h"
+#include "oxygen/application/Configuration.h"
+#include "oxygen/application/EngineMain.h"
+#include "oxygen/application/GameLoader.h"
+#include "oxygen/application/audio/AudioOutBase.h"
+#include "oxygen/application/input/ControlsIn.h"
+#include "oxygen/application/video/VideoOut.h"
+#include "oxygen/helper/HighResolutionTimer.h"
+#include "oxygen/rendering/parts/RenderParts.h"
+#include "oxygen/simulation/CodeExec.h"
+#include "oxygen/simulation/EmulatorInterface.h"
+#include "oxygen/simulation/GameRecorder.h"
+#include "oxygen/simulation/LogDisplay.h"
+#include "oxygen/simulation/Simulation.h"
+
+#include <thread>
+
+
+namespace
+{
+	static const uint32 DEFAULT_NUM_FRAMES = 3600;	// Used if there's no game recording that defines the number of frames
+
+	double getPercentile(const std::vector<double>& sortedValues, double percentile)
+	{
+		if (sortedValues.empty())
+			return 0.0;
+		const size_t index = std::min((size_t)(percentile * (double)sortedValues.size()), sortedValues.size() - 1);
+		return sortedValues[index];
+	}
+}
+
+
+bool HeadlessRunner::run()
+{
+	RMX_LOG_INFO("Starting headless simulation run");
+
+	// The application instance is needed nonetheless, as it owns the simulation and game views, and script bindings access it
+	Application application;
+	application.initialize();
+
+	bool success = startupGame(application);
+	if (success)
+	{
+		if (!Configuration::instance().mHeadless.mBatchDirectory.empty())
+		{
+			success = runBatch(application);
+		}
+		else
+		{
+			Report report;
+			simulateFrames(application, report);
+			printReport(report);
+			success = (report.mNumFrames > 0 && report.mRenderCheckMismatches == 0 && report.mDeltaStateMismatches == 0);
+		}
+	}
+
+	application.deinitialize();
+	return success;
+}
+
+bool HeadlessRunner::startupGame(Application& application)
+{
+	// Load everything the same way the application does, just without waiting for the next update
+	while (GameLoader::instance().isLoading())
+	{
+		if (!application.updateLoading())
+			return false;
+
+		// There's no way to e.g. wait for user input for the ROM selection here
+		if (GameLoader::instance().isLoading())
+		{
+			RMX_LOG_INFO("Headless: Game loading did not complete");
+			return false;
+		}
+	}
+
+	Simulation& simulation = application.getSimulation();
+	if (!simulation.getCodeExec().isCodeExecutionPossible())
+	{
+		RMX_LOG_INFO("Headless: Script execution is not possible");
+		return false;
+	}
+
+	GameRecorder& gameRecorder = simulation.getGameRecorder();
+	if (gameRecorder.isPlaying() && Configuration::instance().mHeadless.mBatchDirectory.empty())
+	{
+		if (gameRecorder.getCurrentNumberOfFrames() < 2)
+		{
+			RMX_LOG_INFO("Headless: Game recording could not be loaded or is empty");
+			return false;
+		}
+
+		// Game recordings saved during gameplay usually don't start at frame 0, in which case the simulation startup did not jump into the recording yet
+		if (!gameRecorder.hasFrameNumber(simulation.getFrameNumber()))
+		{
+			if (!simulation.jumpToFrame(gameRecorder.getRangeStart(), false))
+			{
+				RMX_LOG_INFO("Headless: Game recording has no initial keyframe");
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void HeadlessRunner::simulateFrames(Application& application, Report& outReport)
+{
+	const Configuration::Headless& options = Configuration::instance().mHeadless;
+	Simulation& simulation = application.getSimulation();
+	GameRecorder& gameRecorder = simulation.getGameRecorder();
+	CodeExec& codeExec = simulation.getCodeExec();
+	VideoOut& videoOut = VideoOut::instance();
+	AudioOutBase& audioOut = EngineMain::instance().getAudioOut();
+
+	const uint32 startFrame = simulation.getFrameNumber();
+	uint32 endFrame = startFrame + ((options.mNumFrames > 0) ? (uint32)options.mNumFrames : DEFAULT_NUM_FRAMES);
+	if (gameRecorder.isPlaying())
+	{
+		// The inputs for a frame are stored in the frame after it, so the last recorded frame can't be simulated
+		endFrame = (options.mNumFrames > 0) ? std::min(endFrame, gameRecorder.getRangeEnd() - 1) : (gameRecorder.getRangeEnd() - 1);
+	}
+	const float frameSeconds = 1.0f / simulation.getSimulationFrequency();
+
+	RMX_LOG_INFO("Headless: Simulating frames " << startFrame << " to " << endFrame << (options.mRender ? ", with rendering" : "") << (options.mAudio ? ", with audio" : ""));
+
+	outReport.mFrameTimes.reserve(endFrame - startFrame);
+
+	HighResolutionTimer totalTimer;
+	HighResolutionTimer frameTimer;
+	totalTimer.start();
+	frameTimer.start();
+
+	while (simulation.getFrameNumber() < endFrame)
+	{
+		const uint32 frameNumber = simulation.getFrameNumber();
+		if (!simulation.generateFrame())
+		{
+			if (!codeExec.isCodeExecutionPossible())
+			{
+				RMX_LOG_INFO("Headless: Script execution stopped at frame " << simulation.getFrameNumber());
+				break;
+			}
+		}
+
+		// Frames can be split over multiple calls, e.g. when scripts yield execution
+		if (simulation.getFrameNumber() == frameNumber)
+			continue;
+
+		if (options.mRender)
+		{
+			videoOut.updateGameScreen();
+			if (options.mRenderCheck)
+			{
+				++outReport.mRenderCheckFrames;
+				if (!videoOut.checkFramePipeline())
+				{
+					RMX_LOG_INFO("Headless: Frame pipeline output differs from serial rendering in frame " << frameNumber);
+					++outReport.mRenderCheckMismatches;
+				}
+			}
+		}
+		if (options.mAudio)
+		{
+			audioOut.realtimeUpdate(frameSeconds);
+		}
+		if (options.mDeltaStateCheck)
+		{
+			++outReport.mDeltaStateChecks;
+			if (!checkDeltaState(simulation))
+			{
+				RMX_LOG_INFO("Headless: Delta save state differs from full save state in frame " << simulation.getFrameNumber());
+				++outReport.mDeltaStateMismatches;
+			}
+		}
+
+		outReport.mFrameTimes.push_back(frameTimer.getSecondsSinceStart());
+		frameTimer.start();
+	}
+
+	outReport.mTotalSeconds = totalTimer.getSecondsSinceStart();
+	outReport.mNumFrames = (uint32)outReport.mFrameTimes.size();
+	outReport.mRamHash = rmx::getFNV1a_64(simulation.getEmulatorInterface().getRam(), 0x10000);
+}
+
+void HeadlessRunner::printReport(const Report& report)
+{
+	std::vector<double> sortedFrameTimes = report.mFrameTimes;
+	std::sort(sortedFrameTimes.begin(), sortedFrameTimes.end());
+
+	const double framesPerSecond = (report.mTotalSeconds > 0.0) ? ((double)report.mNumFrames / report.mTotalSeconds) : 0.0;
+	const double maxFrameTime = sortedFrameTimes.empty() ? 0.0 : sortedFrameTimes.back();
+
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("--- HEADLESS REPORT ---");
+	RMX_LOG_INFO("Frames simulated:    " << report.mNumFrames);
+	RMX_LOG_INFO(*String(0, "Total time:          %.3f s", report.mTotalSeconds));
+	RMX_LOG_INFO(*String(0, "Frames per second:   %.1f", framesPerSecond));
+	RMX_LOG_INFO(*String(0, "Frame time p50:      %.3f ms", getPercentile(sortedFrameTimes, 0.5) * 1000.0));
+	RMX_LOG_INFO(*String(0, "Frame time p90:      %.3f ms", getPercentile(sortedFrameTimes, 0.9) * 1000.0));
+	RMX_LOG_INFO(*String(0, "Frame time p99:      %.3f ms", getPercentile(sortedFrameTimes, 0.99) * 1000.0));
+	RMX_LOG_INFO(*String(0, "Frame time max:      %.3f ms", maxFrameTime * 1000.0));
+	RMX_LOG_INFO("RAM hash:            " << rmx::hexString(report.mRamHash, 16));
+	if (report.mRenderCheckFrames > 0)
+	{
+		RMX_LOG_INFO("Render check:        " << report.mRenderCheckFrames << " frames, " << report.mRenderCheckMismatches << " mismatches");
+	}
+	if (report.mDeltaStateChecks > 0)
+	{
+		RMX_LOG_INFO("Delta state check:   " << report.mDeltaStateChecks << " frames, " << report.mDeltaStateMismatches << " mismatches");
+	}
+}
+
+bool HeadlessRunner::checkDeltaState(Simulation& simulation)
+{
+	DeltaStateCheck& check = mDeltaStateCheck;
+	SaveStateSerializer serializer(simulation, RenderParts::instance());
+
+	// Take a new reference every second, just like the game recorder does for its full keyframes
+	if (!check.mReference.isValid() || simulation.getFrameNumber() % 60 == 0)
+	{
+		check.mReferenceState.clear();
+		return serializer.saveState(check.mReferenceState) && serializer.saveDeltaReference(check.mReference);
+	}
+
+	check.mExpectedState.clear();
+	check.mDeltaState.clear();
+	if (!serializer.saveState(check.mExpectedState) || !serializer.saveDeltaState(check.mDeltaState, check.mReference))
+		return false;
+
+	// The full state built from the delta state must be the same as the real one
+	if (!SaveStateSerializer::buildFullState(check.mState, check.mDeltaState, check.mReference.mId, check.mReferenceState) || check.mState != check.mExpectedState)
+		return false;
+
+	// Load the delta state again, and from time to time after a full state load, so that dirty pages can't be used
+	++check.mNumDeltaStates;
+	if (check.mNumDeltaStates % 10 == 0)
+	{
+		if (!serializer.loadState(check.mReferenceState))
+			return false;
+	}
+	if (!serializer.loadDeltaState(check.mDeltaState, check.mReference))
+		return false;
+	simulation.getCodeExec().reinitRuntime(nullptr, CodeExec::CallStackInitPolicy::USE_EXISTING);
+
+	check.mState.clear();
+	return serializer.saveState(check.mState) && check.mState == check.mExpectedState;
+}
+
+bool HeadlessRunner::runBatch(Application& application)
+{
+	const Configuration::Headless& options = Configuration::instance().mHeadless;
+
+	std::vector<rmx::FileIO::FileEntry> fileEntries;
+	FTX::FileSystem->listFilesByMask(options.mBatchDirectory + L"*.bin", false, fileEntries);
+	if (fileEntries.empty())
+	{
+		RMX_LOG_INFO("Headless: No game recordings found in '" << WString(options.mBatchDirectory).toStdString() << "'");
+		return false;
+	}
+	std::sort(fileEntries.begin(), fileEntries.end(), [](const rmx::FileIO::FileEntry& a, const rmx::FileIO::FileEntry& b) { return a.mFilename < b.mFilename; });
+
+	std::vector<BatchEntry> entries(fileEntries.size());
+	for (size_t k = 0; k < fileEntries.size(); ++k)
+	{
+		entries[k].mFilename = fileEntries[k].mPath + fileEntries[k].mFilename;
+	}
+
+	// Without support by the engine delegate, all game recordings get played back by the main simulation, one after the other
+	size_t numThreads = 1;
+	if (EngineMain::getDelegate().supportsParallelSimulations())
+	{
+		numThreads = (options.mNumThreads > 0) ? (size_t)options.mNumThreads : (size_t)std::max(std::thread::hardware_concurrency(), 1u);
+		numThreads = std::min(numThreads, entries.size());
+	}
+	else if (options.mNumThreads > 1)
+	{
+		RMX_LOG_INFO("Headless: Parallel simulations are not supported, using the main simulation only");
+	}
+
+	RMX_LOG_INFO("Headless: Playing back " << entries.size() << " game recordings using " << numThreads << " simulation(s)");
+
+	HighResolutionTimer totalTimer;
+	totalTimer.start();
+
+	if (numThreads <= 1)
+	{
+		for (BatchEntry& entry : entries)
+			playbackBatchEntry(application.getSimulation(), entry);
+	}
+	else
+	{
+		// The main thread only waits, as its simulation would share video output, audio output and persistent data with the others
+		std::atomic<size_t> nextIndex = 0;
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads);
+		for (size_t k = 0; k < numThreads; ++k)
+			threads.emplace_back(&HeadlessRunner::runBatchWorker, this, std::ref(entries), std::ref(nextIndex));
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	printBatchReport(entries, totalTimer.getSecondsSinceStart());
+	return std::all_of(entries.begin(), entries.end(), [](const BatchEntry& entry) { return entry.mSuccess; });
+}
+
+void HeadlessRunner::runBatchWorker(std::vector<BatchEntry>& entries, std::atomic<size_t>& nextIndex)
+{
+	// Create this thread's own instances of everything used by the simulation, see "PerThreadInstance"
+	std::unique_ptr<RenderParts> renderParts;
+	std::unique_ptr<ControlsIn> controlsIn;
+	std::unique_ptr<LogDisplay> logDisplay;
+	std::unique_ptr<Simulation> simulation;
+	bool success = false;
+	{
+		std::lock_guard<std::mutex> lock(mSetupMutex);
+		EngineMain::getDelegate().startupParallelSimulation();
+		renderParts = std::make_unique<RenderParts>();
+		controlsIn = std::make_unique<ControlsIn>();
+		logDisplay = std::make_unique<LogDisplay>();
+		simulation = std::make_unique<Simulation>();
+		success = simulation->startup() && simulation->getCodeExec().isCodeExecutionPossible();
+	}
+
+	if (success)
+	{
+		// Take the next game recording until there's none left
+		while (true)
+		{
+			const size_t index = nextIndex++;
+			if (index >= entries.size())
+				break;
+			playbackBatchEntry(*simulation, entries[index]);
+		}
+	}
+	else
+	{
+		RMX_LOG_INFO("Headless: Simulation setup failed in worker thread");
+	}
+
+	std::lock_guard<std::mutex> lock(mSetupMutex);
+	simulation.reset();
+	logDisplay.reset();
+	controlsIn.reset();
+	renderParts.reset();
+	EngineMain::getDelegate().shutdownParallelSimulation();
+}
+
+void HeadlessRunner::playbackBatchEntry(Simulation& simulation, BatchEntry& entry)
+{
+	if (!simulation.startGameRecordingPlayback(entry.mFilename))
+		return;
+
+	const Configuration::Headless& options = Configuration::instance().mHeadless;
+	const uint32 startFrame = simulation.getFrameNumber();
+	uint32 endFrame = simulation.getGameRecorder().getRangeEnd() - 1;
+	if (options.mNumFrames > 0)
+		endFrame = std::min(endFrame, startFrame + (uint32)options.mNumFrames);
+
+	while (simulation.getFrameNumber() < endFrame)
+	{
+		if (!simulation.generateFrame() && !simulation.getCodeExec().isCodeExecutionPossible())
+			break;
+	}
+
+	entry.mSuccess = (simulation.getFrameNumber() >= endFrame);
+	entry.mNumFrames = simulation.getFrameNumber() - startFrame;
+	entry.mRamHash = rmx::getFNV1a_64(simulation.getEmulatorInterface().getRam(), 0x10000);
+}
+
+void HeadlessRunner::printBatchReport(const std::vector<BatchEntry>& entries, double totalSeconds)
+{
+	size_t numSucceeded = 0;
+	uint64 totalFrames = 0;
+
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("--- HEADLESS BATCH REPORT ---");
+	for (const BatchEntry& entry : entries)
+	{
+		const std::string filename = WString(entry.mFilename).toStdString();
+		if (entry.mSuccess)
+		{
+			RMX_LOG_INFO(rmx::hexString(entry.mRamHash, 16) << *String(0, "  %8d frames  ", entry.mNumFrames) << filename);
+			++numSucceeded;
+		}
+		else
+		{
+			RMX_LOG_INFO("FAILED              " << *String(0, "  %8d frames  ", entry.mNumFrames) << filename);
+		}
+		totalFrames += entry.mNumFrames;
+	}
+
+	const double framesPerSecond = (totalSeconds > 0.0) ? ((double)totalFrames / totalSeconds) : 0.0;
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("Recordings played:   " << numSucceeded << " of " << entries.size());
+	RMX_LOG_INFO("Frames simulated:    " << totalFrames);
+	RMX_LOG_INFO(*String(0, "Total time:          %.3f s", totalSeconds));
+	RMX_LOG_INFO(*String(0, "Frames per second:   %.1f", framesPerSecond));
+}
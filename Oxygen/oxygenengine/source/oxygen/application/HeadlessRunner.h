@@ -0,0 +1,77 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "oxygen/simulation/SaveStateSerializer.h"
+
+#include <atomic>
+#include <mutex>
+
+class Application;
+class Simulation;
+
+
+// Runs the simulation as fast as possible without realtime synchronization, rendering to screen or audio output
+//  - Used for benchmarking and checking determinism, e.g. on machines without a display
+//  - Input comes from a game recording or an input recording, see "Configuration::Headless" for the options
+//  - At the end, a report with frames per second, frame time percentiles and a hash of the RAM content gets printed
+//  - In batch mode, all game recordings in a directory get played back, using multiple simulations in parallel if the engine delegate supports it
+class HeadlessRunner
+{
+public:
+	struct Report
+	{
+		uint32 mNumFrames = 0;
+		double mTotalSeconds = 0.0;
+		std::vector<double> mFrameTimes;	// In seconds
+		uint64 mRamHash = 0;
+		uint32 mRenderCheckFrames = 0;
+		uint32 mRenderCheckMismatches = 0;
+		uint32 mDeltaStateChecks = 0;
+		uint32 mDeltaStateMismatches = 0;
+	};
+
+	struct BatchEntry
+	{
+		std::wstring mFilename;
+		bool mSuccess = false;
+		uint32 mNumFrames = 0;
+		uint64 mRamHash = 0;
+	};
+
+public:
+	bool run();
+
+private:
+	bool startupGame(Application& application);
+	void simulateFrames(Application& application, Report& outReport);
+	void printReport(const Report& report);
+	bool checkDeltaState(Simulation& simulation);
+
+	bool runBatch(Application& application);
+	void runBatchWorker(std::vector<BatchEntry>& entries, std::atomic<size_t>& nextIndex);
+	void playbackBatchEntry(Simulation& simulation, BatchEntry& entry);
+	void printBatchReport(const std::vector<BatchEntry>& entries, double totalSeconds);
+
+private:
+	// Delta save state check, see "Configuration::Headless::mDeltaStateCheck"
+	struct DeltaStateCheck
+	{
+		SaveStateSerializer::DeltaReference mReference;
+		std::vector<uint8> mReferenceState;
+		std::vector<uint8> mExpectedState;
+		std::vector<uint8> mDeltaState;
+		std::vector<uint8> mState;
+		uint32 mNumDeltaStates = 0;
+	};
+
+private:
+	DeltaStateCheck mDeltaStateCheck;
+	std::mutex mSetupMutex;		// Setup and destruction of simulations use shared state, so worker threads take turns there
+};
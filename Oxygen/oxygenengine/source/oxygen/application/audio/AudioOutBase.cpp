@@ -12,6 +12,7 @@
 #include "oxygen/application/modding/ModManager.h"
 #include "oxygen/application/Application.h"
 #include "oxygen/application/Configuration.h"
+#include "oxygen/helper/HighResolutionTimer.h"
 
 
 AudioOutBase::AudioOutBase() :
@@ -154,8 +155,116 @@ void AudioOutBase::reloadAudioCollection()
 	mAudioPlayer.loadPlaybackState(playbackState);
 }
 
+void AudioOutBase::runBenchmark()
+{
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("--- AUDIO MIXER BENCHMARK ---");
+	runMixerBenchmark("Ingame mixing");
+}
+
 void AudioOutBase::determineActiveSourceRegistrations()
 {
 	// Default implementation: Use remastered music if possible
 	mAudioCollection.determineActiveSourceRegistrations(false);
 }
+
+void AudioOutBase::runMixerBenchmark(const char* name, const std::function<void()>& preparePass)
+{
+	constexpr int NUM_INSTANCES = 40;
+	constexpr int NUM_CALLBACKS = 500;
+	constexpr int CALLBACK_SAMPLES = 1024;
+	const int outputFrequency = FTX::Audio->getOutputFrequency();
+	if (FTX::Audio->getOutputChannels() != 2 || outputFrequency <= 0)
+	{
+		RMX_LOG_INFO(name << ": Skipped, as there's no stereo audio output");
+		return;
+	}
+
+	// Synthetic sounds, similar to a dense moment in the game with lots of sound effects at the same time, like scattering rings
+	//  -> Mono and stereo sounds, and sample rates that differ from the output, which need resampling
+	std::vector<std::unique_ptr<AudioBuffer>> audioBuffers;
+	{
+		static const int FREQUENCIES[] = { 44100, 32000, 22050 };
+		uint32 rng = 0x12345678;
+		const auto nextRandom = [&]() { rng = rng * 1103515245 + 12345; return rng >> 16; };
+
+		std::vector<short> samples[2];
+		for (int k = 0; k < NUM_INSTANCES; ++k)
+		{
+			const int channels = 1 + (k % 2);
+			const int frequency = (k % 3 == 0) ? FREQUENCIES[k % 9 / 3] : outputFrequency;
+			const int length = frequency;
+			for (int channel = 0; channel < 2; ++channel)
+			{
+				// Square wave with some noise
+				samples[channel].resize(length);
+				const int period = 50 + k * 7 + channel * 13;
+				for (int i = 0; i < length; ++i)
+				{
+					samples[channel][i] = (short)(((i % period) < period / 2 ? 0x2000 : -0x2000) + (int)(nextRandom() & 0x7ff) - 0x400);
+				}
+			}
+
+			AudioBuffer& audioBuffer = *audioBuffers.emplace_back(std::make_unique<AudioBuffer>());
+			short* data[2] = { &samples[0][0], &samples[1][0] };
+			audioBuffer.clear(frequency, channels);
+			audioBuffer.addData(data, length);
+			audioBuffer.setCompleted();
+		}
+	}
+
+	// Each pass plays the same instances from the start, and hashes the output for comparison
+	//  -> Some instances use a different playback speed, panning, or get faded out, to cover all code paths
+	std::vector<uint8> output((size_t)NUM_CALLBACKS * CALLBACK_SAMPLES * 2 * sizeof(short));
+	const auto runPass = [&](bool useOptimizedMixing, uint64& outHash)
+	{
+		if (preparePass)
+			preparePass();
+
+		std::vector<AudioReference> audioRefs(NUM_INSTANCES);
+		for (int k = 0; k < NUM_INSTANCES; ++k)
+		{
+			rmx::AudioManager::PlaybackOptions playbackOptions;
+			playbackOptions.mAudioBuffer = audioBuffers[k].get();
+			playbackOptions.mAudioMixerId = (int)((k % 8 == 0) ? AudioMixerId::INGAME_MUSIC : AudioMixerId::INGAME_SOUND);
+			playbackOptions.mVolume = 0.3f + 0.1f * (float)(k % 8);
+			playbackOptions.mVolumeChange = (k % 5 == 4) ? -0.03f : 0.0f;
+			playbackOptions.mSpeed = (k % 4 == 3) ? 1.25f : 1.0f;
+			playbackOptions.mLoop = true;
+			FTX::Audio->addSound(playbackOptions, audioRefs[k]);
+			if (k % 6 == 5)
+			{
+				audioRefs[k].setPanning(true, (k % 12 == 5) ? -0.5f : 0.5f);
+			}
+		}
+
+		FTX::Audio->lockAudio();
+		rmx::AudioMixer::setUseOptimizedMixing(useOptimizedMixing);
+		HighResolutionTimer timer;
+		timer.start();
+		for (int n = 0; n < NUM_CALLBACKS; ++n)
+		{
+			FTX::Audio->mixAudio(&output[(size_t)n * CALLBACK_SAMPLES * 2 * sizeof(short)], CALLBACK_SAMPLES * 2 * sizeof(short));
+		}
+		const double seconds = timer.getSecondsSinceStart();
+		rmx::AudioMixer::setUseOptimizedMixing(true);
+		FTX::Audio->unlockAudio();
+
+		for (AudioReference& audioRef : audioRefs)
+		{
+			FTX::Audio->removeSound(audioRef);
+		}
+		outHash = rmx::addToFNV1a_64(rmx::startFNV1a_64(), &output[0], output.size());
+		return seconds;
+	};
+
+	uint64 plainHash = 0;
+	uint64 optimizedHash = 0;
+	const double plainSeconds = runPass(false, plainHash);
+	const double optimizedSeconds = runPass(true, optimizedHash);
+	const double audioSeconds = (double)(NUM_CALLBACKS * CALLBACK_SAMPLES) / (double)outputFrequency;
+	RMX_LOG_INFO(name << " of " << NUM_INSTANCES << " sounds, " << roundToInt(audioSeconds * 1000.0) << " ms of audio:");
+	RMX_LOG_INFO("   Plain:  " << roundToInt(plainSeconds * 1000000.0 / NUM_CALLBACKS) << " us per audio callback");
+	RMX_LOG_INFO("   Optimized:  " << roundToInt(optimizedSeconds * 1000000.0 / NUM_CALLBACKS) << " us per audio callback, "
+				 << "speedup " << roundToInt(plainSeconds / std::max(optimizedSeconds, 1e-9) * 100.0) << "%" << ((optimizedHash == plainHash) ? "" : ", OUTPUT MISMATCH"));
+}
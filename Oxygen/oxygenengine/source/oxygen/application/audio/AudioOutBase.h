@@ -77,9 +77,15 @@ public:
 	void handleActiveModsChanged();
 	void reloadAudioCollection();
 
+	// Micro-benchmark of the audio mixing with lots of sounds playing at the same time, comparing optimized mixing against the plain version, with the results written to the log
+	virtual void runBenchmark();
+
 protected:
 	virtual void determineActiveSourceRegistrations();
 
+	// Runs the mixing benchmark once with plain and once with optimized mixing; the optional function gets called before each of these passes
+	void runMixerBenchmark(const char* name, const std::function<void()>& preparePass = nullptr);
+
 protected:
 	AudioCollection mAudioCollection;
 	AudioPlayer mAudioPlayer;
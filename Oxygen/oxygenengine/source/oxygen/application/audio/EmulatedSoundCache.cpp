@@ -0,0 +1,263 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/application/audio/EmulatedSoundCache.h"
+#include "oxygen/application/Configuration.h"
+#include "oxygen/application/EngineMain.h"
+#include "oxygen/simulation/EmulatorInterface.h"
+
+
+namespace
+{
+	static const char CACHE_FILE_SIGNATURE[] = "OESC";
+	static const uint16 CACHE_FILE_FORMAT_VERSION = 2;
+	static const uint16 EMULATOR_OUTPUT_VERSION = 1;		// Increment this whenever the sound emulation produces different output, so existing cache files get invalidated
+	static const constexpr uint32 BLOCK_SIZE = 0x1000;		// In samples per channel
+
+	std::wstring getCacheFilename(uint64 key)
+	{
+		return Configuration::instance().mAppDataPath + L"cache/sound/" + *String(rmx::hexString(key, 16, "")).toWString() + L".bin";
+	}
+
+	uint64 addRomPageToHash(uint64 hash, uint32 pageIndex)
+	{
+		const uint8* rom = EmulatorInterface::instance().getRom();
+		return rmx::addToFNV1a_64(hash, &rom[pageIndex * SoundDriver::RomReadTracking::PAGE_SIZE], SoundDriver::RomReadTracking::PAGE_SIZE);
+	}
+}
+
+
+uint64 EmulatedSoundCache::buildKey(uint8 soundId, uint32 sourceAddress, const std::vector<uint8>& content, uint32 contentOffset, int sampleRate)
+{
+	uint64 hash = rmx::startFNV1a_64();
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&soundId, sizeof(soundId));
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&sourceAddress, sizeof(sourceAddress));
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&contentOffset, sizeof(contentOffset));
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&sampleRate, sizeof(sampleRate));
+	if (!content.empty())
+	{
+		hash = rmx::addToFNV1a_64(hash, &content[0], content.size());
+	}
+	return hash;
+}
+
+void EmulatedSoundCache::saveSound(uint64 key, AudioBuffer& audioBuffer, const SoundDriver::RomReadTracking& romReadTracking)
+{
+	// Sounds reading anything else than ROM can't be validated later on
+	if (romReadTracking.mReadOutsideRom)
+		return;
+
+	std::vector<uint8> buffer;
+	VectorBinarySerializer serializer(false, buffer);
+	serializer.write(CACHE_FILE_SIGNATURE, 4);
+	serializer.write(CACHE_FILE_FORMAT_VERSION);
+	serializer.write(EMULATOR_OUTPUT_VERSION);
+	serializer.write(EngineMain::getDelegate().getAppMetaData().mBuildVersionNumber);
+
+	// List of ROM pages that were read, and a hash over their content
+	uint64 romHash = rmx::startFNV1a_64();
+	std::vector<uint16> pageIndices;
+	for (uint32 pageIndex = 0; pageIndex < SoundDriver::RomReadTracking::NUM_PAGES; ++pageIndex)
+	{
+		if (romReadTracking.mReadPages.isBitSet(pageIndex))
+		{
+			pageIndices.push_back((uint16)pageIndex);
+			romHash = addRomPageToHash(romHash, pageIndex);
+		}
+	}
+	serializer.writeAs<uint32>(pageIndices.size());
+	if (!pageIndices.empty())
+	{
+		serializer.write(&pageIndices[0], pageIndices.size() * sizeof(uint16));
+	}
+	serializer.write(romHash);
+
+	// No need to lock the audio buffer for reading here, as this gets called by its producer, and persistent audio buffers don't get purged
+	if (audioBuffer.getChannels() != 2)
+		return;
+	const uint32 length = (uint32)audioBuffer.getLength();
+	if (length == 0)
+		return;
+	serializer.write<uint32>(audioBuffer.getFrequency());
+	serializer.write(length);
+	serializer.write<uint32>((length + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+	// Each block stores the two channels one after the other, as differences between consecutive samples, which compresses a lot better than the samples themselves
+	std::vector<int16> samples(BLOCK_SIZE * 2);
+	std::vector<uint8> compressed;
+	for (uint32 position = 0; position < length; position += BLOCK_SIZE)
+	{
+		const uint32 numSamples = std::min(length - position, BLOCK_SIZE);
+		int16 lastSample[2] = { 0, 0 };
+		for (uint32 done = 0; done < numSamples; )
+		{
+			short* data[2];
+			const uint32 available = (uint32)std::max(audioBuffer.getData(data, (int)(position + done)), 0);
+			if (available == 0)
+			{
+				// Data is not available any more, e.g. because it got purged
+				return;
+			}
+
+			const uint32 count = std::min(available, numSamples - done);
+			for (int channel = 0; channel < 2; ++channel)
+			{
+				int16* output = &samples[channel * numSamples + done];
+				for (uint32 i = 0; i < count; ++i)
+				{
+					output[i] = (int16)(uint16)(data[channel][i] - lastSample[channel]);
+					lastSample[channel] = data[channel][i];
+				}
+			}
+			done += count;
+		}
+
+		const size_t rawSize = numSamples * 2 * sizeof(int16);
+		const bool useCompression = ZlibDeflate::encode(compressed, &samples[0], rawSize) && compressed.size() < rawSize;
+		serializer.write(numSamples);
+		serializer.write<uint8>(useCompression ? 1 : 0);
+		if (useCompression)
+		{
+			serializer.writeAs<uint32>(compressed.size());
+			serializer.write(&compressed[0], compressed.size());
+		}
+		else
+		{
+			serializer.writeAs<uint32>(rawSize);
+			serializer.write(&samples[0], rawSize);
+		}
+	}
+
+	// Not using FTX::FileSystem here, as this can get called from a worker thread
+	rmx::FileIO::createDirectory(Configuration::instance().mAppDataPath + L"cache/sound/");
+	rmx::FileIO::saveFile(getCacheFilename(key), &buffer[0], buffer.size());
+}
+
+bool EmulatedSoundCache::load(uint64 key, int sampleRate)
+{
+	clear();
+	if (!FTX::FileSystem->readFile(getCacheFilename(key), mFileContent))
+		return false;
+
+	VectorBinarySerializer serializer(true, mFileContent);
+	char signature[4] = { 0 };
+	serializer.read(signature, 4);
+	if (memcmp(signature, CACHE_FILE_SIGNATURE, 4) != 0 || serializer.read<uint16>() != CACHE_FILE_FORMAT_VERSION)
+	{
+		clear();
+		return false;
+	}
+
+	// Sounds emulated by a different build might sound different, even if the emulator output version did not get changed
+	if (serializer.read<uint16>() != EMULATOR_OUTPUT_VERSION || serializer.read<uint32>() != EngineMain::getDelegate().getAppMetaData().mBuildVersionNumber)
+	{
+		clear();
+		return false;
+	}
+
+	// Check if the ROM content the sound was emulated from is still the same
+	const uint32 numPages = serializer.read<uint32>();
+	if (numPages > SoundDriver::RomReadTracking::NUM_PAGES || serializer.getRemaining() < numPages * sizeof(uint16))
+	{
+		clear();
+		return false;
+	}
+	uint64 romHash = rmx::startFNV1a_64();
+	for (uint32 k = 0; k < numPages; ++k)
+	{
+		const uint16 pageIndex = serializer.read<uint16>();
+		if (pageIndex >= SoundDriver::RomReadTracking::NUM_PAGES)
+		{
+			clear();
+			return false;
+		}
+		romHash = addRomPageToHash(romHash, pageIndex);
+	}
+	if (serializer.read<uint64>() != romHash || serializer.read<uint32>() != (uint32)sampleRate)
+	{
+		clear();
+		return false;
+	}
+
+	// Only build the block index here, decompression happens when the blocks are needed
+	const uint32 length = serializer.read<uint32>();
+	const uint32 numBlocks = serializer.read<uint32>();
+	uint32 totalSamples = 0;
+	for (uint32 k = 0; k < numBlocks && !serializer.hasError(); ++k)
+	{
+		Block block;
+		block.mNumSamples = serializer.read<uint32>();
+		block.mCompressed = (serializer.read<uint8>() != 0);
+		block.mSize = serializer.read<uint32>();
+		block.mOffset = serializer.getReadPosition();
+		if (serializer.getRemaining() < block.mSize || block.mNumSamples > BLOCK_SIZE || (!block.mCompressed && block.mSize != block.mNumSamples * 2 * sizeof(int16)))
+			break;
+
+		serializer.skip(block.mSize);
+		totalSamples += block.mNumSamples;
+		mBlocks.push_back(block);
+	}
+
+	if (serializer.hasError() || mBlocks.size() != numBlocks || totalSamples != length || numBlocks == 0)
+	{
+		RMX_LOG_WARNING("Emulated sound cache file '" << *WString(getCacheFilename(key)).toString() << "' is broken and will be replaced");
+		clear();
+		return false;
+	}
+	return true;
+}
+
+void EmulatedSoundCache::clear()
+{
+	mFileContent.clear();
+	mFileContent.shrink_to_fit();
+	mBlocks.clear();
+	mNextBlockIndex = 0;
+}
+
+bool EmulatedSoundCache::addNextBlock(AudioBuffer& audioBuffer)
+{
+	if (mNextBlockIndex >= mBlocks.size())
+		return false;
+
+	const Block& block = mBlocks[mNextBlockIndex];
+	++mNextBlockIndex;
+
+	const size_t rawSize = block.mNumSamples * 2 * sizeof(int16);
+	mSamples.resize(block.mNumSamples * 2);
+	if (block.mCompressed)
+	{
+		mDecompressed.clear();
+		if (!ZlibDeflate::decode(mDecompressed, &mFileContent[block.mOffset], block.mSize) || mDecompressed.size() != rawSize)
+		{
+			RMX_LOG_WARNING("Failed to decompress emulated sound cache data");
+			return false;
+		}
+		memcpy(&mSamples[0], &mDecompressed[0], rawSize);
+	}
+	else
+	{
+		memcpy(&mSamples[0], &mFileContent[block.mOffset], rawSize);
+	}
+
+	// Undo the difference encoding
+	int16* data[2] = { &mSamples[0], &mSamples[block.mNumSamples] };
+	for (int channel = 0; channel < 2; ++channel)
+	{
+		int16 lastSample = 0;
+		for (uint32 i = 0; i < block.mNumSamples; ++i)
+		{
+			lastSample = (int16)(uint16)(lastSample + data[channel][i]);
+			data[channel][i] = lastSample;
+		}
+	}
+
+	audioBuffer.addData(data, (int)block.mNumSamples);
+	return true;
+}
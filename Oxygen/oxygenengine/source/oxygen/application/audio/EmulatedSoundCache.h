@@ -0,0 +1,49 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "oxygen/simulation/sound/SoundDriver.h"
+
+
+// On-disk cache of the output of emulated sounds that are the same on each playback, so they don't need to get emulated again in later sessions
+//  - There is one cache file per sound, named after a hash of everything the output depends on, except for the ROM content
+//  - The sound driver may read data from all over the ROM (which can be changed by mods), so the file also contains a hash over the ROM pages that got read, to check them before using the file
+//  - Sample data is split into blocks that get compressed individually, so that a cached sound can be streamed block by block
+class EmulatedSoundCache
+{
+public:
+	static uint64 buildKey(uint8 soundId, uint32 sourceAddress, const std::vector<uint8>& content, uint32 contentOffset, int sampleRate);
+
+	// Writes a completely emulated sound to the cache; this may be called from a worker thread
+	static void saveSound(uint64 key, AudioBuffer& audioBuffer, const SoundDriver::RomReadTracking& romReadTracking);
+
+public:
+	bool load(uint64 key, int sampleRate);
+	inline bool isLoaded() const  { return !mBlocks.empty(); }
+	void clear();
+
+	// Adds the next block of samples to the audio buffer, returns false if all blocks were added already
+	bool addNextBlock(AudioBuffer& audioBuffer);
+
+private:
+	struct Block
+	{
+		size_t mOffset = 0;			// Offset of the block data inside the file content
+		uint32 mSize = 0;			// Size of the block data in bytes
+		uint32 mNumSamples = 0;
+		bool mCompressed = false;
+	};
+
+private:
+	std::vector<uint8> mFileContent;
+	std::vector<Block> mBlocks;
+	size_t mNextBlockIndex = 0;
+	std::vector<uint8> mDecompressed;
+	std::vector<int16> mSamples;
+};
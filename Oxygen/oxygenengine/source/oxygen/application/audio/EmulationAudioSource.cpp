@@ -8,12 +8,15 @@
 
 #include "oxygen/pch.h"
 #include "oxygen/application/audio/EmulationAudioSource.h"
+#include "oxygen/application/audio/AudioOutBase.h"
 #include "oxygen/application/Configuration.h"
+#include "oxygen/application/EngineMain.h"
+#include "oxygen/helper/HighResolutionTimer.h"
+#include "oxygen/resources/ResourcesCache.h"
+#include "oxygen/simulation/EmulatorInterface.h"
 
 #if defined(PLATFORM_VITA) // For the emergency unloads
-	#include "oxygen/application/audio/AudioOutBase.h"
 	#include "oxygen/application/audio/AudioPlayer.h"
-	#include "oxygen/application/EngineMain.h"
 #endif
 
 
@@ -53,6 +56,7 @@ bool EmulationAudioSource::initWithCustomContent(uint8 soundId, const std::wstri
 {
 	mSoundId = soundId;
 	mFilename = filename;
+	mContentOffset = contentOffset;
 
 	if (!mFilename.empty())
 	{
@@ -142,12 +146,12 @@ bool EmulationAudioSource::checkForUnload(float timestamp)
 		}
 
 		SDL_LockMutex(mMutex);
-		mAudioBuffer.lock();
 		mAudioBuffer.clear();
-		mAudioBuffer.unlock();
 		mState = State::INACTIVE;
 		mReadTime = 0.0f;
 		mSoundDriver.reset();
+		mCachedSound.clear();
+		mCacheKey = 0;
 
 		SDL_UnlockMutex(mMutex);
 		return true;
@@ -155,6 +159,88 @@ bool EmulationAudioSource::checkForUnload(float timestamp)
 	return false;
 }
 
+void EmulationAudioSource::runBenchmark()
+{
+	// Renders the first minute of each music track of the original soundtrack, the same way as the emulated audio sources do
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("--- SOUNDTRACK EMULATION BENCHMARK ---");
+
+	// The sound driver reads music data from the ROM, using an own emulator interface instance for this thread, as there might be no simulation yet
+	if (ResourcesCache::instance().getUnmodifiedRom().empty() && !ResourcesCache::instance().loadRom())
+	{
+		RMX_LOG_INFO("Skipped, as no ROM could be loaded");
+		return;
+	}
+	std::unique_ptr<EmulatorInterface> emulatorInterfaceInstance = std::make_unique<EmulatorInterface>();
+	emulatorInterfaceInstance->clear();
+
+	constexpr int NUM_FRAMES = 60 * 60;		// One minute of audio
+	const int sampleRate = Configuration::instance().mAudioSampleRate;
+	std::vector<int16> outBuffer(0x10000);
+	std::vector<uint8> content;
+	double totalSeconds = 0.0;
+	int totalFrames = 0;
+
+	const AudioCollection& audioCollection = EngineMain::instance().getAudioOut().getAudioCollection();
+	for (const auto& [keyId, audioDefinition] : audioCollection.getAudioDefinitions())
+	{
+		if (audioDefinition.mType != AudioCollection::AudioDefinition::Type::MUSIC)
+			continue;
+
+		const AudioCollection::SourceRegistration* sourceRegistration = nullptr;
+		for (const AudioCollection::SourceRegistration& source : audioDefinition.mSources)
+		{
+			if (source.mPackage == AudioCollection::Package::ORIGINAL && source.mType != AudioCollection::SourceRegistration::Type::FILE)
+			{
+				sourceRegistration = &source;
+				break;
+			}
+		}
+		if (nullptr == sourceRegistration)
+			continue;
+
+		std::unique_ptr<SoundDriver> soundDriver = std::make_unique<SoundDriver>();
+		if (!sourceRegistration->mSourceFile.empty())
+		{
+			if (!FTX::FileSystem->readFile(sourceRegistration->mSourceFile, content) || content.empty())
+				continue;
+			soundDriver->setFixedContent(&content[0], (uint32)content.size(), sourceRegistration->mContentOffset);
+		}
+		else if (sourceRegistration->mSourceAddress != 0)
+		{
+			soundDriver->setSourceAddress(sourceRegistration->mSourceAddress);
+		}
+		soundDriver->reset();
+		soundDriver->playSound(sourceRegistration->mEmulationSfxId);
+
+		std::unique_ptr<SoundEmulation> soundEmulation = std::make_unique<SoundEmulation>();
+		soundEmulation->init(sampleRate, 60.0);
+
+		uint64 checksum = rmx::startFNV1a_64();
+		HighResolutionTimer timer;
+		timer.start();
+		int frame = 0;
+		for (; frame < NUM_FRAMES; ++frame)
+		{
+			if (soundDriver->update() != SoundDriver::UpdateResult::CONTINUE)
+				break;
+
+			const int length = soundEmulation->update(&outBuffer[0], soundDriver->getSoundChipWrites());
+			checksum = rmx::addToFNV1a_64(checksum, (const uint8*)&outBuffer[0], length * 2 * sizeof(int16));
+		}
+		const double seconds = timer.getSecondsSinceStart();
+		totalSeconds += seconds;
+		totalFrames += frame;
+
+		RMX_LOG_INFO(audioDefinition.mKeyString << ":  " << roundToInt(seconds * 1000.0) << " ms for " << roundToInt(frame / 60.0f) << " seconds of audio (checksum " << rmx::hexString(checksum, 16) << ")");
+	}
+
+	if (totalFrames > 0)
+	{
+		RMX_LOG_INFO("Total:  " << roundToInt(totalSeconds * 1000.0) << " ms for " << roundToInt(totalFrames / 60.0f) << " seconds of audio, i.e. " << roundToInt(totalSeconds * 1000.0 * 3600.0 / totalFrames) << " ms per minute of audio");
+	}
+}
+
 AudioSourceBase::State EmulationAudioSource::startupInternal()
 {
 	if (isJobRegistered())
@@ -163,11 +249,28 @@ AudioSourceBase::State EmulationAudioSource::startupInternal()
 	}
 
 	SDL_LockMutex(mMutex);
-	mAudioBuffer.lock();
-	mAudioBuffer.clear(Configuration::instance().mAudioSampleRate, 2);
-	mAudioBuffer.unlock();
+	const int sampleRate = Configuration::instance().mAudioSampleRate;
+	mAudioBuffer.clear(sampleRate, 2);
+
+	// Sounds that are the same on each playback don't need to be emulated again if they're in the on-disk cache
+	mCachedSound.clear();
+	mCacheKey = 0;
+	if (!isDynamic() && Configuration::instance().mUseEmulatedSoundCache)
+	{
+		const uint64 cacheKey = EmulatedSoundCache::buildKey(mSoundId, mSourceAddress, mCompressedContent, mContentOffset, sampleRate);
+		if (mCachedSound.load(cacheKey, sampleRate))
+		{
+			SDL_UnlockMutex(mMutex);
+			return State::STREAMING;
+		}
 
-	mSoundEmulation.init(Configuration::instance().mAudioSampleRate, 60.0);
+		// Emulate it, and keep track of what was read from the ROM to store it together with the output
+		mCacheKey = cacheKey;
+		mRomReadTracking.clear();
+	}
+	mSoundDriver.setRomReadTracking((mCacheKey != 0) ? &mRomReadTracking : nullptr);
+
+	mSoundEmulation.init(sampleRate, 60.0);
 	mSoundDriver.reset();
 	mSoundDriver.playSound(mSoundId);
 	SDL_UnlockMutex(mMutex);
@@ -211,44 +314,18 @@ bool EmulationAudioSource::jobFunc()
 	const float targetTime = clamp(mPrecacheTime, 0.025f, mAudioBuffer.getLengthInSec() + 0.002f);
 	while (mAudioBuffer.getLengthInSec() < targetTime && shouldJobBeRunning())
 	{
-		const SoundDriver::UpdateResult updateResult = mSoundDriver.update();
-		const std::vector<SoundChipWrite>& writes = mSoundDriver.getSoundChipWrites();
-		bool isPlaying = (updateResult == SoundDriver::UpdateResult::CONTINUE);
-
-		static int16 soundBuffer[0x10000];
-		const uint32 length = mSoundEmulation.update(soundBuffer, writes);	// Returns length in samples
-
-		if (updateResult == SoundDriver::UpdateResult::FINISHED)
-		{
-			// Check if sound chips still produce output
-			for (uint32 i = 0; i < length * 2; ++i)
-			{
-				if (soundBuffer[i] < -2 || soundBuffer[i] > 0)	// Sometimes we get -2 indefinitely (e.g. sound ID "CC" does this)
-				{
-					isPlaying = true;
-					break;
-				}
-			}
-		}
-
-		if (isPlaying)
+		const bool isPlaying = mCachedSound.isLoaded() ? mCachedSound.addNextBlock(mAudioBuffer) : emulateFrame();
+		if (!isPlaying)
 		{
-			static int16 pcm[2][0x10000];
-			int16* pcmPtr[2] = { pcm[0], pcm[1] };
+			mAudioBuffer.setCompleted();
+			mState = State::COMPLETED;
 
-			for (uint32 i = 0; i < length; ++i)
+			if (mCacheKey != 0)
 			{
-				pcm[0][i] = soundBuffer[i*2];
-				pcm[1][i] = soundBuffer[i*2+1];
+				EmulatedSoundCache::saveSound(mCacheKey, mAudioBuffer, mRomReadTracking);
+				mCacheKey = 0;
 			}
-			mAudioBuffer.lock();
-			mAudioBuffer.addData(pcmPtr, length);
-			mAudioBuffer.unlock();
-		}
-		else
-		{
-			mAudioBuffer.setCompleted();
-			mState = State::COMPLETED;
+			mCachedSound.clear();
 			SDL_UnlockMutex(mMutex);
 
 			// Job completed
@@ -263,3 +340,41 @@ bool EmulationAudioSource::jobFunc()
 	// Keep going with this job, i.e. this method will get called again
 	return false;
 }
+
+bool EmulationAudioSource::emulateFrame()
+{
+	const SoundDriver::UpdateResult updateResult = mSoundDriver.update();
+	const std::vector<SoundChipWrite>& writes = mSoundDriver.getSoundChipWrites();
+	bool isPlaying = (updateResult == SoundDriver::UpdateResult::CONTINUE);
+
+	// Buffers are per thread, as multiple worker threads may update different audio sources at the same time
+	thread_local std::vector<int16> soundBuffer(0x10000);
+	const uint32 length = mSoundEmulation.update(&soundBuffer[0], writes);	// Returns length in samples
+
+	if (updateResult == SoundDriver::UpdateResult::FINISHED)
+	{
+		// Check if sound chips still produce output
+		for (uint32 i = 0; i < length * 2; ++i)
+		{
+			if (soundBuffer[i] < -2 || soundBuffer[i] > 0)	// Sometimes we get -2 indefinitely (e.g. sound ID "CC" does this)
+			{
+				isPlaying = true;
+				break;
+			}
+		}
+	}
+
+	if (isPlaying)
+	{
+		thread_local std::vector<int16> pcm[2] = { std::vector<int16>(0x10000), std::vector<int16>(0x10000) };
+		int16* pcmPtr[2] = { &pcm[0][0], &pcm[1][0] };
+
+		for (uint32 i = 0; i < length; ++i)
+		{
+			pcm[0][i] = soundBuffer[i*2];
+			pcm[1][i] = soundBuffer[i*2+1];
+		}
+		mAudioBuffer.addData(pcmPtr, length);
+	}
+	return isPlaying;
+}
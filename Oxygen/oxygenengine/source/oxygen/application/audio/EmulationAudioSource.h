@@ -9,6 +9,7 @@
 #pragma once
 
 #include "oxygen/application/audio/AudioSourceBase.h"
+#include "oxygen/application/audio/EmulatedSoundCache.h"
 #include "oxygen/simulation/sound/SoundEmulation.h"
 #include "oxygen/simulation/sound/SoundDriver.h"
 
@@ -31,6 +32,8 @@ public:
 
 	virtual bool checkForUnload(float timestamp) override;
 
+	static void runBenchmark();
+
 protected:
 	virtual State startupInternal() override;
 	virtual void progressInternal(float targetTime) override;
@@ -38,15 +41,23 @@ protected:
 protected:
 	virtual bool jobFunc() override;
 
+private:
+	bool emulateFrame();
+
 private:
 	uint8 mSoundId = 0;
 	uint32 mSourceAddress = 0;				// Usually not used (i.e. stays zero), except if a different address should be used than the one associated with the sound ID
 	std::wstring mFilename;					// Empty if using original ROM data
 	std::vector<uint8> mCompressedContent;	// Empty if using original ROM data
+	uint32 mContentOffset = 0;
 
 	SoundEmulation mSoundEmulation;
 	SoundDriver mSoundDriver;
 
+	EmulatedSoundCache mCachedSound;		// Only loaded while playing back a sound from the on-disk cache
+	uint64 mCacheKey = 0;					// Only set while emulating a sound whose output should be written to the on-disk cache
+	SoundDriver::RomReadTracking mRomReadTracking;
+
 	SDL_mutex* mMutex = nullptr;
 	float mPrecacheTime = 0.0f;
 };
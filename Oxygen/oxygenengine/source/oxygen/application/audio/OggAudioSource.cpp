@@ -84,9 +84,7 @@ void OggAudioSource::onPlaybackStart(AudioReference& audioRef, float time)
 		audioRef.setLoop(false);
 
 		// Always start with an empty audio buffer, it will get filled now
-		mAudioBuffer.lock();
 		mAudioBuffer.clear(mAudioBuffer.getFrequency());
-		mAudioBuffer.unlock();
 		mReadTime = 0.0f;
 
 		// Perform seeking if needed
@@ -150,9 +148,7 @@ bool OggAudioSource::checkForUnload(float timestamp)
 		}
 
 		SDL_LockMutex(mMutex);
-		mAudioBuffer.lock();
 		mAudioBuffer.clear();
-		mAudioBuffer.unlock();
 		mState = State::INACTIVE;
 		mReadTime = 0.0f;
 
@@ -214,9 +210,7 @@ AudioSourceBase::State OggAudioSource::startupInternal()
 	{
 		mOggLoader = new OggLoader();
 	}
-	mAudioBuffer.lock();
 	const bool success = mOggLoader->startVorbisStreaming(&mAudioBuffer, mInputStream);
-	mAudioBuffer.unlock();
 	SDL_UnlockMutex(mMutex);
 
 	return success ? State::STREAMING : State::COMPLETED;
@@ -298,11 +292,9 @@ bool OggAudioSource::jobFunc()
 
 void OggAudioSource::updateStreaming(float targetTime)
 {
-	mAudioBuffer.lock();
 	while (mAudioBuffer.getLengthInSec() < targetTime)
 	{
 		if (!mOggLoader->updateStreaming())
 			break;
 	}
-	mAudioBuffer.unlock();
 }
@@ -406,7 +406,7 @@ void GameView::keyboard(const rmx::KeyboardEvent& ev)
 						{
 							HighResolutionTimer timer;
 							timer.start();
-							if (mSimulation.triggerFullScriptsReload())
+							if (mSimulation.triggerScriptsReload())
 							{
 								setLogDisplay(String(0, "Reloaded scripts in %0.2f sec", timer.getSecondsSinceStart()));
 							}
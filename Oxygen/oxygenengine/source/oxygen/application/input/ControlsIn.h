@@ -11,7 +11,7 @@
 #include "oxygen/application/input/InputManager.h"
 
 
-class ControlsIn : public SingleInstance<ControlsIn>
+class ControlsIn : public PerThreadInstance<ControlsIn>
 {
 public:
 	enum class Button
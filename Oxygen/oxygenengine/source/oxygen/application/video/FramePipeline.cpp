@@ -0,0 +1,210 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/application/video/FramePipeline.h"
+#include "oxygen/rendering/parts/RenderParts.h"
+#include "oxygen/rendering/software/SoftwareRenderer.h"
+#include "oxygen/simulation/EmulatorInterface.h"
+
+
+FramePipeline::FramePipeline(DrawerTexture& gameScreenTexture) :
+	mGameScreenTexture(gameScreenTexture)
+{
+	// Wait until the render thread created its instances
+	mThread = std::thread(&FramePipeline::threadFunc, this);
+	std::unique_lock<std::mutex> lock(mMutex);
+	mCondition.wait(lock, [&] { return mThreadReady; });
+}
+
+FramePipeline::~FramePipeline()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopThread = true;
+	}
+	mCondition.notify_all();
+	mThread.join();
+
+	clearGeometries();
+}
+
+void FramePipeline::submitFrame(const RenderParts& renderParts, const std::vector<Geometry*>& geometries, const Vec2i& gameResolution)
+{
+	RMX_CHECK(!mFrameInFlight, "Last frame must be finished before submitting the next one", finishFrame());
+
+	// Take the snapshot, the render thread is idle in the meantime
+	mRenderParts->copyForRendering(renderParts);
+	memcpy(mEmulatorInterface->getVRam(), EmulatorInterface::instance().getVRam(), 0x10000);
+	copyGeometries(geometries);
+	mGameResolution = gameResolution;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mRenderRequested = true;
+	}
+	mCondition.notify_all();
+	mFrameInFlight = true;
+}
+
+bool FramePipeline::finishFrame()
+{
+	if (!mFrameInFlight)
+		return false;
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mCondition.wait(lock, [&] { return !mRenderRequested; });
+	}
+	mFrameInFlight = false;
+
+	mGameScreenTexture.accessBitmap() = mOutputTexture.accessBitmap();
+	mGameScreenTexture.bitmapUpdated();
+	return true;
+}
+
+void FramePipeline::threadFunc()
+{
+	// Create this thread's own instances, so that the renderer reads the snapshot instead of the simulation's state
+	std::unique_ptr<EmulatorInterface> emulatorInterface = std::make_unique<EmulatorInterface>();
+	std::unique_ptr<RenderParts> renderParts = std::make_unique<RenderParts>();
+	std::unique_ptr<SoftwareRenderer> renderer = std::make_unique<SoftwareRenderer>(*renderParts, mOutputTexture);
+	renderer->initialize();
+	Vec2i gameResolution = Configuration::instance().mGameScreen;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mEmulatorInterface = emulatorInterface.get();
+		mRenderParts = renderParts.get();
+		mRenderer = renderer.get();
+		mThreadReady = true;
+	}
+	mCondition.notify_all();
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [&] { return mStopThread || mRenderRequested; });
+			if (mStopThread)
+				break;
+		}
+
+		if (gameResolution != mGameResolution)
+		{
+			gameResolution = mGameResolution;
+			renderer->setGameResolution(gameResolution);
+		}
+		renderer->renderGameScreen(mGeometries);
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mRenderRequested = false;
+		}
+		mCondition.notify_all();
+	}
+
+	// Instances must be destroyed by the thread that created them
+	mRenderer = nullptr;
+	mRenderParts = nullptr;
+	mEmulatorInterface = nullptr;
+	renderer.reset();
+	renderParts.reset();
+	emulatorInterface.reset();
+}
+
+void FramePipeline::copyGeometries(const std::vector<Geometry*>& geometries)
+{
+	clearGeometries();
+	for (const Geometry* geometry : geometries)
+	{
+		Geometry* copy = nullptr;
+		switch (geometry->getType())
+		{
+			case Geometry::Type::PLANE:
+			{
+				const PlaneGeometry& pg = geometry->as<PlaneGeometry>();
+				copy = &mGeometryFactory.createPlaneGeometry(pg.mActiveRect, pg.mPlaneIndex, pg.mPriorityFlag, pg.mScrollOffsets, pg.mRenderQueue);
+				break;
+			}
+
+			case Geometry::Type::SPRITE:
+			{
+				// Sprite render items get destroyed or changed by the next frame simulation, so these need to be copied as well
+				const renderitems::SpriteInfo& spriteInfo = geometry->as<SpriteGeometry>().mSpriteInfo;
+				renderitems::SpriteInfo* spriteInfoCopy = nullptr;
+				switch (spriteInfo.getType())
+				{
+					case RenderItem::Type::VDP_SPRITE:		 spriteInfoCopy = &mVdpSprites.createObject(static_cast<const renderitems::VdpSpriteInfo&>(spriteInfo));				break;
+					case RenderItem::Type::PALETTE_SPRITE:	 spriteInfoCopy = &mPaletteSprites.createObject(static_cast<const renderitems::PaletteSpriteInfo&>(spriteInfo));		break;
+					case RenderItem::Type::COMPONENT_SPRITE: spriteInfoCopy = &mComponentSprites.createObject(static_cast<const renderitems::ComponentSpriteInfo&>(spriteInfo));	break;
+					case RenderItem::Type::SPRITE_MASK:		 spriteInfoCopy = &mSpriteMasks.createObject(static_cast<const renderitems::SpriteMaskInfo&>(spriteInfo));			break;
+					default:
+						RMX_ERROR("Unsupported render item type for a sprite geometry", continue);
+				}
+				mSpriteInfos.push_back(spriteInfoCopy);
+				copy = &mGeometryFactory.createSpriteGeometry(*spriteInfoCopy);
+				break;
+			}
+
+			case Geometry::Type::RECT:
+			{
+				const RectGeometry& rg = geometry->as<RectGeometry>();
+				copy = &mGeometryFactory.createRectGeometry(rg.mRect, rg.mColor);
+				break;
+			}
+
+			case Geometry::Type::TEXTURED_RECT:
+			{
+				// The texture is owned by the printed text cache, which only removes textures not used since its last cleanup
+				const TexturedRectGeometry& trg = geometry->as<TexturedRectGeometry>();
+				copy = &mGeometryFactory.createTexturedRectGeometry(trg.mRect, trg.mDrawerTexture, trg.mTintColor, trg.mAddedColor);
+				break;
+			}
+
+			case Geometry::Type::EFFECT_BLUR:
+			{
+				copy = &mGeometryFactory.createEffectBlurGeometry(geometry->as<EffectBlurGeometry>().mBlurValue);
+				break;
+			}
+
+			case Geometry::Type::VIEWPORT:
+			{
+				copy = &mGeometryFactory.createViewportGeometry(geometry->as<ViewportGeometry>().mRect);
+				break;
+			}
+
+			default:
+				continue;
+		}
+		copy->mRenderQueue = geometry->mRenderQueue;
+		mGeometries.push_back(copy);
+	}
+}
+
+void FramePipeline::clearGeometries()
+{
+	for (Geometry* geometry : mGeometries)
+	{
+		mGeometryFactory.destroy(*geometry);
+	}
+	mGeometries.clear();
+
+	for (renderitems::SpriteInfo* spriteInfo : mSpriteInfos)
+	{
+		switch (spriteInfo->getType())
+		{
+			case RenderItem::Type::VDP_SPRITE:		 mVdpSprites.destroyObject(static_cast<renderitems::VdpSpriteInfo&>(*spriteInfo));				break;
+			case RenderItem::Type::PALETTE_SPRITE:	 mPaletteSprites.destroyObject(static_cast<renderitems::PaletteSpriteInfo&>(*spriteInfo));		break;
+			case RenderItem::Type::COMPONENT_SPRITE: mComponentSprites.destroyObject(static_cast<renderitems::ComponentSpriteInfo&>(*spriteInfo));	break;
+			case RenderItem::Type::SPRITE_MASK:		 mSpriteMasks.destroyObject(static_cast<renderitems::SpriteMaskInfo&>(*spriteInfo));			break;
+			default:	break;
+		}
+	}
+	mSpriteInfos.clear();
+}
@@ -0,0 +1,74 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "oxygen/drawing/DrawerTexture.h"
+#include "oxygen/rendering/Geometry.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class EmulatorInterface;
+class RenderParts;
+class SoftwareRenderer;
+
+
+// Renders the game screen with the software renderer on an own thread, while the main thread already simulates the next frame
+//  - Each submitted frame is a snapshot of everything the renderer reads: render parts, VRAM, and the geometries incl. their sprite render items
+//  - The render thread has its own emulator interface and render parts instances for that, see "PerThreadInstance"
+//  - The result of a frame gets written to the game screen texture only when the next frame gets submitted, so this adds one frame of latency
+//  - Sprites and palettes from the global collections are not part of the snapshot, these are expected to not change during a frame simulation
+class FramePipeline
+{
+public:
+	explicit FramePipeline(DrawerTexture& gameScreenTexture);
+	~FramePipeline();
+
+	inline bool isFrameInFlight() const  { return mFrameInFlight; }
+
+	// Takes a snapshot for rendering, and starts rendering it on the render thread; the last frame must be finished already
+	void submitFrame(const RenderParts& renderParts, const std::vector<Geometry*>& geometries, const Vec2i& gameResolution);
+
+	// Waits until the frame in flight (if any) is rendered, and writes it into the game screen texture; returns false if there was no frame in flight
+	bool finishFrame();
+
+private:
+	void threadFunc();
+	void copyGeometries(const std::vector<Geometry*>& geometries);
+	void clearGeometries();
+
+private:
+	DrawerTexture& mGameScreenTexture;
+	bool mFrameInFlight = false;
+
+	// Synchronization with the render thread
+	std::thread mThread;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mThreadReady = false;
+	bool mRenderRequested = false;
+	bool mStopThread = false;
+
+	// Everything below is owned by the render thread while a frame is in flight, and by the main thread otherwise
+	EmulatorInterface* mEmulatorInterface = nullptr;
+	RenderParts* mRenderParts = nullptr;
+	SoftwareRenderer* mRenderer = nullptr;
+	DrawerTexture mOutputTexture;
+	Vec2i mGameResolution;
+	std::vector<Geometry*> mGeometries;
+	GeometryFactory mGeometryFactory;
+
+	// Copies of the sprite render items referenced by the geometries
+	ObjectPool<renderitems::VdpSpriteInfo>		 mVdpSprites;
+	ObjectPool<renderitems::PaletteSpriteInfo>	 mPaletteSprites;
+	ObjectPool<renderitems::ComponentSpriteInfo> mComponentSprites;
+	ObjectPool<renderitems::SpriteMaskInfo>		 mSpriteMasks;
+	std::vector<renderitems::SpriteInfo*> mSpriteInfos;
+};
@@ -10,6 +10,7 @@
 #include "oxygen/application/video/VideoOut.h"
 #include "oxygen/application/Configuration.h"
 #include "oxygen/application/EngineMain.h"
+#include "oxygen/application/video/FramePipeline.h"
 #include "oxygen/drawing/opengl/OpenGLDrawer.h"
 #include "oxygen/helper/Logging.h"
 #include "oxygen/rendering/Geometry.h"
@@ -31,6 +32,7 @@ VideoOut::VideoOut() :
 
 VideoOut::~VideoOut()
 {
+	delete mFramePipeline;
 	delete mRenderParts;
 	delete &mRenderResources;
 	delete mSoftwareRenderer;
@@ -58,11 +60,13 @@ void VideoOut::startup()
 
 void VideoOut::shutdown()
 {
+	SAFE_DELETE(mFramePipeline);
 	clearGeometries();
 }
 
 void VideoOut::reset()
 {
+	finishPipelinedFrame();
 	mRenderParts->reset();
 	mActiveRenderer->reset();
 
@@ -85,6 +89,7 @@ void VideoOut::createRenderer(bool reset)
 
 void VideoOut::destroyRenderer()
 {
+	SAFE_DELETE(mFramePipeline);
 	SAFE_DELETE(mSoftwareRenderer);
 #ifdef RMX_WITH_OPENGL_SUPPORT
 	SAFE_DELETE(mOpenGLRenderer);
@@ -93,6 +98,8 @@ void VideoOut::destroyRenderer()
 
 void VideoOut::setActiveRenderer(bool useOpenGLRenderer, bool reset)
 {
+	finishPipelinedFrame();
+
 #ifdef RMX_WITH_OPENGL_SUPPORT
 	if (useOpenGLRenderer)
 	{
@@ -129,6 +136,8 @@ void VideoOut::setActiveRenderer(bool useOpenGLRenderer, bool reset)
 
 void VideoOut::setScreenSize(uint32 width, uint32 height)
 {
+	finishPipelinedFrame();
+
 	mGameResolution.x = width;
 	mGameResolution.y = height;
 
@@ -202,8 +211,8 @@ bool VideoOut::updateGameScreen()
 	const bool hasNewSimulationFrame = (mFrameState == FrameState::FRAME_READY);
 	if (!hasNewSimulationFrame && !mFrameInterpolation.mCurrentlyInterpolating && !mDebugDrawRenderingRequested && !mRequireGameScreenUpdate)
 	{
-		// No update
-		return false;
+		// No update, except for a pipelined frame that is still to be shown
+		return (nullptr != mFramePipeline && mFramePipeline->finishFrame());
 	}
 
 	mFrameState = FrameState::OUTSIDE_FRAME;
@@ -225,6 +234,8 @@ bool VideoOut::updateGameScreen()
 
 void VideoOut::blurGameScreen()
 {
+	finishPipelinedFrame();
+
 #ifdef RMX_WITH_OPENGL_SUPPORT
 	if (mActiveRenderer == mOpenGLRenderer)
 	{
@@ -233,6 +244,44 @@ void VideoOut::blurGameScreen()
 #endif
 }
 
+bool VideoOut::checkFramePipeline()
+{
+	if (nullptr == mSoftwareRenderer || mActiveRenderer != mSoftwareRenderer)
+		return true;
+
+	finishPipelinedFrame();
+	Configuration& config = Configuration::instance();
+	const int oldSoftwareRendererThreads = config.mSoftwareRendererThreads;
+
+	// Serial rendering on this thread as reference
+	config.mSoftwareRendererThreads = 1;
+	mSoftwareRenderer->renderGameScreen(mGeometries);
+	const Bitmap expectedBitmap = mGameScreenTexture.accessBitmap();
+
+	// Render the same frame with the pipeline, while the live VRAM gets changed like the next frame's simulation would do
+	//  -> Any read of the live VRAM instead of the pipeline's snapshot then shows up as a difference
+	config.mSoftwareRendererThreads = 4;
+	if (nullptr == mFramePipeline)
+	{
+		mFramePipeline = new FramePipeline(mGameScreenTexture);
+	}
+	mFramePipeline->submitFrame(*mRenderParts, mGeometries, mGameResolution);
+
+	uint8* vram = EmulatorInterface::instance().getVRam();
+	const std::vector<uint8> vramBackup(vram, vram + 0x10000);
+	for (size_t i = 0; i < 0x10000; ++i)
+	{
+		vram[i] ^= 0xff;
+	}
+	mFramePipeline->finishFrame();
+	memcpy(vram, vramBackup.data(), 0x10000);
+	config.mSoftwareRendererThreads = oldSoftwareRendererThreads;
+
+	const Bitmap& bitmap = mGameScreenTexture.accessBitmap();
+	return (bitmap.getWidth() == expectedBitmap.getWidth() && bitmap.getHeight() == expectedBitmap.getHeight() &&
+			memcmp(bitmap.getData(), expectedBitmap.getData(), (size_t)bitmap.getPixelCount() * sizeof(uint32)) == 0);
+}
+
 void VideoOut::toggleLayerRendering(int index)
 {
 	mRenderParts->mLayerRendering[index] = !mRenderParts->mLayerRendering[index];
@@ -510,6 +559,9 @@ void VideoOut::collectGeometries(std::vector<Geometry*>& geometries)
 
 void VideoOut::renderGameScreen()
 {
+	// The frame in flight needs to be finished first, as it may still use textures of the printed text cache
+	finishPipelinedFrame();
+
 	// Collect geometries to render
 	clearGeometries();
 	if (mRenderParts->getActiveDisplay())
@@ -518,7 +570,33 @@ void VideoOut::renderGameScreen()
 	}
 
 	// Render them
-	mActiveRenderer->renderGameScreen(mGeometries);
+	if (useFramePipeline())
+	{
+		// Rendering happens on the pipeline's thread while the next frame gets simulated, the result is shown with the next update
+		if (nullptr == mFramePipeline)
+		{
+			RMX_LOG_INFO("VideoOut: Creating frame pipeline");
+			mFramePipeline = new FramePipeline(mGameScreenTexture);
+		}
+		mFramePipeline->submitFrame(*mRenderParts, mGeometries, mGameResolution);
+	}
+	else
+	{
+		mActiveRenderer->renderGameScreen(mGeometries);
+	}
+}
+
+bool VideoOut::useFramePipeline() const
+{
+	return Configuration::instance().mFramePipelining && nullptr != mSoftwareRenderer && mActiveRenderer == mSoftwareRenderer;
+}
+
+void VideoOut::finishPipelinedFrame()
+{
+	if (nullptr != mFramePipeline)
+	{
+		mFramePipeline->finishFrame();
+	}
 }
 
 void VideoOut::preRefreshDebugging()
@@ -540,6 +618,7 @@ void VideoOut::postRefreshDebugging()
 
 void VideoOut::renderDebugDraw(int debugDrawMode, const Recti& rect)
 {
+	finishPipelinedFrame();
 	mActiveRenderer->renderDebugDraw(debugDrawMode, rect);
 }
 
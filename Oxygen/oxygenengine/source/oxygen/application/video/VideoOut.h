@@ -11,6 +11,7 @@
 #include "oxygen/drawing/DrawerTexture.h"
 #include "oxygen/rendering/Geometry.h"
 
+class FramePipeline;
 class Renderer;
 class OpenGLRenderer;
 class SoftwareRenderer;
@@ -54,6 +55,9 @@ public:
 	bool updateGameScreen();
 	void blurGameScreen();
 
+	// Renders the last frame again with the frame pipeline and multiple bands, and returns whether that gives the same output as serial rendering
+	bool checkFramePipeline();
+
 	void preRefreshDebugging();
 	void postRefreshDebugging();
 
@@ -75,6 +79,8 @@ private:
 	void collectGeometries(std::vector<Geometry*>& geometries);
 
 	void renderGameScreen();
+	bool useFramePipeline() const;
+	void finishPipelinedFrame();
 
 private:
 	enum class FrameState
@@ -95,6 +101,7 @@ private:
 private:
 	Renderer* mActiveRenderer = nullptr;
 	SoftwareRenderer* mSoftwareRenderer = nullptr;
+	FramePipeline* mFramePipeline = nullptr;	// Only created when frame pipelining gets used at all
 #ifdef RMX_WITH_OPENGL_SUPPORT
 	OpenGLRenderer* mOpenGLRenderer = nullptr;
 #endif
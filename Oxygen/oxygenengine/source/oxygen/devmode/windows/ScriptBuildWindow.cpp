@@ -42,7 +42,7 @@ void ScriptBuildWindow::buildContent()
 	{
 		HighResolutionTimer timer;
 		timer.start();
-		if (simulation.triggerFullScriptsReload())
+		if (simulation.triggerScriptsReload())
 		{
 			LogDisplay::instance().setLogDisplay(String(0, "Reloaded scripts in %0.2f sec", timer.getSecondsSinceStart()));
 		}
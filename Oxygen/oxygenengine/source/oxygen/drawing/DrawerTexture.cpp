@@ -10,6 +10,14 @@
 #include "oxygen/drawing/DrawerTexture.h"
 #include "oxygen/drawing/Drawer.h"
 
+#include <atomic>
+
+
+namespace
+{
+	std::atomic<uint32> gGlobalTextureChangeCounter = 0;	// Textures not registered at a drawer can get updated by other threads, see "FramePipeline"
+}
+
 
 DrawerTexture::~DrawerTexture()
 {
@@ -43,6 +51,7 @@ void DrawerTexture::clearBitmap()
 {
 	mBitmap.clear();
 	invalidate();
+	increaseChangeCounter();
 }
 
 Bitmap& DrawerTexture::accessBitmap()
@@ -53,6 +62,7 @@ Bitmap& DrawerTexture::accessBitmap()
 void DrawerTexture::bitmapUpdated()
 {
 	mSize.set(mBitmap.getWidth(), mBitmap.getHeight());
+	increaseChangeCounter();
 
 	if (nullptr != mImplementation)
 	{
@@ -68,6 +78,7 @@ void DrawerTexture::setupAsRenderTarget(uint32 width, uint32 height)
 
 	mSize.set(width, height);
 	mSetupAsRenderTarget = true;
+	increaseChangeCounter();
 
 	if (nullptr != mImplementation)
 	{
@@ -88,4 +99,11 @@ void DrawerTexture::swap(DrawerTexture& other)
 	mBitmap.swap(other.mBitmap);
 	std::swap(mSize, other.mSize);
 	std::swap(mImplementation, other.mImplementation);
+	increaseChangeCounter();
+	other.increaseChangeCounter();
+}
+
+void DrawerTexture::increaseChangeCounter()
+{
+	mChangeCounter = ++gGlobalTextureChangeCounter;
 }
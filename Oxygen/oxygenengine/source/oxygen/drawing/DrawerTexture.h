@@ -57,6 +57,12 @@ public:
 
 	void swap(DrawerTexture& other);
 
+	// Changes whenever the texture content got updated, and is unique among all textures (so it can't be mixed up with one destroyed earlier)
+	uint32 getChangeCounter() const	{ return mChangeCounter; }
+
+private:
+	void increaseChangeCounter();
+
 private:
 	Drawer* mRegisteredOwner = nullptr;
 	size_t mRegisteredIndex = 0;
@@ -64,6 +70,7 @@ private:
 	Bitmap mBitmap;		// Holding the texture content, except if this is an OpenGL render target
 	Vec2i mSize;		// Resolution of the texture -- either the size of the bitmap or of an OpenGL render target
 	bool mSetupAsRenderTarget = false;
+	uint32 mChangeCounter = 0;
 
 	DrawerTextureImplementation* mImplementation = nullptr;
 };
@@ -9,6 +9,7 @@
 #include "oxygen/pch.h"
 #include "oxygen/drawing/software/Blitter.h"
 #include "oxygen/drawing/software/BlitterHelper.h"
+#include "oxygen/rendering/utils/PixelKernels.h"
 
 
 namespace
@@ -53,6 +54,162 @@ namespace
 		minX = clamp(minX, 0, width);
 		maxX = clamp(maxX, 0, width);
 	}
+
+	void swapRedBlueChannels(uint32* dst, const uint32* src, int numPixels)
+	{
+		int k = 0;
+		if constexpr (sizeof(void*) == 8)
+		{
+			// On 64-bit architectures: Process 2 pixels at once
+			for (; k + 2 <= numPixels; k += 2)
+			{
+				uint64 colors;
+				memcpy(&colors, &src[k], 8);
+				colors = ((colors & 0x00ff000000ff0000ull) >> 16) | (colors & 0xff00ff00ff00ff00ull) | ((colors & 0x000000ff000000ffull) << 16);
+				memcpy(&dst[k], &colors, 8);
+			}
+		}
+		// Process single pixels
+		for (; k < numPixels; ++k)
+		{
+			const uint32 color = src[k];
+			dst[k] = ((color & 0x00ff0000) >> 16) | (color & 0xff00ff00) | ((color & 0x000000ff) << 16);
+		}
+	}
+
+	// Color changes applied to each line before merging it into the output (like tint color / added color)
+	class ColorProcessing
+	{
+	public:
+		explicit ColorProcessing(Blitter::Options& options)
+		{
+			mUseTint = (nullptr != options.mTintColor || nullptr != options.mAddedColor);
+			mSwapRedBlueChannels = options.mSwapRedBlueChannels;
+			if (!mUseTint)
+				return;
+
+			if (nullptr != options.mTintColor)
+			{
+				mMultiply[0] = clamp((int)(options.mTintColor->r * 0x100 + 0.5f), -0x10000, 0x10000);
+				mMultiply[1] = clamp((int)(options.mTintColor->g * 0x100 + 0.5f), -0x10000, 0x10000);
+				mMultiply[2] = clamp((int)(options.mTintColor->b * 0x100 + 0.5f), -0x10000, 0x10000);
+				mMultiply[3] = clamp((int)(options.mTintColor->a * 0x100 + 0.5f), -0x10000, 0x10000);
+			}
+			if (nullptr != options.mAddedColor)
+			{
+				// Added color does not affect the alpha channel
+				mAdd[0] = (int)(options.mAddedColor->r * 0xff + 0.5f);
+				mAdd[1] = (int)(options.mAddedColor->g * 0xff + 0.5f);
+				mAdd[2] = (int)(options.mAddedColor->b * 0xff + 0.5f);
+			}
+
+			// The pixel kernel covers the usual case of tint colors up to 1.0; limiting the added values makes no difference, as the result gets clamped anyways
+			mUseKernel = true;
+			for (int k = 0; k < 4; ++k)
+			{
+				mUseKernel = mUseKernel && (mMultiply[k] >= 0 && mMultiply[k] <= 0x100);
+				mKernelMultiply[k] = (int16)clamp(mMultiply[k], 0, 0x100);
+				mKernelAdd[k] = (int16)clamp(mAdd[k], -0xff, 0xff);
+			}
+
+			// Special handling for one-bit alpha if tint color enforces alpha blending
+			if (nullptr != options.mTintColor && options.mTintColor->a < 1.0f && options.mBlendMode == BlendMode::ONE_BIT)
+			{
+				options.mBlendMode = BlendMode::ALPHA;
+				mUseOneBitAlpha = true;
+				mOneBitAlphaValue = (uint32)(uint8)(options.mTintColor->a * 255.0f + 0.5f) << 24;
+			}
+		}
+
+		// Writes the processed colors of the source line into the destination line, which may also be the same
+		void processLine(uint32* dst, const uint32* src, int numPixels) const
+		{
+			if (mUseTint)
+			{
+				if (mUseKernel)
+				{
+					PixelKernels::tintLine(dst, src, mKernelMultiply, mKernelAdd, numPixels);
+				}
+				else
+				{
+					const uint8* srcBytes = (const uint8*)src;
+					uint8* dstBytes = (uint8*)dst;
+					for (int x = 0; x < numPixels; ++x)
+					{
+						dstBytes[0] = (uint8)clamp(((srcBytes[0] * mMultiply[0]) >> 8) + mAdd[0], 0, 0xff);
+						dstBytes[1] = (uint8)clamp(((srcBytes[1] * mMultiply[1]) >> 8) + mAdd[1], 0, 0xff);
+						dstBytes[2] = (uint8)clamp(((srcBytes[2] * mMultiply[2]) >> 8) + mAdd[2], 0, 0xff);
+						dstBytes[3] = (uint8)clamp(((srcBytes[3] * mMultiply[3]) >> 8),           0, 0xff);
+						srcBytes += 4;
+						dstBytes += 4;
+					}
+				}
+				src = dst;
+
+				if (mUseOneBitAlpha)
+				{
+					for (int x = 0; x < numPixels; ++x)
+					{
+						dst[x] = (dst[x] & 0x00ffffff) | ((dst[x] & 0xff000000) ? mOneBitAlphaValue : 0);
+					}
+				}
+			}
+
+			if (mSwapRedBlueChannels)
+			{
+				swapRedBlueChannels(dst, src, numPixels);
+			}
+			else if (src != dst)
+			{
+				memcpy(dst, src, numPixels * sizeof(uint32));
+			}
+		}
+
+	private:
+		bool mUseTint = false;
+		bool mUseKernel = false;
+		bool mUseOneBitAlpha = false;
+		bool mSwapRedBlueChannels = false;
+		int mMultiply[4] = { 0x100, 0x100, 0x100, 0x100 };
+		int mAdd[4] = { 0, 0, 0, 0 };
+		int16 mKernelMultiply[4] = { 0x100, 0x100, 0x100, 0x100 };
+		int16 mKernelAdd[4] = { 0, 0, 0, 0 };
+		uint32 mOneBitAlphaValue = 0;
+	};
+
+	// Samples a line of a transformed sprite, starting at the given offset from the sprite position
+	//  -> Each pixel gets transformed on its own instead of accumulating a step, so the result does not depend on where the output got cropped
+	template<typename POINT_SAMPLER, typename BILINEAR_SAMPLER>
+	void sampleTransformedLine(uint32* dst, int numPixels, Vec2i offset, const Vec2f& floatPivot, const Blitter::Options& options, const POINT_SAMPLER& pointSampler, const BILINEAR_SAMPLER& bilinearSampler)
+	{
+		const float dy = (float)offset.y + 0.5f;
+		switch (options.mSamplingMode)
+		{
+			case SamplingMode::POINT:
+			{
+				for (int ix = 0; ix < numPixels; ++ix)
+				{
+					const float dx = (float)(offset.x + ix) + 0.5f;
+					const float localX = dx * options.mInvTransform[0] + dy * options.mInvTransform[1] + floatPivot.x;
+					const float localY = dx * options.mInvTransform[2] + dy * options.mInvTransform[3] + floatPivot.y;
+					dst[ix] = pointSampler((int)localX, (int)localY);
+				}
+				break;
+			}
+
+			case SamplingMode::BILINEAR:
+			{
+				for (int ix = 0; ix < numPixels; ++ix)
+				{
+					const float dx = (float)(offset.x + ix) + 0.5f;
+					const float localX = dx * options.mInvTransform[0] + dy * options.mInvTransform[1] + floatPivot.x - 0.5f;
+					const float localY = dx * options.mInvTransform[2] + dy * options.mInvTransform[3] + floatPivot.y - 0.5f;
+					dst[ix] = bilinearSampler(localX, localY);
+				}
+				break;
+			}
+		}
+	}
 }
 
 
@@ -81,43 +238,27 @@ void Blitter::blitSprite(const OutputWrapper& output, const SpriteWrapper& sprit
 	if (mPixelSegments.empty())
 		return;
 
-	// TODO: Use "mPixelSegments" in more of the calculations below
-
 	if (nullptr == options.mTransform)
 	{
+		// Lines get read directly from the sprite data, even color processing does not need a copy of the sprite
 		const Vec2i innerIndent = outputBoundingBox.getPos() - position + sprite.mPivot;
-
-		// As an optimization, differentiate between whether intermediate processing is needed (and we thus need to make an actual copy of the sprite data) or not
-		if (needsIntermediateProcessing(options))
-		{
-			// Copy only the actually used part from the input sprite into an intermediate bitmap
-			BitmapViewMutable<uint32> intermediate = makeTempBitmapAsCopy(sprite.mBitmapView, outputBoundingBox.getSize(), innerIndent);
-
-			// Intermediate processing (like tint color / added color)
-			processIntermediateBitmap(intermediate, options);
-
-			// Merge into output (incl. blending and depth test)
-			BlitterHelper::mergeIntoOutput(output, outputBoundingBox, intermediate, mPixelSegments, options);
-		}
-		else
+		blitLines(output, outputBoundingBox, options, [&](uint32* lineBuffer, Vec2i linePosition, int numPixels)
 		{
-			// We're not going to make changes to the intermediate bitmap, so just use the sprite data directly
-			BitmapView<uint32> intermediate(sprite.mBitmapView, Recti(innerIndent, outputBoundingBox.getSize()));
-
-			// Merge into output (incl. blending and depth test)
-			BlitterHelper::mergeIntoOutput(output, outputBoundingBox, intermediate, mPixelSegments, options);
-		}
+			return sprite.mBitmapView.getPixelPointer(innerIndent + linePosition);
+		});
 	}
 	else
 	{
 		// TODO: Add optimizations for "simple" transformations, especially flips
-		BitmapViewMutable<uint32> intermediate = makeTempBitmapAsTransformedCopy(outputBoundingBox, sprite, position, options);
-
-		// Intermediate processing (like tint color / added color)
-		processIntermediateBitmap(intermediate, options);
-
-		// Merge into output (incl. blending and depth test)
-		BlitterHelper::mergeIntoOutput(output, outputBoundingBox, intermediate, mPixelSegments, options);
+		const Vec2i offset = outputBoundingBox.getPos() - position;
+		const Vec2f floatPivot(sprite.mPivot);
+		const auto pointSampler = [&](int px, int py) { return BlitterHelper::pointSampling(sprite.mBitmapView, px, py); };
+		const auto bilinearSampler = [&](float px, float py) { return BlitterHelper::bilinearSampling(sprite.mBitmapView, px, py); };
+		blitLines(output, outputBoundingBox, options, [&](uint32* lineBuffer, Vec2i linePosition, int numPixels)
+		{
+			sampleTransformedLine(lineBuffer, numPixels, offset + linePosition, floatPivot, options, pointSampler, bilinearSampler);
+			return (const uint32*)lineBuffer;
+		});
 	}
 }
 
@@ -127,50 +268,53 @@ void Blitter::blitIndexed(const OutputWrapper& output, const IndexedSpriteWrappe
 	if (mPixelSegments.empty())
 		return;
 
-	// TODO: Use "mPixelSegments" in more of the calculations below
-
 	if (nullptr == options.mTransform)
 	{
 		const Vec2i innerIndent = outputBoundingBox.getPos() - position + sprite.mPivot;
-
-		// Copy only the actually used part from the input sprite into an intermediate bitmap
-		BitmapViewMutable<uint32> intermediate = makeTempBitmapAsCopy(sprite.mBitmapView, palette, outputBoundingBox.getSize(), innerIndent);
-
-		// Intermediate processing (like tint color / added color)
-		processIntermediateBitmap(intermediate, options);
-
-		// Merge into output (incl. blending and depth test)
-		BlitterHelper::mergeIntoOutput(output, outputBoundingBox, intermediate, mPixelSegments, options);
+		blitLines(output, outputBoundingBox, options, [&](uint32* lineBuffer, Vec2i linePosition, int numPixels)
+		{
+			const uint8* src = sprite.mBitmapView.getPixelPointer(innerIndent + linePosition);
+			for (int x = 0; x < numPixels; ++x)
+			{
+				const uint8 index = src[x];
+				lineBuffer[x] = (index < palette.mNumEntries) ? palette.mPalette[index] : 0;
+			}
+			return (const uint32*)lineBuffer;
+		});
 	}
 	else
 	{
 		// TODO: Add optimizations for "simple" transformations, especially flips
-		BitmapViewMutable<uint32> intermediate = makeTempBitmapAsTransformedCopy(outputBoundingBox, sprite, palette, position, options);
-
-		// Intermediate processing (like tint color / added color)
-		processIntermediateBitmap(intermediate, options);
-
-		// Merge into output (incl. blending and depth test)
-		BlitterHelper::mergeIntoOutput(output, outputBoundingBox, intermediate, mPixelSegments, options);
+		const Vec2i offset = outputBoundingBox.getPos() - position;
+		const Vec2f floatPivot(sprite.mPivot);
+		const auto pointSampler = [&](int px, int py) { return BlitterHelper::pointSampling(sprite.mBitmapView, palette, px, py); };
+		const auto bilinearSampler = [&](float px, float py) { return BlitterHelper::bilinearSampling(sprite.mBitmapView, palette, px, py); };
+		blitLines(output, outputBoundingBox, options, [&](uint32* lineBuffer, Vec2i linePosition, int numPixels)
+		{
+			sampleTransformedLine(lineBuffer, numPixels, offset + linePosition, floatPivot, options, pointSampler, bilinearSampler);
+			return (const uint32*)lineBuffer;
+		});
 	}
 }
 
-void Blitter::blitRectWithScaling(BitmapViewMutable<uint32>& destBitmap, Recti destRect, const BitmapViewMutable<uint32>& sourceBitmap, Recti sourceRect, const Options& options)
+void Blitter::blitRectWithScaling(const OutputWrapper& output, Recti destRect, const BitmapViewMutable<uint32>& sourceBitmap, Recti sourceRect, const Options& options)
 {
-	if (destBitmap.isEmpty() || sourceRect.isEmpty())
+	if (output.mViewportRect.isEmpty() || destRect.isEmpty() || sourceRect.isEmpty())
 		return;
 
+	uint32* lineBuffer = makeLineBuffer(sourceRect.width + destRect.width);
+
 	if (nullptr == options.mTintColor)
 	{
 		if (options.mBlendMode != BlendMode::ALPHA)
 		{
 			// No blending
-			BlitterHelper::blitBitmapWithScaling<false, false>(destBitmap, destRect, sourceBitmap, sourceRect, 0xffffffff);
+			BlitterHelper::blitBitmapWithScaling<false, false>(output.mBitmapView, destRect, output.mViewportRect, sourceBitmap, sourceRect, 0xffffffff, lineBuffer);
 		}
 		else
 		{
 			// Alpha blending
-			BlitterHelper::blitBitmapWithScaling<true, false>(destBitmap, destRect, sourceBitmap, sourceRect, 0xffffffff);
+			BlitterHelper::blitBitmapWithScaling<true, false>(output.mBitmapView, destRect, output.mViewportRect, sourceBitmap, sourceRect, 0xffffffff, lineBuffer);
 		}
 	}
 	else
@@ -178,12 +322,12 @@ void Blitter::blitRectWithScaling(BitmapViewMutable<uint32>& destBitmap, Recti d
 		if (options.mBlendMode != BlendMode::ALPHA)
 		{
 			// No blending
-			BlitterHelper::blitBitmapWithScaling<false, true>(destBitmap, destRect, sourceBitmap, sourceRect, Color(*options.mTintColor).getABGR32());
+			BlitterHelper::blitBitmapWithScaling<false, true>(output.mBitmapView, destRect, output.mViewportRect, sourceBitmap, sourceRect, Color(*options.mTintColor).getABGR32(), lineBuffer);
 		}
 		else
 		{
 			// Alpha blending
-			BlitterHelper::blitBitmapWithScaling<true, true>(destBitmap, destRect, sourceBitmap, sourceRect, Color(*options.mTintColor).getABGR32());
+			BlitterHelper::blitBitmapWithScaling<true, true>(output.mBitmapView, destRect, output.mViewportRect, sourceBitmap, sourceRect, Color(*options.mTintColor).getABGR32(), lineBuffer);
 		}
 	}
 }
@@ -222,152 +366,72 @@ void Blitter::blitRectWithUVs(BitmapViewMutable<uint32>& destBitmap, Recti destR
 }
 
 
-BitmapViewMutable<uint32> Blitter::makeTempBitmap(Vec2i size)
+Recti Blitter::getSpriteBoundingBox(const Recti& spriteRect, const Vec2i& position, const float* transform)
 {
-	mTempBitmapData.resize(size.x * size.y);
-	return BitmapViewMutable<uint32>(&mTempBitmapData[0], size);
-}
+	if (nullptr == transform)
+	{
+		return Recti(position + spriteRect.getPos(), spriteRect.getSize());
+	}
 
-BitmapViewMutable<uint32> Blitter::makeTempBitmapAsCopy(const BitmapView<uint32>& input, Vec2i size, Vec2i innerIndent)
-{
-	BitmapViewMutable<uint32> result = makeTempBitmap(size);
-	for (int y = 0; y < size.y; ++y)
+	Vec2f min(1e10f, 1e10f);
+	Vec2f max(-1e10f, -1e10f);
+	const Vec2i size = spriteRect.getSize();
+	const Vec2i corners[4] = { Vec2i(0, 0), Vec2i(size.x, 0), Vec2i(0, size.y), size };
+	for (int i = 0; i < 4; ++i)
 	{
-		memcpy(result.getLinePointer(y), input.getPixelPointer(innerIndent.x, innerIndent.y + y), size.x * sizeof(uint32));
+		const Vec2f localCorner = Vec2f(corners[i] + spriteRect.getPos());
+		const float screenCornerX = position.x + localCorner.x * transform[0] + localCorner.y * transform[1];
+		const float screenCornerY = position.y + localCorner.x * transform[2] + localCorner.y * transform[3];
+		min.x = std::min(screenCornerX, min.x);
+		min.y = std::min(screenCornerY, min.y);
+		max.x = std::max(screenCornerX, max.x);
+		max.y = std::max(screenCornerY, max.y);
 	}
-	return result;
+
+	Recti boundingBox;
+	boundingBox.x = (int)min.x;
+	boundingBox.y = (int)min.y;
+	boundingBox.width  = (int)max.x + 1 - boundingBox.x;
+	boundingBox.height = (int)max.y + 1 - boundingBox.y;
+	return boundingBox;
 }
 
-BitmapViewMutable<uint32> Blitter::makeTempBitmapAsCopy(const BitmapView<uint8>& input, const PaletteWrapper& palette, Vec2i size, Vec2i innerIndent)
+uint32* Blitter::makeLineBuffer(int numPixels)
 {
-	BitmapViewMutable<uint32> result = makeTempBitmap(size);
-	for (int y = 0; y < size.y; ++y)
-	{
-		uint32* dst = result.getLinePointer(y);
-		const uint8* src = input.getPixelPointer(innerIndent.x, innerIndent.y + y);
-		for (int x = 0; x < size.x; ++x)
-		{
-			const uint8 index = *src;
-			*dst = (index < palette.mNumEntries) ? palette.mPalette[index] : 0;
-			++dst;
-			++src;
-		}
-	}
-	return result;
+	mLineBufferData.resize(std::max(numPixels, 1));
+	return &mLineBufferData[0];
 }
 
-BitmapViewMutable<uint32> Blitter::makeTempBitmapAsTransformedCopy(Recti outputBoundingBox, const SpriteWrapper& sprite, Vec2i position, const Options& options)
+template<typename LINE_SOURCE>
+void Blitter::blitLines(const OutputWrapper& output, const Recti& outputBoundingBox, Options& options, const LINE_SOURCE& lineSource)
 {
-	BitmapViewMutable<uint32> result = makeTempBitmap(outputBoundingBox.getSize());
-	const Vec2f floatPivot(sprite.mPivot);
-	switch (options.mSamplingMode)
+	// Each pixel segment goes from its source (over the line buffer where needed) right into the output, without an intermediate bitmap
+	//  -> Color processing may switch the blend mode, so the blend function has to be chosen afterwards
+	const bool needsProcessing = needsIntermediateProcessing(options);
+	const ColorProcessing colorProcessing(options);
+	const BlitterHelper::BlendLineFunction blendLine = BlitterHelper::getBlendLineFunction(options.mBlendMode, nullptr != options.mDepthBuffer);
+
+	uint32* lineBuffer = makeLineBuffer(outputBoundingBox.width);
+	const BitmapViewMutable<uint32> outputView(output.mBitmapView, outputBoundingBox);
+	BitmapViewMutable<uint8> depthBufferView;
+	if (nullptr != options.mDepthBuffer)
 	{
-		case SamplingMode::POINT:
-		{
-			for (int iy = 0; iy < outputBoundingBox.height; ++iy)
-			{
-				// Transform into sprite-local coordinates
-				const float dx = (float)(outputBoundingBox.x - position.x) + 0.5f;
-				const float dy = (float)(outputBoundingBox.y - position.y + iy) + 0.5f;
-				float localX = dx * options.mInvTransform[0] + dy * options.mInvTransform[1] + floatPivot.x;
-				float localY = dx * options.mInvTransform[2] + dy * options.mInvTransform[3] + floatPivot.y;
-				const float advanceX = options.mInvTransform[0];
-				const float advanceY = options.mInvTransform[2];
-
-				uint32* dst = result.getPixelPointer(0, iy);
-				for (int ix = 0; ix < outputBoundingBox.width; ++ix)
-				{
-					*dst = BlitterHelper::pointSampling(sprite.mBitmapView, (int)localX, (int)localY);
-					++dst;
-					localX += advanceX;
-					localY += advanceY;
-				}
-			}
-			break;
-		}
-
-		case SamplingMode::BILINEAR:
-		{
-			for (int iy = 0; iy < outputBoundingBox.height; ++iy)
-			{
-				// Transform into sprite-local coordinates
-				const float dx = (float)(outputBoundingBox.x - position.x) + 0.5f;
-				const float dy = (float)(outputBoundingBox.y - position.y + iy) + 0.5f;
-				float localX = dx * options.mInvTransform[0] + dy * options.mInvTransform[1] + floatPivot.x - 0.5f;
-				float localY = dx * options.mInvTransform[2] + dy * options.mInvTransform[3] + floatPivot.y - 0.5f;
-				const float advanceX = options.mInvTransform[0];
-				const float advanceY = options.mInvTransform[2];
-
-				uint32* dst = result.getPixelPointer(0, iy);
-				for (int ix = 0; ix < outputBoundingBox.width; ++ix)
-				{
-					*dst = BlitterHelper::bilinearSampling(sprite.mBitmapView, localX, localY);
-					++dst;
-					localX += advanceX;
-					localY += advanceY;
-				}
-			}
-			break;
-		}
+		//RMX_ASSERT(options.mDepthBuffer->getSize() == output.mBitmapView.getSize(), "Depth buffer size differs from output bitmap size");
+		depthBufferView = BitmapViewMutable<uint8>(*options.mDepthBuffer, outputBoundingBox);
 	}
-	return result;
-}
 
-BitmapViewMutable<uint32> Blitter::makeTempBitmapAsTransformedCopy(Recti outputBoundingBox, const IndexedSpriteWrapper& sprite, const PaletteWrapper& palette, Vec2i position, const Options& options)
-{
-	BitmapViewMutable<uint32> result = makeTempBitmap(outputBoundingBox.getSize());
-	const Vec2f floatPivot(sprite.mPivot);
-	switch (options.mSamplingMode)
+	for (const PixelSegment& pixelSegment : mPixelSegments)
 	{
-		case SamplingMode::POINT:
+		const uint32* colors = lineSource(lineBuffer, pixelSegment.mPosition, pixelSegment.mNumPixels);
+		if (needsProcessing)
 		{
-			for (int iy = 0; iy < outputBoundingBox.height; ++iy)
-			{
-				// Transform into sprite-local coordinates
-				const float dx = (float)(outputBoundingBox.x - position.x) + 0.5f;
-				const float dy = (float)(outputBoundingBox.y - position.y + iy) + 0.5f;
-				float localX = dx * options.mInvTransform[0] + dy * options.mInvTransform[1] + floatPivot.x;
-				float localY = dx * options.mInvTransform[2] + dy * options.mInvTransform[3] + floatPivot.y;
-				const float advanceX = options.mInvTransform[0];
-				const float advanceY = options.mInvTransform[2];
-
-				uint32* dst = result.getPixelPointer(0, iy);
-				for (int ix = 0; ix < outputBoundingBox.width; ++ix)
-				{
-					*dst = BlitterHelper::pointSampling(sprite.mBitmapView, palette, (int)localX, (int)localY);
-					++dst;
-					localX += advanceX;
-					localY += advanceY;
-				}
-			}
-			break;
+			colorProcessing.processLine(lineBuffer, colors, pixelSegment.mNumPixels);
+			colors = lineBuffer;
 		}
 
-		case SamplingMode::BILINEAR:
-		{
-			for (int iy = 0; iy < outputBoundingBox.height; ++iy)
-			{
-				// Transform into sprite-local coordinates
-				const float dx = (float)(outputBoundingBox.x - position.x) + 0.5f;
-				const float dy = (float)(outputBoundingBox.y - position.y + iy) + 0.5f;
-				float localX = dx * options.mInvTransform[0] + dy * options.mInvTransform[1] + floatPivot.x - 0.5f;
-				float localY = dx * options.mInvTransform[2] + dy * options.mInvTransform[3] + floatPivot.y - 0.5f;
-				const float advanceX = options.mInvTransform[0];
-				const float advanceY = options.mInvTransform[2];
-
-				uint32* dst = result.getPixelPointer(0, iy);
-				for (int ix = 0; ix < outputBoundingBox.width; ++ix)
-				{
-					*dst = BlitterHelper::bilinearSampling(sprite.mBitmapView, palette, localX, localY);
-					++dst;
-					localX += advanceX;
-					localY += advanceY;
-				}
-			}
-			break;
-		}
+		uint8* depthBuffer = (nullptr == options.mDepthBuffer) ? nullptr : depthBufferView.getPixelPointer(pixelSegment.mPosition);
+		blendLine(outputView.getPixelPointer(pixelSegment.mPosition), colors, pixelSegment.mNumPixels, depthBuffer, options.mDepthTestValue);
 	}
-	return result;
 }
 
 Recti Blitter::applyCropping(std::vector<PixelSegment>& outPixelSegments, const Recti& viewportRect, const Recti& spriteRect, const Vec2i& position, const Options& options)
@@ -377,34 +441,7 @@ Recti Blitter::applyCropping(std::vector<PixelSegment>& outPixelSegments, const
 		return Recti();
 
 	// First calculate the sprite's bounding box, taking into account the transformation and all inner rectangles
-	Recti uncroppedBoundingBox;
-	if (nullptr == options.mTransform)
-	{
-		uncroppedBoundingBox.setPos(position + spriteRect.getPos());
-		uncroppedBoundingBox.setSize(spriteRect.getSize());
-	}
-	else
-	{
-		Vec2f min(1e10f, 1e10f);
-		Vec2f max(-1e10f, -1e10f);
-		const Vec2i size = spriteRect.getSize();
-		const Vec2i corners[4] = { Vec2i(0, 0), Vec2i(size.x, 0), Vec2i(0, size.y), size };
-		for (int i = 0; i < 4; ++i)
-		{
-			const Vec2f localCorner = Vec2f(corners[i] + spriteRect.getPos());
-			const float screenCornerX = position.x + localCorner.x * options.mTransform[0] + localCorner.y * options.mTransform[1];
-			const float screenCornerY = position.y + localCorner.x * options.mTransform[2] + localCorner.y * options.mTransform[3];
-			min.x = std::min(screenCornerX, min.x);
-			min.y = std::min(screenCornerY, min.y);
-			max.x = std::max(screenCornerX, max.x);
-			max.y = std::max(screenCornerY, max.y);
-		}
-
-		uncroppedBoundingBox.x = (int)min.x;
-		uncroppedBoundingBox.y = (int)min.y;
-		uncroppedBoundingBox.width  = (int)max.x + 1 - uncroppedBoundingBox.x;
-		uncroppedBoundingBox.height = (int)max.y + 1 - uncroppedBoundingBox.y;
-	}
+	const Recti uncroppedBoundingBox = getSpriteBoundingBox(spriteRect, position, options.mTransform);
 
 	// Get the (cropped) bounding box in the output viewport
 	const Recti boundingBox = Recti::getIntersection(uncroppedBoundingBox, viewportRect);
@@ -447,110 +484,3 @@ bool Blitter::needsIntermediateProcessing(const Options& options)
 {
 	return (nullptr != options.mTintColor || nullptr != options.mAddedColor || options.mSwapRedBlueChannels);
 }
-
-void Blitter::processIntermediateBitmap(BitmapViewMutable<uint32>& bitmap, Options& options)
-{
-	const Options* useOptions = &options;
-	if (nullptr != options.mTintColor || nullptr != options.mAddedColor)
-	{
-		int mult[4];
-		if (nullptr != options.mTintColor)
-		{
-			mult[0] = clamp((int)(options.mTintColor->r * 0x100 + 0.5f), -0x10000, 0x10000);
-			mult[1] = clamp((int)(options.mTintColor->g * 0x100 + 0.5f), -0x10000, 0x10000);
-			mult[2] = clamp((int)(options.mTintColor->b * 0x100 + 0.5f), -0x10000, 0x10000);
-			mult[3] = clamp((int)(options.mTintColor->a * 0x100 + 0.5f), -0x10000, 0x10000);
-		}
-		else
-		{
-			mult[0] = 0x100;
-			mult[1] = 0x100;
-			mult[2] = 0x100;
-			mult[3] = 0x100;
-		}
-
-		if (nullptr == options.mAddedColor)
-		{
-			// Only apply tint color
-			for (int y = 0; y < bitmap.getSize().y; ++y)
-			{
-				uint8* dst = (uint8*)bitmap.getLinePointer(y);
-				for (int x = 0; x < bitmap.getSize().x; ++x)
-				{
-					dst[0] = (uint8)clamp((dst[0] * mult[0]) >> 8, 0, 0xff);
-					dst[1] = (uint8)clamp((dst[1] * mult[1]) >> 8, 0, 0xff);
-					dst[2] = (uint8)clamp((dst[2] * mult[2]) >> 8, 0, 0xff);
-					dst[3] = (uint8)clamp((dst[3] * mult[3]) >> 8, 0, 0xff);
-					dst += 4;
-				}
-			}
-		}
-		else
-		{
-			// Apply tint & added color
-			//  -> Even though tint color may be unused, so that we're just multiplying by 1, but that's expected to be a quite rare case
-			const int add[3] =
-			{
-				(int)(options.mAddedColor->r * 0xff + 0.5f),
-				(int)(options.mAddedColor->g * 0xff + 0.5f),
-				(int)(options.mAddedColor->b * 0xff + 0.5f)
-			};
-			for (int y = 0; y < bitmap.getSize().y; ++y)
-			{
-				uint8* dst = (uint8*)bitmap.getLinePointer(y);
-				for (int x = 0; x < bitmap.getSize().x; ++x)
-				{
-					dst[0] = (uint8)clamp(((dst[0] * mult[0]) >> 8) + add[0], 0, 0xff);
-					dst[1] = (uint8)clamp(((dst[1] * mult[1]) >> 8) + add[1], 0, 0xff);
-					dst[2] = (uint8)clamp(((dst[2] * mult[2]) >> 8) + add[2], 0, 0xff);
-					dst[3] = (uint8)clamp(((dst[3] * mult[3]) >> 8),          0, 0xff);
-					dst += 4;
-				}
-			}
-		}
-
-		// Special handling for one-bit alpha if tint color enforces alpha blending
-		if (nullptr != options.mTintColor && options.mTintColor->a < 1.0f && options.mBlendMode == BlendMode::ONE_BIT)
-		{
-			options.mBlendMode = BlendMode::ALPHA;
-			const uint8 alphaValue = (uint8)(options.mTintColor->a * 255.0f + 0.5f);
-			for (int y = 0; y < bitmap.getSize().y; ++y)
-			{
-				uint8* dst = (uint8*)bitmap.getLinePointer(y);
-				for (int x = 0; x < bitmap.getSize().x; ++x)
-				{
-					dst[3] = (dst[3] > 0) ? alphaValue : 0;
-					dst += 4;
-				}
-			}
-		}
-	}
-
-	if (options.mSwapRedBlueChannels)
-	{
-		// Copy over data and swap red and blue channels
-		const int numPixels = bitmap.getSize().x;
-		for (int y = 0; y < bitmap.getSize().y; ++y)
-		{
-			uint32* dst = bitmap.getLinePointer(y);
-			int k = 0;
-			if constexpr (sizeof(void*) == 8)
-			{
-				// On 64-bit architectures: Process 2 pixels at once
-				for (; k < numPixels; k += 2)
-				{
-					const uint64 colors = *(uint64*)dst;
-					*(uint64*)dst = ((colors & 0x00ff000000ff0000ull) >> 16) | (colors & 0xff00ff00ff00ff00ull) | ((colors & 0x000000ff000000ffull) << 16);
-					dst += 2;
-				}
-			}
-			// Process single pixels
-			for (; k < numPixels; ++k)
-			{
-				const uint32 color = *dst;
-				*dst = ((color & 0x00ff0000) >> 16) | (color & 0xff00ff00) | ((color & 0x000000ff) << 16);
-				++dst;
-			}
-		}
-	}
-}
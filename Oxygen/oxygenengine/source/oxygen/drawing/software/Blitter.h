@@ -80,21 +80,23 @@ public:
 	void blitColor(const OutputWrapper& output, const Color& color, BlendMode blendMode);
 	void blitSprite(const OutputWrapper& output, const SpriteWrapper& sprite, Vec2i position, Options& options);
 	void blitIndexed(const OutputWrapper& output, const IndexedSpriteWrapper& sprite, const PaletteWrapper& palette, Vec2i position, Options& options);
-	void blitRectWithScaling(BitmapViewMutable<uint32>& destBitmap, Recti destRect, const BitmapViewMutable<uint32>& sourceBitmap, Recti sourceRect, const Options& options);
+	void blitRectWithScaling(const OutputWrapper& output, Recti destRect, const BitmapViewMutable<uint32>& sourceBitmap, Recti sourceRect, const Options& options);	// Output gets cropped to the viewport, without affecting which pixels are sampled
 	void blitRectWithUVs(BitmapViewMutable<uint32>& destBitmap, Recti destRect, const BitmapViewMutable<uint32>& sourceBitmap, Recti sourceRect, const Options& options);
 
+	// Output bounding box of a sprite before cropping, with the sprite rect being relative to the position (i.e. using the negated pivot)
+	static Recti getSpriteBoundingBox(const Recti& spriteRect, const Vec2i& position, const float* transform);
+
 private:
-	BitmapViewMutable<uint32> makeTempBitmap(Vec2i size);
-	BitmapViewMutable<uint32> makeTempBitmapAsCopy(const BitmapView<uint32>& input, Vec2i size, Vec2i innerIndent);
-	BitmapViewMutable<uint32> makeTempBitmapAsCopy(const BitmapView<uint8>& input, const PaletteWrapper& palette, Vec2i size, Vec2i innerIndent);
-	BitmapViewMutable<uint32> makeTempBitmapAsTransformedCopy(Recti outputBoundingBox, const SpriteWrapper& sprite, Vec2i position, const Options& options);
-	BitmapViewMutable<uint32> makeTempBitmapAsTransformedCopy(Recti outputBoundingBox, const IndexedSpriteWrapper& sprite, const PaletteWrapper& palette, Vec2i position, const Options& options);
+	uint32* makeLineBuffer(int numPixels);
+
+	// Blits all pixel segments, with the line source returning the colors for a segment (either from the sprite data or written to the given line buffer)
+	template<typename LINE_SOURCE>
+	void blitLines(const OutputWrapper& output, const Recti& outputBoundingBox, Options& options, const LINE_SOURCE& lineSource);
 
 	static Recti applyCropping(std::vector<PixelSegment>& outPixelSegments, const Recti& viewportRect, const Recti& spriteRect, const Vec2i& position, const Options& options);
 	static bool needsIntermediateProcessing(const Options& options);
-	static void processIntermediateBitmap(BitmapViewMutable<uint32>& bitmap, Options& options);
 
 private:
-	std::vector<uint32> mTempBitmapData;		// Defined here so its reserved memory can be reused for multiple blitting calls
+	std::vector<uint32> mLineBufferData;		// Defined here so its reserved memory can be reused for multiple blitting calls
 	std::vector<PixelSegment> mPixelSegments;
 };
@@ -7,6 +7,7 @@
 */
 
 #include "oxygen/drawing/software/Blitter.h"
+#include "oxygen/rendering/utils/PixelKernels.h"
 
 
 struct BlitterHelper
@@ -392,220 +393,142 @@ struct BlitterHelper
 		return r + (g << 8) + (b << 16) + (a << 24);
 	}
 
-	static void mergeIntoOutputDirect(const BitmapViewMutable<uint32>& output, const BitmapView<uint32>& input, const std::vector<Blitter::PixelSegment>& pixelSegments, const Blitter::Options& options)
+	typedef void(*BlendLineFunction)(uint32* dst, const uint32* src, size_t numPixels, uint8* depthBuffer, uint8 depthTestValue);
+
+	// Merges a line of pixels into the output, specialized at compile time for the blend mode and whether a depth test is used
+	template<BlendMode BLEND_MODE, bool DEPTH_TEST>
+	static void blendLine(uint32* dst, const uint32* src, size_t numPixels, uint8* depthBuffer, uint8 depthTestValue)
 	{
-		switch (options.mBlendMode)
+		if constexpr (DEPTH_TEST)
 		{
-			case BlendMode::ALPHA:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineAlpha(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels);
-				break;
-			}
-
-			case BlendMode::ONE_BIT:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineOneBit(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels);
-				break;
-			}
-
-			case BlendMode::ADDITIVE:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineAdditive(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels);
-				break;
-			}
-
-			case BlendMode::SUBTRACTIVE:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineSubtractive(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels);
-				break;
-			}
-
-			case BlendMode::MULTIPLICATIVE:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineMultiplicative(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels);
-				break;
-			}
-
-			case BlendMode::MINIMUM:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineMinimum(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels);
-				break;
-			}
-
-			case BlendMode::MAXIMUM:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineMaximum(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels);
-				break;
-			}
-
-			default:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineOpaque(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels);
-				break;
-			}
+			if constexpr (BLEND_MODE == BlendMode::ALPHA)				blendLineAlphaWithDepth(dst, src, numPixels, depthBuffer, depthTestValue);
+			else if constexpr (BLEND_MODE == BlendMode::ONE_BIT)		blendLineOneBitWithDepth(dst, src, numPixels, depthBuffer, depthTestValue);
+			else if constexpr (BLEND_MODE == BlendMode::ADDITIVE)		blendLineAdditiveWithDepth(dst, src, numPixels, depthBuffer, depthTestValue);
+			else if constexpr (BLEND_MODE == BlendMode::SUBTRACTIVE)	blendLineSubtractiveWithDepth(dst, src, numPixels, depthBuffer, depthTestValue);
+			else if constexpr (BLEND_MODE == BlendMode::MULTIPLICATIVE)	blendLineMultiplicativeWithDepth(dst, src, numPixels, depthBuffer, depthTestValue);
+			else if constexpr (BLEND_MODE == BlendMode::MINIMUM)		blendLineMinimumWithDepth(dst, src, numPixels, depthBuffer, depthTestValue);
+			else if constexpr (BLEND_MODE == BlendMode::MAXIMUM)		blendLineMaximumWithDepth(dst, src, numPixels, depthBuffer, depthTestValue);
+			else														blendLineOpaqueWithDepth(dst, src, numPixels, depthBuffer, depthTestValue);
+		}
+		else
+		{
+			if constexpr (BLEND_MODE == BlendMode::ALPHA)				PixelKernels::blendLineAlpha(dst, src, (int)numPixels);
+			else if constexpr (BLEND_MODE == BlendMode::ONE_BIT)		blendLineOneBit(dst, src, numPixels);
+			else if constexpr (BLEND_MODE == BlendMode::ADDITIVE)		blendLineAdditive(dst, src, numPixels);
+			else if constexpr (BLEND_MODE == BlendMode::SUBTRACTIVE)	blendLineSubtractive(dst, src, numPixels);
+			else if constexpr (BLEND_MODE == BlendMode::MULTIPLICATIVE)	blendLineMultiplicative(dst, src, numPixels);
+			else if constexpr (BLEND_MODE == BlendMode::MINIMUM)		blendLineMinimum(dst, src, numPixels);
+			else if constexpr (BLEND_MODE == BlendMode::MAXIMUM)		blendLineMaximum(dst, src, numPixels);
+			else														blendLineOpaque(dst, src, numPixels);
 		}
 	}
 
-	static void mergeIntoOutputWithDepth(const BitmapViewMutable<uint32>& output, const BitmapView<uint32>& input, BitmapViewMutable<uint8>& depthBuffer, const std::vector<Blitter::PixelSegment>& pixelSegments, const Blitter::Options& options)
+	static BlendLineFunction getBlendLineFunction(BlendMode blendMode, bool depthTest)
 	{
-		switch (options.mBlendMode)
+		switch (blendMode)
 		{
-			case BlendMode::ALPHA:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineAlphaWithDepth(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels, depthBuffer.getPixelPointer(pixelSegment.mPosition), options.mDepthTestValue);
-				break;
-			}
-
-			case BlendMode::ONE_BIT:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineOneBitWithDepth(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels, depthBuffer.getPixelPointer(pixelSegment.mPosition), options.mDepthTestValue);
-				break;
-			}
-
-			case BlendMode::ADDITIVE:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineAdditiveWithDepth(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels, depthBuffer.getPixelPointer(pixelSegment.mPosition), options.mDepthTestValue);
-				break;
-			}
-
-			case BlendMode::SUBTRACTIVE:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineSubtractiveWithDepth(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels, depthBuffer.getPixelPointer(pixelSegment.mPosition), options.mDepthTestValue);
-				break;
-			}
-
-			case BlendMode::MULTIPLICATIVE:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineMultiplicativeWithDepth(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels, depthBuffer.getPixelPointer(pixelSegment.mPosition), options.mDepthTestValue);
-				break;
-			}
-
-			case BlendMode::MINIMUM:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineMinimumWithDepth(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels, depthBuffer.getPixelPointer(pixelSegment.mPosition), options.mDepthTestValue);
-				break;
-			}
+			case BlendMode::ALPHA:			 return depthTest ? &blendLine<BlendMode::ALPHA, true>			: &blendLine<BlendMode::ALPHA, false>;
+			case BlendMode::ONE_BIT:		 return depthTest ? &blendLine<BlendMode::ONE_BIT, true>		: &blendLine<BlendMode::ONE_BIT, false>;
+			case BlendMode::ADDITIVE:		 return depthTest ? &blendLine<BlendMode::ADDITIVE, true>		: &blendLine<BlendMode::ADDITIVE, false>;
+			case BlendMode::SUBTRACTIVE:	 return depthTest ? &blendLine<BlendMode::SUBTRACTIVE, true>	: &blendLine<BlendMode::SUBTRACTIVE, false>;
+			case BlendMode::MULTIPLICATIVE:	 return depthTest ? &blendLine<BlendMode::MULTIPLICATIVE, true>	: &blendLine<BlendMode::MULTIPLICATIVE, false>;
+			case BlendMode::MINIMUM:		 return depthTest ? &blendLine<BlendMode::MINIMUM, true>		: &blendLine<BlendMode::MINIMUM, false>;
+			case BlendMode::MAXIMUM:		 return depthTest ? &blendLine<BlendMode::MAXIMUM, true>		: &blendLine<BlendMode::MAXIMUM, false>;
+			default:						 return depthTest ? &blendLine<BlendMode::OPAQUE, true>			: &blendLine<BlendMode::OPAQUE, false>;
+		}
+	}
 
-			case BlendMode::MAXIMUM:
-			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineMaximumWithDepth(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels, depthBuffer.getPixelPointer(pixelSegment.mPosition), options.mDepthTestValue);
-				break;
-			}
 
-			default:
+	static inline void scaleLine(uint32* RESTRICT dst, int numPixels, const uint32* RESTRICT src, uint32 advance, int destOffset)
+	{
+		// Upscaling by a factor of 2 or 4 is exact in 16.16 fixed point, so it can get a simpler loop with the same result
+		if (advance == 0x10000)
+		{
+			memcpy(dst, &src[destOffset], numPixels * sizeof(uint32));
+		}
+		else if (advance == 0x8000)
+		{
+			for (int destX = 0; destX < numPixels; ++destX)
 			{
-				for (const Blitter::PixelSegment& pixelSegment : pixelSegments)
-					blendLineOpaqueWithDepth(output.getPixelPointer(pixelSegment.mPosition), input.getPixelPointer(pixelSegment.mPosition), pixelSegment.mNumPixels, depthBuffer.getPixelPointer(pixelSegment.mPosition), options.mDepthTestValue);
-				break;
+				dst[destX] = src[(destOffset + destX) >> 1];
 			}
 		}
-	}
-
-	static void mergeIntoOutput(const Blitter::OutputWrapper& output, const Recti& outputBoundingBox, const BitmapView<uint32>& intermediate, const std::vector<Blitter::PixelSegment>& pixelSegments, const Blitter::Options& options)
-	{
-		BitmapViewMutable<uint32> outputView(output.mBitmapView, Recti(outputBoundingBox.getPos(), intermediate.getSize()));
-		if (nullptr == options.mDepthBuffer)
+		else if (advance == 0x4000)
 		{
-			mergeIntoOutputDirect(outputView, intermediate, pixelSegments, options);
+			for (int destX = 0; destX < numPixels; ++destX)
+			{
+				dst[destX] = src[(destOffset + destX) >> 2];
+			}
 		}
 		else
 		{
-			//RMX_ASSERT(options.mDepthBuffer->getSize() == output.mBitmapView.getSize(), "Depth buffer size differs from output bitmap size");
-			BitmapViewMutable<uint8> depthBuffer(*options.mDepthBuffer, Recti(outputBoundingBox.getPos(), intermediate.getSize()));
-			mergeIntoOutputWithDepth(outputView, intermediate, depthBuffer, pixelSegments, options);
+			uint32 position = advance * (uint32)destOffset;	// This is used as a 16.16 fixed point number
+			for (int destX = 0; destX < numPixels; ++destX)
+			{
+				dst[destX] = src[position >> 16];
+				position += advance;
+			}
 		}
 	}
 
-
+	// The line buffer must have room for both source and destination width
+	//  -> Only the part of the destination rect inside the clip rect gets written, with the same result there as without clipping
 	template<bool ALPHA_BLENDING, bool USE_TINT_COLOR>
-	static inline void blitBitmapWithScaling(BitmapViewMutable<uint32>& destBitmap, Recti destRect, const BitmapViewMutable<uint32>& sourceBitmap, Recti sourceRect, uint32 tintColor)
+	static inline void blitBitmapWithScaling(const BitmapViewMutable<uint32>& destBitmap, Recti destRect, const Recti& clipRect, const BitmapViewMutable<uint32>& sourceBitmap, Recti sourceRect, uint32 tintColor, uint32* lineBuffer)
 	{
 		if (destBitmap.isEmpty() || sourceRect.isEmpty())
 			return;
 
+		const Recti visibleRect = Recti::getIntersection(destRect, clipRect);
+		if (visibleRect.isEmpty())
+			return;
+
 		int lastSourceY = -1;
 		uint32* lastDestData = nullptr;
 
-		uint32 position = 0;	// This is used as a 16.16 fixed point number
 		const uint32 advance = (sourceRect.width << 16) / destRect.width;
+		const int destOffset = visibleRect.x - destRect.x;
+		uint32* scaledLine = &lineBuffer[sourceRect.width];
 
-		for (int lineIndex = 0; lineIndex < destRect.height; ++lineIndex)
+		for (int lineIndex = visibleRect.y - destRect.y; lineIndex < visibleRect.y + visibleRect.height - destRect.y; ++lineIndex)
 		{
 			const int destY = destRect.y + lineIndex;
 			const int sourceY = sourceRect.y + lineIndex * sourceRect.height / destRect.height;
-			uint32* destData = destBitmap.getPixelPointer(destRect.x, destY);
+			uint32* destData = destBitmap.getPixelPointer(visibleRect.x, destY);
 
-			if (sourceY == lastSourceY && nullptr != lastDestData && !ALPHA_BLENDING)
+			if (sourceY == lastSourceY && nullptr != lastDestData)
 			{
-				// Just copy the content from the last line, as it's the same contents again
-				memcpy(destData, lastDestData, destRect.width * sizeof(uint32));
+				if (ALPHA_BLENDING)
+				{
+					// Blend the same scaled line again
+					PixelKernels::blendLineAlpha(destData, scaledLine, visibleRect.width);
+				}
+				else
+				{
+					// Just copy the content from the last line, as it's the same contents again
+					memcpy(destData, lastDestData, visibleRect.width * sizeof(uint32));
+				}
 			}
 			else
 			{
 				const uint32* sourceData = sourceBitmap.getPixelPointer(sourceRect.x, sourceY);
-				position = 0;
-
 				if (USE_TINT_COLOR)
 				{
-					const constexpr int BUFFER_SIZE = 2048;
-					RMX_ASSERT(sourceRect.width <= BUFFER_SIZE, "Buffer supports only widths of " << BUFFER_SIZE << " pixels at maximum");
-					sourceRect.width = std::min(sourceRect.width, BUFFER_SIZE);
-					uint32 buffer[BUFFER_SIZE];
 					for (int x = 0; x < sourceRect.width; ++x)
 					{
-						buffer[x] = multiplyColors(sourceData[x], tintColor);
+						lineBuffer[x] = multiplyColors(sourceData[x], tintColor);
 					}
+					sourceData = lineBuffer;
+				}
 
-					if (ALPHA_BLENDING)
-					{
-						for (int destX = 0; destX < destRect.width; ++destX)
-						{
-							blendPixelAlpha((uint8*)&destData[destX], (uint8*)&buffer[position >> 16]);
-							position += advance;
-						}
-					}
-					else
-					{
-						for (int destX = 0; destX < destRect.width; ++destX)
-						{
-							destData[destX] = buffer[position >> 16];
-							position += advance;
-						}
-					}
+				if (ALPHA_BLENDING)
+				{
+					scaleLine(scaledLine, visibleRect.width, sourceData, advance, destOffset);
+					PixelKernels::blendLineAlpha(destData, scaledLine, visibleRect.width);
 				}
 				else
 				{
-					if (ALPHA_BLENDING)
-					{
-						for (int destX = 0; destX < destRect.width; ++destX)
-						{
-							blendPixelAlpha((uint8*)&destData[destX], (uint8*)&sourceData[position >> 16]);
-							position += advance;
-						}
-					}
-					else
-					{
-						for (int destX = 0; destX < destRect.width; ++destX)
-						{
-							destData[destX] = sourceData[position >> 16];
-							position += advance;
-						}
-					}
+					scaleLine(destData, visibleRect.width, sourceData, advance, destOffset);
 				}
 
 				lastSourceY = sourceY;
@@ -107,6 +107,149 @@ namespace softwaredrawer
 	}
 
 
+	// Information about a draw command targeting the window, used to find out which parts of the window need to be redrawn
+	struct WindowCommandInfo
+	{
+		bool mIsDrawing = false;	// False for changes of the render state, which don't draw anything themselves
+		uint64 mHash = 0;			// Covers everything that affects the output, incl. render state and change counters of used resources
+		Recti mBounds;				// Part of the window the command may draw to
+		Recti mChangedRect;			// Part of the bounds affected by changes of the used texture's content since the last frame
+	};
+
+	struct TextureSnapshot
+	{
+		uint32 mChangeCounter = 0;
+		uint32 mLastUsedFrame = 0;
+		Recti mChangedRect;			// Part of the texture that changed since the last frame
+		Bitmap mContent;
+	};
+
+	struct RenderState
+	{
+		BlendMode mBlendMode = BlendMode::OPAQUE;
+		SamplingMode mSamplingMode = SamplingMode::POINT;
+		TextureWrapMode mWrapMode = TextureWrapMode::CLAMP;
+		Recti mScissorRect;
+		std::vector<Recti> mScissorStack;
+	};
+
+	template<typename T>
+	void addToHash(uint64& hash, const T& value)
+	{
+		hash = rmx::addToFNV1a_64(hash, (const uint8*)&value, sizeof(T));
+	}
+
+	void addTextToHash(uint64& hash, const StringReader& text)
+	{
+		if (nullptr != text.mString)
+			hash = rmx::addToFNV1a_64(hash, (const uint8*)text.mString, text.mLength);
+		else
+			hash = rmx::addToFNV1a_64(hash, (const uint8*)text.mWString, text.mLength * sizeof(wchar_t));
+	}
+
+	Recti getNormalizedRect(Recti rect)
+	{
+		// Negative width is used for mirrored drawing
+		if (rect.width < 0)
+		{
+			rect.x += rect.width;
+			rect.width = -rect.width;
+		}
+		return rect;
+	}
+
+	Recti getBoundingRect(const Recti& rect1, const Recti& rect2)
+	{
+		const int minX = std::min(rect1.x, rect2.x);
+		const int minY = std::min(rect1.y, rect2.y);
+		const int maxX = std::max(rect1.x + rect1.width, rect2.x + rect2.width);
+		const int maxY = std::max(rect1.y + rect1.height, rect2.y + rect2.height);
+		return Recti(minX, minY, maxX - minX, maxY - minY);
+	}
+
+	// Adds a rect to a list of non-overlapping dirty rects, merging it with all rects it overlaps
+	//  -> The rects must not overlap, as each one gets rendered on its own and alpha blending would be applied twice otherwise
+	void addDirtyRect(std::vector<Recti>& dirtyRects, Recti rect)
+	{
+		if (rect.isEmpty())
+			return;
+
+		for (size_t k = 0; k < dirtyRects.size(); )
+		{
+			if (Recti::getIntersection(dirtyRects[k], rect).nonEmpty())
+			{
+				rect = getBoundingRect(rect, dirtyRects[k]);
+				dirtyRects.erase(dirtyRects.begin() + k);
+				k = 0;		// The grown rect may overlap rects that were checked before
+			}
+			else
+			{
+				++k;
+			}
+		}
+		dirtyRects.push_back(rect);
+	}
+
+	// Returns the bounding rect of all pixels that differ between two bitmaps of the same size
+	Recti getChangedRect(const Bitmap& oldContent, const Bitmap& newContent)
+	{
+		const int width = newContent.getWidth();
+		int minX = width;
+		int maxX = -1;
+		int minY = -1;
+		int maxY = -1;
+		for (int y = 0; y < newContent.getHeight(); ++y)
+		{
+			const uint32* oldLine = oldContent.getPixelPointer(0, y);
+			const uint32* newLine = newContent.getPixelPointer(0, y);
+			if (memcmp(oldLine, newLine, width * sizeof(uint32)) == 0)
+				continue;
+
+			int x0 = 0;
+			while (oldLine[x0] == newLine[x0])
+				++x0;
+			int x1 = width - 1;
+			while (oldLine[x1] == newLine[x1])
+				--x1;
+
+			minX = std::min(minX, x0);
+			maxX = std::max(maxX, x1);
+			if (minY < 0)
+				minY = y;
+			maxY = y;
+		}
+		return (minY < 0) ? Recti() : Recti(minX, minY, maxX - minX + 1, maxY - minY + 1);
+	}
+
+	// Maps a part of a texture to where it ends up when the whole texture is drawn scaled to the target rect
+	//  -> This adds a small margin, to be on the safe side regarding rounding in the scaled blitting
+	Recti mapTextureRectToTarget(const Recti& textureRect, const Vec2i& textureSize, const Recti& targetRect)
+	{
+		if (textureRect.isEmpty() || textureSize.x <= 0 || textureSize.y <= 0)
+			return Recti();
+
+		const int minX = targetRect.x + (int)((int64)textureRect.x * targetRect.width / textureSize.x) - 2;
+		const int minY = targetRect.y + (int)((int64)textureRect.y * targetRect.height / textureSize.y) - 2;
+		const int maxX = targetRect.x + (int)(((int64)(textureRect.x + textureRect.width) * targetRect.width + textureSize.x - 1) / textureSize.x) + 2;
+		const int maxY = targetRect.y + (int)(((int64)(textureRect.y + textureRect.height) * targetRect.height + textureSize.y - 1) / textureSize.y) + 2;
+		return Recti::getIntersection(Recti(minX, minY, maxX - minX, maxY - minY), targetRect);
+	}
+
+	Recti getComponentSpriteRect(const SpriteDrawCommand& sc, const SpriteBase& sprite)
+	{
+		Vec2i offset = sprite.mOffset;
+		Vec2i size = sprite.getSize();
+		if (sc.mScale.x != 1.0f || sc.mScale.y != 1.0f)
+		{
+			offset.x = roundToInt((float)offset.x * sc.mScale.x);
+			offset.y = roundToInt((float)offset.y * sc.mScale.y);
+			size.x = roundToInt((float)size.x * sc.mScale.x);
+			size.y = roundToInt((float)size.y * sc.mScale.y);
+		}
+		return Recti(sc.mPosition + offset, size);
+	}
+
+
 	struct Internal
 	{
 	public:
@@ -150,7 +293,16 @@ namespace softwaredrawer
 			if (formatSupported)
 			{
 				// Success, format is supported
-				mScissorRect.set(0, 0, mScreenSurface->w, mScreenSurface->h);
+				const Recti windowRect(0, 0, mScreenSurface->w, mScreenSurface->h);
+				if (mScreenSurface != mLastScreenSurface || windowRect != mWindowRect)
+				{
+					// Nothing from earlier frames can be reused
+					mFullRedraw = true;
+				}
+				mLastScreenSurface = mScreenSurface;
+				mWindowRect = windowRect;
+				mWindowClipRect = windowRect;
+				mScissorRect = windowRect;
 			}
 			else
 			{
@@ -162,6 +314,7 @@ namespace softwaredrawer
 				}
 
 				mScreenSurface = nullptr;
+				mLastScreenSurface = nullptr;
 				mOutputWrapper = BitmapViewMutable<uint32>();
 			}
 		}
@@ -185,7 +338,7 @@ namespace softwaredrawer
 			if (nullptr == mCurrentRenderTarget)
 			{
 				// Next call to "getOutputWrapper" will update the output wrapper accordingly
-				mScissorRect.set(0, 0, mScreenSurface->w, mScreenSurface->h);
+				mScissorRect = mWindowClipRect;
 			}
 			else
 			{
@@ -309,32 +462,40 @@ namespace softwaredrawer
 
 				BitmapViewMutable<uint32> inputWrapper(*inputBitmap);
 
-				const Vec2f originalUVStart = uv0;
-				const Vec2f originalUVRange = uv1 - uv0;
+				// Get the part from the input that will get drawn
+				//  -> This uses the original UVs, as scaled drawing handles cropping on its own
+				const Vec2f inputStart = uv0 * Vec2f(inputWrapper.getSize());
+				const Vec2f inputEnd = uv1 * Vec2f(inputWrapper.getSize());
 				Recti inputRect;
-				bool useUVs = false;
+				inputRect.x = roundToInt(inputStart.x);
+				inputRect.y = roundToInt(inputStart.y);
+				inputRect.width = roundToInt(inputEnd.x) - inputRect.x;
+				inputRect.height = roundToInt(inputEnd.y) - inputRect.y;
+
+				const bool useUVs = (uv0.x < 0.0f || uv0.x > uv1.x || uv1.x > 1.0f || uv0.y < 0.0f || uv0.y > uv1.y || uv1.y > 1.0f);
+				if (useUVs)
 				{
 					// Calculate actual UVs that also take cropping into account
 					if (targetRect != uncroppedRect)
 					{
+						const Vec2f originalUVStart = uv0;
+						const Vec2f originalUVRange = uv1 - uv0;
 						const Vec2f relativeStart = Vec2f(targetRect.getPos() - uncroppedRect.getPos()) / Vec2f(uncroppedRect.getSize());
 						const Vec2f relativeEnd   = Vec2f(targetRect.getPos() - uncroppedRect.getPos() + targetRect.getSize()) / Vec2f(uncroppedRect.getSize());
 						uv0 = originalUVStart + relativeStart * originalUVRange;
 						uv1 = originalUVStart + relativeEnd * originalUVRange;
 					}
 
-					useUVs = (uv0.x < 0.0f || uv0.x > uv1.x || uv1.x > 1.0f || uv0.y < 0.0f || uv0.y > uv1.y || uv1.y > 1.0f);
-
 					// Get the part from the input that will get drawn
-					const Vec2f inputStart = uv0 * Vec2f(inputWrapper.getSize());
-					const Vec2f inputEnd = uv1 * Vec2f(inputWrapper.getSize());
-					inputRect.x = roundToInt(inputStart.x);
-					inputRect.y = roundToInt(inputStart.y);
-					inputRect.width = roundToInt(inputEnd.x) - inputRect.x;
-					inputRect.height = roundToInt(inputEnd.y) - inputRect.y;
+					const Vec2f croppedInputStart = uv0 * Vec2f(inputWrapper.getSize());
+					const Vec2f croppedInputEnd = uv1 * Vec2f(inputWrapper.getSize());
+					inputRect.x = roundToInt(croppedInputStart.x);
+					inputRect.y = roundToInt(croppedInputStart.y);
+					inputRect.width = roundToInt(croppedInputEnd.x) - inputRect.x;
+					inputRect.height = roundToInt(croppedInputEnd.y) - inputRect.y;
 				}
 
-				if (useUVs || targetRect.getSize() != inputRect.getSize())
+				if (useUVs || uncroppedRect.getSize() != inputRect.getSize())
 				{
 					if (needSwapRedBlueChannels())
 					{
@@ -351,20 +512,11 @@ namespace softwaredrawer
 					}
 					else
 					{
-						mBlitter.blitRectWithScaling(getOutputWrapper(), targetRect, inputWrapper, inputRect, options);
+						mBlitter.blitRectWithScaling(Blitter::OutputWrapper(getOutputWrapper(), getScissorRect()), uncroppedRect, inputWrapper, inputRect, options);
 					}
 				}
 				else
 				{
-					// Get the part from the input that will get drawn
-					//  -> Calculated here again, as we need to use the original UVs in this case
-					const Vec2f inputStart = originalUVStart * Vec2f(inputWrapper.getSize());
-					const Vec2f inputEnd = (originalUVStart + originalUVRange) * Vec2f(inputWrapper.getSize());
-					inputRect.x = roundToInt(inputStart.x);
-					inputRect.y = roundToInt(inputStart.y);
-					inputRect.width = roundToInt(inputEnd.x) - inputRect.x;
-					inputRect.height = roundToInt(inputEnd.y) - inputRect.y;
-
 					Blitter::Options blitterOptions;
 					blitterOptions.mBlendMode = useAlphaBlending() ? BlendMode::ALPHA : BlendMode::OPAQUE;
 					blitterOptions.mTintColor = (color != Color::WHITE) ? &color : nullptr;
@@ -411,10 +563,379 @@ namespace softwaredrawer
 			mBlitter.blitSprite(Blitter::OutputWrapper(getOutputWrapper(), getScissorRect()), Blitter::SpriteWrapper(bufferBitmap, Vec2i()), drawPosition, blitterOptions);
 		}
 
+		RenderState getRenderState() const
+		{
+			RenderState state;
+			state.mBlendMode = mCurrentBlendMode;
+			state.mSamplingMode = mCurrentSamplingMode;
+			state.mWrapMode = mCurrentWrapMode;
+			state.mScissorRect = mScissorRect;
+			state.mScissorStack = mScissorStack;
+			return state;
+		}
+
+		void setRenderState(const RenderState& state, const Recti& windowClipRect)
+		{
+			mCurrentBlendMode = state.mBlendMode;
+			mCurrentSamplingMode = state.mSamplingMode;
+			mCurrentWrapMode = state.mWrapMode;
+			mWindowClipRect = windowClipRect;
+			mScissorRect = Recti::getIntersection(state.mScissorRect, windowClipRect);
+			mScissorStack = state.mScissorStack;
+			for (Recti& rect : mScissorStack)
+			{
+				rect.intersect(windowClipRect);
+			}
+		}
+
+		const Recti& getChangedTextureRect(DrawerTexture& texture)
+		{
+			const Bitmap& bitmap = texture.accessBitmap();
+			const auto [it, inserted] = mTextureSnapshots.try_emplace(&texture);
+			TextureSnapshot& snapshot = it->second;
+			if (!inserted && snapshot.mLastUsedFrame == mFrameNumber)
+				return snapshot.mChangedRect;
+
+			if (inserted || snapshot.mContent.getSize() != bitmap.getSize())
+			{
+				snapshot.mChangedRect.set(Vec2i(), bitmap.getSize());
+				snapshot.mContent = bitmap;
+			}
+			else if (snapshot.mChangeCounter != texture.getChangeCounter())
+			{
+				// Compare the content, as textures like render targets get updated each frame, but often with only small changes
+				snapshot.mChangedRect = getChangedRect(snapshot.mContent, bitmap);
+				for (int y = snapshot.mChangedRect.y; y < snapshot.mChangedRect.y + snapshot.mChangedRect.height; ++y)
+				{
+					memcpy(snapshot.mContent.getPixelPointer(0, y), bitmap.getPixelPointer(0, y), bitmap.getWidth() * sizeof(uint32));
+				}
+			}
+			else
+			{
+				snapshot.mChangedRect = Recti();
+			}
+			snapshot.mChangeCounter = texture.getChangeCounter();
+			snapshot.mLastUsedFrame = mFrameNumber;
+			return snapshot.mChangedRect;
+		}
+
+		Recti getTextBounds(uint64 textHash, Font& font, const StringReader& text, const Recti& rect, const DrawerPrintOptions& printOptions)
+		{
+			// Printing the text is the only way to get its exact size, so reuse the result of earlier frames
+			Recti bounds;
+			const auto it = mLastTextBounds.find(textHash);
+			if (it != mLastTextBounds.end())
+			{
+				bounds = it->second;
+			}
+			else
+			{
+				const auto it2 = mTextBounds.find(textHash);
+				if (it2 != mTextBounds.end())
+					return it2->second;
+
+				Vec2i drawPosition;
+				font.printBitmap(mTempBuffer, drawPosition, rect, text, printOptions.mAlignment, printOptions.mSpacing, &mTempReservedSize);
+				bounds.set(drawPosition, mTempBuffer.getSize());
+			}
+			mTextBounds[textHash] = bounds;
+			return bounds;
+		}
+
+		// Updates the given render state like the draw command would, and fills the info with what the command draws where
+		//  -> Returns false if the command's output is not independent of the scissor rect, so it can't get drawn again for only a part of the window
+		bool getWindowCommandInfo(DrawCommand& drawCommand, RenderState& state, WindowCommandInfo& outInfo)
+		{
+			outInfo = WindowCommandInfo();
+			uint64 hash = rmx::startFNV1a_64();
+			addToHash(hash, drawCommand.getType());
+			addToHash(hash, state.mBlendMode);
+			addToHash(hash, state.mSamplingMode);
+			addToHash(hash, state.mScissorRect);
+
+			Recti bounds;
+			bool usesScissor = true;
+			bool independentOfScissor = true;
+			switch (drawCommand.getType())
+			{
+				case DrawCommand::Type::RECT:
+				{
+					RectDrawCommand& dc = drawCommand.as<RectDrawCommand>();
+					bounds = getNormalizedRect(dc.mRect);
+					addToHash(hash, dc.mRect);
+					addToHash(hash, dc.mTexture);
+					addToHash(hash, dc.mColor);
+					if (nullptr != dc.mTexture)
+					{
+						addToHash(hash, dc.mUV0);
+						addToHash(hash, dc.mUV1);
+
+						// Drawing with UVs outside of the texture uses UVs adjusted for the scissor rect
+						independentOfScissor = (dc.mUV0.x >= 0.0f && dc.mUV0.x <= dc.mUV1.x && dc.mUV1.x <= 1.0f && dc.mUV0.y >= 0.0f && dc.mUV0.y <= dc.mUV1.y && dc.mUV1.y <= 1.0f);
+
+						const Recti& changedRect = getChangedTextureRect(*dc.mTexture);
+						if (changedRect.nonEmpty())
+						{
+							const bool isSimpleRect = (dc.mRect.width >= 0 && dc.mUV0 == Vec2f(0.0f, 0.0f) && dc.mUV1 == Vec2f(1.0f, 1.0f));
+							outInfo.mChangedRect = isSimpleRect ? mapTextureRectToTarget(changedRect, dc.mTexture->accessBitmap().getSize(), bounds) : bounds;
+						}
+					}
+					break;
+				}
+
+				case DrawCommand::Type::UPSCALED_RECT:
+				{
+					UpscaledRectDrawCommand& dc = drawCommand.as<UpscaledRectDrawCommand>();
+					addToHash(hash, dc.mRect);
+					addToHash(hash, dc.mTexture);
+					if (nullptr != dc.mTexture)
+					{
+						bounds = dc.mRect;
+						outInfo.mChangedRect = mapTextureRectToTarget(getChangedTextureRect(*dc.mTexture), dc.mTexture->accessBitmap().getSize(), bounds);
+					}
+					break;
+				}
+
+				case DrawCommand::Type::SPRITE:
+				{
+					SpriteDrawCommand& sc = drawCommand.as<SpriteDrawCommand>();
+					const SpriteCollection::Item* item = SpriteCollection::instance().getSprite(sc.mSpriteKey);
+					addToHash(hash, sc.mPosition);
+					addToHash(hash, sc.mSpriteKey);
+					addToHash(hash, sc.mPaletteKey);
+					addToHash(hash, sc.mTintColor);
+					addToHash(hash, sc.mScale);
+					addToHash(hash, item);
+					if (nullptr != item)
+					{
+						addToHash(hash, item->mSprite);
+						addToHash(hash, item->mChangeCounter);
+						if (item->mUsesComponentSprite)
+						{
+							bounds = getNormalizedRect(getComponentSpriteRect(sc, *item->mSprite));
+						}
+						else
+						{
+							const PaletteBase* palette = PaletteCollection::instance().getPalette(sc.mPaletteKey, 0);
+							addToHash(hash, palette);
+							if (nullptr != palette)
+							{
+								addToHash(hash, palette->getChangeCounter());
+								bounds.set(sc.mPosition + item->mSprite->mOffset, item->mSprite->getSize());
+							}
+						}
+					}
+					break;
+				}
+
+				case DrawCommand::Type::SPRITE_RECT:
+				{
+					SpriteRectDrawCommand& sc = drawCommand.as<SpriteRectDrawCommand>();
+					const SpriteCollection::Item* item = SpriteCollection::instance().getSprite(sc.mSpriteKey);
+					addToHash(hash, sc.mRect);
+					addToHash(hash, sc.mSpriteKey);
+					addToHash(hash, sc.mTintColor);
+					addToHash(hash, item);
+					if (nullptr != item && item->mUsesComponentSprite)
+					{
+						addToHash(hash, item->mSprite);
+						addToHash(hash, item->mChangeCounter);
+						bounds = getNormalizedRect(sc.mRect);
+					}
+					break;
+				}
+
+				case DrawCommand::Type::MESH:
+				case DrawCommand::Type::MESH_VERTEX_COLOR:
+				{
+					// The rasterizer does not support scissor rects
+					usesScissor = false;
+					independentOfScissor = false;
+
+					Vec2f minPosition(1e9f, 1e9f);
+					Vec2f maxPosition(-1e9f, -1e9f);
+					const auto addVertexPositions = [&](const auto& triangles)
+					{
+						for (const auto& vertex : triangles)
+						{
+							minPosition.x = std::min(minPosition.x, vertex.mPosition.x);
+							minPosition.y = std::min(minPosition.y, vertex.mPosition.y);
+							maxPosition.x = std::max(maxPosition.x, vertex.mPosition.x);
+							maxPosition.y = std::max(maxPosition.y, vertex.mPosition.y);
+						}
+						if (!triangles.empty())
+							hash = rmx::addToFNV1a_64(hash, (const uint8*)&triangles[0], triangles.size() * sizeof(triangles[0]));
+					};
+
+					if (drawCommand.getType() == DrawCommand::Type::MESH)
+					{
+						MeshDrawCommand& dc = drawCommand.as<MeshDrawCommand>();
+						addVertexPositions(dc.mTriangles);
+						addToHash(hash, dc.mTexture);
+					}
+					else
+					{
+						addVertexPositions(drawCommand.as<MeshVertexColorDrawCommand>().mTriangles);
+					}
+
+					if (minPosition.x <= maxPosition.x)
+					{
+						const Vec2i minCorner((int)std::floor(minPosition.x), (int)std::floor(minPosition.y));
+						const Vec2i maxCorner((int)std::ceil(maxPosition.x) + 1, (int)std::ceil(maxPosition.y) + 1);
+						bounds.set(minCorner, maxCorner - minCorner);
+					}
+					if (drawCommand.getType() == DrawCommand::Type::MESH)
+					{
+						DrawerTexture* texture = drawCommand.as<MeshDrawCommand>().mTexture;
+						if (nullptr != texture && getChangedTextureRect(*texture).nonEmpty())
+							outInfo.mChangedRect = bounds;
+					}
+					break;
+				}
+
+				case DrawCommand::Type::PRINT_TEXT:
+				case DrawCommand::Type::PRINT_TEXT_W:
+				{
+					Font* font;
+					Recti rect;
+					StringReader text("");
+					DrawerPrintOptions printOptions;
+					if (drawCommand.getType() == DrawCommand::Type::PRINT_TEXT)
+					{
+						PrintTextDrawCommand& dc = drawCommand.as<PrintTextDrawCommand>();
+						font = dc.mFont;
+						rect = dc.mRect;
+						text = StringReader(dc.mText);
+						printOptions = dc.mPrintOptions;
+					}
+					else
+					{
+						PrintTextWDrawCommand& dc = drawCommand.as<PrintTextWDrawCommand>();
+						font = dc.mFont;
+						rect = dc.mRect;
+						text = StringReader(dc.mText);
+						printOptions = dc.mPrintOptions;
+					}
+
+					// The hash without the render state and tint color is used for caching the text bounds
+					uint64 textHash = rmx::startFNV1a_64();
+					addToHash(textHash, font);
+					addToHash(textHash, font->getChangeCounter());
+					addToHash(textHash, rect);
+					addToHash(textHash, printOptions.mAlignment);
+					addToHash(textHash, printOptions.mSpacing);
+					addTextToHash(textHash, text);
+
+					addToHash(hash, textHash);
+					addToHash(hash, printOptions.mTintColor);
+					bounds = getTextBounds(textHash, *font, text, rect, printOptions);
+					break;
+				}
+
+				case DrawCommand::Type::SET_BLEND_MODE:
+				{
+					state.mBlendMode = drawCommand.as<SetBlendModeDrawCommand>().mBlendMode;
+					return true;
+				}
+
+				case DrawCommand::Type::SET_SAMPLING_MODE:
+				{
+					state.mSamplingMode = drawCommand.as<SetSamplingModeDrawCommand>().mSamplingMode;
+					return true;
+				}
+
+				case DrawCommand::Type::SET_WRAP_MODE:
+				{
+					state.mWrapMode = drawCommand.as<SetWrapModeDrawCommand>().mWrapMode;
+					return true;
+				}
+
+				case DrawCommand::Type::PUSH_SCISSOR:
+				{
+					state.mScissorRect.intersect(drawCommand.as<PushScissorDrawCommand>().mRect);
+					state.mScissorStack.emplace_back(state.mScissorRect);
+					return true;
+				}
+
+				case DrawCommand::Type::POP_SCISSOR:
+				{
+					if (!state.mScissorStack.empty())
+						state.mScissorStack.pop_back();
+					state.mScissorRect = state.mScissorStack.empty() ? mWindowRect : state.mScissorStack.back();
+					return true;
+				}
+
+				default:
+					return true;
+			}
+
+			outInfo.mIsDrawing = true;
+			outInfo.mHash = hash;
+			outInfo.mBounds = Recti::getIntersection(bounds, usesScissor ? state.mScissorRect : mWindowRect);
+			if (outInfo.mChangedRect.nonEmpty())
+				outInfo.mChangedRect.intersect(outInfo.mBounds);
+			return independentOfScissor;
+		}
+
+		// Adds dirty rects for all changes between the drawing commands of the last and the current frame
+		void addChangedRects(const std::vector<WindowCommandInfo>& oldInfos, const std::vector<WindowCommandInfo>& newInfos)
+		{
+			// Unchanged commands at the start and end can be ignored, as they draw the same in the same order;
+			// everything in between needs to be drawn again, in both their old and new bounds
+			const auto isSameCommand = [](const WindowCommandInfo& info1, const WindowCommandInfo& info2)
+			{
+				return (info1.mHash == info2.mHash && info1.mBounds == info2.mBounds);
+			};
+
+			size_t numSameAtStart = 0;
+			while (numSameAtStart < oldInfos.size() && numSameAtStart < newInfos.size() && isSameCommand(oldInfos[numSameAtStart], newInfos[numSameAtStart]))
+				++numSameAtStart;
+
+			size_t numSameAtEnd = 0;
+			while (numSameAtStart + numSameAtEnd < oldInfos.size() && numSameAtStart + numSameAtEnd < newInfos.size() && isSameCommand(oldInfos[oldInfos.size() - 1 - numSameAtEnd], newInfos[newInfos.size() - 1 - numSameAtEnd]))
+				++numSameAtEnd;
+
+			for (size_t k = numSameAtStart; k < oldInfos.size() - numSameAtEnd; ++k)
+				addDirtyRect(mDirtyRects, oldInfos[k].mBounds);
+			for (size_t k = numSameAtStart; k < newInfos.size() - numSameAtEnd; ++k)
+				addDirtyRect(mDirtyRects, newInfos[k].mBounds);
+
+			// Changes inside of textures
+			for (const WindowCommandInfo& info : newInfos)
+				addDirtyRect(mDirtyRects, info.mChangedRect);
+		}
+
+		void finishFrame()
+		{
+			if (mNumWindowSegments > 0)
+			{
+				mLastFirstSegmentInfos.swap(mFirstSegmentInfos);
+				mLastOverlayBounds.swap(mOverlayBounds);
+			}
+			mFirstSegmentInfos.clear();
+			mOverlayBounds.clear();
+			mDirtyRects.clear();
+			mNumWindowSegments = 0;
+
+			mLastTextBounds.swap(mTextBounds);
+			mTextBounds.clear();
+
+			// Forget about textures not used any more
+			for (auto it = mTextureSnapshots.begin(); it != mTextureSnapshots.end(); )
+			{
+				if (it->second.mLastUsedFrame != mFrameNumber)
+					it = mTextureSnapshots.erase(it);
+				else
+					++it;
+			}
+			++mFrameNumber;
+		}
+
 	public:
 		SDL_Window* mOutputWindow = nullptr;
 		SDL_Surface* mScreenSurface = nullptr;
 		bool mSurfaceSwapRedBlue = false;
+		Recti mWindowRect;
 
 		BlendMode mCurrentBlendMode = BlendMode::OPAQUE;
 		SamplingMode mCurrentSamplingMode = SamplingMode::POINT;
@@ -427,8 +948,27 @@ namespace softwaredrawer
 		Bitmap mTempBuffer;
 		int mTempReservedSize = 0;
 
+		// Dirty region tracking for the window
+		//  -> The first segment of draw commands targeting the window in each frame gets compared to the last frame, and only drawn again where there are changes
+		//  -> Later segments in the same frame (like overlays drawn after the game view) are always drawn completely, and their bounds are regarded as changed in the next frame
+		bool mFullRedraw = true;
+		uint32 mFrameNumber = 0;
+		int mNumWindowSegments = 0;			// Number of segments with draw commands targeting the window in the current frame
+		Recti mWindowClipRect;				// Part of the window that may get drawn to, used as scissor rect when drawing again only a dirty rect
+		std::vector<WindowCommandInfo> mSegmentInfos;			// Infos for all commands of the segment currently getting drawn
+		std::vector<WindowCommandInfo> mFirstSegmentInfos;		// Infos for the drawing commands of the first segment in the current frame
+		std::vector<WindowCommandInfo> mLastFirstSegmentInfos;
+		std::vector<Recti> mOverlayBounds;		// Bounds of the drawing commands in later segments of the current frame
+		std::vector<Recti> mLastOverlayBounds;
+		std::vector<Recti> mDirtyRects;			// Non-overlapping parts of the window that changed in the current frame
+		std::vector<SDL_Rect> mPresentedRects;
+		std::unordered_map<const DrawerTexture*, TextureSnapshot> mTextureSnapshots;
+		std::unordered_map<uint64, Recti> mTextBounds;
+		std::unordered_map<uint64, Recti> mLastTextBounds;
+
 	private:
 		DrawerTexture* mCurrentRenderTarget = nullptr;
+		SDL_Surface* mLastScreenSurface = nullptr;
 		BitmapViewMutable<uint32> mOutputWrapper;
 		bool mIsScreenSurfaceLocked = false;
 		bool mDisplayedFormatWarning = false;
@@ -463,258 +1003,378 @@ void SoftwareDrawer::setupRenderWindow(SDL_Window* window)
 
 void SoftwareDrawer::performRendering(const DrawCollection& drawCollection)
 {
-	for (DrawCommand* drawCommand : drawCollection.getDrawCommands())
+	const std::vector<DrawCommand*>& drawCommands = drawCollection.getDrawCommands();
+	size_t index = 0;
+	while (index < drawCommands.size())
 	{
-		switch (drawCommand->getType())
+		if (nullptr != mInternal.getCurrentRenderTarget())
 		{
-			case DrawCommand::Type::UNDEFINED:
-			{
-				RMX_ERROR("Got invalid draw command", );
-				continue;
-			}
+			// Render targets get drawn to completely each time
+			executeDrawCommand(*drawCommands[index]);
+			++index;
+		}
+		else
+		{
+			// Collect the segment of commands targeting the window, up to the next render target change
+			size_t endIndex = index;
+			while (endIndex < drawCommands.size() && drawCommands[endIndex]->getType() != DrawCommand::Type::SET_RENDER_TARGET)
+				++endIndex;
 
-			case DrawCommand::Type::SET_WINDOW_RENDER_TARGET:
-			{
-				//SetWindowRenderTargetDrawCommand& dc = drawCommand->as<SetWindowRenderTargetDrawCommand>();
-				if (nullptr != mInternal.getCurrentRenderTarget())
-				{
-					mInternal.getCurrentRenderTarget()->bitmapUpdated();
-					mInternal.setCurrentRenderTarget(nullptr);
-				}
-				break;
-			}
+			renderWindowSegment(drawCommands, index, endIndex);
+			index = endIndex;
+		}
+	}
+}
+
+void SoftwareDrawer::presentScreen()
+{
+	if (nullptr == mInternal.mScreenSurface)
+		return;
+
+	mInternal.unlockScreenSurface();
 
-			case DrawCommand::Type::SET_RENDER_TARGET:
+	// Only update the parts of the window that changed
+	if (!mInternal.mDirtyRects.empty())
+	{
+		mInternal.mPresentedRects.clear();
+		for (const Recti& rect : mInternal.mDirtyRects)
+		{
+			SDL_Rect& sdlRect = vectorAdd(mInternal.mPresentedRects);
+			sdlRect.x = rect.x;
+			sdlRect.y = rect.y;
+			sdlRect.w = rect.width;
+			sdlRect.h = rect.height;
+		}
+		SDL_UpdateWindowSurfaceRects(mInternal.mOutputWindow, &mInternal.mPresentedRects[0], (int)mInternal.mPresentedRects.size());
+	}
+
+	mInternal.finishFrame();
+}
+
+void SoftwareDrawer::renderWindowSegment(const std::vector<DrawCommand*>& drawCommands, size_t beginIndex, size_t endIndex)
+{
+	if (nullptr == mInternal.mScreenSurface)
+	{
+		for (size_t index = beginIndex; index < endIndex; ++index)
+			executeDrawCommand(*drawCommands[index]);
+		return;
+	}
+
+	// Collect information about all commands first, incl. the render state at the end of the segment
+	const softwaredrawer::RenderState startState = mInternal.getRenderState();
+	softwaredrawer::RenderState endState = startState;
+	std::vector<softwaredrawer::WindowCommandInfo>& infos = mInternal.mSegmentInfos;
+	infos.resize(endIndex - beginIndex);
+	bool canDrawPartially = true;
+	bool anyDrawing = false;
+	for (size_t index = beginIndex; index < endIndex; ++index)
+	{
+		softwaredrawer::WindowCommandInfo& info = infos[index - beginIndex];
+		canDrawPartially = mInternal.getWindowCommandInfo(*drawCommands[index], endState, info) && canDrawPartially;
+		anyDrawing = anyDrawing || info.mIsDrawing;
+	}
+
+	if (!anyDrawing || mInternal.mNumWindowSegments > 0)
+	{
+		// Draw the whole segment, and remember its bounds
+		//  -> The first segment of the next frame will get drawn again in these bounds, which removes this segment's output again
+		for (size_t index = beginIndex; index < endIndex; ++index)
+			executeDrawCommand(*drawCommands[index]);
+
+		for (const softwaredrawer::WindowCommandInfo& info : infos)
+		{
+			if (info.mIsDrawing)
 			{
-				SetRenderTargetDrawCommand& dc = drawCommand->as<SetRenderTargetDrawCommand>();
-				if (nullptr != mInternal.getCurrentRenderTarget())
-				{
-					mInternal.getCurrentRenderTarget()->bitmapUpdated();
-				}
-				mInternal.setCurrentRenderTarget(dc.mTexture);
-				break;
+				mInternal.mOverlayBounds.push_back(info.mBounds);
+				softwaredrawer::addDirtyRect(mInternal.mDirtyRects, info.mBounds);
 			}
+		}
+		if (anyDrawing)
+			++mInternal.mNumWindowSegments;
+		return;
+	}
 
-			case DrawCommand::Type::RECT:
-			{
-				RectDrawCommand& dc = drawCommand->as<RectDrawCommand>();
-				Bitmap* inputBitmap = (nullptr == dc.mTexture) ? nullptr : &dc.mTexture->accessBitmap();
+	// This is the first segment in this frame, compare it to the last frame
+	mInternal.mFirstSegmentInfos.clear();
+	for (const softwaredrawer::WindowCommandInfo& info : infos)
+	{
+		if (info.mIsDrawing)
+			mInternal.mFirstSegmentInfos.push_back(info);
+	}
 
-				mInternal.drawRect(dc.mRect, inputBitmap, dc.mColor, dc.mUV0, dc.mUV1);
-				break;
-			}
+	std::vector<Recti>& dirtyRects = mInternal.mDirtyRects;
+	if (mInternal.mFullRedraw || !canDrawPartially)
+	{
+		softwaredrawer::addDirtyRect(dirtyRects, mInternal.mWindowRect);
+	}
+	else
+	{
+		mInternal.addChangedRects(mInternal.mLastFirstSegmentInfos, mInternal.mFirstSegmentInfos);
+		for (const Recti& rect : mInternal.mLastOverlayBounds)
+			softwaredrawer::addDirtyRect(dirtyRects, rect);
 
-			case DrawCommand::Type::UPSCALED_RECT:
-			{
-				UpscaledRectDrawCommand& dc = drawCommand->as<UpscaledRectDrawCommand>();
-				if (nullptr != dc.mTexture)
-				{
-					BitmapViewMutable<uint32>& outputWrapper = mInternal.getOutputWrapper();
-					BitmapViewMutable<uint32> inputWrapper(dc.mTexture->accessBitmap());
+		if (dirtyRects.size() > 16)
+		{
+			// Limit the number of times the segment gets drawn
+			Recti boundingRect = dirtyRects[0];
+			for (const Recti& rect : dirtyRects)
+				boundingRect = softwaredrawer::getBoundingRect(boundingRect, rect);
+			dirtyRects.clear();
+			dirtyRects.push_back(boundingRect);
+		}
+	}
 
-					if (mInternal.needSwapRedBlueChannels())
-					{
-						mInternal.setupRedBlueSwappedBitmapWrapper(inputWrapper);
-					}
+	// Draw the segment again inside each dirty rect, skipping commands that are completely outside
+	for (const Recti& dirtyRect : dirtyRects)
+	{
+		mInternal.setRenderState(startState, dirtyRect);
+		for (size_t index = beginIndex; index < endIndex; ++index)
+		{
+			const softwaredrawer::WindowCommandInfo& info = infos[index - beginIndex];
+			if (info.mIsDrawing && Recti::getIntersection(info.mBounds, dirtyRect).isEmpty())
+				continue;
+			executeDrawCommand(*drawCommands[index]);
+		}
+	}
+	mInternal.setRenderState(endState, mInternal.mWindowRect);
 
-					mInternal.mBlitter.blitRectWithScaling(outputWrapper, dc.mRect, inputWrapper, Recti(0, 0, inputWrapper.getSize().x, inputWrapper.getSize().y), Blitter::Options());
-				}
-				break;
+	mInternal.mFullRedraw = false;
+	++mInternal.mNumWindowSegments;
+}
+
+void SoftwareDrawer::executeDrawCommand(DrawCommand& drawCommand)
+{
+	switch (drawCommand.getType())
+	{
+		case DrawCommand::Type::UNDEFINED:
+		{
+			RMX_ERROR("Got invalid draw command", );
+			return;
+		}
+
+		case DrawCommand::Type::SET_WINDOW_RENDER_TARGET:
+		{
+			//SetWindowRenderTargetDrawCommand& dc = drawCommand.as<SetWindowRenderTargetDrawCommand>();
+			if (nullptr != mInternal.getCurrentRenderTarget())
+			{
+				mInternal.getCurrentRenderTarget()->bitmapUpdated();
+				mInternal.setCurrentRenderTarget(nullptr);
 			}
+			break;
+		}
 
-			case DrawCommand::Type::SPRITE:
+		case DrawCommand::Type::SET_RENDER_TARGET:
+		{
+			SetRenderTargetDrawCommand& dc = drawCommand.as<SetRenderTargetDrawCommand>();
+			if (nullptr != mInternal.getCurrentRenderTarget())
 			{
-				SpriteDrawCommand& sc = drawCommand->as<SpriteDrawCommand>();
-				const SpriteCollection::Item* item = SpriteCollection::instance().getSprite(sc.mSpriteKey);
-				if (nullptr == item)
-					break;
+				mInternal.getCurrentRenderTarget()->bitmapUpdated();
+			}
+			mInternal.setCurrentRenderTarget(dc.mTexture);
+			break;
+		}
 
-				const PaletteBase* palette = nullptr;
-				if (!item->mUsesComponentSprite)
-				{
-					palette = PaletteCollection::instance().getPalette(sc.mPaletteKey, 0);
-					if (nullptr == palette)
-						break;
-				}
+		case DrawCommand::Type::RECT:
+		{
+			RectDrawCommand& dc = drawCommand.as<RectDrawCommand>();
+			Bitmap* inputBitmap = (nullptr == dc.mTexture) ? nullptr : &dc.mTexture->accessBitmap();
 
-				SpriteBase& sprite = *item->mSprite;
-				Vec2i offset = sprite.mOffset;
+			mInternal.drawRect(dc.mRect, inputBitmap, dc.mColor, dc.mUV0, dc.mUV1);
+			break;
+		}
 
-				// TODO: No support for bilinear sampling here...
+		case DrawCommand::Type::UPSCALED_RECT:
+		{
+			UpscaledRectDrawCommand& dc = drawCommand.as<UpscaledRectDrawCommand>();
+			if (nullptr != dc.mTexture)
+			{
+				BitmapViewMutable<uint32>& outputWrapper = mInternal.getOutputWrapper();
+				BitmapViewMutable<uint32> inputWrapper(dc.mTexture->accessBitmap());
 
-				if (item->mUsesComponentSprite)
+				if (mInternal.needSwapRedBlueChannels())
 				{
-					Vec2i size = sprite.getSize();
-					if (sc.mScale.x != 1.0f || sc.mScale.y != 1.0f)
-					{
-						offset.x = roundToInt((float)offset.x * sc.mScale.x);
-						offset.y = roundToInt((float)offset.y * sc.mScale.y);
-						size.x = roundToInt((float)size.x * sc.mScale.x);
-						size.y = roundToInt((float)size.y * sc.mScale.y);
-					}
-					const Recti targetRect(sc.mPosition + offset, size);
-
-					ComponentSprite& componentSprite = static_cast<ComponentSprite&>(sprite);
-					mInternal.drawRect(targetRect, &componentSprite.accessBitmap(), sc.mTintColor);
+					mInternal.setupRedBlueSwappedBitmapWrapper(inputWrapper);
 				}
-				else
-				{
-					// TODO: Support scaling here as well
 
-					PaletteSprite& paletteSprite = static_cast<PaletteSprite&>(sprite);
-					mInternal.drawIndexed(sc.mPosition + offset, paletteSprite.accessBitmap(), *palette, sc.mTintColor);
-				}
-				break;
+				mInternal.mBlitter.blitRectWithScaling(Blitter::OutputWrapper(outputWrapper, mInternal.getScissorRect()), dc.mRect, inputWrapper, Recti(0, 0, inputWrapper.getSize().x, inputWrapper.getSize().y), Blitter::Options());
 			}
+			break;
+		}
+
+		case DrawCommand::Type::SPRITE:
+		{
+			SpriteDrawCommand& sc = drawCommand.as<SpriteDrawCommand>();
+			const SpriteCollection::Item* item = SpriteCollection::instance().getSprite(sc.mSpriteKey);
+			if (nullptr == item)
+				break;
 
-			case DrawCommand::Type::SPRITE_RECT:
+			const PaletteBase* palette = nullptr;
+			if (!item->mUsesComponentSprite)
 			{
-				SpriteRectDrawCommand& sc = drawCommand->as<SpriteRectDrawCommand>();
-				const SpriteCollection::Item* item = SpriteCollection::instance().getSprite(sc.mSpriteKey);
-				if (nullptr == item)
-					break;
-				if (!item->mUsesComponentSprite)
+				palette = PaletteCollection::instance().getPalette(sc.mPaletteKey, 0);
+				if (nullptr == palette)
 					break;
+			}
 
-				ComponentSprite& sprite = *static_cast<ComponentSprite*>(item->mSprite);
-
-				// TODO: No support for bilinear sampling here...
+			SpriteBase& sprite = *item->mSprite;
 
-				mInternal.drawRect(sc.mRect, &sprite.accessBitmap(), sc.mTintColor);
-				break;
-			}
+			// TODO: No support for bilinear sampling here...
 
-			case DrawCommand::Type::MESH:
+			if (item->mUsesComponentSprite)
 			{
-				MeshDrawCommand& dc = drawCommand->as<MeshDrawCommand>();
-				if (nullptr != dc.mTexture)
-				{
-					BitmapViewMutable<uint32> outputView(mInternal.getOutputWrapper().getData(), mInternal.getOutputWrapper().getSize());
-					Bitmap& inputBitmap = dc.mTexture->accessBitmap();
+				const Recti targetRect = softwaredrawer::getComponentSpriteRect(sc, sprite);
 
-					Blitter::Options options;
-					options.mBlendMode = mInternal.useAlphaBlending() ? BlendMode::ALPHA : BlendMode::OPAQUE;
-					options.mSamplingMode = (mInternal.mCurrentSamplingMode == SamplingMode::BILINEAR) ? SamplingMode::BILINEAR : SamplingMode::POINT;
-					// Note that this does not support red-blue channel swap
+				ComponentSprite& componentSprite = static_cast<ComponentSprite&>(sprite);
+				mInternal.drawRect(targetRect, &componentSprite.accessBitmap(), sc.mTintColor);
+			}
+			else
+			{
+				// TODO: Support scaling here as well
 
-					SoftwareRasterizer rasterizer(outputView, options);
-					SoftwareRasterizer::Vertex_P2_T2 triangle[3];
+				PaletteSprite& paletteSprite = static_cast<PaletteSprite&>(sprite);
+				mInternal.drawIndexed(sc.mPosition + sprite.mOffset, paletteSprite.accessBitmap(), *palette, sc.mTintColor);
+			}
+			break;
+		}
 
-					const int numTriangles = (int)dc.mTriangles.size() / 3;
-					for (int i = 0; i < numTriangles; ++i)
-					{
-						DrawerMeshVertex* input = &dc.mTriangles[i * 3];
-						for (int k = 0; k < 3; ++k)
-						{
-							triangle[k].mPosition = input[k].mPosition;
-							triangle[k].mUV = input[k].mTexcoords;
-						}
-						rasterizer.drawTriangle(triangle, inputBitmap);
-					}
-				}
+		case DrawCommand::Type::SPRITE_RECT:
+		{
+			SpriteRectDrawCommand& sc = drawCommand.as<SpriteRectDrawCommand>();
+			const SpriteCollection::Item* item = SpriteCollection::instance().getSprite(sc.mSpriteKey);
+			if (nullptr == item)
 				break;
-			}
+			if (!item->mUsesComponentSprite)
+				break;
+
+			ComponentSprite& sprite = *static_cast<ComponentSprite*>(item->mSprite);
+
+			// TODO: No support for bilinear sampling here...
+
+			mInternal.drawRect(sc.mRect, &sprite.accessBitmap(), sc.mTintColor);
+			break;
+		}
 
-			case DrawCommand::Type::MESH_VERTEX_COLOR:
+		case DrawCommand::Type::MESH:
+		{
+			MeshDrawCommand& dc = drawCommand.as<MeshDrawCommand>();
+			if (nullptr != dc.mTexture)
 			{
-				MeshVertexColorDrawCommand& dc = drawCommand->as<MeshVertexColorDrawCommand>();
 				BitmapViewMutable<uint32> outputView(mInternal.getOutputWrapper().getData(), mInternal.getOutputWrapper().getSize());
+				Bitmap& inputBitmap = dc.mTexture->accessBitmap();
 
 				Blitter::Options options;
 				options.mBlendMode = mInternal.useAlphaBlending() ? BlendMode::ALPHA : BlendMode::OPAQUE;
+				options.mSamplingMode = (mInternal.mCurrentSamplingMode == SamplingMode::BILINEAR) ? SamplingMode::BILINEAR : SamplingMode::POINT;
+				// Note that this does not support red-blue channel swap
 
 				SoftwareRasterizer rasterizer(outputView, options);
-				SoftwareRasterizer::Vertex_P2_C4 triangle[3];
-				const bool swapRedBlue = mInternal.needSwapRedBlueChannels();
+				SoftwareRasterizer::Vertex_P2_T2 triangle[3];
 
 				const int numTriangles = (int)dc.mTriangles.size() / 3;
 				for (int i = 0; i < numTriangles; ++i)
 				{
-					DrawerMeshVertex_P2_C4* input = &dc.mTriangles[i * 3];
+					DrawerMeshVertex* input = &dc.mTriangles[i * 3];
 					for (int k = 0; k < 3; ++k)
 					{
 						triangle[k].mPosition = input[k].mPosition;
-						triangle[k].mColor = input[k].mColor;
-					}
-					if (swapRedBlue)
-					{
-						for (int k = 0; k < 3; ++k)
-							triangle[k].mColor.swapRedBlue();
+						triangle[k].mUV = input[k].mTexcoords;
 					}
-					rasterizer.drawTriangle(triangle);
+					rasterizer.drawTriangle(triangle, inputBitmap);
 				}
-				break;
 			}
+			break;
+		}
 
-			case DrawCommand::Type::SET_BLEND_MODE:
-			{
-				SetBlendModeDrawCommand& dc = drawCommand->as<SetBlendModeDrawCommand>();
-				mInternal.mCurrentBlendMode = dc.mBlendMode;
-				break;
-			}
+		case DrawCommand::Type::MESH_VERTEX_COLOR:
+		{
+			MeshVertexColorDrawCommand& dc = drawCommand.as<MeshVertexColorDrawCommand>();
+			BitmapViewMutable<uint32> outputView(mInternal.getOutputWrapper().getData(), mInternal.getOutputWrapper().getSize());
 
-			case DrawCommand::Type::SET_SAMPLING_MODE:
-			{
-				SetSamplingModeDrawCommand& dc = drawCommand->as<SetSamplingModeDrawCommand>();
-				mInternal.mCurrentSamplingMode = dc.mSamplingMode;
-				break;
-			}
+			Blitter::Options options;
+			options.mBlendMode = mInternal.useAlphaBlending() ? BlendMode::ALPHA : BlendMode::OPAQUE;
 
-			case DrawCommand::Type::SET_WRAP_MODE:
-			{
-				SetWrapModeDrawCommand& dc = drawCommand->as<SetWrapModeDrawCommand>();
-				mInternal.mCurrentWrapMode = dc.mWrapMode;
-				break;
-			}
+			SoftwareRasterizer rasterizer(outputView, options);
+			SoftwareRasterizer::Vertex_P2_C4 triangle[3];
+			const bool swapRedBlue = mInternal.needSwapRedBlueChannels();
 
-			case DrawCommand::Type::PRINT_TEXT:
+			const int numTriangles = (int)dc.mTriangles.size() / 3;
+			for (int i = 0; i < numTriangles; ++i)
 			{
-				PrintTextDrawCommand& dc = drawCommand->as<PrintTextDrawCommand>();
-				mInternal.printText(*dc.mFont, dc.mText, dc.mRect, dc.mPrintOptions);
-				break;
+				DrawerMeshVertex_P2_C4* input = &dc.mTriangles[i * 3];
+				for (int k = 0; k < 3; ++k)
+				{
+					triangle[k].mPosition = input[k].mPosition;
+					triangle[k].mColor = input[k].mColor;
+				}
+				if (swapRedBlue)
+				{
+					for (int k = 0; k < 3; ++k)
+						triangle[k].mColor.swapRedBlue();
+				}
+				rasterizer.drawTriangle(triangle);
 			}
+			break;
+		}
 
-			case DrawCommand::Type::PRINT_TEXT_W:
-			{
-				PrintTextWDrawCommand& dc = drawCommand->as<PrintTextWDrawCommand>();
-				mInternal.printText(*dc.mFont, dc.mText, dc.mRect, dc.mPrintOptions);
-				break;
-			}
+		case DrawCommand::Type::SET_BLEND_MODE:
+		{
+			SetBlendModeDrawCommand& dc = drawCommand.as<SetBlendModeDrawCommand>();
+			mInternal.mCurrentBlendMode = dc.mBlendMode;
+			break;
+		}
 
-			case DrawCommand::Type::PUSH_SCISSOR:
-			{
-				PushScissorDrawCommand& dc = drawCommand->as<PushScissorDrawCommand>();
+		case DrawCommand::Type::SET_SAMPLING_MODE:
+		{
+			SetSamplingModeDrawCommand& dc = drawCommand.as<SetSamplingModeDrawCommand>();
+			mInternal.mCurrentSamplingMode = dc.mSamplingMode;
+			break;
+		}
 
-				mInternal.mScissorRect.intersect(dc.mRect);
-				mInternal.mScissorStack.emplace_back(mInternal.mScissorRect);
-				break;
-			}
+		case DrawCommand::Type::SET_WRAP_MODE:
+		{
+			SetWrapModeDrawCommand& dc = drawCommand.as<SetWrapModeDrawCommand>();
+			mInternal.mCurrentWrapMode = dc.mWrapMode;
+			break;
+		}
+
+		case DrawCommand::Type::PRINT_TEXT:
+		{
+			PrintTextDrawCommand& dc = drawCommand.as<PrintTextDrawCommand>();
+			mInternal.printText(*dc.mFont, dc.mText, dc.mRect, dc.mPrintOptions);
+			break;
+		}
+
+		case DrawCommand::Type::PRINT_TEXT_W:
+		{
+			PrintTextWDrawCommand& dc = drawCommand.as<PrintTextWDrawCommand>();
+			mInternal.printText(*dc.mFont, dc.mText, dc.mRect, dc.mPrintOptions);
+			break;
+		}
+
+		case DrawCommand::Type::PUSH_SCISSOR:
+		{
+			PushScissorDrawCommand& dc = drawCommand.as<PushScissorDrawCommand>();
 
-			case DrawCommand::Type::POP_SCISSOR:
+			mInternal.mScissorRect.intersect(dc.mRect);
+			mInternal.mScissorStack.emplace_back(mInternal.mScissorRect);
+			break;
+		}
+
+		case DrawCommand::Type::POP_SCISSOR:
+		{
+			mInternal.mScissorStack.pop_back();
+			if (mInternal.mScissorStack.empty())
 			{
-				mInternal.mScissorStack.pop_back();
-				if (mInternal.mScissorStack.empty())
+				if (nullptr != mInternal.mScreenSurface)
 				{
-					if (nullptr != mInternal.mScreenSurface)
-					{
-						mInternal.mScissorRect.set(0, 0, mInternal.mScreenSurface->w, mInternal.mScreenSurface->h);
-					}
-				}
-				else
-				{
-					mInternal.mScissorRect = mInternal.mScissorStack.back();
+					mInternal.mScissorRect = mInternal.mWindowClipRect;
 				}
-				break;
 			}
+			else
+			{
+				mInternal.mScissorRect = mInternal.mScissorStack.back();
+			}
+			break;
 		}
 	}
 }
-
-void SoftwareDrawer::presentScreen()
-{
-	if (nullptr == mInternal.mScreenSurface)
-		return;
-
-	mInternal.unlockScreenSurface();
-	SDL_UpdateWindowSurface(mInternal.mOutputWindow);
-}
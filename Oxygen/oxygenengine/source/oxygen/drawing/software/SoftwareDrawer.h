@@ -32,6 +32,10 @@ public:
 	void performRendering(const DrawCollection& drawCollection) override;
 	void presentScreen() override;
 
+private:
+	void renderWindowSegment(const std::vector<DrawCommand*>& drawCommands, size_t beginIndex, size_t endIndex);
+	void executeDrawCommand(DrawCommand& drawCommand);
+
 private:
 	softwaredrawer::Internal& mInternal;
 };
@@ -102,7 +102,22 @@ bool FileHelper::loadPaletteBitmap(PaletteBitmap& bitmap, const std::wstring& fi
 		RMX_CHECK(!showError, "Failed to load image file '" << *WString(filename).toString() << "': File not found", );
 		return false;
 	}
+	return decodePaletteBitmap(bitmap, content, filename, outPalette, showError);
+}
+
+bool FileHelper::loadBitmap(Bitmap& bitmap, const std::wstring& filename, bool showError)
+{
+	std::vector<uint8> content;
+	if (!FTX::FileSystem->readFile(filename, content))
+	{
+		RMX_CHECK(!showError, "Failed to load image file '" << *WString(filename).toString() << "': File not found", );
+		return false;
+	}
+	return decodeBitmap(bitmap, content, filename, showError);
+}
 
+bool FileHelper::decodePaletteBitmap(PaletteBitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename, std::vector<uint32>* outPalette, bool showError)
+{
 	if (!bitmap.loadBMP(content, outPalette))
 	{
 		RMX_CHECK(!showError, "Failed to load image file '" << *WString(filename).toString() << "': Format not supported", );
@@ -111,12 +126,11 @@ bool FileHelper::loadPaletteBitmap(PaletteBitmap& bitmap, const std::wstring& fi
 	return true;
 }
 
-bool FileHelper::loadBitmap(Bitmap& bitmap, const std::wstring& filename, bool showError)
+bool FileHelper::decodeBitmap(Bitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename, bool showError)
 {
-	std::vector<uint8> content;
-	if (!FTX::FileSystem->readFile(filename, content))
+	if (content.empty())
 	{
-		RMX_CHECK(!showError, "Failed to load image file '" << *WString(filename).toString() << "': File not found", );
+		RMX_CHECK(!showError, "Failed to load image file '" << *WString(filename).toString() << "': File is empty", );
 		return false;
 	}
 
@@ -19,6 +19,11 @@ class FileHelper
 public:
 	static bool loadPaletteBitmap(PaletteBitmap& bitmap, const std::wstring& filename, std::vector<uint32>* outPalette = nullptr, bool showError = true);
 	static bool loadBitmap(Bitmap& bitmap, const std::wstring& filename, bool showError = true);
+
+	// Variants for file content that was already read, the filename is only used for the format and error output
+	static bool decodePaletteBitmap(PaletteBitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename, std::vector<uint32>* outPalette = nullptr, bool showError = true);
+	static bool decodeBitmap(Bitmap& bitmap, const std::vector<uint8>& content, const std::wstring& filename, bool showError = true);
+
 	static bool loadTexture(DrawerTexture& texture, const std::wstring& filename, bool showError = true);
 
 #ifdef RMX_WITH_OPENGL_SUPPORT
@@ -9,12 +9,14 @@
 #include "oxygen/pch.h"
 #include "oxygen/rendering/parts/PatternManager.h"
 #include "oxygen/rendering/utils/RenderUtils.h"
+#include "oxygen/helper/HighResolutionTimer.h"
 #include "oxygen/simulation/EmulatorInterface.h"
 
 
 void PatternManager::refresh()
 {
 	mChangeBits.clearAllBits();
+	++mRefreshCounter;
 
 	// Update pattern cache content
 	const BitArray<0x800>& changeBits = EmulatorInterface::instance().getVRamChangeBits();
@@ -39,28 +41,11 @@ void PatternManager::refresh()
 
 					if (changed)
 					{
-						// Fill main pattern
-						CacheItem::Pattern* patterns = cacheItem.mFlipVariation;
-						RenderUtils::expandPatternDataFromVRAM(patterns[0].mPixels, src);
-
-						// Fill other flip variations
-						for (uint8 y = 0; y < 8; ++y)
-						{
-							uint8* v0 = &patterns[0].mPixels[y * 8];
-							uint8* v1 = &patterns[1].mPixels[y * 8];
-							uint8* v2 = &patterns[2].mPixels[(7 - y) * 8];
-							uint8* v3 = &patterns[3].mPixels[(7 - y) * 8];
-
-							for (uint8 x = 0; x < 8; ++x)
-							{
-								v1[x] = v0[7 - x];
-							}
-							memcpy(v2, v0, 8);
-							memcpy(v3, v1, 8);
-						}
-
+						// Flip variations are not cached, so this is all that needs to be updated
+						RenderUtils::expandPatternDataFromVRAM(cacheItem.mPixels, src);
 						memcpy(cacheItem.mOriginalDataBackup, src, 0x20);
 						mChangeBits.setBit(patternIndex);
+						mPatternChangeCounters[patternIndex] = mRefreshCounter;
 					}
 				}
 
@@ -73,12 +58,12 @@ void PatternManager::refresh()
 
 uint8 PatternManager::getLastUsedAtex(uint16 patternIndex) const
 {
-	return mPatternCache[patternIndex & 0x07ff].mLastUsedAtex;
+	return mLastUsedAtex[patternIndex & 0x07ff];
 }
 
 void PatternManager::setLastUsedAtex(uint16 patternIndex, uint8 atex)
 {
-	mPatternCache[patternIndex & 0x07ff].mLastUsedAtex = atex;
+	mLastUsedAtex[patternIndex & 0x07ff] = atex;
 }
 
 void PatternManager::dumpAsPaletteBitmap(PaletteBitmap& output) const
@@ -89,7 +74,92 @@ void PatternManager::dumpAsPaletteBitmap(PaletteBitmap& output) const
 		for (int x = 0; x < 512; ++x)
 		{
 			const int patternIndex = (x/8) + (y/8) * 64;
-			output[x+y*512] = mPatternCache[patternIndex].mFlipVariation[0].mPixels[(x%8) + (y%8) * 8] + getLastUsedAtex((uint16)patternIndex);
+			output[x+y*512] = mPatternCache[patternIndex].mPixels[(x%8) + (y%8) * 8] + getLastUsedAtex((uint16)patternIndex);
+		}
+	}
+}
+
+void PatternManager::runBenchmark()
+{
+	// Use an own emulator interface instance for this thread, so that the benchmark does not touch the simulation's VRAM
+	std::unique_ptr<EmulatorInterface> emulatorInterfaceInstance = std::make_unique<EmulatorInterface>();
+	EmulatorInterface& emulatorInterface = *emulatorInterfaceInstance;
+	std::unique_ptr<PatternManager> patternManager = std::make_unique<PatternManager>();
+
+	// Random data in RAM to upload to VRAM, and a plane with random pattern indices including flip bits
+	uint32 rng = 0x12345678;
+	const auto nextRandom = [&]() { rng = rng * 1103515245 + 12345; return rng >> 16; };
+	uint8* ram = emulatorInterface.getRam();
+	for (int k = 0; k < 0x10000; ++k)
+		ram[k] = (uint8)nextRandom();
+
+	constexpr int PLANE_WIDTH = 64;
+	uint16 planeData[PLANE_WIDTH * 32];
+	for (uint16& patternIndex : planeData)
+		patternIndex = (uint16)nextRandom();
+
+	constexpr int SCREEN_WIDTH = 320;
+	constexpr int SCREEN_HEIGHT = 224;
+	std::vector<uint8> screen(SCREEN_WIDTH * SCREEN_HEIGHT);
+
+	// Each frame uploads a number of patterns in DMA-sized chunks, refreshes the cache, and then reads a full screen of pixels from the cache
+	struct Scenario
+	{
+		const char* mName;
+		int mPatternsPerFrame;
+	};
+	static const Scenario SCENARIOS[] =
+	{
+		{ "All patterns changed (level load)", 0x800 },
+		{ "0x200 patterns changed", 0x200 },
+		{ "0x40 patterns changed (animated patterns)", 0x40 },
+		{ "No changes", 0 }
+	};
+
+	constexpr int NUM_FRAMES = 200;
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("--- PATTERN CACHE BENCHMARK ---");
+	RMX_LOG_INFO("Cache size: " << sizeof(patternManager->mPatternCache) / 1024 << " KB");
+
+	for (const Scenario& scenario : SCENARIOS)
+	{
+		double refreshSeconds = 0.0;
+		double renderSeconds = 0.0;
+		uint64 hash = rmx::startFNV1a_64();
+		HighResolutionTimer timer;
+
+		for (int frame = 0; frame < NUM_FRAMES; ++frame)
+		{
+			const int firstPattern = (frame * 0x135) % (0x801 - scenario.mPatternsPerFrame);
+			for (int offset = 0; offset < scenario.mPatternsPerFrame * 0x20; offset += 0x800)
+			{
+				const uint16 bytes = (uint16)std::min(scenario.mPatternsPerFrame * 0x20 - offset, 0x800);
+				const uint32 sourceAddress = 0xffff0000 + ((frame * 0x2e2 + offset) & 0x77fe);
+				emulatorInterface.copyFromMemoryToVRam((uint16)(firstPattern * 0x20 + offset), sourceAddress, bytes);
+			}
+
+			timer.start();
+			patternManager->refresh();
+			refreshSeconds += timer.getSecondsSinceStart();
+
+			timer.start();
+			for (int y = 0; y < SCREEN_HEIGHT; ++y)
+			{
+				const uint16* planeDataForThisLine = &planeData[(y / 8) * PLANE_WIDTH];
+				uint8* dst = &screen[y * SCREEN_WIDTH];
+				for (int x = 0; x < SCREEN_WIDTH; x += 8)
+				{
+					const uint16 patternIndex = planeDataForThisLine[x / 8];
+					const uint64 pixels = patternManager->mPatternCache[patternIndex & 0x07ff].getPixelLine(y & 0x07, patternIndex);
+					memcpy(&dst[x], &pixels, 8);
+				}
+			}
+			renderSeconds += timer.getSecondsSinceStart();
+			hash = rmx::addToFNV1a_64(hash, &screen[0], screen.size());
 		}
+
+		RMX_LOG_INFO(scenario.mName << ":");
+		RMX_LOG_INFO("   Refresh:  " << roundToInt(refreshSeconds * 1000000.0 / NUM_FRAMES) << " us per frame");
+		RMX_LOG_INFO("   Render:   " << roundToInt(renderSeconds * 1000000.0 / NUM_FRAMES) << " us per frame (checksum " << rmx::hexString(hash, 16) << ")");
 	}
 }
@@ -14,15 +14,29 @@
 class PatternManager
 {
 public:
+	// Cached pattern in a single orientation, flips get applied when reading the pixels
+	//  -> The flip bits are the same as in a pattern index, i.e. 0x0800 for horizontal flip and 0x1000 for vertical flip
 	struct CacheItem
 	{
-		struct Pattern
+		uint8 mPixels[64] = { 0 };			// One byte per pixel, 8 lines of 8 pixels each
+		uint8 mOriginalDataBackup[32] = { 0 };
+
+		// Returns a line of 8 pixels, with the first pixel in the lowest memory address when written back to memory
+		FORCE_INLINE uint64 getPixelLine(int y, uint16 flipBits) const
+		{
+			uint64 line;
+			memcpy(&line, &mPixels[((flipBits & 0x1000) ? (7 - y) : y) * 8], 8);
+			return (flipBits & 0x0800) ? swapBytes64(line) : line;
+		}
+
+		FORCE_INLINE uint8 getPixel(int x, int y, uint16 flipBits) const
 		{
-			uint8 mPixels[64] = { 0 };
-		};
-		Pattern mFlipVariation[4];
-		uint8 mOriginalDataBackup[32];
-		mutable uint8 mLastUsedAtex = 0;	// Only for debug output
+			if (flipBits & 0x0800)
+				x = 7 - x;
+			if (flipBits & 0x1000)
+				y = 7 - y;
+			return mPixels[x + y * 8];
+		}
 	};
 
 public:
@@ -34,9 +48,19 @@ public:
 	inline const CacheItem* getPatternCache() const  { return mPatternCache; }
 	const BitArray<0x800>& getChangeBits() const  { return mChangeBits; }
 
+	// Change counters allow for checking whether patterns were changed since any earlier point in time, not only in the last "refresh" call
+	inline uint32 getRefreshCounter() const  { return mRefreshCounter; }
+	inline const uint32* getPatternChangeCounters() const  { return mPatternChangeCounters; }
+
 	void dumpAsPaletteBitmap(PaletteBitmap& output) const;
 
+	// Micro-benchmark of pattern cache refresh and reading under heavy VRAM changes, with the results written to the log
+	static void runBenchmark();
+
 private:
 	CacheItem mPatternCache[0x800];
+	uint8 mLastUsedAtex[0x800] = { 0 };	// Only for debug output
 	BitArray<0x800> mChangeBits;	// One bit for each pattern, so we know which ones were changed in the last "refresh" call
+	uint32 mRefreshCounter = 0;		// Incremented with each "refresh" call
+	uint32 mPatternChangeCounters[0x800] = { 0 };	// Value of the refresh counter when each pattern was last changed
 };
@@ -137,6 +137,19 @@ void PlaneManager::resetCustomPlanes()
 	mCustomPlanes.clear();
 }
 
+void PlaneManager::copy(const PlaneManager& source)
+{
+	mNameTableBaseA = source.mNameTableBaseA;
+	mNameTableBaseB = source.mNameTableBaseB;
+	mNameTableBaseW = source.mNameTableBaseW;
+	mPlayfieldSize = source.mPlayfieldSize;
+	memcpy(mPlanePatternsBuffer, source.mPlanePatternsBuffer, sizeof(mPlanePatternsBuffer));
+	mUsingPlaneW = source.mUsingPlaneW;
+	mPlaneAWSplit = source.mPlaneAWSplit;
+	memcpy(mDisabledDefaultPlane, source.mDisabledDefaultPlane, sizeof(mDisabledDefaultPlane));
+	mCustomPlanes = source.mCustomPlanes;
+}
+
 bool PlaneManager::isPlaneUsed(int index) const
 {
 	if (EngineMain::getDelegate().useDeveloperFeatures())
@@ -264,8 +277,8 @@ void PlaneManager::dumpAsPaletteBitmap(PaletteBitmap& output, int planeIndex, bo
 		for (int x = 0; x < bitmapSize.x; x += 8, dest += 8)
 		{
 			const uint16 patternIndex = getPatternAtIndex(planeIndex, (x / 8) + (y / 8) * numPatternsPerLine);
-			const PatternManager::CacheItem::Pattern& pattern = patternCache[patternIndex & 0x07ff].mFlipVariation[(patternIndex >> 11) & 3];
-			const uint8* srcPatternPixels = &pattern.mPixels[(x & 0x07) + (y & 0x07) * 8];
+			const uint64 pixels = patternCache[patternIndex & 0x07ff].getPixelLine(y & 0x07, patternIndex);
+			const uint8* srcPatternPixels = (const uint8*)&pixels;
 			const uint8 atex = (patternIndex >> 9) & 0x30;
 
 			for (int k = 0; k < 8; ++k)
@@ -39,6 +39,7 @@ public:
 	void refresh();
 
 	void resetCustomPlanes();
+	void copy(const PlaneManager& source);
 	bool isPlaneUsed(int index) const;
 
 	inline uint16 getNameTableBaseB() const  { return mNameTableBaseB; }
@@ -55,6 +55,17 @@ void RenderParts::refresh(const RefreshParameters& refreshParameters)
 	}
 }
 
+void RenderParts::copyForRendering(const RenderParts& source)
+{
+	mPaletteManager = source.mPaletteManager;
+	mPatternManager = source.mPatternManager;
+	mPlaneManager.copy(source.mPlaneManager);
+	mScrollOffsetsManager.copy(source.mScrollOffsetsManager);
+	mSpacesManager = source.mSpacesManager;
+	memcpy(mLayerRendering, source.mLayerRendering, sizeof(mLayerRendering));
+	mActiveDisplay = source.mActiveDisplay;
+}
+
 void RenderParts::dumpPatternsContent()
 {
 	PaletteBitmap bmp;
@@ -16,7 +16,7 @@
 #include "oxygen/rendering/parts/SpriteManager.h"
 
 
-class RenderParts : public SingleInstance<RenderParts>
+class RenderParts : public PerThreadInstance<RenderParts>
 {
 public:
 	RenderParts();
@@ -36,6 +36,10 @@ public:
 	void postFrameUpdate();
 	void refresh(const RefreshParameters& refreshParameters);
 
+	// Copies everything that renderers read from the render parts, so that the copy can get rendered while the source gets changed by the simulation
+	//  -> This does not include the sprite manager's render items, and plane content still gets read from VRAM of the emulator interface instance
+	void copyForRendering(const RenderParts& source);
+
 	void dumpPatternsContent();
 	void dumpPlaneContent(int planeIndex);
 
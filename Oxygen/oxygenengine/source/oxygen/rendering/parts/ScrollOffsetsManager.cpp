@@ -36,6 +36,20 @@ void ScrollOffsetsManager::reset()
 	}
 }
 
+void ScrollOffsetsManager::copy(const ScrollOffsetsManager& source)
+{
+	mVerticalScrolling = source.mVerticalScrolling;
+	mHorizontalScrollMask = source.mHorizontalScrollMask;
+	mHorizontalScrollTableBase = source.mHorizontalScrollTableBase;
+	mScrollOffsetW = source.mScrollOffsetW;
+	mVerticalScrollOffsetBias = source.mVerticalScrollOffsetBias;
+	for (int index = 0; index < 4; ++index)
+	{
+		mSets[index] = source.mSets[index];
+		mInterpolatedSets[index] = source.mInterpolatedSets[index];
+	}
+}
+
 void ScrollOffsetsManager::refresh(const RefreshParameters& refreshParameters)
 {
 	if (refreshParameters.mHasNewSimulationFrame)
@@ -20,6 +20,7 @@ public:
 
 	void reset();
 	void refresh(const RefreshParameters& refreshParameters);
+	void copy(const ScrollOffsetsManager& source);
 	void preFrameUpdate();
 	void postFrameUpdate();
 
@@ -10,106 +10,72 @@
 
 #include <rmxbase.h>
 
+#include "oxygen/rendering/utils/PixelKernels.h"
+
 
 struct SoftwareBlur
 {
 public:
 	static void blurBitmap(Bitmap& bitmap, int blurValue)
 	{
-		switch (blurValue)
-		{
-			case 1:  blurBitmap<16>(bitmap);  break;
-			case 2:  blurBitmap<32>(bitmap);  break;
-			case 3:  blurBitmap<48>(bitmap);  break;
-			case 4:  blurBitmap<64>(bitmap);  break;
-			default: break;
-		}
+		if (!prepareBlur(bitmap, blurValue))
+			return;
+
+		blurLinesX(bitmap, blurValue, 0, bitmap.getHeight());
+		blurLinesY(bitmap, blurValue, 0, bitmap.getHeight());
 	}
 
-private:
-	// Template parameters are weights for each of the neighbor pixels, as a fraction of 256;
-	//  the higher these values are, the stronger the blur gets
-	template<int weightX, int weightY = weightX>
-	static void blurBitmap(Bitmap& bitmap)
+	// The blur is done in two passes, which can each get split into ranges of lines that are independent of each other:
+	//  - Call "prepareBlur" first, and only continue if it returns true
+	//  - Call "blurLinesX" for ranges of lines covering the whole bitmap, these can run in parallel
+	//  - After all of these are done, call "blurLinesY" in the same way
+	static bool prepareBlur(const Bitmap& bitmap, int blurValue)
 	{
 		// Can't blur bitmaps that are too small
-		if (bitmap.getWidth() < 2 || bitmap.getHeight() < 2)
-			return;
-
-		// Get weights for the central pixel
-		constexpr int invWeightX = 256 - weightX * 2;
-		constexpr int invWeightY = 256 - weightY * 2;
+		if (getWeight(blurValue) == 0 || bitmap.getWidth() < 2 || bitmap.getHeight() < 2)
+			return false;
 
 		mTemp.create(bitmap.getSize());
+		return true;
+	}
 
-		// Pass 1: Blur in x-direction
-		for (int y = 0; y < bitmap.getHeight(); ++y)
+	// Pass 1: Blur in x-direction, from the bitmap into the temp buffer
+	static void blurLinesX(const Bitmap& bitmap, int blurValue, int minY, int maxY)
+	{
+		const int weight = getWeight(blurValue);
+		const int width = bitmap.getWidth();
+		for (int y = minY; y < maxY; ++y)
 		{
 			uint32* dst = mTemp.getPixelPointer(0, y);
 			const uint32* src = bitmap.getPixelPointer(0, y);
 
-			// Preparations & leftmost pixel
-			uint32 src0 = src[0];
-			uint32 src1 = src[0];
-			uint32 src2 = src[1];
-			dst[0] = mixColors<weightX, invWeightX>(src0, src1, src2);
-
-			// Pixels in between
-			const uint32* end = src + ((std::ptrdiff_t)bitmap.getWidth() - 2);
-			while (src != end)
-			{
-				++src;
-				++dst;
-				src0 = src1;
-				src1 = src2;
-				src2 = src[1];
-				dst[0] = mixColors<weightX, invWeightX>(src0, src1, src2);
-			}
-
-			// Rightmost pixel
-			dst[1] = mixColors<weightX, invWeightX>(src1, src2, src2);
+			// Leftmost and rightmost pixels use themselves as the missing neighbor
+			PixelKernels::blurLine(&dst[0], &src[0], &src[0], &src[1], weight, 1);
+			PixelKernels::blurLine(&dst[1], &src[0], &src[1], &src[2], weight, width - 2);
+			PixelKernels::blurLine(&dst[width - 1], &src[width - 2], &src[width - 1], &src[width - 1], weight, 1);
 		}
+	}
 
-		// Copy everything over
-		bitmap = mTemp;
-
-		// Pass 2: Blur in y-direction
+	// Pass 2: Blur in y-direction, from the temp buffer back into the bitmap
+	static void blurLinesY(Bitmap& bitmap, int blurValue, int minY, int maxY)
+	{
+		const int weight = getWeight(blurValue);
+		const int height = bitmap.getHeight();
+		for (int y = minY; y < maxY; ++y)
 		{
-			// Topmost line
-			mixLines<weightY, invWeightY>(bitmap, mTemp, 0, 0, 1);
-
-			// Lines in between
-			int y = 1;
-			for (; y < bitmap.getHeight() - 1; ++y)
-			{
-				mixLines<weightY, invWeightY>(bitmap, mTemp, y-1, y, y+1);
-			}
-
-			// Bottommost line
-			mixLines<weightY, invWeightY>(bitmap, mTemp, y-1, y, y);
+			// Topmost and bottommost lines use themselves as the missing neighbor
+			const uint32* src0 = mTemp.getPixelPointer(0, std::max(y - 1, 0));
+			const uint32* src1 = mTemp.getPixelPointer(0, y);
+			const uint32* src2 = mTemp.getPixelPointer(0, std::min(y + 1, height - 1));
+			PixelKernels::blurLine(bitmap.getPixelPointer(0, y), src0, src1, src2, weight, bitmap.getWidth());
 		}
 	}
 
 private:
-	template<int factor0, int factor1>
-	static inline uint32 mixColors(uint32 src0, uint32 src1, uint32 src2)
+	// Weight for each of the neighbor pixels, as a fraction of 256; the higher this value is, the stronger the blur gets
+	static int getWeight(int blurValue)
 	{
-		return ((((src0 & 0xff00ff) * factor0 + (src1 & 0xff00ff) * factor1 + (src2 & 0xff00ff) * factor0) >> 8) & 0xff00ff)
-			 + ((((src0 & 0x00ff00) * factor0 + (src1 & 0x00ff00) * factor1 + (src2 & 0x00ff00) * factor0) >> 8) & 0x00ff00);
-	};
-
-	template<int factor0, int factor1>
-	static inline void mixLines(Bitmap& output, const Bitmap& input, int y0, int y1, int y2)
-	{
-		const uint32* src0 = input.getPixelPointer(0, y0);
-		uint32* src1 = output.getPixelPointer(0, y1);
-		const uint32* src2 = input.getPixelPointer(0, y2);
-
-		uint32* end = src1 + input.getWidth();
-		for (; src1 != end; ++src0, ++src1, ++src2)
-		{
-			*src1 = mixColors<factor0, factor1>(*src0, *src1, *src2);
-		}
+		return (blurValue >= 1 && blurValue <= 4) ? blurValue * 16 : 0;
 	}
 
 private:
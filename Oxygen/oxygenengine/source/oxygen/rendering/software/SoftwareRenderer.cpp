@@ -11,11 +11,18 @@
 #include "oxygen/rendering/software/SoftwareBlur.h"
 #include "oxygen/rendering/Geometry.h"
 #include "oxygen/rendering/parts/RenderParts.h"
+#include "oxygen/rendering/utils/PixelKernels.h"
 #include "oxygen/application/Configuration.h"
 #include "oxygen/application/EngineMain.h"
 #include "oxygen/drawing/Drawer.h"
 #include "oxygen/drawing/DrawerTexture.h"
 #include "oxygen/drawing/software/BlitterHelper.h"
+#include "oxygen/simulation/EmulatorInterface.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 #if defined(PLATFORM_VITA)
 	#include <psp2/kernel/clib.h>
@@ -24,6 +31,95 @@
 
 namespace detail
 {
+	// Worker threads for rendering multiple bands of the screen in parallel
+	//  -> Workers use the calling thread's emulator interface, which is not the default instance when rendering on the frame pipeline's thread
+	class BandWorkers
+	{
+	public:
+		~BandWorkers()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mStopThreads = true;
+			}
+			mStartCondition.notify_all();
+			for (std::thread& thread : mThreads)
+				thread.join();
+		}
+
+		// Calls the function for each band index, with band 0 being processed on the calling thread; returns only after all bands are done
+		void run(int numBands, const std::function<void(int)>& function)
+		{
+			while ((int)mThreads.size() < numBands - 1)
+			{
+				mThreads.emplace_back(&BandWorkers::threadFunc, this, (int)mThreads.size() + 1, mGeneration);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mFunction = &function;
+				mEmulatorInterface = EmulatorInterface::hasInstance() ? &EmulatorInterface::instance() : nullptr;
+				mNumBands = numBands;
+				mNumPending = numBands - 1;
+				++mGeneration;
+			}
+			mStartCondition.notify_all();
+
+			function(0);
+
+			std::unique_lock<std::mutex> lock(mMutex);
+			mDoneCondition.wait(lock, [&] { return mNumPending == 0; });
+			mFunction = nullptr;
+			mEmulatorInterface = nullptr;
+		}
+
+	private:
+		void threadFunc(int bandIndex, uint32 lastGeneration)
+		{
+			while (true)
+			{
+				const std::function<void(int)>* function = nullptr;
+				EmulatorInterface* emulatorInterface = nullptr;
+				{
+					std::unique_lock<std::mutex> lock(mMutex);
+					mStartCondition.wait(lock, [&] { return mStopThreads || mGeneration != lastGeneration; });
+					if (mStopThreads)
+						return;
+
+					lastGeneration = mGeneration;
+					if (bandIndex >= mNumBands)
+						continue;
+					function = mFunction;
+					emulatorInterface = mEmulatorInterface;
+				}
+
+				{
+					const PerThreadInstance<EmulatorInterface>::ScopedBinding binding(emulatorInterface);
+					(*function)(bandIndex);
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					--mNumPending;
+				}
+				mDoneCondition.notify_one();
+			}
+		}
+
+	private:
+		std::vector<std::thread> mThreads;
+		std::mutex mMutex;
+		std::condition_variable mStartCondition;
+		std::condition_variable mDoneCondition;
+		const std::function<void(int)>* mFunction = nullptr;
+		EmulatorInterface* mEmulatorInterface = nullptr;
+		int mNumBands = 0;
+		int mNumPending = 0;
+		uint32 mGeneration = 0;
+		bool mStopThreads = false;
+	};
+
+
 	class PixelBlockWriter
 	{
 	public:
@@ -33,19 +129,23 @@ namespace detail
 			mPatternCache(patternCache)
 		{}
 
-		void newLine(int lineNumber, int position, int paletteIndex)
+		void newLine(SoftwareRenderer::BufferedPlaneData::Line& line, int lineNumber, int position, int paletteIndex)
 		{
+			mLine = &line;
+			mLine->mPrioBlocks.clear();
+			mLine->mNonPrioBlocks.clear();
 			mLineNumber = lineNumber;
 			mPosition = position;
+			mContentPosition = position - mBufferedPlaneData->mContentOffset;
 			mPaletteIndex = paletteIndex;
 			mLastPatternBits = 0xffff;
 		}
 
 		FORCE_INLINE void addPixels(int x, uint16 patternIndex, int pixels)
 		{
-			const PatternManager::CacheItem::Pattern& pattern = mPatternCache[patternIndex & 0x07ff].mFlipVariation[(patternIndex >> 11) & 3];
-			uint8* dst = &mContent[mPosition + x];
-			const uint8* srcPatternPixels = &pattern.mPixels[mPatternPixelOffset];
+			const uint64 patternPixels = mPatternCache[patternIndex & 0x07ff].getPixelLine(mPatternLine, patternIndex);
+			uint8* dst = &mContent[mContentPosition + x];
+			const uint8* srcPatternPixels = (const uint8*)&patternPixels + mPatternPixelX;
 			memcpy(dst, srcPatternPixels, pixels);
 
 			const uint16 patternBits = (patternIndex & 0xe000);		// Includes priority bit and atex
@@ -53,7 +153,7 @@ namespace detail
 			{
 				mLastPatternBits = patternBits;
 
-				mCurrentPixelBlock = &vectorAdd((patternBits & 0x8000) ? mBufferedPlaneData->mPrioBlocks : mBufferedPlaneData->mNonPrioBlocks);
+				mCurrentPixelBlock = &vectorAdd((patternBits & 0x8000) ? mLine->mPrioBlocks : mLine->mNonPrioBlocks);
 				mCurrentPixelBlock->mStartCoords.set(x, mLineNumber);
 				mCurrentPixelBlock->mLinearPosition = mPosition + x;
 				mCurrentPixelBlock->mNumPixels = pixels;
@@ -69,15 +169,14 @@ namespace detail
 		FORCE_INLINE void addPixels8(int x, uint16 patternIndex)
 		{
 			// Same as above, but with hardcoded "pixels == 8"
-			const PatternManager::CacheItem::Pattern& pattern = mPatternCache[patternIndex & 0x07ff].mFlipVariation[(patternIndex >> 11) & 3];
-			uint64* dst = (uint64*)&mContent[mPosition + x];
-			const uint64* srcPatternPixels = (uint64*)&pattern.mPixels[mPatternPixelOffset];
+			const uint64 patternPixels = mPatternCache[patternIndex & 0x07ff].getPixelLine(mPatternLine, patternIndex);
+			uint64* dst = (uint64*)&mContent[mContentPosition + x];
 
 		#if !defined(PLATFORM_VITA)
-			*dst = *srcPatternPixels;
+			*dst = patternPixels;
 		#else
 			// This fixes a crash
-			sceClibMemcpy(dst, srcPatternPixels, sizeof(*dst));
+			sceClibMemcpy(dst, &patternPixels, sizeof(*dst));
 		#endif
 
 			const uint16 patternBits = (patternIndex & 0xe000);		// Includes priority bit and atex
@@ -85,7 +184,7 @@ namespace detail
 			{
 				mLastPatternBits = patternBits;
 
-				mCurrentPixelBlock = &vectorAdd((patternBits & 0x8000) ? mBufferedPlaneData->mPrioBlocks : mBufferedPlaneData->mNonPrioBlocks);
+				mCurrentPixelBlock = &vectorAdd((patternBits & 0x8000) ? mLine->mPrioBlocks : mLine->mNonPrioBlocks);
 				mCurrentPixelBlock->mStartCoords.set(x, mLineNumber);
 				mCurrentPixelBlock->mLinearPosition = mPosition + x;
 				mCurrentPixelBlock->mNumPixels = 8;
@@ -99,15 +198,18 @@ namespace detail
 		}
 
 	public:
-		int mPatternPixelOffset = 0;
+		int mPatternLine = 0;		// Line inside the pattern, before flipping
+		int mPatternPixelX = 0;		// Position inside the pattern line of the first pixel in "addPixels", after flipping
 
 	private:
 		SoftwareRenderer::BufferedPlaneData* mBufferedPlaneData = nullptr;
 		uint8* mContent = nullptr;
 		const PatternManager::CacheItem* mPatternCache = nullptr;
 
+		SoftwareRenderer::BufferedPlaneData::Line* mLine = nullptr;
 		int mLineNumber = 0;
 		int mPosition = 0;
+		int mContentPosition = 0;
 		int mDepthPosition = 0;
 		int mPaletteIndex = 0;
 
@@ -117,11 +219,64 @@ namespace detail
 }
 
 
+namespace
+{
+	bool isBinnableSprite(const Geometry& geometry)
+	{
+		if (geometry.getType() != Geometry::Type::SPRITE)
+			return false;
+
+		const RenderItem::Type type = static_cast<const SpriteGeometry&>(geometry).mSpriteInfo.getType();
+		return (type == RenderItem::Type::VDP_SPRITE || type == RenderItem::Type::PALETTE_SPRITE || type == RenderItem::Type::COMPONENT_SPRITE);
+	}
+
+	// Returns the screen rect a sprite can draw to before any clipping, which is never smaller than what actually gets drawn
+	Recti getSpriteScreenRect(const SpriteGeometry& geometry)
+	{
+		switch (geometry.mSpriteInfo.getType())
+		{
+			case RenderItem::Type::VDP_SPRITE:
+			{
+				const renderitems::VdpSpriteInfo& sprite = static_cast<const renderitems::VdpSpriteInfo&>(geometry.mSpriteInfo);
+				return Recti(sprite.mInterpolatedPosition.x, sprite.mInterpolatedPosition.y, sprite.mSize.x * 8, sprite.mSize.y * 8);
+			}
+
+			case RenderItem::Type::PALETTE_SPRITE:
+			{
+				const renderitems::PaletteSpriteInfo& spriteInfo = static_cast<const renderitems::PaletteSpriteInfo&>(geometry.mSpriteInfo);
+				const PaletteSprite& paletteSprite = *static_cast<PaletteSprite*>(spriteInfo.mCacheItem->mSprite);
+				const PaletteBitmap& paletteBitmap = spriteInfo.mUseUpscaledSprite ? paletteSprite.getUpscaledBitmap() : paletteSprite.getBitmap();
+				const float* transform = spriteInfo.mTransformation.isIdentity() ? nullptr : *spriteInfo.mTransformation.mMatrix;
+				return Blitter::getSpriteBoundingBox(Recti(paletteSprite.mOffset, paletteBitmap.getSize()), spriteInfo.mInterpolatedPosition, transform);
+			}
+
+			case RenderItem::Type::COMPONENT_SPRITE:
+			{
+				const renderitems::ComponentSpriteInfo& spriteInfo = static_cast<const renderitems::ComponentSpriteInfo&>(geometry.mSpriteInfo);
+				const ComponentSprite& componentSprite = *static_cast<ComponentSprite*>(spriteInfo.mCacheItem->mSprite);
+				const float* transform = spriteInfo.mTransformation.isIdentity() ? nullptr : *spriteInfo.mTransformation.mMatrix;
+				return Blitter::getSpriteBoundingBox(Recti(componentSprite.mOffset, componentSprite.getBitmap().getSize()), spriteInfo.mInterpolatedPosition, transform);
+			}
+
+			default:
+				return Recti();
+		}
+	}
+}
+
+
 SoftwareRenderer::SoftwareRenderer(RenderParts& renderParts, DrawerTexture& outputTexture) :
 	Renderer(RENDERER_TYPE_ID, renderParts, outputTexture)
 {
 }
 
+SoftwareRenderer::~SoftwareRenderer()
+{
+	delete mBandWorkers;
+	for (Band* band : mBands)
+		delete band;
+}
+
 void SoftwareRenderer::initialize()
 {
 	mGameResolution = Configuration::instance().mGameScreen;
@@ -151,52 +306,48 @@ void SoftwareRenderer::clearGameScreen()
 void SoftwareRenderer::renderGameScreen(const std::vector<Geometry*>& geometries)
 {
 	startRendering();
-	Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
-
-	// Clear the screen
-	gameScreenBitmap.clear(mRenderParts.getPaletteManager().getBackdropColor());
-	memset(mDepthBuffer, 0, sizeof(mDepthBuffer));
-	mEmptyDepthBuffer = true;
-
-	mCurrentViewport.set(0, 0, mGameResolution.x, mGameResolution.y);
-	mFullViewport = true;
-
-	for (int i = 0; i < MAX_BUFFER_PLANE_DATA; ++i)
-	{
-		mBufferedPlaneData[i].mValid = false;
-	}
+	updateBands();
+	mAbortRendering = false;
 
 	// Check if sprite masking needed
 	const bool usingSpriteMask = isUsingSpriteMask(geometries);
+	if (usingSpriteMask)
+		mGameScreenCopy.create(mGameResolution.x, mGameResolution.y);
 
 	// Render geometries
+	//  -> Blur effects need the whole screen, so they split up the geometries into parts that get rendered one after the other
+	size_t startIndex = 0;
+	while (true)
 	{
-		uint16 lastRenderQueue = 0xffff;
-		for (size_t i = 0; i < geometries.size(); ++i)
+		size_t endIndex = startIndex;
+		while (endIndex < geometries.size() && geometries[endIndex]->getType() != Geometry::Type::EFFECT_BLUR)
+			++endIndex;
+
+		if (mBands.size() == 1)
 		{
-			if (!progressRendering())
-				break;
+			renderBand(*mBands[0], geometries, startIndex, endIndex, usingSpriteMask);
+		}
+		else
+		{
+			mBandWorkers->run((int)mBands.size(), [&](int bandIndex) { renderBand(*mBands[bandIndex], geometries, startIndex, endIndex, usingSpriteMask); });
+		}
+
+		if (endIndex >= geometries.size())
+			break;
 
-			const uint16 renderQueue = geometries[i]->mRenderQueue;
-			if (usingSpriteMask && lastRenderQueue < 0x8000 && renderQueue >= 0x8000)
+		if (!mAbortRendering && progressRendering())
+		{
+			const EffectBlurGeometry& ebg = static_cast<const EffectBlurGeometry&>(*geometries[endIndex]);
+			if (ebg.mBlurValue >= 1)
 			{
-				// Copy planes (needed for sprite masking)
-				mGameScreenCopy = gameScreenBitmap;
+				blurBitmap(mGameScreenTexture.accessBitmap(), ebg.mBlurValue);
 			}
-
-			renderGeometry(*geometries[i]);
-			lastRenderQueue = renderQueue;
 		}
-	}
-
-	// Set alpha channel to 0xff to make sure nothing gets lost due to alpha test
-	{
-		uint64* RESTRICT ptr = (uint64*)gameScreenBitmap.getData();
-		uint64* RESTRICT end = ptr + gameScreenBitmap.getPixelCount() / 2;
-		for (; ptr < end; ++ptr)
+		else
 		{
-			*ptr |= 0xff000000ff000000ull;
+			mAbortRendering = true;
 		}
+		startIndex = endIndex + 1;
 	}
 
 	mGameScreenTexture.bitmapUpdated();
@@ -242,9 +393,6 @@ void SoftwareRenderer::renderDebugDraw(int debugDrawMode, const Recti& rect)
 	}
 	mGameScreenTexture.bitmapUpdated();
 
-	mCurrentViewport.set(0, 0, bitmapSize.x, bitmapSize.y);
-	mFullViewport = true;
-
 	drawer.setWindowRenderTarget(FTX::screenRect());
 	drawer.setBlendMode(BlendMode::OPAQUE);
 	drawer.drawUpscaledRect(RenderUtils::getLetterBoxRect(rect, (float)bitmapSize.x / (float)bitmapSize.y), mGameScreenTexture);
@@ -254,7 +402,145 @@ void SoftwareRenderer::renderDebugDraw(int debugDrawMode, const Recti& rect)
 	gameScreenBitmap.create(oldSize.x, oldSize.y);
 }
 
-void SoftwareRenderer::renderGeometry(const Geometry& geometry)
+void SoftwareRenderer::blurBitmap(Bitmap& bitmap, int blurValue)
+{
+	if (mBands.size() == 1)
+	{
+		SoftwareBlur::blurBitmap(bitmap, blurValue);
+		return;
+	}
+
+	if (!SoftwareBlur::prepareBlur(bitmap, blurValue))
+		return;
+
+	// Each pass gets split into bands of lines, the same way as rendering, using the band worker threads
+	//  -> The second pass reads the lines around each band from the first pass, so it can only start after all bands finished the first pass
+	const int numBands = (int)mBands.size();
+	const int height = bitmap.getHeight();
+	mBandWorkers->run(numBands, [&](int bandIndex) { SoftwareBlur::blurLinesX(bitmap, blurValue, height * bandIndex / numBands, height * (bandIndex + 1) / numBands); });
+	mBandWorkers->run(numBands, [&](int bandIndex) { SoftwareBlur::blurLinesY(bitmap, blurValue, height * bandIndex / numBands, height * (bandIndex + 1) / numBands); });
+}
+
+void SoftwareRenderer::updateBands()
+{
+	int numBands = Configuration::instance().mSoftwareRendererThreads;
+	if (numBands <= 0)
+	{
+		// Using more than 4 threads is not worth the synchronization overhead
+		numBands = clamp((int)std::thread::hardware_concurrency(), 1, 4);
+	}
+
+	// Bands should not get too small
+	numBands = clamp(numBands, 1, std::max(mGameResolution.y / 32, 1));
+
+	while ((int)mBands.size() < numBands)
+		mBands.push_back(new Band());
+	while ((int)mBands.size() > numBands)
+	{
+		delete mBands.back();
+		mBands.pop_back();
+	}
+
+	for (int k = 0; k < numBands; ++k)
+	{
+		const int minY = mGameResolution.y * k / numBands;
+		const int maxY = mGameResolution.y * (k + 1) / numBands;
+		const Recti rect(0, minY, mGameResolution.x, maxY - minY);
+		if (mBands[k]->mRect != rect)
+		{
+			mBands[k]->mRect = rect;
+			for (int i = 0; i < MAX_BUFFER_PLANE_DATA; ++i)
+			{
+				mBands[k]->mBufferedPlaneData[i].mValid = false;
+			}
+		}
+	}
+
+	if (numBands > 1 && nullptr == mBandWorkers)
+	{
+		mBandWorkers = new detail::BandWorkers();
+	}
+}
+
+void SoftwareRenderer::renderBand(Band& band, const std::vector<Geometry*>& geometries, size_t startIndex, size_t endIndex, bool usingSpriteMask)
+{
+	Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
+	const int width = gameScreenBitmap.getWidth();
+	uint32* bandPixels = gameScreenBitmap.getData() + band.mRect.y * width;
+	const int numBandPixels = band.mRect.height * width;
+
+	if (startIndex == 0)
+	{
+		// Clear the band's part of the screen
+		const uint32 backdropColor = mRenderParts.getPaletteManager().getBackdropColor().getABGR32();
+		for (int i = 0; i < numBandPixels; ++i)
+		{
+			bandPixels[i] = backdropColor;
+		}
+
+		const size_t depthStart = std::min<size_t>(band.mRect.y * 0x200, sizeof(mDepthBuffer));
+		const size_t depthEnd = std::min<size_t>((band.mRect.y + band.mRect.height) * 0x200, sizeof(mDepthBuffer));
+		memset(&mDepthBuffer[depthStart], 0, depthEnd - depthStart);
+		band.mEmptyDepthBuffer = true;
+
+		band.mCurrentViewport = band.mRect;
+		band.mFullViewport = true;
+
+		// Buffered plane data from the last frame stays valid, but needs to be updated before its next use
+		++band.mFrameNumber;
+		band.mLastRenderQueue = 0xffff;
+	}
+
+	// Only the first band checks the render time limit, and tells the others to stop as well
+	const bool isFirstBand = (&band == mBands[0]);
+	for (size_t i = startIndex; i < endIndex; ++i)
+	{
+		if (isFirstBand && !progressRendering())
+			mAbortRendering = true;
+		if (mAbortRendering)
+			break;
+
+		const uint16 renderQueue = geometries[i]->mRenderQueue;
+		if (usingSpriteMask && band.mLastRenderQueue < 0x8000 && renderQueue >= 0x8000)
+		{
+			// Copy planes (needed for sprite masking)
+			memcpy(mGameScreenCopy.getData() + band.mRect.y * width, bandPixels, numBandPixels * sizeof(uint32));
+		}
+
+		// Longer runs of sprites get rendered in screen tiles
+		size_t runEnd = i;
+		while (runEnd < endIndex && isBinnableSprite(*geometries[runEnd]))
+		{
+			// The run must not cross the point where the planes get copied for sprite masking
+			if (runEnd > i && usingSpriteMask && geometries[runEnd - 1]->mRenderQueue < 0x8000 && geometries[runEnd]->mRenderQueue >= 0x8000)
+				break;
+			++runEnd;
+		}
+		if (runEnd - i >= MIN_SPRITES_FOR_BINNING)
+		{
+			renderSpriteRun(band, geometries, i, runEnd);
+			i = runEnd - 1;
+			band.mLastRenderQueue = geometries[i]->mRenderQueue;
+			continue;
+		}
+
+		renderGeometry(band, *geometries[i]);
+		band.mLastRenderQueue = renderQueue;
+	}
+
+	if (endIndex >= geometries.size())
+	{
+		// Set alpha channel to 0xff to make sure nothing gets lost due to alpha test
+		uint32* RESTRICT ptr = bandPixels;
+		uint32* RESTRICT end = bandPixels + numBandPixels;
+		for (; ptr < end; ++ptr)
+		{
+			*ptr |= 0xff000000;
+		}
+	}
+}
+
+void SoftwareRenderer::renderGeometry(Band& band, const Geometry& geometry)
 {
 	switch (geometry.getType())
 	{
@@ -263,21 +549,21 @@ void SoftwareRenderer::renderGeometry(const Geometry& geometry)
 
 		case Geometry::Type::PLANE:
 		{
-			renderPlane(static_cast<const PlaneGeometry&>(geometry));
+			renderPlane(band, static_cast<const PlaneGeometry&>(geometry));
 			break;
 		}
 
 		case Geometry::Type::SPRITE:
 		{
-			renderSprite(static_cast<const SpriteGeometry&>(geometry));
+			renderSprite(band, static_cast<const SpriteGeometry&>(geometry), band.mCurrentViewport);
 			break;
 		}
 
 		case Geometry::Type::RECT:
 		{
 			const RectGeometry& rg = static_cast<const RectGeometry&>(geometry);
-			const Recti rect = Recti::getIntersection(rg.mRect, mCurrentViewport);
-			mBlitter.blitColor(Blitter::OutputWrapper(mGameScreenTexture.accessBitmap(), rect), rg.mColor, BlendMode::ALPHA);
+			const Recti rect = Recti::getIntersection(rg.mRect, band.mCurrentViewport);
+			band.mBlitter.blitColor(Blitter::OutputWrapper(mGameScreenTexture.accessBitmap(), rect), rg.mColor, BlendMode::ALPHA);
 			break;
 		}
 
@@ -291,41 +577,33 @@ void SoftwareRenderer::renderGeometry(const Geometry& geometry)
 			blitterOptions.mTintColor = &tg.mTintColor;
 			blitterOptions.mAddedColor = &tg.mAddedColor;
 
-			mBlitter.blitSprite(Blitter::OutputWrapper(mGameScreenTexture.accessBitmap(), mCurrentViewport), Blitter::SpriteWrapper(tg.mDrawerTexture.accessBitmap(), Vec2i()), tg.mRect.getPos(), blitterOptions);
+			band.mBlitter.blitSprite(Blitter::OutputWrapper(mGameScreenTexture.accessBitmap(), band.mCurrentViewport), Blitter::SpriteWrapper(tg.mDrawerTexture.accessBitmap(), Vec2i()), tg.mRect.getPos(), blitterOptions);
 			break;
 		}
 
 		case Geometry::Type::EFFECT_BLUR:
-		{
-			const EffectBlurGeometry& ebg = static_cast<const EffectBlurGeometry&>(geometry);
-			Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
-
-			if (ebg.mBlurValue >= 1)
-			{
-				SoftwareBlur::blurBitmap(gameScreenBitmap, ebg.mBlurValue);
-			}
-			break;
-		}
+			break;	// Blur needs the whole screen, so this is handled in "renderGameScreen"
 
 		case Geometry::Type::VIEWPORT:
 		{
 			const ViewportGeometry& vg = static_cast<const ViewportGeometry&>(geometry);
 			const Recti fullViewport(0, 0, mGameResolution.x, mGameResolution.y);
-			mCurrentViewport = fullViewport;
-			mCurrentViewport.intersect(vg.mRect);
-			mFullViewport = (mCurrentViewport == fullViewport);
+			Recti viewport = fullViewport;
+			viewport.intersect(vg.mRect);
+			band.mFullViewport = (viewport == fullViewport);
+			band.mCurrentViewport = Recti::getIntersection(viewport, band.mRect);
 			break;
 		}
 	}
 }
 
-void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
+void SoftwareRenderer::renderPlane(Band& band, const PlaneGeometry& geometry)
 {
 	Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
 
 	Recti rect(0, 0, mGameResolution.x, mGameResolution.y);
 	rect.intersect(geometry.mActiveRect);
-	rect.intersect(mCurrentViewport);
+	rect.intersect(band.mCurrentViewport);
 	const int minX = rect.x;
 	const int maxX = rect.x + rect.width;
 	const int minY = rect.y;
@@ -335,11 +613,11 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 	const ScrollOffsetsManager& scrollOffsetsManager = mRenderParts.getScrollOffsetsManager();
 	const PaletteManager& paletteManager = mRenderParts.getPaletteManager();
 
-	// Search for already setup buffered plane data fitting this geometry
+	// Search for buffered plane data fitting this geometry, either from this frame or from an earlier one
 	int foundFittingBufferedPlaneDataIndex = -1;
 	for (int i = 0; i < MAX_BUFFER_PLANE_DATA; ++i)
 	{
-		const BufferedPlaneData& bufferedPlaneData = mBufferedPlaneData[i];
+		const BufferedPlaneData& bufferedPlaneData = band.mBufferedPlaneData[i];
 		if (bufferedPlaneData.mValid &&
 			bufferedPlaneData.mPlaneIndex == geometry.mPlaneIndex &&
 			bufferedPlaneData.mScrollOffsets == geometry.mScrollOffsets &&
@@ -352,38 +630,61 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 
 	if (foundFittingBufferedPlaneDataIndex == -1)
 	{
-		// Find a free index
+		// Find a free index, or otherwise the one that was not used for the longest time
 		for (int i = 0; i < MAX_BUFFER_PLANE_DATA; ++i)
 		{
-			if (!mBufferedPlaneData[i].mValid)
+			const BufferedPlaneData& bufferedPlaneData = band.mBufferedPlaneData[i];
+			if (!bufferedPlaneData.mValid)
 			{
 				foundFittingBufferedPlaneDataIndex = i;
 				break;
 			}
+			if (bufferedPlaneData.mLastUsedFrame != band.mFrameNumber)
+			{
+				if (foundFittingBufferedPlaneDataIndex == -1 || bufferedPlaneData.mLastUsedFrame < band.mBufferedPlaneData[foundFittingBufferedPlaneDataIndex].mLastUsedFrame)
+					foundFittingBufferedPlaneDataIndex = i;
+			}
 		}
 		RMX_CHECK(foundFittingBufferedPlaneDataIndex != -1, "No free buffered plane data structure found", return);
 
-		BufferedPlaneData& bufferedPlaneData = mBufferedPlaneData[foundFittingBufferedPlaneDataIndex];
+		BufferedPlaneData& bufferedPlaneData = band.mBufferedPlaneData[foundFittingBufferedPlaneDataIndex];
+		bufferedPlaneData.mValid = true;
 		bufferedPlaneData.mPlaneIndex = geometry.mPlaneIndex;
 		bufferedPlaneData.mScrollOffsets = geometry.mScrollOffsets;
 		bufferedPlaneData.mActiveRect = geometry.mActiveRect;
-		bufferedPlaneData.mContent.resize(gameScreenBitmap.getPixelCount());
-		bufferedPlaneData.mPrioBlocks.clear();
-		bufferedPlaneData.mPrioBlocks.reserve(0x800);
-		bufferedPlaneData.mNonPrioBlocks.clear();
-		bufferedPlaneData.mNonPrioBlocks.reserve(0x800);
+		bufferedPlaneData.mPlaneData = nullptr;
+		bufferedPlaneData.mLastUsedFrame = 0;
+		bufferedPlaneData.mContent.resize(band.mRect.height * gameScreenBitmap.getWidth());
+		bufferedPlaneData.mContentOffset = band.mRect.y * gameScreenBitmap.getWidth();
+		bufferedPlaneData.mLines.resize(band.mRect.height);
+		for (BufferedPlaneData::Line& line : bufferedPlaneData.mLines)
+		{
+			line.mValid = false;
+		}
+	}
+
+	BufferedPlaneData& bufferedPlaneData = band.mBufferedPlaneData[foundFittingBufferedPlaneDataIndex];
+	if (bufferedPlaneData.mLastUsedFrame != band.mFrameNumber)
+	{
+		// Update the buffered plane data for this frame
+		//  -> Only lines whose inputs changed since the last update get rasterized again
+		bufferedPlaneData.mLastUsedFrame = band.mFrameNumber;
+
+		const PatternManager& patternManager = mRenderParts.getPatternManager();
+		const uint32 patternRefreshCounter = patternManager.getRefreshCounter();
+		const uint32* patternChangeCounters = patternManager.getPatternChangeCounters();
 
 		const uint16* planeData = planeManager.getPlaneDataInVRAM(geometry.mPlaneIndex);
 		const uint16 numPatternsPerLine = (geometry.mPlaneIndex <= PlaneManager::PLANE_A) ? planeManager.getPlayfieldSizeInPatterns().x : 64;
 		const uint16* scrollOffsetsH = nullptr;
 		const uint16* scrollOffsetsV = nullptr;
+		uint16 wScrollOffsetX = 0;
 		uint16 scrollMaskH = 0xff;
 		uint16 scrollMaskV = 0;
 		bool scrollNoRepeat = false;
 
 		if (geometry.mPlaneIndex == PlaneManager::PLANE_W)
 		{
-			static uint16 wScrollOffsetX;
 			wScrollOffsetX = (uint16)scrollOffsetsManager.getPlaneWScrollOffset().x;
 			scrollOffsetsH = &wScrollOffsetX;
 			scrollMaskH = 0;
@@ -399,12 +700,36 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 		const uint16 positionMaskV = planeManager.getPlayfieldSizeInPixels().y - 1;
 		const int16 verticalScrollOffsetBias = scrollOffsetsManager.getVerticalScrollOffsetBias();
 
-		detail::PixelBlockWriter pixelBlockWriter(bufferedPlaneData, mRenderParts.getPatternManager().getPatternCache());
+		// A different name table location or playfield size invalidates all lines
+		if (bufferedPlaneData.mPlaneData != planeData || bufferedPlaneData.mPlayfieldSize != planeManager.getPlayfieldSizeInPatterns())
+		{
+			bufferedPlaneData.mPlaneData = planeData;
+			bufferedPlaneData.mPlayfieldSize = planeManager.getPlayfieldSizeInPatterns();
+			for (BufferedPlaneData::Line& line : bufferedPlaneData.mLines)
+			{
+				line.mValid = false;
+			}
+		}
+
+		// Lines outside of the rect don't get rendered at all
+		for (int y = band.mRect.y; y < band.mRect.y + band.mRect.height; ++y)
+		{
+			if (y < minY || y >= maxY)
+			{
+				BufferedPlaneData::Line& line = bufferedPlaneData.mLines[y - band.mRect.y];
+				line.mValid = false;
+				line.mPrioBlocks.clear();
+				line.mNonPrioBlocks.clear();
+			}
+		}
+
+		detail::PixelBlockWriter pixelBlockWriter(bufferedPlaneData, patternManager.getPatternCache());
 
 		for (int y = minY; y < maxY; ++y)
 		{
+			BufferedPlaneData::Line& line = bufferedPlaneData.mLines[y - band.mRect.y];
 			const int position = y * gameScreenBitmap.getWidth();
-			pixelBlockWriter.newLine(y, position, (y < paletteManager.mSplitPositionY) ? 0 : 1);
+			const int paletteIndex = (y < paletteManager.mSplitPositionY) ? 0 : 1;
 
 			int vx = minX;
 			if (nullptr != scrollOffsetsH)
@@ -424,7 +749,11 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 					endX = startX + (positionMaskH - vx) + 1;
 				}
 				if (startX >= endX)
+				{
+					pixelBlockWriter.newLine(line, y, position, paletteIndex);
+					line.mValid = false;
 					continue;
+				}
 			}
 
 			if (scrollMaskV == 0)
@@ -432,7 +761,42 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 				// Optimized version of the code below in the else-block
 				const int vy = ((nullptr == scrollOffsetsV) ? y : (y + scrollOffsetsV[0])) & positionMaskV;
 				const uint16* planeDataForThisLine = &planeData[(vy / 8) * numPatternsPerLine];
-				const int patternPixelBaseOffset = (vy & 0x07) * 8;
+
+				// Check if the line can be reused from the last update
+				//  -> That's the case if it shows the same part of the plane, with the same plane content, and none of the patterns changed in the meantime
+				const int firstPatternVx = vx & positionMaskH & ~0x07;
+				const size_t numPatterns = (size_t)(((vx & 0x07) + (endX - startX) + 7) / 8);
+				if (line.mValid && line.mScrollX == vx && line.mScrollY == vy && line.mStartX == startX && line.mEndX == endX && line.mPaletteIndex == paletteIndex && line.mPatterns.size() == numPatterns)
+				{
+					bool unchanged = true;
+					for (size_t k = 0; k < numPatterns; ++k)
+					{
+						const uint16 patternIndex = planeDataForThisLine[((firstPatternVx + (int)k * 8) & positionMaskH) / 8];
+						if (patternIndex != line.mPatterns[k] || patternChangeCounters[patternIndex & 0x07ff] > line.mPatternRefreshCounter)
+						{
+							unchanged = false;
+							break;
+						}
+					}
+					if (unchanged)
+						continue;
+				}
+
+				line.mValid = true;
+				line.mScrollX = vx;
+				line.mScrollY = vy;
+				line.mStartX = startX;
+				line.mEndX = endX;
+				line.mPaletteIndex = paletteIndex;
+				line.mPatternRefreshCounter = patternRefreshCounter;
+				line.mPatterns.resize(numPatterns);
+				for (size_t k = 0; k < numPatterns; ++k)
+				{
+					line.mPatterns[k] = planeDataForThisLine[((firstPatternVx + (int)k * 8) & positionMaskH) / 8];
+				}
+
+				pixelBlockWriter.newLine(line, y, position, paletteIndex);
+				pixelBlockWriter.mPatternLine = vy & 0x07;
 
 				// First few pixels until vx gets divisible by 8
 				int x = startX;
@@ -441,14 +805,14 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 					const uint16 patternIndex = planeDataForThisLine[vx / 8];
 					const int vxMod8 = vx & 0x07;
 					const int pixels = std::min(8 - vxMod8, endX - x);
-					pixelBlockWriter.mPatternPixelOffset = patternPixelBaseOffset + vxMod8;
+					pixelBlockWriter.mPatternPixelX = vxMod8;
 					pixelBlockWriter.addPixels(x, patternIndex, pixels);
 					x += pixels;
 					vx += pixels;
 				}
 
 				// Full blocks of 8 pixels
-				pixelBlockWriter.mPatternPixelOffset = patternPixelBaseOffset;
+				pixelBlockWriter.mPatternPixelX = 0;
 				while (true)
 				{
 					vx &= positionMaskH;
@@ -480,6 +844,10 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 			}
 			else
 			{
+				// With vertical scrolling, each column can use a different row of the plane, so the line does not get cached
+				pixelBlockWriter.newLine(line, y, position, paletteIndex);
+				line.mValid = false;
+
 				for (int x = startX; x < endX; )
 				{
 					vx &= positionMaskH;
@@ -499,68 +867,54 @@ void SoftwareRenderer::renderPlane(const PlaneGeometry& geometry)
 					const int vxMod8 = vx & 0x07;
 					const int pixels = std::min(8 - vxMod8, endX - x);
 
-					pixelBlockWriter.mPatternPixelOffset = vxMod8 + (vy & 0x07) * 8;
+					pixelBlockWriter.mPatternLine = vy & 0x07;
+					pixelBlockWriter.mPatternPixelX = vxMod8;
 					pixelBlockWriter.addPixels(x, patternIndex, pixels);
 					x += pixels;
 					vx += pixels;
 				}
 			}
 		}
-
-		bufferedPlaneData.mValid = true;
 	}
 
 	// Write plane data to output
 	{
-		BufferedPlaneData& bufferedPlaneData = mBufferedPlaneData[foundFittingBufferedPlaneDataIndex];
-
 		const uint32* palettes[2] = { paletteManager.getMainPalette(0).getRawColors(), paletteManager.getMainPalette(1).getRawColors() };
 		const bool isBackground = (geometry.mPlaneIndex == PlaneManager::PLANE_B && !geometry.mPriorityFlag);
 
-		const std::vector<BufferedPlaneData::PixelBlock>& blocks = geometry.mPriorityFlag ? bufferedPlaneData.mPrioBlocks : bufferedPlaneData.mNonPrioBlocks;
-		for (const BufferedPlaneData::PixelBlock& block : blocks)
+		bool anyBlocks = false;
+		for (const BufferedPlaneData::Line& line : bufferedPlaneData.mLines)
 		{
-			const uint8* RESTRICT src = &bufferedPlaneData.mContent[block.mLinearPosition];
-			uint32* RESTRICT dstRGBA = &gameScreenBitmap.getData()[block.mLinearPosition];
-			const uint32* RESTRICT paletteWithAtex = &palettes[block.mPaletteIndex][block.mAtex];
-
-			if (isBackground)
+			const std::vector<BufferedPlaneData::PixelBlock>& blocks = geometry.mPriorityFlag ? line.mPrioBlocks : line.mNonPrioBlocks;
+			for (const BufferedPlaneData::PixelBlock& block : blocks)
 			{
-				for (int i = 0; i < block.mNumPixels; ++i)
+				const uint8* RESTRICT src = &bufferedPlaneData.mContent[block.mLinearPosition - bufferedPlaneData.mContentOffset];
+				uint32* RESTRICT dstRGBA = &gameScreenBitmap.getData()[block.mLinearPosition];
+				const uint32* RESTRICT paletteWithAtex = &palettes[block.mPaletteIndex][block.mAtex];
+
+				if (isBackground)
 				{
-					dstRGBA[i] = paletteWithAtex[src[i]];
+					PixelKernels::paletteLookup(dstRGBA, src, paletteWithAtex, block.mNumPixels);
 				}
-			}
-			else if (geometry.mPriorityFlag)
-			{
-				uint8* RESTRICT dstDepth = &mDepthBuffer[block.mStartCoords.x + block.mStartCoords.y * 0x200];
-				for (int i = 0; i < block.mNumPixels; ++i)
+				else if (geometry.mPriorityFlag)
 				{
-					if (src[i] & 0x0f)
-					{
-						dstRGBA[i] = paletteWithAtex[src[i]];
-						dstDepth[i] = 0x80;
-					}
+					uint8* RESTRICT dstDepth = &mDepthBuffer[block.mStartCoords.x + block.mStartCoords.y * 0x200];
+					PixelKernels::paletteLookupMaskedWithDepth(dstRGBA, dstDepth, 0x80, src, paletteWithAtex, block.mNumPixels);
 				}
-			}
-			else
-			{
-				for (int i = 0; i < block.mNumPixels; ++i)
+				else
 				{
-					if (src[i] & 0x0f)
-					{
-						dstRGBA[i] = paletteWithAtex[src[i]];
-					}
+					PixelKernels::paletteLookupMasked(dstRGBA, src, paletteWithAtex, block.mNumPixels);
 				}
 			}
+			anyBlocks |= !blocks.empty();
 		}
 
-		if (!blocks.empty() && geometry.mPriorityFlag)
-			mEmptyDepthBuffer = false;
+		if (anyBlocks && geometry.mPriorityFlag)
+			band.mEmptyDepthBuffer = false;
 	}
 }
 
-void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
+void SoftwareRenderer::renderSprite(Band& band, const SpriteGeometry& geometry, const Recti& clipRect)
 {
 	Bitmap& gameScreenBitmap = mGameScreenTexture.accessBitmap();
 
@@ -578,7 +932,7 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 			const bool useTintColor = (sprite.mTintColor != Color::WHITE || sprite.mAddedColor != Color::TRANSPARENT);
 
 			Recti rect(sprite.mInterpolatedPosition.x, sprite.mInterpolatedPosition.y, sprite.mSize.x * 8, sprite.mSize.y * 8);
-			rect = Recti::getIntersection(rect, mCurrentViewport);
+			rect = Recti::getIntersection(rect, clipRect);
 
 			const int minX = rect.x;
 			const int maxX = rect.x + rect.width;
@@ -606,9 +960,7 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 						patternY = sprite.mSize.y - patternY - 1;
 
 					const uint16 patternIndex = sprite.mFirstPattern + patternY + patternX * sprite.mSize.y;
-					const PatternManager::CacheItem::Pattern& pattern = patternCache[patternIndex & 0x07ff].mFlipVariation[(patternIndex >> 11) & 3];
-
-					uint8 colorIndex = pattern.mPixels[(vx%8) + (vy%8) * 8];
+					uint8 colorIndex = patternCache[patternIndex & 0x07ff].getPixel(vx % 8, vy % 8, patternIndex);
 					colorIndex += (patternIndex >> 9) & 0x30;
 					if (colorIndex & 0x0f)
 					{
@@ -660,7 +1012,7 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 				blitterOptions.mBlendMode = spriteBase.mBlendMode;
 				blitterOptions.mTintColor = (tintColor != Color::WHITE) ? &tintColor : nullptr;
 				blitterOptions.mAddedColor = (addedColor != Color::TRANSPARENT) ? &addedColor : nullptr;
-				blitterOptions.mDepthBuffer = (mEmptyDepthBuffer && !spriteBase.mPriorityFlag) ? nullptr : &depthBufferView;
+				blitterOptions.mDepthBuffer = (band.mEmptyDepthBuffer && !spriteBase.mPriorityFlag) ? nullptr : &depthBufferView;
 				blitterOptions.mDepthTestValue = (spriteBase.mPriorityFlag) ? 0x80 : 0;
 			}
 
@@ -683,15 +1035,15 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 					const PaletteBase& secondaryPalette = (nullptr == spriteInfo.mSecondaryPalette) ? paletteManager.getMainPalette(1) : *spriteInfo.mSecondaryPalette;
 					const Blitter::PaletteWrapper paletteWrapper2(secondaryPalette.getRawColors() + spriteInfo.mAtex, secondaryPalette.getSize() - spriteInfo.mAtex);
 
-					Recti targetRect = Recti::getIntersection(mCurrentViewport, Recti(0, 0, mGameResolution.x, splitY));
-					mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, targetRect), spriteWrapper, paletteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
+					Recti targetRect = Recti::getIntersection(clipRect, Recti(0, 0, mGameResolution.x, splitY));
+					band.mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, targetRect), spriteWrapper, paletteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
 
-					targetRect = Recti::getIntersection(mCurrentViewport, Recti(0, splitY, mGameResolution.x, mGameResolution.y - splitY));
-					mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, targetRect), spriteWrapper, paletteWrapper2, spriteInfo.mInterpolatedPosition, blitterOptions);
+					targetRect = Recti::getIntersection(clipRect, Recti(0, splitY, mGameResolution.x, mGameResolution.y - splitY));
+					band.mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, targetRect), spriteWrapper, paletteWrapper2, spriteInfo.mInterpolatedPosition, blitterOptions);
 				}
 				else
 				{
-					mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, mCurrentViewport), spriteWrapper, paletteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
+					band.mBlitter.blitIndexed(Blitter::OutputWrapper(gameScreenBitmap, clipRect), spriteWrapper, paletteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
 				}
 			}
 			else
@@ -702,11 +1054,11 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 				const ComponentSprite& componentSprite = *static_cast<ComponentSprite*>(spriteInfo.mCacheItem->mSprite);
 				const Blitter::SpriteWrapper spriteWrapper(componentSprite.getBitmap(), -componentSprite.mOffset);
 
-				mBlitter.blitSprite(Blitter::OutputWrapper(gameScreenBitmap, mCurrentViewport), spriteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
+				band.mBlitter.blitSprite(Blitter::OutputWrapper(gameScreenBitmap, clipRect), spriteWrapper, spriteInfo.mInterpolatedPosition, blitterOptions);
 			}
 
 			if (spriteBase.mPriorityFlag)
-				mEmptyDepthBuffer = false;
+				band.mEmptyDepthBuffer = false;
 			break;
 		}
 
@@ -721,8 +1073,8 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 				const int bytes = (maxX - minX) * 4;
 				if (bytes > 0)
 				{
-					const int minY = clamp(mask.mInterpolatedPosition.y, 0, gameScreenBitmap.getHeight());
-					const int maxY = clamp(mask.mInterpolatedPosition.y + mask.mSize.y, 0, gameScreenBitmap.getHeight());
+					const int minY = clamp(mask.mInterpolatedPosition.y, band.mRect.y, band.mRect.y + band.mRect.height);
+					const int maxY = clamp(mask.mInterpolatedPosition.y + mask.mSize.y, band.mRect.y, band.mRect.y + band.mRect.height);
 
 					for (int line = minY; line < maxY; ++line)
 					{
@@ -741,3 +1093,73 @@ void SoftwareRenderer::renderSprite(const SpriteGeometry& geometry)
 			break;
 	}
 }
+
+void SoftwareRenderer::renderSpriteRun(Band& band, const std::vector<Geometry*>& geometries, size_t startIndex, size_t endIndex)
+{
+	// Sprites get binned into screen tiles first, then each tile renders its sprites in their original order
+	//  -> Every pixel still sees the same sequence of sprites, but the tile's part of the screen and depth buffer stays in the cache
+	//  -> Sprites never write to the depth buffer, so occlusion by priority planes can be checked once per tile and sprite up front
+	const Recti viewport = band.mCurrentViewport;
+	if (viewport.isEmpty())
+		return;
+
+	const int numTilesX = (viewport.width + SPRITE_TILE_WIDTH - 1) / SPRITE_TILE_WIDTH;
+	const int numTilesY = (viewport.height + SPRITE_TILE_HEIGHT - 1) / SPRITE_TILE_HEIGHT;
+	band.mSpriteTiles.resize(numTilesX * numTilesY);
+
+	for (int tileY = 0; tileY < numTilesY; ++tileY)
+	{
+		for (int tileX = 0; tileX < numTilesX; ++tileX)
+		{
+			SpriteTile& tile = band.mSpriteTiles[tileX + tileY * numTilesX];
+			tile.mRect = Recti::getIntersection(Recti(viewport.x + tileX * SPRITE_TILE_WIDTH, viewport.y + tileY * SPRITE_TILE_HEIGHT, SPRITE_TILE_WIDTH, SPRITE_TILE_HEIGHT), viewport);
+			tile.mSprites.clear();
+
+			uint8 minDepth = 0;
+			if (!band.mEmptyDepthBuffer)
+			{
+				minDepth = 0xff;
+				for (int y = tile.mRect.y; y < tile.mRect.y + tile.mRect.height && minDepth > 0; ++y)
+				{
+					const uint8* depth = &mDepthBuffer[tile.mRect.x + y * 0x200];
+					for (int x = 0; x < tile.mRect.width; ++x)
+						minDepth = std::min(minDepth, depth[x]);
+				}
+			}
+			tile.mMinDepth = minDepth;
+		}
+	}
+
+	// Bin the sprites, skipping those that are clipped away or occluded
+	for (size_t i = startIndex; i < endIndex; ++i)
+	{
+		const SpriteGeometry& geometry = static_cast<const SpriteGeometry&>(*geometries[i]);
+		const Recti rect = Recti::getIntersection(getSpriteScreenRect(geometry), viewport);
+		if (rect.isEmpty())
+			continue;
+
+		const uint8 depthTestValue = (geometry.mSpriteInfo.mPriorityFlag) ? 0x80 : 0;
+		const int minTileX = (rect.x - viewport.x) / SPRITE_TILE_WIDTH;
+		const int maxTileX = (rect.x + rect.width - 1 - viewport.x) / SPRITE_TILE_WIDTH;
+		const int minTileY = (rect.y - viewport.y) / SPRITE_TILE_HEIGHT;
+		const int maxTileY = (rect.y + rect.height - 1 - viewport.y) / SPRITE_TILE_HEIGHT;
+		for (int tileY = minTileY; tileY <= maxTileY; ++tileY)
+		{
+			for (int tileX = minTileX; tileX <= maxTileX; ++tileX)
+			{
+				SpriteTile& tile = band.mSpriteTiles[tileX + tileY * numTilesX];
+				if (depthTestValue >= tile.mMinDepth)
+					tile.mSprites.push_back(&geometry);
+			}
+		}
+	}
+
+	// Rasterize tile by tile
+	for (SpriteTile& tile : band.mSpriteTiles)
+	{
+		for (const SpriteGeometry* geometry : tile.mSprites)
+		{
+			renderSprite(band, *geometry, tile.mRect);
+		}
+	}
+}
@@ -11,10 +11,13 @@
 #include "oxygen/rendering/Renderer.h"
 #include "oxygen/drawing/software/Blitter.h"
 
+#include <atomic>
+
 class PlaneGeometry;
 class SpriteGeometry;
 namespace detail
 {
+	class BandWorkers;
 	class PixelBlockWriter;
 }
 
@@ -28,6 +31,7 @@ public:
 
 public:
 	SoftwareRenderer(RenderParts& renderParts, DrawerTexture& outputTexture);
+	~SoftwareRenderer();
 
 	virtual void initialize() override;
 	virtual void reset() override;
@@ -37,20 +41,19 @@ public:
 	virtual void renderDebugDraw(int debugDrawMode, const Recti& rect) override;
 
 private:
-	void renderGeometry(const Geometry& geometry);
-	void renderPlane(const PlaneGeometry& geometry);
-	void renderSprite(const SpriteGeometry& geometry);
+	struct Band;
 
-private:
-	Vec2i mGameResolution;
-	Bitmap mGameScreenCopy;
+	void blurBitmap(Bitmap& bitmap, int blurValue);
 
-	uint8 mDepthBuffer[0x20000] = { 0 };	// 512x256 pixels
-	bool mEmptyDepthBuffer = true;			// Stays true until first non-zero depth value was written
+	void updateBands();
+	void renderBand(Band& band, const std::vector<Geometry*>& geometries, size_t startIndex, size_t endIndex, bool usingSpriteMask);
 
-	Recti mCurrentViewport;
-	bool mFullViewport = true;
+	void renderGeometry(Band& band, const Geometry& geometry);
+	void renderPlane(Band& band, const PlaneGeometry& geometry);
+	void renderSprite(Band& band, const SpriteGeometry& geometry, const Recti& clipRect);
+	void renderSpriteRun(Band& band, const std::vector<Geometry*>& geometries, size_t startIndex, size_t endIndex);
 
+private:
 	struct BufferedPlaneData
 	{
 		struct PixelBlock
@@ -62,17 +65,70 @@ private:
 			uint8 mPaletteIndex = 0;
 		};
 
+		// Rasterized line, which gets reused in the next frames as long as none of its inputs changed
+		struct Line
+		{
+			bool mValid = false;				// Only set if the line can be reused at all
+			int mScrollX = 0;					// Position in the plane of the first pixel
+			int mScrollY = 0;
+			int mStartX = 0;
+			int mEndX = 0;
+			int mPaletteIndex = 0;
+			uint32 mPatternRefreshCounter = 0;	// Pattern manager's refresh counter when the line got rasterized
+			std::vector<uint16> mPatterns;		// Plane content (i.e. name table entries) the line got rasterized from
+			std::vector<PixelBlock> mPrioBlocks;
+			std::vector<PixelBlock> mNonPrioBlocks;
+		};
+
 		bool mValid = false;
 		int mPlaneIndex = 0;
 		int mScrollOffsets = 0;
 		Recti mActiveRect;
+		const uint16* mPlaneData = nullptr;
+		Vec2i mPlayfieldSize;
+		uint32 mLastUsedFrame = 0;		// Frame number of the band when this was last updated
 
-		std::vector<uint8> mContent;
-		std::vector<PixelBlock> mPrioBlocks;
-		std::vector<PixelBlock> mNonPrioBlocks;
+		std::vector<uint8> mContent;	// Only covers the lines of the band
+		int mContentOffset = 0;			// Linear position on screen of the first pixel in mContent
+		std::vector<Line> mLines;		// One for each line of the band
 	};
 	static const constexpr int MAX_BUFFER_PLANE_DATA = 8;
-	BufferedPlaneData mBufferedPlaneData[MAX_BUFFER_PLANE_DATA];
 
-	Blitter mBlitter;
+	// Screen tile for binned sprite rendering, see "renderSpriteRun"
+	struct SpriteTile
+	{
+		Recti mRect;
+		uint8 mMinDepth = 0;				// Smallest depth buffer value inside the tile, sprites with a lower depth test value are fully occluded
+		std::vector<const SpriteGeometry*> mSprites;
+	};
+	static const constexpr int SPRITE_TILE_WIDTH = 64;
+	static const constexpr int SPRITE_TILE_HEIGHT = 32;
+	static const constexpr int MIN_SPRITES_FOR_BINNING = 8;
+
+	// Horizontal band of the screen, rendered independently from the others
+	//  -> All geometries get rendered by each band in the same order, clipped to the band's lines, so the result is the same as rendering the whole screen at once
+	//  -> The depth buffer and sprite mask copy are shared, but each band only ever touches its own lines in there
+	//  -> Buffered plane data is kept between frames, so that unchanged lines don't need to be rasterized again
+	struct Band
+	{
+		Recti mRect;
+		uint32 mFrameNumber = 0;
+		Recti mCurrentViewport;
+		bool mFullViewport = true;
+		bool mEmptyDepthBuffer = true;		// Stays true until first non-zero depth value was written
+		uint16 mLastRenderQueue = 0xffff;
+		BufferedPlaneData mBufferedPlaneData[MAX_BUFFER_PLANE_DATA];
+		std::vector<SpriteTile> mSpriteTiles;
+		Blitter mBlitter;
+	};
+
+private:
+	Vec2i mGameResolution;
+	Bitmap mGameScreenCopy;
+
+	uint8 mDepthBuffer[0x20000] = { 0 };	// 512x256 pixels
+
+	std::vector<Band*> mBands;
+	detail::BandWorkers* mBandWorkers = nullptr;
+	std::atomic<bool> mAbortRendering = false;
 };
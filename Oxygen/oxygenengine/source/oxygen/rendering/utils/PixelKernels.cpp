@@ -0,0 +1,886 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/rendering/utils/PixelKernels.h"
+#include "oxygen/helper/HighResolutionTimer.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define PIXELKERNELS_X64
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		#define TARGET_AVX2
+	#else
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define PIXELKERNELS_NEON
+	#include <arm_neon.h>
+#endif
+
+
+namespace
+{
+
+	// Scalar implementations
+
+	void expandPatternNibblesScalar(uint8* dst, const uint8* src)
+	{
+		for (int y = 0; y < 8; ++y)
+		{
+			uint32 bp;
+			memcpy(&bp, &src[y * 4], 4);
+			dst[0] = (bp >> 12) & 0x0f;
+			dst[1] = (bp >> 8)  & 0x0f;
+			dst[2] = (bp >> 4)  & 0x0f;
+			dst[3] = (bp >> 0)  & 0x0f;
+			dst[4] = (bp >> 28) & 0x0f;
+			dst[5] = (bp >> 24) & 0x0f;
+			dst[6] = (bp >> 20) & 0x0f;
+			dst[7] = (bp >> 16) & 0x0f;
+			dst += 8;
+		}
+	}
+
+	void paletteLookupScalar(uint32* RESTRICT dst, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		for (int i = 0; i < numPixels; ++i)
+		{
+			dst[i] = palette[src[i]];
+		}
+	}
+
+	void paletteLookupMaskedScalar(uint32* RESTRICT dst, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		for (int i = 0; i < numPixels; ++i)
+		{
+			if (src[i] & 0x0f)
+			{
+				dst[i] = palette[src[i]];
+			}
+		}
+	}
+
+	void paletteLookupMaskedWithDepthScalar(uint32* RESTRICT dst, uint8* RESTRICT dstDepth, uint8 depthValue, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		for (int i = 0; i < numPixels; ++i)
+		{
+			if (src[i] & 0x0f)
+			{
+				dst[i] = palette[src[i]];
+				dstDepth[i] = depthValue;
+			}
+		}
+	}
+
+	void blendLineAlphaScalar(uint32* RESTRICT dst, const uint32* RESTRICT src, int numPixels)
+	{
+		uint8* dstBytes = (uint8*)dst;
+		const uint8* srcBytes = (const uint8*)src;
+		for (int i = 0; i < numPixels; ++i)
+		{
+			const int alpha = srcBytes[3];
+			if (alpha > 0)
+			{
+				const int oneMinusAlpha = 255 - alpha;
+				dstBytes[0] = (uint8)((srcBytes[0] * alpha + dstBytes[0] * oneMinusAlpha) / 255);
+				dstBytes[1] = (uint8)((srcBytes[1] * alpha + dstBytes[1] * oneMinusAlpha) / 255);
+				dstBytes[2] = (uint8)((srcBytes[2] * alpha + dstBytes[2] * oneMinusAlpha) / 255);
+			}
+			dstBytes += 4;
+			srcBytes += 4;
+		}
+	}
+
+	void tintLineScalar(uint32* dst, const uint32* src, const int16* multiply, const int16* add, int numPixels)
+	{
+		uint8* dstBytes = (uint8*)dst;
+		const uint8* srcBytes = (const uint8*)src;
+		for (int i = 0; i < numPixels; ++i)
+		{
+			for (int k = 0; k < 4; ++k)
+			{
+				dstBytes[k] = (uint8)clamp(((srcBytes[k] * multiply[k]) >> 8) + add[k], 0, 0xff);
+			}
+			dstBytes += 4;
+			srcBytes += 4;
+		}
+	}
+
+	void blurLineScalar(uint32* RESTRICT dst, const uint32* src0, const uint32* src1, const uint32* src2, int weight, int numPixels)
+	{
+		// Red and blue channel get processed together, as the sums don't exceed 16 bits each
+		const uint32 centerWeight = 256 - weight * 2;
+		for (int i = 0; i < numPixels; ++i)
+		{
+			dst[i] = ((((src0[i] & 0xff00ff) * weight + (src1[i] & 0xff00ff) * centerWeight + (src2[i] & 0xff00ff) * weight) >> 8) & 0xff00ff)
+				   + ((((src0[i] & 0x00ff00) * weight + (src1[i] & 0x00ff00) * centerWeight + (src2[i] & 0x00ff00) * weight) >> 8) & 0x00ff00);
+		}
+	}
+
+
+#if defined(PIXELKERNELS_X64)
+
+	// SSE2 implementations
+	//  -> SSE2 has no byte shuffle, so palette colors get read one by one, but transparency masking and depth writes are vectorized
+
+	void expandPatternNibblesSSE2(uint8* dst, const uint8* src)
+	{
+		const __m128i lowNibbleMask = _mm_set1_epi8(0x0f);
+		for (int k = 0; k < 2; ++k)
+		{
+			// Swap bytes inside each 16-bit word, then the high nibble of each byte is the first pixel
+			__m128i v = _mm_loadu_si128((const __m128i*)&src[k * 16]);
+			v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			const __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), lowNibbleMask);
+			const __m128i low = _mm_and_si128(v, lowNibbleMask);
+			_mm_storeu_si128((__m128i*)&dst[k * 32], _mm_unpacklo_epi8(high, low));
+			_mm_storeu_si128((__m128i*)&dst[k * 32 + 16], _mm_unpackhi_epi8(high, low));
+		}
+	}
+
+	FORCE_INLINE __m128i gatherColorsSSE2(const uint8* src, const uint32* palette)
+	{
+		return _mm_set_epi32((int)palette[src[3]], (int)palette[src[2]], (int)palette[src[1]], (int)palette[src[0]]);
+	}
+
+	template<bool WRITE_DEPTH>
+	FORCE_INLINE void paletteLookupMaskedSSE2Internal(uint32* RESTRICT dst, uint8* RESTRICT dstDepth, uint8 depthValue, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i lowNibbleMask = _mm_set1_epi8(0x0f);
+		const __m128i depthValues = _mm_set1_epi8((char)depthValue);
+		int i = 0;
+		for (; i + 16 <= numPixels; i += 16)
+		{
+			// Mask has all bits set for transparent pixels
+			const __m128i mask8 = _mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i*)&src[i]), lowNibbleMask), zero);
+			const int transparentBits = _mm_movemask_epi8(mask8);
+			if (transparentBits == 0xffff)
+				continue;
+
+			if (transparentBits == 0)
+			{
+				for (int k = 0; k < 16; k += 4)
+				{
+					_mm_storeu_si128((__m128i*)&dst[i + k], gatherColorsSSE2(&src[i + k], palette));
+				}
+				if constexpr (WRITE_DEPTH)
+				{
+					_mm_storeu_si128((__m128i*)&dstDepth[i], depthValues);
+				}
+			}
+			else
+			{
+				const __m128i mask16[2] = { _mm_unpacklo_epi8(mask8, mask8), _mm_unpackhi_epi8(mask8, mask8) };
+				for (int k = 0; k < 4; ++k)
+				{
+					const __m128i mask32 = (k & 1) ? _mm_unpackhi_epi16(mask16[k / 2], mask16[k / 2]) : _mm_unpacklo_epi16(mask16[k / 2], mask16[k / 2]);
+					__m128i* RESTRICT ptr = (__m128i*)&dst[i + k * 4];
+					const __m128i colors = gatherColorsSSE2(&src[i + k * 4], palette);
+					_mm_storeu_si128(ptr, _mm_or_si128(_mm_and_si128(mask32, _mm_loadu_si128(ptr)), _mm_andnot_si128(mask32, colors)));
+				}
+				if constexpr (WRITE_DEPTH)
+				{
+					__m128i* RESTRICT ptr = (__m128i*)&dstDepth[i];
+					_mm_storeu_si128(ptr, _mm_or_si128(_mm_and_si128(mask8, _mm_loadu_si128(ptr)), _mm_andnot_si128(mask8, depthValues)));
+				}
+			}
+		}
+
+		if constexpr (WRITE_DEPTH)
+			paletteLookupMaskedWithDepthScalar(&dst[i], &dstDepth[i], depthValue, &src[i], palette, numPixels - i);
+		else
+			paletteLookupMaskedScalar(&dst[i], &src[i], palette, numPixels - i);
+	}
+
+	void paletteLookupMaskedSSE2(uint32* RESTRICT dst, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		paletteLookupMaskedSSE2Internal<false>(dst, nullptr, 0, src, palette, numPixels);
+	}
+
+	void paletteLookupMaskedWithDepthSSE2(uint32* RESTRICT dst, uint8* RESTRICT dstDepth, uint8 depthValue, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		paletteLookupMaskedSSE2Internal<true>(dst, dstDepth, depthValue, src, palette, numPixels);
+	}
+
+	// Blends two pixels given as 16-bit channels, with an exact division by 255
+	FORCE_INLINE __m128i blendAlphaSSE2(__m128i src16, __m128i dst16)
+	{
+		const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src16, 0xff), 0xff);
+		const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(src16, alpha), _mm_mullo_epi16(dst16, _mm_sub_epi16(_mm_set1_epi16(0xff), alpha)));
+		return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(sum, _mm_set1_epi16(1)), _mm_srli_epi16(sum, 8)), 8);
+	}
+
+	void blendLineAlphaSSE2(uint32* RESTRICT dst, const uint32* RESTRICT src, int numPixels)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32((int)0xff000000);
+		int i = 0;
+		for (; i + 4 <= numPixels; i += 4)
+		{
+			const __m128i srcColors = _mm_loadu_si128((const __m128i*)&src[i]);
+			const __m128i srcAlpha = _mm_and_si128(srcColors, alphaMask);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(srcAlpha, zero)) == 0xffff)
+				continue;
+
+			__m128i* RESTRICT ptr = (__m128i*)&dst[i];
+			const __m128i dstColors = _mm_loadu_si128(ptr);
+			__m128i result = srcColors;
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(srcAlpha, alphaMask)) != 0xffff)
+			{
+				const __m128i low = blendAlphaSSE2(_mm_unpacklo_epi8(srcColors, zero), _mm_unpacklo_epi8(dstColors, zero));
+				const __m128i high = blendAlphaSSE2(_mm_unpackhi_epi8(srcColors, zero), _mm_unpackhi_epi8(dstColors, zero));
+				result = _mm_packus_epi16(low, high);
+			}
+
+			// Destination alpha stays the same
+			_mm_storeu_si128(ptr, _mm_or_si128(_mm_and_si128(dstColors, alphaMask), _mm_andnot_si128(alphaMask, result)));
+		}
+		blendLineAlphaScalar(&dst[i], &src[i], numPixels - i);
+	}
+
+	void tintLineSSE2(uint32* dst, const uint32* src, const int16* multiply, const int16* add, int numPixels)
+	{
+		// With factors up to 0x100, the products still fit into unsigned 16-bit values
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i factors = _mm_setr_epi16(multiply[0], multiply[1], multiply[2], multiply[3], multiply[0], multiply[1], multiply[2], multiply[3]);
+		const __m128i offsets = _mm_setr_epi16(add[0], add[1], add[2], add[3], add[0], add[1], add[2], add[3]);
+		int i = 0;
+		for (; i + 4 <= numPixels; i += 4)
+		{
+			const __m128i colors = _mm_loadu_si128((const __m128i*)&src[i]);
+			const __m128i low = _mm_adds_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(colors, zero), factors), 8), offsets);
+			const __m128i high = _mm_adds_epi16(_mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(colors, zero), factors), 8), offsets);
+			_mm_storeu_si128((__m128i*)&dst[i], _mm_packus_epi16(low, high));
+		}
+		tintLineScalar(&dst[i], &src[i], multiply, add, numPixels - i);
+	}
+
+	void blurLineSSE2(uint32* RESTRICT dst, const uint32* src0, const uint32* src1, const uint32* src2, int weight, int numPixels)
+	{
+		// All weights sum up to 256, so the sums fit into unsigned 16-bit values
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i colorMask = _mm_set1_epi32(0x00ffffff);
+		const __m128i outerWeight = _mm_set1_epi16((int16)weight);
+		const __m128i centerWeight = _mm_set1_epi16((int16)(256 - weight * 2));
+		int i = 0;
+		for (; i + 4 <= numPixels; i += 4)
+		{
+			const __m128i colors0 = _mm_loadu_si128((const __m128i*)&src0[i]);
+			const __m128i colors1 = _mm_loadu_si128((const __m128i*)&src1[i]);
+			const __m128i colors2 = _mm_loadu_si128((const __m128i*)&src2[i]);
+			const __m128i low = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_add_epi16(_mm_unpacklo_epi8(colors0, zero), _mm_unpacklo_epi8(colors2, zero)), outerWeight), _mm_mullo_epi16(_mm_unpacklo_epi8(colors1, zero), centerWeight)), 8);
+			const __m128i high = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_add_epi16(_mm_unpackhi_epi8(colors0, zero), _mm_unpackhi_epi8(colors2, zero)), outerWeight), _mm_mullo_epi16(_mm_unpackhi_epi8(colors1, zero), centerWeight)), 8);
+			_mm_storeu_si128((__m128i*)&dst[i], _mm_and_si128(_mm_packus_epi16(low, high), colorMask));
+		}
+		blurLineScalar(&dst[i], &src0[i], &src1[i], &src2[i], weight, numPixels - i);
+	}
+
+
+	// AVX2 implementations
+	//  -> The palette gets split into four 16-byte tables, one for each color channel, so that the lookup is a byte shuffle per channel
+
+	struct PalettePlanesAVX2
+	{
+		__m256i mPlanes[4];
+	};
+
+	TARGET_AVX2 FORCE_INLINE void buildPalettePlanesAVX2(PalettePlanesAVX2& outPlanes, const uint32* palette)
+	{
+		// Transpose the 16 colors, so that each 32-bit lane holds the same channel of four colors
+		const __m128i transposeShuffle = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+		const __m128i c0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&palette[0]), transposeShuffle);
+		const __m128i c1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&palette[4]), transposeShuffle);
+		const __m128i c2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&palette[8]), transposeShuffle);
+		const __m128i c3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&palette[12]), transposeShuffle);
+		const __m128i t0 = _mm_unpacklo_epi32(c0, c1);
+		const __m128i t1 = _mm_unpacklo_epi32(c2, c3);
+		const __m128i t2 = _mm_unpackhi_epi32(c0, c1);
+		const __m128i t3 = _mm_unpackhi_epi32(c2, c3);
+		outPlanes.mPlanes[0] = _mm256_broadcastsi128_si256(_mm_unpacklo_epi64(t0, t1));
+		outPlanes.mPlanes[1] = _mm256_broadcastsi128_si256(_mm_unpackhi_epi64(t0, t1));
+		outPlanes.mPlanes[2] = _mm256_broadcastsi128_si256(_mm_unpacklo_epi64(t2, t3));
+		outPlanes.mPlanes[3] = _mm256_broadcastsi128_si256(_mm_unpackhi_epi64(t2, t3));
+	}
+
+	// Converts 32 bytes (one per pixel) into 32-bit values, in four registers with 8 pixels each, in pixel order
+	TARGET_AVX2 FORCE_INLINE void interleaveChannelsAVX2(__m256i* out, __m256i p0, __m256i p1, __m256i p2, __m256i p3)
+	{
+		const __m256i t0 = _mm256_unpacklo_epi8(p0, p1);
+		const __m256i t1 = _mm256_unpackhi_epi8(p0, p1);
+		const __m256i t2 = _mm256_unpacklo_epi8(p2, p3);
+		const __m256i t3 = _mm256_unpackhi_epi8(p2, p3);
+		const __m256i c0 = _mm256_unpacklo_epi16(t0, t2);
+		const __m256i c1 = _mm256_unpackhi_epi16(t0, t2);
+		const __m256i c2 = _mm256_unpacklo_epi16(t1, t3);
+		const __m256i c3 = _mm256_unpackhi_epi16(t1, t3);
+		out[0] = _mm256_permute2x128_si256(c0, c1, 0x20);
+		out[1] = _mm256_permute2x128_si256(c2, c3, 0x20);
+		out[2] = _mm256_permute2x128_si256(c0, c1, 0x31);
+		out[3] = _mm256_permute2x128_si256(c2, c3, 0x31);
+	}
+
+	TARGET_AVX2 FORCE_INLINE void lookupColorsAVX2(__m256i* outColors, const PalettePlanesAVX2& planes, __m256i indices)
+	{
+		interleaveChannelsAVX2(outColors, _mm256_shuffle_epi8(planes.mPlanes[0], indices), _mm256_shuffle_epi8(planes.mPlanes[1], indices),
+										  _mm256_shuffle_epi8(planes.mPlanes[2], indices), _mm256_shuffle_epi8(planes.mPlanes[3], indices));
+	}
+
+	TARGET_AVX2 void paletteLookupAVX2(uint32* RESTRICT dst, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		int i = 0;
+		if (numPixels >= 32)
+		{
+			PalettePlanesAVX2 planes;
+			buildPalettePlanesAVX2(planes, palette);
+			const __m256i lowNibbleMask = _mm256_set1_epi8(0x0f);
+
+			for (; i + 32 <= numPixels; i += 32)
+			{
+				const __m256i indices = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&src[i]), lowNibbleMask);
+				__m256i colors[4];
+				lookupColorsAVX2(colors, planes, indices);
+				for (int k = 0; k < 4; ++k)
+				{
+					_mm256_storeu_si256((__m256i*)&dst[i + k * 8], colors[k]);
+				}
+			}
+		}
+		paletteLookupScalar(&dst[i], &src[i], palette, numPixels - i);
+	}
+
+	template<bool WRITE_DEPTH>
+	TARGET_AVX2 FORCE_INLINE void paletteLookupMaskedAVX2Internal(uint32* RESTRICT dst, uint8* RESTRICT dstDepth, uint8 depthValue, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		int i = 0;
+		if (numPixels >= 32)
+		{
+			PalettePlanesAVX2 planes;
+			buildPalettePlanesAVX2(planes, palette);
+			const __m256i lowNibbleMask = _mm256_set1_epi8(0x0f);
+			const __m256i depthValues = _mm256_set1_epi8((char)depthValue);
+
+			for (; i + 32 <= numPixels; i += 32)
+			{
+				const __m256i indices = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&src[i]), lowNibbleMask);
+
+				// Mask has all bits set for non-transparent pixels
+				const __m256i mask8 = _mm256_xor_si256(_mm256_cmpeq_epi8(indices, _mm256_setzero_si256()), _mm256_set1_epi8(-1));
+				const uint32 writeBits = (uint32)_mm256_movemask_epi8(mask8);
+				if (writeBits == 0)
+					continue;
+
+				__m256i colors[4];
+				lookupColorsAVX2(colors, planes, indices);
+				if (writeBits == 0xffffffff)
+				{
+					for (int k = 0; k < 4; ++k)
+					{
+						_mm256_storeu_si256((__m256i*)&dst[i + k * 8], colors[k]);
+					}
+					if constexpr (WRITE_DEPTH)
+					{
+						_mm256_storeu_si256((__m256i*)&dstDepth[i], depthValues);
+					}
+				}
+				else
+				{
+					__m256i masks[4];
+					interleaveChannelsAVX2(masks, mask8, mask8, mask8, mask8);
+					for (int k = 0; k < 4; ++k)
+					{
+						_mm256_maskstore_epi32((int*)&dst[i + k * 8], masks[k], colors[k]);
+					}
+					if constexpr (WRITE_DEPTH)
+					{
+						__m256i* RESTRICT ptr = (__m256i*)&dstDepth[i];
+						_mm256_storeu_si256(ptr, _mm256_blendv_epi8(_mm256_loadu_si256(ptr), depthValues, mask8));
+					}
+				}
+			}
+		}
+
+		if constexpr (WRITE_DEPTH)
+			paletteLookupMaskedWithDepthScalar(&dst[i], &dstDepth[i], depthValue, &src[i], palette, numPixels - i);
+		else
+			paletteLookupMaskedScalar(&dst[i], &src[i], palette, numPixels - i);
+	}
+
+	TARGET_AVX2 void paletteLookupMaskedAVX2(uint32* RESTRICT dst, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		paletteLookupMaskedAVX2Internal<false>(dst, nullptr, 0, src, palette, numPixels);
+	}
+
+	TARGET_AVX2 void paletteLookupMaskedWithDepthAVX2(uint32* RESTRICT dst, uint8* RESTRICT dstDepth, uint8 depthValue, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		paletteLookupMaskedAVX2Internal<true>(dst, dstDepth, depthValue, src, palette, numPixels);
+	}
+
+	TARGET_AVX2 FORCE_INLINE __m256i blendAlphaAVX2(__m256i src16, __m256i dst16)
+	{
+		const __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src16, 0xff), 0xff);
+		const __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(src16, alpha), _mm256_mullo_epi16(dst16, _mm256_sub_epi16(_mm256_set1_epi16(0xff), alpha)));
+		return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(1)), _mm256_srli_epi16(sum, 8)), 8);
+	}
+
+	TARGET_AVX2 void blendLineAlphaAVX2(uint32* RESTRICT dst, const uint32* RESTRICT src, int numPixels)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i alphaMask = _mm256_set1_epi32((int)0xff000000);
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const __m256i srcColors = _mm256_loadu_si256((const __m256i*)&src[i]);
+			const __m256i srcAlpha = _mm256_and_si256(srcColors, alphaMask);
+			if ((uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi32(srcAlpha, zero)) == 0xffffffff)
+				continue;
+
+			__m256i* RESTRICT ptr = (__m256i*)&dst[i];
+			const __m256i dstColors = _mm256_loadu_si256(ptr);
+			__m256i result = srcColors;
+			if ((uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi32(srcAlpha, alphaMask)) != 0xffffffff)
+			{
+				// Unpacking and packing both work per 128-bit lane, so the pixel order is preserved
+				const __m256i low = blendAlphaAVX2(_mm256_unpacklo_epi8(srcColors, zero), _mm256_unpacklo_epi8(dstColors, zero));
+				const __m256i high = blendAlphaAVX2(_mm256_unpackhi_epi8(srcColors, zero), _mm256_unpackhi_epi8(dstColors, zero));
+				result = _mm256_packus_epi16(low, high);
+			}
+			_mm256_storeu_si256(ptr, _mm256_blendv_epi8(result, dstColors, alphaMask));
+		}
+		blendLineAlphaSSE2(&dst[i], &src[i], numPixels - i);
+	}
+
+	TARGET_AVX2 void tintLineAVX2(uint32* dst, const uint32* src, const int16* multiply, const int16* add, int numPixels)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i factors = _mm256_setr_epi16(multiply[0], multiply[1], multiply[2], multiply[3], multiply[0], multiply[1], multiply[2], multiply[3],
+												  multiply[0], multiply[1], multiply[2], multiply[3], multiply[0], multiply[1], multiply[2], multiply[3]);
+		const __m256i offsets = _mm256_setr_epi16(add[0], add[1], add[2], add[3], add[0], add[1], add[2], add[3], add[0], add[1], add[2], add[3], add[0], add[1], add[2], add[3]);
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const __m256i colors = _mm256_loadu_si256((const __m256i*)&src[i]);
+			const __m256i low = _mm256_adds_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(colors, zero), factors), 8), offsets);
+			const __m256i high = _mm256_adds_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(colors, zero), factors), 8), offsets);
+			_mm256_storeu_si256((__m256i*)&dst[i], _mm256_packus_epi16(low, high));
+		}
+		tintLineSSE2(&dst[i], &src[i], multiply, add, numPixels - i);
+	}
+
+	bool isAVX2Supported()
+	{
+	#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		// Check for OS support of AVX registers first
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 0x06) != 0x06)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	#else
+		// This may get called during static initialization, so make sure the CPU info is there already
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+	#endif
+	}
+
+#endif
+
+
+#if defined(PIXELKERNELS_NEON)
+
+	// NEON implementations
+	//  -> The palette gets split into four 16-byte tables, one for each color channel, so that the lookup is a table lookup per channel
+
+	void expandPatternNibblesNEON(uint8* dst, const uint8* src)
+	{
+		const uint8x16_t lowNibbleMask = vdupq_n_u8(0x0f);
+		for (int k = 0; k < 2; ++k)
+		{
+			// Swap bytes inside each 16-bit word, then the high nibble of each byte is the first pixel
+			const uint8x16_t v = vrev16q_u8(vld1q_u8(&src[k * 16]));
+			const uint8x16x2_t zipped = vzipq_u8(vshrq_n_u8(v, 4), vandq_u8(v, lowNibbleMask));
+			vst1q_u8(&dst[k * 32], zipped.val[0]);
+			vst1q_u8(&dst[k * 32 + 16], zipped.val[1]);
+		}
+	}
+
+	FORCE_INLINE uint8x16x4_t lookupColorsNEON(const uint8x16x4_t& planes, uint8x16_t indices)
+	{
+		uint8x16x4_t colors;
+		colors.val[0] = vqtbl1q_u8(planes.val[0], indices);
+		colors.val[1] = vqtbl1q_u8(planes.val[1], indices);
+		colors.val[2] = vqtbl1q_u8(planes.val[2], indices);
+		colors.val[3] = vqtbl1q_u8(planes.val[3], indices);
+		return colors;
+	}
+
+	void paletteLookupNEON(uint32* RESTRICT dst, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		int i = 0;
+		if (numPixels >= 16)
+		{
+			const uint8x16x4_t planes = vld4q_u8((const uint8*)palette);
+			const uint8x16_t lowNibbleMask = vdupq_n_u8(0x0f);
+			for (; i + 16 <= numPixels; i += 16)
+			{
+				const uint8x16_t indices = vandq_u8(vld1q_u8(&src[i]), lowNibbleMask);
+				vst4q_u8((uint8*)&dst[i], lookupColorsNEON(planes, indices));
+			}
+		}
+		paletteLookupScalar(&dst[i], &src[i], palette, numPixels - i);
+	}
+
+	template<bool WRITE_DEPTH>
+	FORCE_INLINE void paletteLookupMaskedNEONInternal(uint32* RESTRICT dst, uint8* RESTRICT dstDepth, uint8 depthValue, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		int i = 0;
+		if (numPixels >= 16)
+		{
+			const uint8x16x4_t planes = vld4q_u8((const uint8*)palette);
+			const uint8x16_t lowNibbleMask = vdupq_n_u8(0x0f);
+			const uint8x16_t depthValues = vdupq_n_u8(depthValue);
+			for (; i + 16 <= numPixels; i += 16)
+			{
+				const uint8x16_t indices = vandq_u8(vld1q_u8(&src[i]), lowNibbleMask);
+
+				// Mask has all bits set for non-transparent pixels
+				const uint8x16_t mask = vtstq_u8(indices, indices);
+				if (vmaxvq_u8(mask) == 0)
+					continue;
+
+				const uint8x16x4_t colors = lookupColorsNEON(planes, indices);
+				uint8x16x4_t pixels = vld4q_u8((const uint8*)&dst[i]);
+				pixels.val[0] = vbslq_u8(mask, colors.val[0], pixels.val[0]);
+				pixels.val[1] = vbslq_u8(mask, colors.val[1], pixels.val[1]);
+				pixels.val[2] = vbslq_u8(mask, colors.val[2], pixels.val[2]);
+				pixels.val[3] = vbslq_u8(mask, colors.val[3], pixels.val[3]);
+				vst4q_u8((uint8*)&dst[i], pixels);
+
+				if constexpr (WRITE_DEPTH)
+				{
+					vst1q_u8(&dstDepth[i], vbslq_u8(mask, depthValues, vld1q_u8(&dstDepth[i])));
+				}
+			}
+		}
+
+		if constexpr (WRITE_DEPTH)
+			paletteLookupMaskedWithDepthScalar(&dst[i], &dstDepth[i], depthValue, &src[i], palette, numPixels - i);
+		else
+			paletteLookupMaskedScalar(&dst[i], &src[i], palette, numPixels - i);
+	}
+
+	void paletteLookupMaskedNEON(uint32* RESTRICT dst, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		paletteLookupMaskedNEONInternal<false>(dst, nullptr, 0, src, palette, numPixels);
+	}
+
+	void paletteLookupMaskedWithDepthNEON(uint32* RESTRICT dst, uint8* RESTRICT dstDepth, uint8 depthValue, const uint8* RESTRICT src, const uint32* RESTRICT palette, int numPixels)
+	{
+		paletteLookupMaskedNEONInternal<true>(dst, dstDepth, depthValue, src, palette, numPixels);
+	}
+
+	void blendLineAlphaNEON(uint32* RESTRICT dst, const uint32* RESTRICT src, int numPixels)
+	{
+		const uint16x8_t one = vdupq_n_u16(1);
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const uint8x8x4_t srcColors = vld4_u8((const uint8*)&src[i]);
+			const uint8x8_t alpha = srcColors.val[3];
+			if (vmaxv_u8(alpha) == 0)
+				continue;
+
+			// The destination alpha channel does not get changed
+			const uint8x8_t oneMinusAlpha = vmvn_u8(alpha);
+			uint8x8x4_t dstColors = vld4_u8((const uint8*)&dst[i]);
+			for (int k = 0; k < 3; ++k)
+			{
+				const uint16x8_t sum = vmlal_u8(vmull_u8(srcColors.val[k], alpha), dstColors.val[k], oneMinusAlpha);
+				dstColors.val[k] = vshrn_n_u16(vaddq_u16(vaddq_u16(sum, one), vshrq_n_u16(sum, 8)), 8);
+			}
+			vst4_u8((uint8*)&dst[i], dstColors);
+		}
+		blendLineAlphaScalar(&dst[i], &src[i], numPixels - i);
+	}
+
+	void tintLineNEON(uint32* dst, const uint32* src, const int16* multiply, const int16* add, int numPixels)
+	{
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			uint8x8x4_t colors = vld4_u8((const uint8*)&src[i]);
+			for (int k = 0; k < 4; ++k)
+			{
+				const uint16x8_t product = vshrq_n_u16(vmulq_n_u16(vmovl_u8(colors.val[k]), (uint16)multiply[k]), 8);
+				colors.val[k] = vqmovun_s16(vaddq_s16(vreinterpretq_s16_u16(product), vdupq_n_s16(add[k])));
+			}
+			vst4_u8((uint8*)&dst[i], colors);
+		}
+		tintLineScalar(&dst[i], &src[i], multiply, add, numPixels - i);
+	}
+
+	void blurLineNEON(uint32* RESTRICT dst, const uint32* src0, const uint32* src1, const uint32* src2, int weight, int numPixels)
+	{
+		const uint8x8_t outerWeight = vdup_n_u8((uint8)weight);
+		const uint8x8_t centerWeight = vdup_n_u8((uint8)(256 - weight * 2));
+		int i = 0;
+		for (; i + 8 <= numPixels; i += 8)
+		{
+			const uint8x8x4_t colors0 = vld4_u8((const uint8*)&src0[i]);
+			const uint8x8x4_t colors1 = vld4_u8((const uint8*)&src1[i]);
+			const uint8x8x4_t colors2 = vld4_u8((const uint8*)&src2[i]);
+			uint8x8x4_t result;
+			for (int k = 0; k < 3; ++k)
+			{
+				const uint16x8_t sum = vmlal_u8(vmlal_u8(vmull_u8(colors0.val[k], outerWeight), colors1.val[k], centerWeight), colors2.val[k], outerWeight);
+				result.val[k] = vshrn_n_u16(sum, 8);
+			}
+			result.val[3] = vdup_n_u8(0);
+			vst4_u8((uint8*)&dst[i], result);
+		}
+		blurLineScalar(&dst[i], &src0[i], &src1[i], &src2[i], weight, numPixels - i);
+	}
+
+#endif
+
+
+	const PixelKernels::Functions SCALAR_FUNCTIONS = { &expandPatternNibblesScalar, &paletteLookupScalar, &paletteLookupMaskedScalar, &paletteLookupMaskedWithDepthScalar, &blendLineAlphaScalar, &tintLineScalar, &blurLineScalar };
+#if defined(PIXELKERNELS_X64)
+	const PixelKernels::Functions SSE2_FUNCTIONS = { &expandPatternNibblesSSE2, &paletteLookupScalar, &paletteLookupMaskedSSE2, &paletteLookupMaskedWithDepthSSE2, &blendLineAlphaSSE2, &tintLineSSE2, &blurLineSSE2 };	// Unmasked lookup without byte shuffle is not faster than scalar code
+	const PixelKernels::Functions AVX2_FUNCTIONS = { &expandPatternNibblesSSE2, &paletteLookupAVX2, &paletteLookupMaskedAVX2, &paletteLookupMaskedWithDepthAVX2, &blendLineAlphaAVX2, &tintLineAVX2, &blurLineSSE2 };	// Nibble expansion is too short and blurring too memory-bound to benefit from AVX2
+#endif
+#if defined(PIXELKERNELS_NEON)
+	const PixelKernels::Functions NEON_FUNCTIONS = { &expandPatternNibblesNEON, &paletteLookupNEON, &paletteLookupMaskedNEON, &paletteLookupMaskedWithDepthNEON, &blendLineAlphaNEON, &tintLineNEON, &blurLineNEON };
+#endif
+}
+
+
+PixelKernels::InstructionSet PixelKernels::mInstructionSet = PixelKernels::getBestSupportedInstructionSet();
+PixelKernels::Functions PixelKernels::mFunctions = PixelKernels::getFunctions(PixelKernels::mInstructionSet);
+
+
+bool PixelKernels::isSupported(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+		case InstructionSet::SCALAR:
+			return true;
+
+	#if defined(PIXELKERNELS_X64)
+		case InstructionSet::SSE2:
+			return true;
+
+		case InstructionSet::AVX2:
+		{
+			static const bool supported = isAVX2Supported();
+			return supported;
+		}
+	#endif
+
+	#if defined(PIXELKERNELS_NEON)
+		case InstructionSet::NEON:
+			return true;
+	#endif
+
+		default:
+			return false;
+	}
+}
+
+PixelKernels::InstructionSet PixelKernels::getBestSupportedInstructionSet()
+{
+	for (int index = (int)InstructionSet::_NUM - 1; index > 0; --index)
+	{
+		if (isSupported((InstructionSet)index))
+			return (InstructionSet)index;
+	}
+	return InstructionSet::SCALAR;
+}
+
+const char* PixelKernels::getInstructionSetName(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+		case InstructionSet::SCALAR:  return "Scalar";
+		case InstructionSet::SSE2:	  return "SSE2";
+		case InstructionSet::AVX2:	  return "AVX2";
+		case InstructionSet::NEON:	  return "NEON";
+		default:					  return "?";
+	}
+}
+
+void PixelKernels::setInstructionSet(InstructionSet instructionSet)
+{
+	if (!isSupported(instructionSet))
+		instructionSet = getBestSupportedInstructionSet();
+
+	mInstructionSet = instructionSet;
+	mFunctions = getFunctions(instructionSet);
+}
+
+void PixelKernels::runBenchmark()
+{
+	// Test data similar to what a plane looks like: runs of transparent and non-transparent pixels of different lengths
+	constexpr int NUM_PIXELS = 320;
+	constexpr int NUM_LINES = 224;
+	constexpr int NUM_PATTERNS = 0x800;
+	std::vector<uint8> patternData(NUM_PATTERNS * 0x20);
+	std::vector<uint8> indices(NUM_PIXELS * NUM_LINES);
+	std::vector<uint32> colors(NUM_PIXELS * NUM_LINES);
+	uint32 palette[16];
+	{
+		uint32 rng = 0x12345678;
+		const auto nextRandom = [&]() { rng = rng * 1103515245 + 12345; return rng >> 16; };
+
+		for (uint8& value : patternData)
+			value = (uint8)nextRandom();
+		for (uint32& color : palette)
+			color = nextRandom() | (nextRandom() << 16);
+
+		size_t position = 0;
+		while (position < indices.size())
+		{
+			const size_t length = std::min<size_t>(1 + nextRandom() % 48, indices.size() - position);
+			const bool transparent = (nextRandom() % 3 == 0);
+			for (size_t k = 0; k < length; ++k)
+			{
+				indices[position + k] = transparent ? 0 : (uint8)(nextRandom() & 0x0f);
+			}
+			position += length;
+		}
+
+		// Colors for blending are mostly either fully transparent or opaque, like in typical sprites and UI graphics
+		for (size_t k = 0; k < colors.size(); ++k)
+		{
+			const uint32 alpha = (indices[k] == 0) ? 0 : (indices[k] < 12) ? 0xff : (nextRandom() & 0xff);
+			colors[k] = (nextRandom() | (nextRandom() << 16) | 0xff000000) & ((alpha << 24) | 0x00ffffff);
+		}
+	}
+	const int16 tintMultiply[4] = { 0x100, 0xc0, 0x40, 0x80 };
+	const int16 tintAdd[4] = { 0x20, -0x10, 0xff, 0 };
+
+	std::vector<uint8> patternOutput(NUM_PATTERNS * 0x40);
+	std::vector<uint32> colorOutput(indices.size());
+	std::vector<uint8> depthOutput(indices.size());
+
+	// Each kernel gets run a fixed number of times on the same data, and its output hashed for comparison with the scalar version
+	constexpr int NUM_ITERATIONS = 200;
+	const auto runKernel = [&](const Functions& functions, int kernelIndex, uint64& outHash)
+	{
+		memset(&colorOutput[0], 0, colorOutput.size() * sizeof(uint32));
+		memset(&depthOutput[0], 0, depthOutput.size());
+
+		HighResolutionTimer timer;
+		timer.start();
+		for (int iteration = 0; iteration < NUM_ITERATIONS; ++iteration)
+		{
+			switch (kernelIndex)
+			{
+				case 0:
+					for (int k = 0; k < NUM_PATTERNS; ++k)
+						functions.mExpandPatternNibbles(&patternOutput[k * 0x40], &patternData[k * 0x20]);
+					break;
+
+				case 1:
+					for (int y = 0; y < NUM_LINES; ++y)
+						functions.mPaletteLookup(&colorOutput[y * NUM_PIXELS], &indices[y * NUM_PIXELS], palette, NUM_PIXELS);
+					break;
+
+				case 2:
+					for (int y = 0; y < NUM_LINES; ++y)
+						functions.mPaletteLookupMasked(&colorOutput[y * NUM_PIXELS], &indices[y * NUM_PIXELS], palette, NUM_PIXELS);
+					break;
+
+				case 3:
+					for (int y = 0; y < NUM_LINES; ++y)
+						functions.mPaletteLookupMaskedWithDepth(&colorOutput[y * NUM_PIXELS], &depthOutput[y * NUM_PIXELS], 0x80, &indices[y * NUM_PIXELS], palette, NUM_PIXELS);
+					break;
+
+				case 4:
+					for (int y = 0; y < NUM_LINES; ++y)
+						functions.mBlendLineAlpha(&colorOutput[y * NUM_PIXELS], &colors[((y + iteration) % NUM_LINES) * NUM_PIXELS], NUM_PIXELS);
+					break;
+
+				case 5:
+					for (int y = 0; y < NUM_LINES; ++y)
+						functions.mTintLine(&colorOutput[y * NUM_PIXELS], &colors[y * NUM_PIXELS], tintMultiply, tintAdd, NUM_PIXELS);
+					break;
+
+				case 6:
+					for (int y = 1; y < NUM_LINES - 1; ++y)
+						functions.mBlurLine(&colorOutput[y * NUM_PIXELS], &colors[(y - 1) * NUM_PIXELS], &colors[y * NUM_PIXELS], &colors[(y + 1) * NUM_PIXELS], 48, NUM_PIXELS);
+					break;
+			}
+		}
+		const double seconds = timer.getSecondsSinceStart();
+
+		uint64 hash = rmx::startFNV1a_64();
+		if (kernelIndex == 0)
+		{
+			hash = rmx::addToFNV1a_64(hash, &patternOutput[0], patternOutput.size());
+		}
+		else
+		{
+			hash = rmx::addToFNV1a_64(hash, (const uint8*)&colorOutput[0], colorOutput.size() * sizeof(uint32));
+			hash = rmx::addToFNV1a_64(hash, &depthOutput[0], depthOutput.size());
+		}
+		outHash = hash;
+		return seconds;
+	};
+
+	static const char* KERNEL_NAMES[] = { "Pattern nibble expansion", "Palette lookup", "Palette lookup, masked", "Palette lookup, masked with depth", "Alpha blending", "Tint color", "Blur" };
+
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("--- PIXEL KERNELS BENCHMARK ---");
+	RMX_LOG_INFO("Active instruction set: " << getInstructionSetName(mInstructionSet));
+	for (int kernelIndex = 0; kernelIndex < 7; ++kernelIndex)
+	{
+		RMX_LOG_INFO(KERNEL_NAMES[kernelIndex] << ":");
+
+		uint64 scalarHash = 0;
+		const double scalarSeconds = runKernel(SCALAR_FUNCTIONS, kernelIndex, scalarHash);
+		RMX_LOG_INFO("   " << getInstructionSetName(InstructionSet::SCALAR) << ":  " << roundToInt(scalarSeconds * 1000000.0 / NUM_ITERATIONS) << " us per run");
+
+		for (int index = 1; index < (int)InstructionSet::_NUM; ++index)
+		{
+			const InstructionSet instructionSet = (InstructionSet)index;
+			if (!isSupported(instructionSet))
+				continue;
+
+			uint64 hash = 0;
+			const double seconds = runKernel(getFunctions(instructionSet), kernelIndex, hash);
+			RMX_LOG_INFO("   " << getInstructionSetName(instructionSet) << ":  " << roundToInt(seconds * 1000000.0 / NUM_ITERATIONS) << " us per run, "
+						 << "speedup " << roundToInt(scalarSeconds / std::max(seconds, 1e-9) * 100.0) << "%" << ((hash == scalarHash) ? "" : ", OUTPUT MISMATCH"));
+		}
+	}
+}
+
+const PixelKernels::Functions& PixelKernels::getFunctions(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+	#if defined(PIXELKERNELS_X64)
+		case InstructionSet::SSE2:  return SSE2_FUNCTIONS;
+		case InstructionSet::AVX2:  return AVX2_FUNCTIONS;
+	#endif
+	#if defined(PIXELKERNELS_NEON)
+		case InstructionSet::NEON:  return NEON_FUNCTIONS;
+	#endif
+		default:					return SCALAR_FUNCTIONS;
+	}
+}
@@ -0,0 +1,82 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <rmxbase.h>
+
+
+// Inner loops of the software renderer and blitter, with SIMD implementations for SSE2 / AVX2 (x64) and NEON (ARM64)
+//  - The best supported instruction set gets chosen at runtime, with a scalar fallback for everything else
+//  - All implementations produce exactly the same output
+class PixelKernels
+{
+public:
+	enum class InstructionSet
+	{
+		SCALAR,
+		SSE2,
+		AVX2,
+		NEON,
+		_NUM
+	};
+
+	struct Functions
+	{
+		void (*mExpandPatternNibbles)(uint8* dst, const uint8* src);
+		void (*mPaletteLookup)(uint32* dst, const uint8* src, const uint32* palette, int numPixels);
+		void (*mPaletteLookupMasked)(uint32* dst, const uint8* src, const uint32* palette, int numPixels);
+		void (*mPaletteLookupMaskedWithDepth)(uint32* dst, uint8* dstDepth, uint8 depthValue, const uint8* src, const uint32* palette, int numPixels);
+		void (*mBlendLineAlpha)(uint32* dst, const uint32* src, int numPixels);
+		void (*mTintLine)(uint32* dst, const uint32* src, const int16* multiply, const int16* add, int numPixels);
+		void (*mBlurLine)(uint32* dst, const uint32* src0, const uint32* src1, const uint32* src2, int weight, int numPixels);
+	};
+
+public:
+	static bool isSupported(InstructionSet instructionSet);
+	static InstructionSet getBestSupportedInstructionSet();
+	static const char* getInstructionSetName(InstructionSet instructionSet);
+
+	static inline InstructionSet getInstructionSet()  { return mInstructionSet; }
+	static void setInstructionSet(InstructionSet instructionSet);
+
+	// Expands one 8x8 pattern in VRAM format (32 bytes with 4 bits per pixel) into 64 bytes with one pixel each
+	static inline void expandPatternNibbles(uint8* dst, const uint8* src)  { mFunctions.mExpandPatternNibbles(dst, src); }
+
+	// Writes the colors for the given pixels, using a palette of 16 colors
+	//  -> Pixel values are expected to be in range 0x00...0x0f
+	static inline void paletteLookup(uint32* dst, const uint8* src, const uint32* palette, int numPixels)  { mFunctions.mPaletteLookup(dst, src, palette, numPixels); }
+
+	// Same as "paletteLookup", but leaves transparent pixels (with value 0) untouched
+	static inline void paletteLookupMasked(uint32* dst, const uint8* src, const uint32* palette, int numPixels)  { mFunctions.mPaletteLookupMasked(dst, src, palette, numPixels); }
+
+	// Same as "paletteLookupMasked", and additionally writes the depth value for each non-transparent pixel
+	static inline void paletteLookupMaskedWithDepth(uint32* dst, uint8* dstDepth, uint8 depthValue, const uint8* src, const uint32* palette, int numPixels)  { mFunctions.mPaletteLookupMaskedWithDepth(dst, dstDepth, depthValue, src, palette, numPixels); }
+
+	// Blends RGBA colors onto the destination using the source alpha, leaving the destination alpha untouched
+	static inline void blendLineAlpha(uint32* dst, const uint32* src, int numPixels)  { mFunctions.mBlendLineAlpha(dst, src, numPixels); }
+
+	// Multiplies each color channel with a factor in 8.8 fixed point and adds an offset, with the result clamped to 0x00...0xff
+	//  -> Factors must be in range 0...0x100, offsets in range -0xff...0xff, each with one value per channel in RGBA order
+	//  -> Destination and source may be the same
+	static inline void tintLine(uint32* dst, const uint32* src, const int16* multiply, const int16* add, int numPixels)  { mFunctions.mTintLine(dst, src, multiply, add, numPixels); }
+
+	// Mixes three lines of colors with weights (weight, 256 - 2 * weight, weight) / 256, rounding down; the alpha channel of the result is always zero
+	//  -> The weight must be in range 1...127, and the destination must not overlap any of the sources
+	static inline void blurLine(uint32* dst, const uint32* src0, const uint32* src1, const uint32* src2, int weight, int numPixels)  { mFunctions.mBlurLine(dst, src0, src1, src2, weight, numPixels); }
+
+	// Micro-benchmark comparing each kernel of all supported instruction sets against its scalar version, with the results written to the log
+	static void runBenchmark();
+
+private:
+	static const Functions& getFunctions(InstructionSet instructionSet);
+
+private:
+	static InstructionSet mInstructionSet;
+	static Functions mFunctions;
+};
@@ -8,6 +8,7 @@
 
 #include "oxygen/pch.h"
 #include "oxygen/rendering/utils/RenderUtils.h"
+#include "oxygen/rendering/utils/PixelKernels.h"
 
 
 namespace
@@ -64,20 +65,7 @@ Recti RenderUtils::getScaleToFillRect(const Recti& frameRect, float aspectRatio)
 
 void RenderUtils::expandPatternDataFromVRAM(uint8* dst, const void* src_)
 {
-	uint32* src = (uint32*)src_;
-	for (uint8 y = 0; y < 8; ++y)
-	{
-		const uint32 bp = src[y];
-		dst[0] = (bp >> 12) & 0x0f;
-		dst[1] = (bp >> 8)  & 0x0f;
-		dst[2] = (bp >> 4)  & 0x0f;
-		dst[3] = (bp >> 0)  & 0x0f;
-		dst[4] = (bp >> 28) & 0x0f;
-		dst[5] = (bp >> 24) & 0x0f;
-		dst[6] = (bp >> 20) & 0x0f;
-		dst[7] = (bp >> 16) & 0x0f;
-		dst += 8;
-	}
+	PixelKernels::expandPatternNibbles(dst, (const uint8*)src_);
 }
 
 void RenderUtils::expandPatternDataFromROM(uint8* dst, const void* src_)
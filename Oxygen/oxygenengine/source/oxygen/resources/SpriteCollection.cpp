@@ -11,10 +11,10 @@
 #include "oxygen/application/Configuration.h"
 #include "oxygen/application/EngineMain.h"
 #include "oxygen/application/modding/ModManager.h"
-#include "oxygen/helper/FileHelper.h"
 #include "oxygen/helper/JsonHelper.h"
 #include "oxygen/rendering/sprite/SpriteDump.h"
 #include "oxygen/rendering/utils/Kosinski.h"
+#include "oxygen/resources/SpriteImageCache.h"
 #include "oxygen/simulation/EmulatorInterface.h"
 #include "oxygen/simulation/LemonScriptRuntime.h"
 
@@ -224,6 +224,18 @@ void SpriteCollection::clear()
 
 void SpriteCollection::loadAllSpriteDefinitions()
 {
+	// Once per session, remove sprite image cache files of mods that are not installed any more
+	if (!mRemovedUnusedImageCacheFiles && Configuration::instance().mUseSpriteImageCache)
+	{
+		std::vector<std::wstring> spritesPaths = { L"data/sprites" };
+		for (const Mod* mod : ModManager::instance().getAllMods())
+		{
+			spritesPaths.push_back(mod->mFullPath + L"sprites");
+		}
+		SpriteImageCache::removeUnusedCacheFiles(spritesPaths);
+		mRemovedUnusedImageCacheFiles = true;
+	}
+
 	// Load or reload from all mods
 	loadSpriteDefinitions(L"data/sprites", nullptr);
 	for (const Mod* mod : ModManager::instance().getActiveMods())
@@ -234,11 +246,13 @@ void SpriteCollection::loadAllSpriteDefinitions()
 
 bool SpriteCollection::hasSprite(uint64 key) const
 {
+	std::lock_guard<std::mutex> lock(mMutex);
 	return (mSpriteItems.count(key) != 0);
 }
 
 const SpriteCollection::Item* SpriteCollection::getSprite(uint64 key)
 {
+	std::lock_guard<std::mutex> lock(mMutex);
 	Item* item = mapFind(mSpriteItems, key);
 	if (nullptr != item)
 	{
@@ -302,6 +316,7 @@ SpriteCollection::Item& SpriteCollection::getOrCreateComponentSprite(uint64 key)
 
 SpriteCollection::Item& SpriteCollection::setupSpriteFromROM(EmulatorInterface& emulatorInterface, const ROMSpriteData& romSpriteData, uint8 atex)
 {
+	std::lock_guard<std::mutex> lock(mMutex);
 	const uint64 key = romSpriteData.getKey();
 	Item* item = mapFind(mSpriteItems, key);
 	if (nullptr == item)
@@ -397,6 +412,7 @@ void SpriteCollection::loadSpriteDefinitions(const std::wstring& path, const Mod
 		std::map<uint64, Bitmap> mComponentSpriteSheets;
 	};
 	SheetCache sheetCache;
+	SpriteImageCache imageCache(path, Configuration::instance().mUseSpriteImageCache);
 
 	std::vector<rmx::FileIO::FileEntry> fileEntries;
 	fileEntries.reserve(8);
@@ -478,7 +494,7 @@ void SpriteCollection::loadSpriteDefinitions(const std::wstring& path, const Mod
 						PaletteSpriteSheet& sheet = sheetCache.mPaletteSpriteSheets[sheetKey];
 						if (sheet.mBitmap.empty())
 						{
-							success = FileHelper::loadPaletteBitmap(sheet.mBitmap, fullpath, &palette);
+							success = imageCache.loadPaletteBitmap(sheet.mBitmap, palette, fullpath);
 							if (success)
 							{
 								sheet.mFirstSpritePaletteKey = paletteKey;
@@ -500,7 +516,7 @@ void SpriteCollection::loadSpriteDefinitions(const std::wstring& path, const Mod
 					{
 						// The sprite is the whole bitmap
 						PaletteBitmap bitmap;
-						success = FileHelper::loadPaletteBitmap(bitmap, fullpath, &palette);
+						success = imageCache.loadPaletteBitmap(bitmap, palette, fullpath);
 						if (success)
 						{
 							sprite->createFromBitmap(std::move(bitmap), -center);
@@ -520,7 +536,7 @@ void SpriteCollection::loadSpriteDefinitions(const std::wstring& path, const Mod
 						Bitmap& bitmap = sheetCache.mComponentSpriteSheets[sheetKey];
 						if (bitmap.empty())
 						{
-							success = FileHelper::loadBitmap(bitmap, fullpath);
+							success = imageCache.loadBitmap(bitmap, fullpath);
 						}
 						else
 						{
@@ -535,13 +551,15 @@ void SpriteCollection::loadSpriteDefinitions(const std::wstring& path, const Mod
 					else
 					{
 						// The sprite is the whole bitmap
-						success = FileHelper::loadBitmap(static_cast<ComponentSprite*>(item.mSprite)->accessBitmap(), fullpath);
+						success = imageCache.loadBitmap(static_cast<ComponentSprite*>(item.mSprite)->accessBitmap(), fullpath);
 					}
 					item.mSprite->mOffset = -center;
 				}
 			}
 		}
 	}
+
+	imageCache.save();
 }
 
 void SpriteCollection::addSpritePalette(uint64 paletteKey, const Item& item, std::vector<uint32>& palette)
@@ -12,6 +12,8 @@
 #include "oxygen/rendering/sprite/ComponentSprite.h"
 #include "oxygen/rendering/sprite/PaletteSprite.h"
 
+#include <mutex>
+
 class EmulatorInterface;
 class Mod;
 class SpriteDump;
@@ -113,4 +115,7 @@ private:
 
 	SpriteDump* mSpriteDump = nullptr;
 	uint32 mGlobalChangeCounter = 0;
+	bool mRemovedUnusedImageCacheFiles = false;
+
+	mutable std::mutex mMutex;	// Sprites from ROM can get set up by simulations running in parallel
 };
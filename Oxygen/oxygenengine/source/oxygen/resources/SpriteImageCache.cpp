@@ -0,0 +1,256 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/resources/SpriteImageCache.h"
+#include "oxygen/application/Configuration.h"
+#include "oxygen/helper/FileHelper.h"
+
+
+namespace
+{
+	static const char CACHE_FILE_SIGNATURE[] = "OSIC";
+	static const uint16 CACHE_FILE_FORMAT_VERSION = 1;
+
+	std::wstring getCacheDirectory()
+	{
+		return Configuration::instance().mAppDataPath + L"cache/sprites/";
+	}
+
+	std::wstring getCacheFilename(const std::wstring& spritesPath)
+	{
+		return String(rmx::hexString(rmx::getMurmur2_64(spritesPath), 16, "")).toStdWString() + L".bin";
+	}
+
+	template<typename T>
+	T readFromEntry(const uint8* data, size_t offset)
+	{
+		T value;
+		memcpy(&value, &data[offset], sizeof(T));
+		return value;
+	}
+}
+
+
+void SpriteImageCache::removeUnusedCacheFiles(const std::vector<std::wstring>& spritesPaths)
+{
+	std::unordered_set<std::wstring> usedFilenames;
+	for (const std::wstring& spritesPath : spritesPaths)
+	{
+		usedFilenames.insert(getCacheFilename(spritesPath));
+	}
+
+	std::vector<rmx::FileIO::FileEntry> fileEntries;
+	FTX::FileSystem->listFilesByMask(getCacheDirectory() + L"*.bin", false, fileEntries);
+	for (const rmx::FileIO::FileEntry& fileEntry : fileEntries)
+	{
+		if (usedFilenames.count(fileEntry.mFilename) == 0)
+		{
+			RMX_LOG_INFO("Removing unused sprite image cache file '" << *WString(fileEntry.mFilename).toString() << "'");
+			FTX::FileSystem->removeFile(fileEntry.mPath + fileEntry.mFilename);
+		}
+	}
+}
+
+SpriteImageCache::SpriteImageCache(const std::wstring& spritesPath, bool enabled) :
+	mEnabled(enabled)
+{
+	if (!mEnabled)
+		return;
+
+	mCacheFilename = getCacheDirectory() + getCacheFilename(spritesPath);
+	if (!FTX::FileSystem->readFile(mCacheFilename, mFileContent))
+		return;
+
+	// Only build the index here, the actual entry content stays in the file content buffer until needed
+	VectorBinarySerializer serializer(true, mFileContent);
+	char signature[4] = { 0 };
+	serializer.read(signature, 4);
+	if (memcmp(signature, CACHE_FILE_SIGNATURE, 4) != 0 || serializer.read<uint16>() != CACHE_FILE_FORMAT_VERSION)
+	{
+		mFileContent.clear();
+		mChanged = true;	// Replace the outdated file
+		return;
+	}
+
+	const uint32 numEntries = serializer.read<uint32>();
+	for (uint32 k = 0; k < numEntries; ++k)
+	{
+		const uint64 key = serializer.read<uint64>();
+		const uint32 size = serializer.read<uint32>();
+		if (serializer.hasError() || serializer.getRemaining() < size)
+		{
+			RMX_LOG_WARNING("Sprite image cache file '" << *WString(mCacheFilename).toString() << "' is broken and will be replaced");
+			mEntries.clear();
+			mFileContent.clear();
+			mChanged = true;
+			return;
+		}
+
+		Entry& entry = mEntries[key];
+		entry.mData = mFileContent.data() + serializer.getReadPosition();
+		entry.mSize = size;
+		serializer.skip(size);
+	}
+}
+
+bool SpriteImageCache::loadPaletteBitmap(PaletteBitmap& bitmap, std::vector<uint32>& outPalette, const std::wstring& filename)
+{
+	if (!mEnabled)
+		return FileHelper::loadPaletteBitmap(bitmap, filename, &outPalette);
+
+	std::vector<uint8> content;
+	if (!FTX::FileSystem->readFile(filename, content))
+		return FileHelper::loadPaletteBitmap(bitmap, filename, &outPalette);	// For the error output
+
+	const uint64 key = buildKey(content, EntryType::PALETTE_BITMAP);
+	const Entry* entry = findEntry(key);
+	if (nullptr != entry && entry->mSize >= 10)
+	{
+		// Layout: width, height, number of palette colors, palette colors, pixels
+		const uint32 width = readFromEntry<uint32>(entry->mData, 0);
+		const uint32 height = readFromEntry<uint32>(entry->mData, 4);
+		const size_t numColors = readFromEntry<uint16>(entry->mData, 8);
+		const size_t numPixels = (size_t)width * height;
+		if (entry->mSize == 10 + numColors * sizeof(uint32) + numPixels)
+		{
+			outPalette.resize(numColors);
+			memcpy(outPalette.data(), &entry->mData[10], numColors * sizeof(uint32));
+			bitmap.create(width, height);
+			memcpy(bitmap.getData(), &entry->mData[10 + numColors * sizeof(uint32)], numPixels);
+			return true;
+		}
+	}
+
+	if (!FileHelper::decodePaletteBitmap(bitmap, content, filename, &outPalette))
+		return false;
+
+	std::vector<uint8> data;
+	VectorBinarySerializer serializer(false, data);
+	serializer.write<uint32>(bitmap.getWidth());
+	serializer.write<uint32>(bitmap.getHeight());
+	serializer.writeAs<uint16>(outPalette.size());
+	serializer.write(outPalette.data(), outPalette.size() * sizeof(uint32));
+	serializer.write(bitmap.getData(), (size_t)bitmap.getPixelCount());
+	addEntry(key, std::move(data));
+	return true;
+}
+
+bool SpriteImageCache::loadBitmap(Bitmap& bitmap, const std::wstring& filename)
+{
+	if (!mEnabled)
+		return FileHelper::loadBitmap(bitmap, filename);
+
+	std::vector<uint8> content;
+	if (!FTX::FileSystem->readFile(filename, content))
+		return FileHelper::loadBitmap(bitmap, filename);	// For the error output
+
+	const uint64 key = buildKey(content, EntryType::BITMAP);
+	const Entry* entry = findEntry(key);
+	if (nullptr != entry && entry->mSize >= 8)
+	{
+		// Layout: width, height, pixels
+		const uint32 width = readFromEntry<uint32>(entry->mData, 0);
+		const uint32 height = readFromEntry<uint32>(entry->mData, 4);
+		const size_t numBytes = (size_t)width * height * sizeof(uint32);
+		if (entry->mSize == 8 + numBytes)
+		{
+			bitmap.create(width, height);
+			memcpy(bitmap.getData(), &entry->mData[8], numBytes);
+			return true;
+		}
+	}
+
+	if (!FileHelper::decodeBitmap(bitmap, content, filename))
+		return false;
+
+	std::vector<uint8> data;
+	VectorBinarySerializer serializer(false, data);
+	serializer.write<uint32>(bitmap.getWidth());
+	serializer.write<uint32>(bitmap.getHeight());
+	serializer.write(bitmap.getData(), (size_t)bitmap.getPixelCount() * sizeof(uint32));
+	addEntry(key, std::move(data));
+	return true;
+}
+
+void SpriteImageCache::save()
+{
+	if (!mEnabled)
+		return;
+
+	// Entries that were not requested belong to sprite files that were removed or changed
+	for (const auto& pair : mEntries)
+	{
+		if (!pair.second.mUsed)
+		{
+			mChanged = true;
+			break;
+		}
+	}
+	if (!mChanged)
+		return;
+
+	std::vector<uint8> buffer;
+	VectorBinarySerializer serializer(false, buffer);
+	serializer.write(CACHE_FILE_SIGNATURE, 4);
+	serializer.write(CACHE_FILE_FORMAT_VERSION);
+
+	uint32 numEntries = 0;
+	for (const auto& pair : mEntries)
+	{
+		if (pair.second.mUsed)
+			++numEntries;
+	}
+	serializer.write(numEntries);
+
+	for (const auto& pair : mEntries)
+	{
+		const Entry& entry = pair.second;
+		if (!entry.mUsed)
+			continue;
+
+		serializer.write(pair.first);
+		serializer.writeAs<uint32>(entry.mSize);
+		serializer.write(entry.mData, entry.mSize);
+	}
+
+	FTX::FileSystem->createDirectory(getCacheDirectory());
+	FTX::FileSystem->saveFile(mCacheFilename, buffer);
+	mChanged = false;
+}
+
+uint64 SpriteImageCache::buildKey(const std::vector<uint8>& content, EntryType entryType)
+{
+	uint64 hash = rmx::startFNV1a_64();
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&entryType, sizeof(entryType));
+	if (!content.empty())
+	{
+		hash = rmx::addToFNV1a_64(hash, &content[0], content.size());
+	}
+	return hash;
+}
+
+const SpriteImageCache::Entry* SpriteImageCache::findEntry(uint64 key)
+{
+	Entry* entry = mapFind(mEntries, key);
+	if (nullptr == entry)
+		return nullptr;
+
+	entry->mUsed = true;
+	return entry;
+}
+
+void SpriteImageCache::addEntry(uint64 key, std::vector<uint8>&& data)
+{
+	Entry& entry = mEntries[key];
+	entry.mOwnData = std::move(data);
+	entry.mData = entry.mOwnData.data();
+	entry.mSize = entry.mOwnData.size();
+	entry.mUsed = true;
+	mChanged = true;
+}
@@ -0,0 +1,61 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <rmxbase.h>
+
+
+// On-disk cache of decoded sprite images, so that sprite files don't need to get decoded again on each start
+//  - There is one cache file per sprites directory (i.e. for the base game and for each mod), which gets read in one go
+//  - Entries are content-addressed: the key is a hash over the source image file, so changed files are detected without relying on file times
+//  - Entries only get decoded from the loaded cache file content when actually requested
+//  - The cache file gets rewritten if entries were added or are not used any more
+//  - Cache files are named by a hash of their sprites directory path, so files of removed mods can be identified and deleted
+class SpriteImageCache
+{
+public:
+	// Deletes all cache files that don't belong to any of the given sprites directories
+	static void removeUnusedCacheFiles(const std::vector<std::wstring>& spritesPaths);
+
+public:
+	SpriteImageCache(const std::wstring& spritesPath, bool enabled);
+
+	bool loadPaletteBitmap(PaletteBitmap& bitmap, std::vector<uint32>& outPalette, const std::wstring& filename);
+	bool loadBitmap(Bitmap& bitmap, const std::wstring& filename);
+
+	void save();
+
+private:
+	enum class EntryType : uint8
+	{
+		PALETTE_BITMAP = 0,
+		BITMAP = 1
+	};
+
+	struct Entry
+	{
+		const uint8* mData = nullptr;		// Points into either the loaded file content, or the entry's own data
+		size_t mSize = 0;
+		std::vector<uint8> mOwnData;		// Only for entries added in this session
+		bool mUsed = false;
+	};
+
+private:
+	static uint64 buildKey(const std::vector<uint8>& content, EntryType entryType);
+
+	const Entry* findEntry(uint64 key);
+	void addEntry(uint64 key, std::vector<uint8>&& data);
+
+private:
+	const bool mEnabled;
+	std::wstring mCacheFilename;
+	std::vector<uint8> mFileContent;
+	std::unordered_map<uint64, Entry> mEntries;
+	bool mChanged = false;
+};
@@ -12,7 +12,6 @@
 #include "oxygen/simulation/LemonScriptProgram.h"
 #include "oxygen/simulation/LogDisplay.h"
 #include "oxygen/simulation/Simulation.h"
-#include "oxygen/application/Application.h"
 #include "oxygen/application/Configuration.h"
 #include "oxygen/application/EngineMain.h"
 #include "oxygen/application/GameProfile.h"
@@ -355,6 +354,24 @@ bool CodeExec::reloadScripts(bool enforceFullReload, bool retainRuntimeState)
 	return (result != LemonScriptProgram::LoadScriptsResult::FAILED);
 }
 
+LemonScriptProgram::LoadScriptsResult CodeExec::reloadChangedScripts()
+{
+	// Unlike "reloadScripts", this keeps the runtime state and execution state as they are
+	LemonScriptProgram::LoadOptions options;
+	options.mModuleSelection = EngineMain::getDelegate().mayLoadScriptMods() ? LemonScriptProgram::LoadOptions::ModuleSelection::ALL_MODS : LemonScriptProgram::LoadOptions::ModuleSelection::BASE_GAME_ONLY;
+	options.mAppVersion = EngineMain::getDelegate().getAppMetaData().mBuildVersionNumber;
+
+	std::vector<const lemon::ScriptFunction*> changedFunctions;
+	const LemonScriptProgram::LoadScriptsResult result = mLemonScriptProgram.reloadChangedScripts(options, changedFunctions);
+	if (result == LemonScriptProgram::LoadScriptsResult::PROGRAM_CHANGED)
+	{
+		lemon::Runtime::setActiveEnvironment(&mRuntimeEnvironment);
+		mLemonScriptRuntime.onFunctionsUpdated(changedFunctions);
+		cleanScriptDebug();
+	}
+	return result;
+}
+
 void CodeExec::restoreRuntimeState(bool hasSaveState)
 {
 	if (mSerializedRuntimeState.empty())
@@ -475,7 +492,7 @@ bool CodeExec::performFrameUpdate()
 			// Reset call frame tracking
 			mMainCallFrameTracking.clear();
 
-			static std::vector<const lemon::Function*> callstack;	// This is static to avoid reallocations
+			thread_local std::vector<const lemon::Function*> callstack;	// Kept between calls to avoid reallocations, and thread-local for simulations running in parallel
 			mLemonScriptRuntime.getCallStack(callstack);
 			for (const lemon::Function* func : callstack)
 			{
@@ -691,9 +708,9 @@ void CodeExec::runScript(bool executeSingleFunction, CallFrameTracking* callFram
 				if (showMessageBox)
 				{
 					bool gameRecordingSaved = false;
-					if (Application::instance().getSimulation().getGameRecorder().isRecording())
+					if (Simulation::instance().getGameRecorder().isRecording())
 					{
-						gameRecordingSaved = (Application::instance().getSimulation().saveGameRecording() != 0);
+						gameRecordingSaved = (Simulation::instance().saveGameRecording() != 0);
 					}
 
 					showErrorWithScriptLocation("Reached limit for runtime steps per update; if this happens, the program probably got stuck in a loop.", gameRecordingSaved ? "A game recording file was written that could be helpful for debugging this issue." : "");
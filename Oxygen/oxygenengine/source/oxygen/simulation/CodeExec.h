@@ -9,6 +9,7 @@
 #pragma once
 
 #include "oxygen/simulation/DebuggingInterfaces.h"
+#include "oxygen/simulation/LemonScriptProgram.h"
 #include "oxygen/simulation/LemonScriptRuntime.h"
 #include "oxygen/simulation/RuntimeEnvironment.h"
 #include "oxygen/simulation/debug/DebugTracking.h"
@@ -101,6 +102,7 @@ public:
 
 	void cleanScriptDebug();
 	bool reloadScripts(bool enforceFullReload, bool retainRuntimeState);
+	LemonScriptProgram::LoadScriptsResult reloadChangedScripts();
 	void restoreRuntimeState(bool hasSaveState);
 	void reinitRuntime(const LemonScriptRuntime::CallStackWithLabels* enforcedCallStack, CallStackInitPolicy callStackInitPolicy, const std::vector<uint8>* serializedRuntimeState = nullptr);
 
@@ -170,5 +172,5 @@ private:
 	std::vector<uint32> mUnknownAddressesInOrder;
 
 private:
-	static inline CodeExec* mActiveInstance = nullptr;
+	static inline thread_local CodeExec* mActiveInstance = nullptr;
 };
@@ -77,6 +77,9 @@ namespace emulatorinterface
 						mSharedMemoryUsage |= (1ull << uint64(address >> 14));
 					else
 						mSharedMemoryUsage |= (3ull << uint64(address >> 14));	// Assmuming size is smaller than 16 KB
+
+					if (size > 0)
+						mSharedMemoryDirtyPages.setBitsInRange(address >> 10, (address + size - 1) >> 10);
 				}
 				return &mSharedMemory[address];
 			}
@@ -84,7 +87,7 @@ namespace emulatorinterface
 			{
 				//if ((address & 0xfffff0) == 0xc00000)
 				//	_asm nop;
-				static uint64 dummy;
+				thread_local uint64 dummy;
 				dummy = 0;
 				return (uint8*)&dummy;
 			}
@@ -131,6 +134,9 @@ void RuntimeMemory::clear()
 	mVRamChangeBits.setAllBits();		// Count all VRAM as changed
 	memset(mSharedMemory, 0, sizeof(mSharedMemory));
 	mSharedMemoryUsage = 0;
+	mVRamDirtyPages.setAllBits();
+	mSharedMemoryDirtyPages.setAllBits();
+	mDirtyPagesReferenceId = 0;
 	memset(mRegisters, 0, sizeof(mRegisters));
 	mRegisters[15] = GameProfile::instance().mAsmStackRange.second;   // Initialization of A7 (just leaving it 0 is no good idea)
 }
@@ -200,6 +206,7 @@ void EmulatorInterface::clearSharedMemory()
 {
 	memset(mInternal.mSharedMemory, 0, sizeof(mInternal.mSharedMemory));
 	mInternal.mSharedMemoryUsage = 0;
+	mInternal.mSharedMemoryDirtyPages.setAllBits();
 }
 
 bool EmulatorInterface::isValidMemoryRegion(uint32 address, uint32 size)
@@ -332,6 +339,7 @@ void EmulatorInterface::writeVRam16(uint16 vramAddress, uint16 value)
 
 	// Mark as changed
 	mInternal.mVRamChangeBits.setBit(vramAddress >> 5);
+	mInternal.mVRamDirtyPages.setBit(vramAddress >> 10);
 }
 
 void EmulatorInterface::fillVRam(uint16 vramAddress, uint16 fillValue, uint16 bytes)
@@ -347,9 +355,7 @@ void EmulatorInterface::fillVRam(uint16 vramAddress, uint16 fillValue, uint16 by
 	}
 
 	// Mark as changed
-	const size_t bitIndexStart = (vramAddress >> 5);
-	const size_t bitIndexEnd = ((vramAddress + bytes - 1) >> 5);
-	mInternal.mVRamChangeBits.setBitsInRange(bitIndexStart, bitIndexEnd);
+	markVRamChanged(vramAddress, bytes);
 }
 
 void EmulatorInterface::copyFromMemoryToVRam(uint16 vramAddress, uint32 sourceAddress, uint16 bytes)
@@ -366,9 +372,17 @@ void EmulatorInterface::copyFromMemoryToVRam(uint16 vramAddress, uint32 sourceAd
 	}
 
 	// Mark as changed
-	const size_t bitIndexStart = (vramAddress >> 5);
-	const size_t bitIndexEnd = ((vramAddress + bytes - 1) >> 5);
-	mInternal.mVRamChangeBits.setBitsInRange(bitIndexStart, bitIndexEnd);
+	markVRamChanged(vramAddress, bytes);
+}
+
+void EmulatorInterface::markVRamChanged(uint16 vramAddress, uint16 bytes)
+{
+	if (bytes == 0)
+		return;
+
+	const size_t lastAddress = std::min<size_t>((size_t)vramAddress + bytes, sizeof(mInternal.mVRam)) - 1;
+	mInternal.mVRamChangeBits.setBitsInRange(vramAddress >> 5, lastAddress >> 5);
+	mInternal.mVRamDirtyPages.setBitsInRange(vramAddress >> 10, lastAddress >> 10);
 }
 
 BitArray<0x800>& EmulatorInterface::getVRamChangeBits()
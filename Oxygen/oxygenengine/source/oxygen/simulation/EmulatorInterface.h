@@ -27,6 +27,9 @@ struct RuntimeMemory
 	uint16 mVSRam[0x40] = { 0 };			// Buffer for vertical scroll offsets
 	uint8 mSharedMemory[0x100000] = { 0 };	// 1 MB of additional shared memory between script and C++ (usage similar to RAM, but not used by original code, obviously)
 	uint64 mSharedMemoryUsage = 0;			// Each bit represents 16 KB of shared memory and tells us if anything non-zero is written there at all
+	BitArray<0x40> mVRamDirtyPages;			// Each bit represents 1 KB of VRAM; a bit is set if the respective page got written since the last delta save state reference
+	BitArray<0x400> mSharedMemoryDirtyPages;	// Each bit represents 1 KB of shared memory; same as above
+	uint32 mDirtyPagesReferenceId = 0;		// ID of the delta save state reference that the dirty pages refer to, or 0 if they are not valid
 	uint32 mRegisters[16] = { 0 };			// Registers
 	bool mFlagZ = false;					// Zero flag
 	bool mFlagN = false;					// Negative flag
@@ -36,7 +39,7 @@ struct RuntimeMemory
 };
 
 
-class EmulatorInterface : public SingleInstance<EmulatorInterface>, public lemon::MemoryAccessHandler
+class EmulatorInterface : public PerThreadInstance<EmulatorInterface>, public lemon::MemoryAccessHandler
 {
 public:
 	enum class Register
@@ -109,6 +112,7 @@ public:
 	void writeVRam16(uint16 vramAddress, uint16 value);
 	void fillVRam(uint16 vramAddress, uint16 fillValue, uint16 bytes);
 	void copyFromMemoryToVRam(uint16 vramAddress, uint32 sourceAddress, uint16 bytes);
+	void markVRamChanged(uint16 vramAddress, uint16 bytes);		// Needed after writing to VRAM directly
 	BitArray<0x800>& getVRamChangeBits();
 
 	// VSRAM = Vertical scroll RAM
@@ -13,11 +13,89 @@
 #include "oxygen/helper/FileHelper.h"
 
 
+namespace
+{
+	// Differential keyframe data is a sequence of runs, each consisting of:
+	//  - uint32: Number of bytes to copy from the anchor data
+	//  - uint32: Number of literal bytes that follow
+	//  - The literal bytes
+	// Comparison is done in blocks of 8 bytes, which is a lot faster than per byte and barely makes a difference in size
+	void encodeDifference(std::vector<uint8>& output, const std::vector<uint8>& anchorData, const std::vector<uint8>& data)
+	{
+		output.clear();
+		const size_t comparableSize = std::min(anchorData.size(), data.size()) & ~(size_t)7;
+
+		size_t position = 0;
+		while (position < data.size())
+		{
+			const size_t copyStart = position;
+			while (position < comparableSize && memcmp(&anchorData[position], &data[position], 8) == 0)
+				position += 8;
+
+			const size_t literalStart = position;
+			while (position < comparableSize && memcmp(&anchorData[position], &data[position], 8) != 0)
+				position += 8;
+			if (position >= comparableSize)
+				position = data.size();		// Remaining bytes can't be compared, so they're literal
+
+			const uint32 copyLength = (uint32)(literalStart - copyStart);
+			const uint32 literalLength = (uint32)(position - literalStart);
+			const size_t outputPosition = output.size();
+			output.resize(outputPosition + 8 + literalLength);
+			memcpy(&output[outputPosition], &copyLength, 4);
+			memcpy(&output[outputPosition + 4], &literalLength, 4);
+			if (literalLength > 0)
+				memcpy(&output[outputPosition + 8], &data[literalStart], literalLength);
+		}
+	}
+
+	bool decodeDifference(std::vector<uint8>& output, const std::vector<uint8>& anchorData, const std::vector<uint8>& difference)
+	{
+		output.clear();
+		size_t position = 0;
+		while (position + 8 <= difference.size())
+		{
+			uint32 copyLength;
+			uint32 literalLength;
+			memcpy(&copyLength, &difference[position], 4);
+			memcpy(&literalLength, &difference[position + 4], 4);
+			position += 8;
+
+			const size_t outputPosition = output.size();
+			if (outputPosition + copyLength > anchorData.size() || position + literalLength > difference.size())
+				return false;
+
+			output.resize(outputPosition + copyLength + literalLength);
+			if (copyLength > 0)
+				memcpy(&output[outputPosition], &anchorData[outputPosition], copyLength);
+			if (literalLength > 0)
+				memcpy(&output[outputPosition + copyLength], &difference[position], literalLength);
+			position += literalLength;
+		}
+		return (position == difference.size());
+	}
+}
+
+
 GameRecorder::GameRecorder()
 {
 	updateFromConfig();
 }
 
+GameRecorder::~GameRecorder()
+{
+	if (nullptr != mWorkerThread)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mWorkerMutex);
+			mStopWorker = true;
+		}
+		mWorkerWakeUp.notify_one();
+		mWorkerThread->join();
+		delete mWorkerThread;
+	}
+}
+
 void GameRecorder::updateFromConfig()
 {
 	Configuration& config = Configuration::instance();
@@ -44,11 +122,16 @@ void GameRecorder::updateFromConfig()
 
 void GameRecorder::clear()
 {
+	waitForAllKeyframes();
+	mAnchorBufferNumber = 0xffffffff;
+	mWorkerAnchorNumber = 0xffffffff;
+
 	mFrames.clear();
 	mFrameNoDataPool.clear();
 	mFrameWithDataPool.clear();
 	mRangeStart = 0;
 	mRangeEnd = 0;
+	mDeltaReference = SaveStateSerializer::DeltaReference();
 }
 
 void GameRecorder::addFrame(uint32 frameNumber, const InputData& input)
@@ -65,12 +148,37 @@ void GameRecorder::addFrame(uint32 frameNumber, const InputData& input)
 	addFrameInternal(frameNumber, input, Frame::Type::INPUT_ONLY);
 }
 
-void GameRecorder::addKeyFrame(uint32 frameNumber, const InputData& input, const std::vector<uint8>& data)
+void GameRecorder::addKeyFrame(uint32 frameNumber, const InputData& input, const std::vector<uint8>& data, uint32 deltaReferenceId)
 {
 	RMX_ASSERT(frameNumber >= mRangeStart && frameNumber <= mRangeEnd, "Invalid frame number");
-	Frame& frame = addFrameInternal(frameNumber, input, Frame::Type::KEYFRAME);
-	frame.mType = Frame::Type::KEYFRAME;
-	frame.mData = data;
+
+	// Only copy the data here, the actual encoding is done by the worker thread
+	//  -> Whether this becomes a differential keyframe has to be decided right away, as the frame types are needed e.g. for discarding old frames
+	const Frame* anchor = findAnchorKeyframe(frameNumber);
+	Frame& frame = addFrameInternal(frameNumber, input, (nullptr != anchor) ? Frame::Type::DIFFERENTIAL : Frame::Type::KEYFRAME);
+	frame.mAnchorNumber = (nullptr != anchor) ? anchor->mNumber : 0;
+	frame.mDeltaReferenceId = (nullptr == anchor) ? deltaReferenceId : 0;
+	enqueueKeyframe(frame, anchor, data);
+}
+
+void GameRecorder::addDeltaKeyFrame(uint32 frameNumber, const InputData& input, const std::vector<uint8>& deltaState)
+{
+	RMX_ASSERT(getKeyframeCapture(frameNumber) == KeyframeCapture::DELTA_STATE, "Delta save state can't be used for this keyframe");
+	const Frame* anchor = findAnchorKeyframe(frameNumber);
+	Frame& frame = addFrameInternal(frameNumber, input, Frame::Type::DIFFERENTIAL);
+	frame.mAnchorNumber = anchor->mNumber;
+	frame.mDeltaState = true;
+	enqueueKeyframe(frame, anchor, deltaState);
+}
+
+GameRecorder::KeyframeCapture GameRecorder::getKeyframeCapture(uint32 frameNumber) const
+{
+	const Frame* anchor = findAnchorKeyframe(frameNumber);
+	if (nullptr == anchor)
+		return KeyframeCapture::NEW_ANCHOR;
+
+	// Delta save states can't be used any more once the anchor got replaced, or e.g. after a save state was loaded in the meantime
+	return (mDeltaReference.isValid() && anchor->mDeltaReferenceId == mDeltaReference.mId) ? KeyframeCapture::DELTA_STATE : KeyframeCapture::FULL_STATE;
 }
 
 void GameRecorder::discardOldFrames(uint32 minKeepNumber)
@@ -85,6 +193,13 @@ void GameRecorder::discardOldFrames(uint32 minKeepNumber)
 		}
 	}
 
+	// Differential keyframes can't be kept without their anchors
+	for (size_t index = firstIndexToKeep; index < mFrames.size(); ++index)
+	{
+		if (mFrames[index]->mType == Frame::Type::DIFFERENTIAL)
+			firstIndexToKeep = std::min<size_t>(firstIndexToKeep, mFrames[index]->mAnchorNumber - mRangeStart);
+	}
+
 	// Go back to the last keyframe, as we can't keep dependent frames whose keyframes get discarded
 	for (; firstIndexToKeep > 0; --firstIndexToKeep)
 	{
@@ -97,6 +212,7 @@ void GameRecorder::discardOldFrames(uint32 minKeepNumber)
 		for (size_t index = 0; index < firstIndexToKeep; ++index)
 		{
 			Frame& frame = *mFrames[index];
+			waitForKeyframe(frame);
 			if (frame.mType == Frame::Type::INPUT_ONLY)
 				mFrameNoDataPool.returnObject(frame);
 			else
@@ -114,6 +230,11 @@ void GameRecorder::discardFramesAfter(uint32 frameNumber)
 	if (frameNumber < mRangeStart || frameNumber + 1 >= mRangeEnd)
 		return;
 
+	// Frame numbers are going to be reused, so make sure the worker thread is done with all of them
+	waitForAllKeyframes();
+	mAnchorBufferNumber = 0xffffffff;
+	mWorkerAnchorNumber = 0xffffffff;
+
 	mRangeEnd = frameNumber + 1;
 	mFrames.erase(mFrames.begin() + (mRangeEnd - mRangeStart), mFrames.end());
 }
@@ -121,7 +242,7 @@ void GameRecorder::discardFramesAfter(uint32 frameNumber)
 bool GameRecorder::isKeyframe(uint32 frameNumber) const
 {
 	const Frame* frame = getFrameInternal(frameNumber);
-	return (nullptr != frame && frame->mType == Frame::Type::KEYFRAME);
+	return (nullptr != frame && frame->mType != Frame::Type::INPUT_ONLY);
 }
 
 bool GameRecorder::getFrameData(uint32 frameNumber, PlaybackResult& outResult)
@@ -132,10 +253,10 @@ bool GameRecorder::getFrameData(uint32 frameNumber, PlaybackResult& outResult)
 
 	outResult.mInput = &frame->mInput;
 
-	if (frame->mType == Frame::Type::KEYFRAME)
+	if (frame->mType != Frame::Type::INPUT_ONLY)
 	{
-		// TODO: Handle "frame.mCompressedData == true" (not needed for pure playback after loading from file)
-		outResult.mData = &frame->mData;
+		waitForKeyframe(*frame);
+		outResult.mData = &getKeyframeData(*frame);
 	}
 	return true;
 }
@@ -177,11 +298,15 @@ GameRecorder::Frame& GameRecorder::createFrameInternal(Frame::Type frameType, ui
 	frame.mInput = InputData();
 	frame.mCompressedData = false;
 	frame.mData.clear();
+	frame.mAnchorNumber = 0;
+	frame.mDeltaReferenceId = 0;
+	frame.mDeltaState = false;
 	return frame;
 }
 
 void GameRecorder::destroyFrame(Frame& frame)
 {
+	waitForKeyframe(frame);
 	if (frame.mType == Frame::Type::INPUT_ONLY)
 		mFrameNoDataPool.returnObject(frame);
 	else
@@ -198,6 +323,205 @@ const GameRecorder::Frame* GameRecorder::getFrameInternal(uint32 frameNumber) co
 	return hasFrameNumber(frameNumber) ? mFrames[frameNumber - mRangeStart] : nullptr;
 }
 
+const GameRecorder::Frame* GameRecorder::findAnchorKeyframe(uint32 frameNumber) const
+{
+	// Use the most recent full keyframe, unless there's too many differential keyframes in between already
+	int numKeyframes = 0;
+	for (uint32 number = frameNumber; number > mRangeStart; )
+	{
+		--number;
+		const Frame& frame = *mFrames[number - mRangeStart];
+		if (frame.mType == Frame::Type::KEYFRAME)
+			return (numKeyframes + 1 < FULL_KEYFRAME_INTERVAL) ? &frame : nullptr;
+		if (frame.mType == Frame::Type::DIFFERENTIAL)
+			++numKeyframes;
+	}
+	return nullptr;
+}
+
+const std::vector<uint8>& GameRecorder::getKeyframeData(const Frame& frame)
+{
+	if (frame.mType == Frame::Type::DIFFERENTIAL)
+	{
+		const Frame* anchor = getFrameInternal(frame.mAnchorNumber);
+		RMX_CHECK(nullptr != anchor && anchor->mType == Frame::Type::KEYFRAME, "Anchor of differential keyframe " << frame.mNumber << " is missing", mReconstructedData.clear(); return mReconstructedData);
+
+		const std::vector<uint8>* anchorData = &anchor->mData;
+		if (anchor->mCompressedData)
+		{
+			// Consecutive differential keyframes usually share the same anchor, so keep its decoded data around
+			if (mAnchorBufferNumber != anchor->mNumber)
+			{
+				mAnchorBuffer.clear();
+				ZlibDeflate::decode(mAnchorBuffer, anchor->mData.data(), anchor->mData.size());
+				mAnchorBufferNumber = anchor->mNumber;
+			}
+			anchorData = &mAnchorBuffer;
+		}
+		const std::vector<uint8>* difference = &frame.mData;
+		if (frame.mCompressedData)
+		{
+			mDifferenceBuffer.clear();
+			ZlibDeflate::decode(mDifferenceBuffer, frame.mData.data(), frame.mData.size());
+			difference = &mDifferenceBuffer;
+		}
+		const bool success = frame.mDeltaState ? SaveStateSerializer::buildFullState(mReconstructedData, *difference, anchor->mDeltaReferenceId, *anchorData)
+											   : decodeDifference(mReconstructedData, *anchorData, *difference);
+		RMX_CHECK(success, "Invalid data in differential keyframe " << frame.mNumber, mReconstructedData.clear());
+		return mReconstructedData;
+	}
+	else if (frame.mCompressedData)
+	{
+		// Full keyframes are usually anchors as well, so use the same buffer
+		if (mAnchorBufferNumber != frame.mNumber)
+		{
+			mAnchorBuffer.clear();
+			ZlibDeflate::decode(mAnchorBuffer, frame.mData.data(), frame.mData.size());
+			mAnchorBufferNumber = frame.mNumber;
+		}
+		return mAnchorBuffer;
+	}
+	else
+	{
+		return frame.mData;
+	}
+}
+
+void GameRecorder::enqueueKeyframe(Frame& frame, const Frame* anchor, const std::vector<uint8>& data)
+{
+	// Wait if the worker thread is lagging behind too far; this does not happen with usual keyframe frequencies
+	const size_t writePosition = mQueueWritePosition.load(std::memory_order_relaxed);
+	while (writePosition - mQueueReadPosition.load(std::memory_order_acquire) >= KEYFRAME_QUEUE_SIZE)
+	{
+		std::unique_lock<std::mutex> lock(mWorkerMutex);
+		mKeyframeDone.wait(lock, [&] { return writePosition - mQueueReadPosition.load(std::memory_order_acquire) < KEYFRAME_QUEUE_SIZE; });
+	}
+
+	PendingKeyframe& pendingKeyframe = mKeyframeQueue[writePosition % KEYFRAME_QUEUE_SIZE];
+	pendingKeyframe.mFrame = &frame;
+	pendingKeyframe.mAnchor = anchor;
+	pendingKeyframe.mData.assign(data.begin(), data.end());
+
+#if defined(PLATFORM_WEB)
+	// No worker thread here, so do everything right away
+	processKeyframe(pendingKeyframe);
+#else
+	frame.mPending.store(true, std::memory_order_relaxed);
+	mQueueWritePosition.store(writePosition + 1, std::memory_order_release);
+
+	if (nullptr == mWorkerThread)
+	{
+		mWorkerThread = new std::thread(&GameRecorder::runWorkerThread, this);
+	}
+	else
+	{
+		// Lock only to make sure the worker thread does not miss the wake-up call while going to sleep
+		{
+			std::lock_guard<std::mutex> lock(mWorkerMutex);
+		}
+		mWorkerWakeUp.notify_one();
+	}
+#endif
+}
+
+void GameRecorder::processKeyframe(PendingKeyframe& pendingKeyframe)
+{
+	Frame& frame = *pendingKeyframe.mFrame;
+	if (frame.mDeltaState)
+	{
+		// Delta save states only contain what changed since the anchor already, so they just need compression
+		frame.mData.clear();
+		ZlibDeflate::encode(frame.mData, pendingKeyframe.mData.data(), pendingKeyframe.mData.size());
+		frame.mData.shrink_to_fit();
+		frame.mCompressedData = true;
+	}
+	else if (frame.mType == Frame::Type::DIFFERENTIAL)
+	{
+		if (mWorkerAnchorNumber != frame.mAnchorNumber)
+		{
+			// The anchor was encoded before, and won't get modified until all pending keyframes are done
+			const Frame& anchor = *pendingKeyframe.mAnchor;
+			if (anchor.mCompressedData)
+			{
+				mWorkerAnchorData.clear();
+				ZlibDeflate::decode(mWorkerAnchorData, anchor.mData.data(), anchor.mData.size());
+			}
+			else
+			{
+				mWorkerAnchorData = anchor.mData;
+			}
+			mWorkerAnchorNumber = anchor.mNumber;
+		}
+
+		// The difference gets compressed as well, otherwise frames with lots of changes would need more memory than a compressed full keyframe
+		encodeDifference(mWorkerDifference, mWorkerAnchorData, pendingKeyframe.mData);
+		frame.mData.clear();
+		ZlibDeflate::encode(frame.mData, mWorkerDifference.data(), mWorkerDifference.size());
+		frame.mData.shrink_to_fit();	// The frame might have been a full keyframe before, so get rid of its capacity
+		frame.mCompressedData = true;
+	}
+	else
+	{
+		// Full keyframes are kept compressed in memory, which also spares the compression when saving the recording
+		frame.mData.clear();
+		ZlibDeflate::encode(frame.mData, pendingKeyframe.mData.data(), pendingKeyframe.mData.size());
+		frame.mData.shrink_to_fit();
+		frame.mCompressedData = true;
+
+		// This is most likely going to be the anchor for the next keyframes
+		mWorkerAnchorData.swap(pendingKeyframe.mData);
+		mWorkerAnchorNumber = frame.mNumber;
+	}
+}
+
+void GameRecorder::waitForKeyframe(const Frame& frame)
+{
+	if (frame.mPending.load(std::memory_order_acquire))
+	{
+		std::unique_lock<std::mutex> lock(mWorkerMutex);
+		mKeyframeDone.wait(lock, [&] { return !frame.mPending.load(std::memory_order_acquire); });
+	}
+}
+
+void GameRecorder::waitForAllKeyframes()
+{
+	const size_t writePosition = mQueueWritePosition.load(std::memory_order_relaxed);
+	if (mQueueReadPosition.load(std::memory_order_acquire) != writePosition)
+	{
+		std::unique_lock<std::mutex> lock(mWorkerMutex);
+		mKeyframeDone.wait(lock, [&] { return mQueueReadPosition.load(std::memory_order_acquire) == writePosition; });
+	}
+}
+
+void GameRecorder::runWorkerThread()
+{
+	size_t readPosition = mQueueReadPosition.load(std::memory_order_relaxed);
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mWorkerMutex);
+			mWorkerWakeUp.wait(lock, [&] { return mStopWorker || mQueueWritePosition.load(std::memory_order_acquire) != readPosition; });
+			if (mStopWorker)
+				return;
+		}
+
+		while (mQueueWritePosition.load(std::memory_order_acquire) != readPosition)
+		{
+			PendingKeyframe& pendingKeyframe = mKeyframeQueue[readPosition % KEYFRAME_QUEUE_SIZE];
+			processKeyframe(pendingKeyframe);
+
+			// Publish the results, the lock is needed so that waiting threads don't miss the notification
+			{
+				std::lock_guard<std::mutex> lock(mWorkerMutex);
+				pendingKeyframe.mFrame->mPending.store(false, std::memory_order_release);
+				++readPosition;
+				mQueueReadPosition.store(readPosition, std::memory_order_release);
+			}
+			mKeyframeDone.notify_all();
+		}
+	}
+}
+
 GameRecorder::Frame& GameRecorder::addFrameInternal(uint32 frameNumber, const InputData& input, Frame::Type frameType)
 {
 	Frame& frame = createFrameInternal(frameType, frameNumber);
@@ -212,12 +536,15 @@ GameRecorder::Frame& GameRecorder::addFrameInternal(uint32 frameNumber, const In
 	{
 		destroyFrame(*mFrames[frameNumber - mRangeStart]);
 		mFrames[frameNumber - mRangeStart] = &frame;
+		if (mAnchorBufferNumber == frameNumber)
+			mAnchorBufferNumber = 0xffffffff;
 	}
 	return frame;
 }
 
 bool GameRecorder::serializeRecording(VectorBinarySerializer& serializer, uint32 minDistanceBetweenKeyframes)
 {
+	waitForAllKeyframes();
 	std::vector<uint8> buffer;
 
 	// Signature and format version
@@ -316,6 +643,8 @@ bool GameRecorder::serializeRecording(VectorBinarySerializer& serializer, uint32
 		if (serializer.isReading())
 		{
 			serializer.serializeAs<uint8>(frameType);
+			if (frameType != Frame::Type::INPUT_ONLY && frameType != Frame::Type::KEYFRAME)
+				return false;
 			frame = &createFrameInternal(frameType, index);
 			mFrames.push_back(frame);
 		}
@@ -323,11 +652,12 @@ bool GameRecorder::serializeRecording(VectorBinarySerializer& serializer, uint32
 		{
 			frame = mFrames[index];
 			frameType = frame->mType;
-			if (frameType == Frame::Type::KEYFRAME)
+			if (frameType != Frame::Type::INPUT_ONLY)
 			{
 				if (index == 0 || index - lastKeyframeIndex >= minDistanceBetweenKeyframes)
 				{
-					// Save as keyframe
+					// Save as keyframe, differential keyframes get saved as full keyframes
+					frameType = Frame::Type::KEYFRAME;
 					lastKeyframeIndex = index;
 				}
 				else
@@ -380,6 +710,17 @@ bool GameRecorder::serializeRecording(VectorBinarySerializer& serializer, uint32
 					}
 				}
 			}
+			else if (frame->mType == Frame::Type::DIFFERENTIAL)
+			{
+				// Compress the reconstructed data, but keep the frame itself as it is
+				const std::vector<uint8>& data = getKeyframeData(*frame);
+				buffer.clear();
+				ZlibDeflate::encode(buffer, data.data(), data.size());
+
+				const uint32 dataSize = (uint32)buffer.size();
+				serializer.write(dataSize);
+				serializer.write(&buffer[0], dataSize);
+			}
 			else
 			{
 				if (!frame->mCompressedData)
@@ -9,6 +9,12 @@
 #pragma once
 
 #include "oxygen/application/input/InputManager.h"
+#include "oxygen/simulation/SaveStateSerializer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 class CodeExec;
 
@@ -27,14 +33,28 @@ public:
 		const std::vector<uint8>* mData = nullptr;
 	};
 
+	// How the save state for the next keyframe should get captured, see "getKeyframeCapture"
+	enum class KeyframeCapture
+	{
+		FULL_STATE,		// Full save state
+		NEW_ANCHOR,		// Full save state, and the delta reference should get updated right after it, as this becomes a new anchor
+		DELTA_STATE		// Delta save state against the delta reference, see "addDeltaKeyFrame"
+	};
+
 public:
 	GameRecorder();
+	~GameRecorder();
 
 	void updateFromConfig();
 
 	void clear();
 	void addFrame(uint32 frameNumber, const InputData& input);
-	void addKeyFrame(uint32 frameNumber, const InputData& input, const std::vector<uint8>& data);
+	void addKeyFrame(uint32 frameNumber, const InputData& input, const std::vector<uint8>& data, uint32 deltaReferenceId = 0);	// Delta reference ID is only used if this becomes a new anchor
+	void addDeltaKeyFrame(uint32 frameNumber, const InputData& input, const std::vector<uint8>& deltaState);
+
+	// Differential keyframes are captured as delta save states, as long as their anchor is the full keyframe the delta reference was taken for
+	KeyframeCapture getKeyframeCapture(uint32 frameNumber) const;
+	inline SaveStateSerializer::DeltaReference& getDeltaReference()  { return mDeltaReference; }
 
 	void discardOldFrames(uint32 minKeepNumber = 3600);
 	void discardFramesAfter(uint32 frameNumber);	// Discards all frames from the given frame number on, including that frame itself
@@ -48,9 +68,9 @@ public:
 
 	inline bool hasFrameNumber(uint32 frameNumber) const  { return frameNumber >= mRangeStart && frameNumber < mRangeEnd; }
 	inline bool canAddFrame(uint32 frameNumber) const	  { return frameNumber >= mRangeStart && frameNumber <= mRangeEnd; }
-	bool isKeyframe(uint32 frameNumber) const;
+	bool isKeyframe(uint32 frameNumber) const;		// Includes differential keyframes
 
-	bool getFrameData(uint32 frameNumber, PlaybackResult& outResult);
+	bool getFrameData(uint32 frameNumber, PlaybackResult& outResult);	// Returned data is valid until the next call
 
 	bool loadRecording(const std::wstring& filename);
 	bool saveRecording(const std::wstring& filename, uint32 minDistanceBetweenKeyframes = 0);
@@ -64,7 +84,7 @@ private:
 		{
 			INPUT_ONLY,
 			KEYFRAME,
-			//DIFFERENTIAL	// Difference to last keyframe; not implemented yet
+			DIFFERENTIAL	// Difference to an earlier full keyframe, its anchor; only used in memory, saved recordings contain full keyframes only
 		};
 
 		Type mType = Type::INPUT_ONLY;
@@ -72,14 +92,38 @@ private:
 		InputData mInput;
 		bool mCompressedData = false;
 		std::vector<uint8> mData;
+		uint32 mAnchorNumber = 0;	// Only for differential keyframes
+		uint32 mDeltaReferenceId = 0;	// Only for full keyframes: ID of the delta reference taken together with this keyframe's save state, or 0 if there's none
+		bool mDeltaState = false;	// Only for differential keyframes: Data is a delta save state instead of a difference to the anchor's data
+		std::atomic<bool> mPending = false;	// Set while the keyframe is still waiting for or being processed by the worker thread
 	};
 
+	// Keyframe that got captured by the simulation thread, but not yet encoded by the worker thread
+	struct PendingKeyframe
+	{
+		Frame* mFrame = nullptr;
+		const Frame* mAnchor = nullptr;
+		std::vector<uint8> mData;	// Uncompressed save state; capacity is kept for reuse
+	};
+	static const constexpr size_t KEYFRAME_QUEUE_SIZE = 4;
+
+	// Differential keyframes only need a fraction of the memory, but get less efficient the further away their anchor is
+	static const constexpr int FULL_KEYFRAME_INTERVAL = 16;		// Add a new full keyframe as anchor after this many keyframes
+
 private:
 	Frame& createFrameInternal(Frame::Type frameType, uint32 number);
 	void destroyFrame(Frame& frame);
 	Frame* getFrameInternal(uint32 frameNumber);
 	const Frame* getFrameInternal(uint32 frameNumber) const;
 	Frame& addFrameInternal(uint32 frameNumber, const InputData& input, Frame::Type frameType);
+	const Frame* findAnchorKeyframe(uint32 frameNumber) const;
+	const std::vector<uint8>& getKeyframeData(const Frame& frame);
+
+	void enqueueKeyframe(Frame& frame, const Frame* anchor, const std::vector<uint8>& data);
+	void processKeyframe(PendingKeyframe& pendingKeyframe);
+	void waitForKeyframe(const Frame& frame);
+	void waitForAllKeyframes();
+	void runWorkerThread();
 
 	bool serializeRecording(VectorBinarySerializer& serializer, uint32 minDistanceBetweenKeyframes);
 
@@ -94,4 +138,25 @@ private:
 	uint32 mRangeStart = 0;			// Frame number of first frame stored in mFrames
 	uint32 mRangeEnd = 0;			// Frame number of last frame stored in mFrames plus one (!)
 	bool mIgnoreKeys = false;
+
+	std::vector<uint8> mAnchorBuffer;
+	uint32 mAnchorBufferNumber = 0xffffffff;	// Frame number of the anchor keyframe whose data is currently in mAnchorBuffer
+	std::vector<uint8> mReconstructedData;
+	std::vector<uint8> mDifferenceBuffer;
+	SaveStateSerializer::DeltaReference mDeltaReference;
+
+	// Keyframe encoding and compression is done on a worker thread
+	//  -> The simulation thread is the only producer and the worker thread the only consumer, so a simple lock-free ring buffer is sufficient
+	//  -> The mutex is only used for putting the worker to sleep while there's nothing to do, and for waiting until a keyframe is done
+	PendingKeyframe mKeyframeQueue[KEYFRAME_QUEUE_SIZE];
+	std::atomic<size_t> mQueueWritePosition = 0;	// Only modified by the simulation thread
+	std::atomic<size_t> mQueueReadPosition = 0;		// Only modified by the worker thread
+	std::thread* mWorkerThread = nullptr;
+	std::mutex mWorkerMutex;
+	std::condition_variable mWorkerWakeUp;
+	std::condition_variable mKeyframeDone;
+	bool mStopWorker = false;
+	std::vector<uint8> mWorkerAnchorData;			// Uncompressed data of the last used anchor keyframe, only accessed by the worker thread while there are pending keyframes
+	uint32 mWorkerAnchorNumber = 0xffffffff;
+	std::vector<uint8> mWorkerDifference;
 };
@@ -10,6 +10,8 @@
 #include "oxygen/simulation/LemonScriptProgram.h"
 #include "oxygen/simulation/EmulatorInterface.h"
 #include "oxygen/simulation/LogDisplay.h"
+#include "oxygen/simulation/ModNativizationCache.h"
+#include "oxygen/simulation/ScriptModuleCache.h"
 #include "oxygen/application/modding/ModManager.h"
 #include "oxygen/helper/Utils.h"
 #include "oxygen/platform/PlatformFunctions.h"
@@ -21,7 +23,9 @@
 #include <lemon/program/Module.h>
 #include <lemon/program/Program.h>
 #include <lemon/runtime/StandardLibrary.h>
+#include <lemon/runtime/provider/NativizedOpcodeProvider.h>
 #include <lemon/utility/PragmaSplitter.h>
+#include <lemon/utility/WorkStealingPool.h>
 
 
 struct ModuleAppendedInfo : public lemon::Module::AppendedInfo
@@ -34,6 +38,12 @@ struct ModuleAppendedInfo : public lemon::Module::AppendedInfo
 
 struct LemonScriptProgram::Internal
 {
+	struct ModuleSource
+	{
+		std::wstring mMainScriptFilename;
+		uint64 mSourceKey = 0;		// Hash over all script files and preprocessor definitions, see "ScriptModuleCache::buildModuleKey"
+	};
+
 	lemon::Module mLemonCoreModule;
 	lemon::Module mOxygenCoreModule;
 	lemon::Module mScriptModule;
@@ -43,6 +53,12 @@ struct LemonScriptProgram::Internal
 	LemonScriptBindings	mLemonScriptBindings;
 	lemon::GlobalsLookup mGlobalsLookupCoreOnly;
 
+	lemon::NativizedOpcodeProvider* mGameNativizedOpcodeProvider = nullptr;
+	lemon::NativizedOpcodeProvider mModNativizedOpcodeProvider;		// Game's nativized code plus the native modules of script mods
+	ModNativizationCache mModNativizationCache;
+	ScriptModuleCache mScriptModuleCache;
+	std::unordered_map<const lemon::Module*, ModuleSource> mModuleSources;	// Only for modules compiled from script files, and only if incremental reloads are enabled
+
 	Hook mPreUpdateHook;
 	Hook mPostUpdateHook;
 	LinearLookupTable<Hook, 0x400000, 6, 1024> mAddressHooks;
@@ -60,6 +76,7 @@ LemonScriptProgram::LemonScriptProgram() :
 {
 	// Register game-specific nativized code
 	EngineMain::getDelegate().registerNativizedCode(mInternal.mProgram);
+	mInternal.mGameNativizedOpcodeProvider = mInternal.mProgram.mNativizedOpcodeProvider;
 
 	Configuration& config = Configuration::instance();
 	mInternal.mLemonCoreModule.clear();
@@ -119,18 +136,7 @@ LemonScriptProgram::LoadScriptsResult LemonScriptProgram::loadScripts(std::strin
 {
 	// Select script mods to load
 	std::vector<const Mod*> modsToLoad;
-	if (loadOptions.mModuleSelection == LoadOptions::ModuleSelection::ALL_MODS)
-	{
-		for (const Mod* mod : ModManager::instance().getActiveMods())
-		{
-			// Is it a script mod?
-			const std::wstring mainScriptFilename = mod->mFullPath + L"scripts/main.lemon";
-			if (FTX::FileSystem->exists(mainScriptFilename))
-			{
-				modsToLoad.push_back(mod);
-			}
-		}
-	}
+	collectModsToLoad(loadOptions, modsToLoad);
 
 	// Check if there's anything to do at all
 	const bool mainScriptReloadNeeded = (mInternal.mProgram.getModules().empty() || loadOptions.mEnforceFullReload);
@@ -164,7 +170,7 @@ LemonScriptProgram::LoadScriptsResult LemonScriptProgram::loadScripts(std::strin
 
 	// Set script optimization level
 	{
-		int scriptOptimizationLevel = clamp(config.mScriptOptimizationLevel, 0, 3);
+		int scriptOptimizationLevel = clamp(config.mScriptOptimizationLevel, 0, 4);
 		if (config.mScriptOptimizationLevel < 0)
 		{
 			// Auto-select script optimization level
@@ -186,6 +192,9 @@ LemonScriptProgram::LoadScriptsResult LemonScriptProgram::loadScripts(std::strin
 		config.mRunScriptNativization = 2;		// Mark as done
 	}
 
+	// Nativized code for script mods
+	updateModNativization(loadOptions);
+
 	// Scan for function pragmas defining hooks
 	evaluateFunctionPragmas();
 
@@ -199,6 +208,80 @@ LemonScriptProgram::LoadScriptsResult LemonScriptProgram::loadScripts(std::strin
 	return LoadScriptsResult::PROGRAM_CHANGED;
 }
 
+LemonScriptProgram::LoadScriptsResult LemonScriptProgram::reloadChangedScripts(const LoadOptions& loadOptions, std::vector<const lemon::ScriptFunction*>& outChangedFunctions)
+{
+	if (!hasValidProgram())
+		return LoadScriptsResult::FULL_RELOAD_NEEDED;
+
+	// Any change in the mod selection requires a full reload
+	std::vector<const Mod*> modsToLoad;
+	collectModsToLoad(loadOptions, modsToLoad);
+	if (modsToLoad != mInternal.mLastModSelection || mInternal.mModModules.size() != modsToLoad.size())
+		return LoadScriptsResult::FULL_RELOAD_NEEDED;
+
+	std::vector<lemon::Module*> modules;
+	modules.push_back(&mInternal.mScriptModule);
+	modules.insert(modules.end(), mInternal.mModModules.begin(), mInternal.mModModules.end());
+
+	// Recompile all modules with changes into new modules first, the program only gets changed when all of them succeeded
+	//  -> Granularity is the whole module, as the script files of a module get compiled together due to includes
+	struct RecompiledModule
+	{
+		lemon::Module* mModule = nullptr;
+		std::unique_ptr<lemon::Module> mRecompiledModule;
+		uint64 mSourceKey = 0;
+	};
+	std::vector<RecompiledModule> recompiledModules;
+
+	lemon::GlobalsLookup globalsLookup = mInternal.mGlobalsLookupCoreOnly;	// Copy the definitions from the two core modules
+	for (lemon::Module* module : modules)
+	{
+		const auto it = mInternal.mModuleSources.find(module);
+		if (it == mInternal.mModuleSources.end())
+			return LoadScriptsResult::FULL_RELOAD_NEEDED;
+
+		const Internal::ModuleSource& moduleSource = it->second;
+		const uint64 sourceKey = buildModuleSourceKey(globalsLookup, moduleSource.mMainScriptFilename);
+		if (sourceKey != moduleSource.mSourceKey)
+		{
+			// Compile against the same definitions as the existing module
+			std::unique_ptr<lemon::Module> recompiledModule = std::make_unique<lemon::Module>(module->getModuleName());
+			LoadingResult loadingResult = LoadingResult::FAILED_RETRY;
+			while (loadingResult == LoadingResult::FAILED_RETRY)
+			{
+				lemon::GlobalsLookup moduleGlobalsLookup = globalsLookup;
+				loadingResult = loadScriptModule(*recompiledModule, moduleGlobalsLookup, moduleSource.mMainScriptFilename);
+			}
+			if (loadingResult != LoadingResult::SUCCESS)
+			{
+				// Keep the existing program, so that the simulation can just go on with it
+				return LoadScriptsResult::FAILED;
+			}
+
+			if (recompiledModule->buildInterfaceHash(globalsLookup) != module->buildInterfaceHash(globalsLookup))
+				return LoadScriptsResult::FULL_RELOAD_NEEDED;
+
+			RecompiledModule& entry = vectorAdd(recompiledModules);
+			entry.mModule = module;
+			entry.mRecompiledModule = std::move(recompiledModule);
+			entry.mSourceKey = sourceKey;
+		}
+
+		// Interface is unchanged, so the existing module can be used for the following modules
+		globalsLookup.addDefinitionsFromModule(*module);
+	}
+
+	if (recompiledModules.empty())
+		return LoadScriptsResult::NO_CHANGE;
+
+	for (RecompiledModule& entry : recompiledModules)
+	{
+		entry.mModule->takeOverCompiledCode(*entry.mRecompiledModule, outChangedFunctions);
+		mInternal.mModuleSources[entry.mModule].mSourceKey = entry.mSourceKey;
+	}
+	return LoadScriptsResult::PROGRAM_CHANGED;
+}
+
 const LemonScriptProgram::Hook* LemonScriptProgram::checkForUpdateHook(bool post)
 {
 	if (post)
@@ -278,10 +361,27 @@ void LemonScriptProgram::resolveLocation(ResolvedLocation& outResolvedLocation,
 	}
 }
 
+void LemonScriptProgram::collectModsToLoad(const LoadOptions& loadOptions, std::vector<const Mod*>& outModsToLoad)
+{
+	if (loadOptions.mModuleSelection == LoadOptions::ModuleSelection::ALL_MODS)
+	{
+		for (const Mod* mod : ModManager::instance().getActiveMods())
+		{
+			// Is it a script mod?
+			const std::wstring mainScriptFilename = mod->mFullPath + L"scripts/main.lemon";
+			if (FTX::FileSystem->exists(mainScriptFilename))
+			{
+				outModsToLoad.push_back(mod);
+			}
+		}
+	}
+}
+
 LemonScriptProgram::LoadingResult LemonScriptProgram::loadAllScriptModules(const LoadOptions& loadOptions, std::string_view baseScriptFilename, const std::vector<const Mod*>& modsToLoad)
 {
 	Configuration& config = Configuration::instance();
 	lemon::GlobalsLookup globalsLookup = mInternal.mGlobalsLookupCoreOnly;	// Copy the definitions from the two core modules
+	lemon::WorkStealingPool::setMaxThreads(config.mScriptCompilerThreads);
 
 	// Clear program here already - in case compilation fails, it would be broken otherwise
 	mInternal.mProgram.clear();
@@ -292,6 +392,7 @@ LemonScriptProgram::LoadingResult LemonScriptProgram::loadAllScriptModules(const
 	if (!baseScriptFilename.empty())
 	{
 		mInternal.mScriptModule.clear();
+		mInternal.mModuleSources.erase(&mInternal.mScriptModule);
 		const uint32 coreModuleDependencyHash = mInternal.mLemonCoreModule.buildDependencyHash() + mInternal.mOxygenCoreModule.buildDependencyHash();
 
 		// Load scripts
@@ -319,13 +420,18 @@ LemonScriptProgram::LoadingResult LemonScriptProgram::loadAllScriptModules(const
 				if (FTX::FileSystem->exists(baseScriptFilename))
 				{
 					// Compile module
-					loadingResult = loadScriptModule(mInternal.mScriptModule, globalsLookup, *String(baseScriptFilename).toWString());
+					const std::wstring mainScriptFilename = *String(baseScriptFilename).toWString();
+					const uint64 sourceKey = buildModuleSourceKey(globalsLookup, mainScriptFilename);
+					loadingResult = loadScriptModule(mInternal.mScriptModule, globalsLookup, mainScriptFilename);
 
 					// If there are no script functions at all, we consider that a failure
 					scriptsLoaded = (loadingResult == LoadingResult::SUCCESS) && !mInternal.mScriptModule.getScriptFunctions().empty();
 
 					if (scriptsLoaded)
 					{
+						if (sourceKey != 0)
+							mInternal.mModuleSources[&mInternal.mScriptModule] = { mainScriptFilename, sourceKey };
+
 						if (!config.mCompiledScriptSavePath.empty())
 						{
 							// Save compiled scripts
@@ -389,26 +495,58 @@ LemonScriptProgram::LoadingResult LemonScriptProgram::loadAllScriptModules(const
 	// TODO: There might be mod script modules already loaded that should stay loaded, i.e. no actual reload is needed for these
 	{
 		for (lemon::Module* module : mInternal.mModModules)
+		{
+			mInternal.mModuleSources.erase(module);
 			delete module;
+		}
 		mInternal.mModModules.clear();
 
 		if (!modsToLoad.empty())
 		{
+			// Compiled mod script modules get cached, so that unchanged mods don't need to be compiled again
+			const bool useModScriptCache = config.mUseModScriptCache && !config.mForceCompileScripts;
+			uint32 dependencyHash = mInternal.mLemonCoreModule.buildDependencyHash() + mInternal.mOxygenCoreModule.buildDependencyHash();
+			uint64 cacheKey = useModScriptCache ? ScriptModuleCache::buildInitialKey(mInternal.mScriptModule, loadOptions.mAppVersion) : 0;
+
 			lemon::Module* previousModule = &mInternal.mScriptModule;
 			for (const Mod* mod : modsToLoad)
 			{
 				if (nullptr != previousModule)
 				{
 					globalsLookup.addDefinitionsFromModule(*previousModule);
+					dependencyHash += previousModule->buildDependencyHash();
 					previousModule = nullptr;
 				}
 
-				// Create and compile module
+				// Create module, and either load it from the cache or compile it
 				lemon::Module* module = new lemon::Module(mod->mUniqueID, new ModuleAppendedInfo(mod));
-				const std::wstring mainScriptFilename = mod->mFullPath + L"scripts/main.lemon";
-				loadingResult = loadScriptModule(*module, globalsLookup, mainScriptFilename);
+				const std::wstring scriptsPath = mod->mFullPath + L"scripts/";
+				const uint64 sourceKey = buildModuleSourceKey(globalsLookup, scriptsPath + L"main.lemon");
+				bool loadedFromCache = false;
+				if (useModScriptCache)
+				{
+					cacheKey = ScriptModuleCache::buildModuleKey(cacheKey, globalsLookup, scriptsPath);
+					loadedFromCache = mInternal.mScriptModuleCache.loadModule(*module, cacheKey, globalsLookup, dependencyHash, loadOptions.mAppVersion);
+				}
+
+				if (loadedFromCache)
+				{
+					module->setScriptBasePath(scriptsPath);
+					loadingResult = LoadingResult::SUCCESS;
+				}
+				else
+				{
+					loadingResult = loadScriptModule(*module, globalsLookup, scriptsPath + L"main.lemon");
+					if (loadingResult == LoadingResult::SUCCESS && useModScriptCache)
+					{
+						mInternal.mScriptModuleCache.saveModule(*module, cacheKey, globalsLookup, dependencyHash, loadOptions.mAppVersion);
+					}
+				}
+
 				if (loadingResult == LoadingResult::SUCCESS)
 				{
+					if (sourceKey != 0)
+						mInternal.mModuleSources[module] = { scriptsPath + L"main.lemon", sourceKey };
 					mInternal.mModModules.push_back(module);
 					previousModule = module;
 				}
@@ -517,6 +655,51 @@ LemonScriptProgram::LoadingResult LemonScriptProgram::loadScriptModule(lemon::Mo
 	return LoadingResult::FAILED_CONTINUE;
 }
 
+void LemonScriptProgram::updateModNativization(const LoadOptions& loadOptions)
+{
+	// Start with only the game's nativized code again
+	lemon::Program& program = mInternal.mProgram;
+	program.mNativizedOpcodeProvider = mInternal.mGameNativizedOpcodeProvider;
+
+	const Configuration& config = Configuration::instance();
+	if (config.mModScriptNativization <= 0 || program.getOptimizationLevel() < 2 || mInternal.mModModules.empty())
+		return;
+
+	lemon::NativizedOpcodeProvider& provider = mInternal.mModNativizedOpcodeProvider;
+	provider = (nullptr != mInternal.mGameNativizedOpcodeProvider) ? *mInternal.mGameNativizedOpcodeProvider : lemon::NativizedOpcodeProvider();
+
+	bool anyLoaded = false;
+	for (const lemon::Module* module : mInternal.mModModules)
+	{
+		if (mInternal.mModNativizationCache.loadNativeModule(provider, *module, loadOptions.mAppVersion))
+		{
+			anyLoaded = true;
+		}
+		else if (config.mModScriptNativization >= 2)
+		{
+			// Not in the cache yet, so build it for the next start
+			mInternal.mModNativizationCache.buildNativeModule(*module, program, EmulatorInterface::instance(), loadOptions.mAppVersion);
+		}
+	}
+
+	if (anyLoaded)
+	{
+		program.mNativizedOpcodeProvider = &provider;
+	}
+}
+
+uint64 LemonScriptProgram::buildModuleSourceKey(const lemon::GlobalsLookup& globalsLookup, const std::wstring& mainScriptFilename) const
+{
+	// Source keys are only needed for incremental reloads, so don't spend time on reading all script files otherwise
+	const Configuration& config = Configuration::instance();
+	if (!config.mDevMode.mEnabled || !config.mDevMode.mIncrementalScriptReload)
+		return 0;
+
+	std::wstring scriptsPath = mainScriptFilename;
+	scriptsPath.erase(scriptsPath.find_last_of(L"/\\") + 1);
+	return ScriptModuleCache::buildModuleKey(0, globalsLookup, scriptsPath);
+}
+
 void LemonScriptProgram::evaluateFunctionPragmas()
 {
 	mInternal.mAddressHooks.clear();
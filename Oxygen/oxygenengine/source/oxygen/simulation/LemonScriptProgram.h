@@ -54,7 +54,8 @@ public:
 	{
 		NO_CHANGE,
 		PROGRAM_CHANGED,
-		FAILED
+		FAILED,
+		FULL_RELOAD_NEEDED	// Only used by "reloadChangedScripts"
 	};
 
 	struct GlobalDefine
@@ -91,6 +92,12 @@ public:
 	bool hasValidProgram() const;
 	LoadScriptsResult loadScripts(std::string_view baseScriptFilename, const LoadOptions& loadOptions);
 
+	// Recompiles only the script modules with changed source files, and updates the existing program in place
+	//  - This works only if nothing changed that other code can depend on, i.e. only function bodies changed
+	//  - Otherwise, nothing gets changed and the result is FULL_RELOAD_NEEDED
+	//  - The script functions whose code changed get collected, as their runtime functions need to be rebuilt
+	LoadScriptsResult reloadChangedScripts(const LoadOptions& loadOptions, std::vector<const lemon::ScriptFunction*>& outChangedFunctions);
+
 	const Hook* checkForUpdateHook(bool post);
 	const Hook* checkForAddressHook(uint32 address);
 	size_t getNumAddressHooks() const;
@@ -116,8 +123,11 @@ private:
 	};
 
 private:
+	void collectModsToLoad(const LoadOptions& loadOptions, std::vector<const Mod*>& outModsToLoad);
 	LoadingResult loadAllScriptModules(const LoadOptions& loadOptions, std::string_view baseScriptFilename, const std::vector<const Mod*>& modsToLoad);
 	LoadingResult loadScriptModule(lemon::Module& module, lemon::GlobalsLookup& globalsLookup, const std::wstring& filename);
+	void updateModNativization(const LoadOptions& loadOptions);
+	uint64 buildModuleSourceKey(const lemon::GlobalsLookup& globalsLookup, const std::wstring& mainScriptFilename) const;
 	void evaluateFunctionPragmas();
 	void evaluateDefines();
 
@@ -147,6 +147,12 @@ void LemonScriptRuntime::onProgramUpdated()
 	mInternal.mRuntime.buildAllRuntimeFunctions();
 }
 
+void LemonScriptRuntime::onFunctionsUpdated(const std::vector<const lemon::ScriptFunction*>& scriptFunctions)
+{
+	// Only the code of these functions changed, so the runtime state including the call stack can stay as it is
+	mInternal.mRuntime.rebuildRuntimeFunctions(scriptFunctions);
+}
+
 bool LemonScriptRuntime::serializeRuntime(VectorBinarySerializer& serializer)
 {
 	return mInternal.mRuntime.serializeState(serializer);
@@ -46,6 +46,7 @@ public:
 
 	bool hasValidProgram() const;
 	void onProgramUpdated();
+	void onFunctionsUpdated(const std::vector<const lemon::ScriptFunction*>& scriptFunctions);
 
 	bool serializeRuntime(VectorBinarySerializer& serializer);
 
@@ -11,7 +11,7 @@
 #include <rmxbase.h>
 
 
-class LogDisplay : public SingleInstance<LogDisplay>
+class LogDisplay : public PerThreadInstance<LogDisplay>
 {
 friend class Application;
 
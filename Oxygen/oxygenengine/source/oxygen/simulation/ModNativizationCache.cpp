@@ -0,0 +1,332 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/simulation/ModNativizationCache.h"
+
+#include <lemon/program/Function.h>
+#include <lemon/program/Module.h>
+#include <lemon/runtime/provider/NativizedOpcodeProvider.h>
+#include <lemon/translator/Nativizer.h>
+
+#if defined(SUPPORT_MOD_NATIVIZATION)
+	#include <dlfcn.h>
+	#include <fcntl.h>
+	#include <spawn.h>
+	#include <sys/wait.h>
+	#include <unistd.h>
+
+	#include <thread>
+
+	extern char** environ;
+#endif
+
+
+namespace
+{
+	// Name of the entry point exported by the native modules
+	const char* LOOKUP_FUNCTION_NAME = "createNativizedModuleLookup";
+
+	// The nativizer output expects to be included inside the lemon namespace, see "NativizedCode.cpp" in S3AIR
+	//  -> It gets wrapped into an additional inner namespace, so that it can't clash with symbols exported by the executable
+	const char* SOURCE_PROLOGUE =
+		"#include <lemon/pch.h>\n"
+		"#include <lemon/program/Program.h>\n"
+		"#include <lemon/runtime/provider/NativizedOpcodeProvider.h>\n"
+		"#include <lemon/runtime/OpcodeExecUtils.h>\n"
+		"#include <lemon/runtime/RuntimeOpcodeContext.h>\n"
+		"\n"
+		"namespace lemon\n"
+		"{\n"
+		"namespace nativizedmodule\n"
+		"{\n";
+
+	const char* SOURCE_EPILOGUE =
+		"}\n"
+		"}\n"
+		"\n"
+		"extern \"C\" __attribute__((visibility(\"default\"))) void createNativizedModuleLookup(lemon::Nativizer::LookupDictionary& dict)\n"
+		"{\n"
+		"\tlemon::nativizedmodule::createNativizedCodeLookup(dict);\n"
+		"}\n";
+
+	std::wstring getExecutableFilename()
+	{
+	#if defined(PLATFORM_LINUX)
+		char buffer[4096];
+		const ssize_t length = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+		if (length > 0)
+		{
+			buffer[length] = 0;
+			return String(buffer).toStdWString();
+		}
+	#endif
+
+		// Fallback: The path the executable was called with, which may be relative to the working directory at startup
+		std::wstring filename = Configuration::instance().mExePath;
+		rmx::FileSystem::normalizePath(filename, false);
+		if (!filename.empty() && filename[0] != L'/')
+		{
+			std::wstring currentDirectory = rmx::FileSystem::getCurrentDirectory();
+			rmx::FileSystem::normalizePath(currentDirectory, true);
+			filename = currentDirectory + filename;
+		}
+		return filename;
+	}
+
+	// Returns the directory containing the engine sources that the native modules get compiled against, or an empty string if there's none
+	//  -> This must not depend on the working directory, as the game can be started from anywhere
+	std::wstring findEngineSourcePath()
+	{
+		static std::wstring sourcePath;
+		static bool searched = false;
+		if (searched)
+			return sourcePath;
+		searched = true;
+
+		const auto isSourcePath = [](const std::wstring& path)
+		{
+			return FTX::FileSystem->exists(path + L"Oxygen/lemonscript/source/lemon/pch.h") && FTX::FileSystem->exists(path + L"librmx/source/rmxbase.h");
+		};
+
+		std::wstring path = Configuration::instance().mModNativizationSourcePath;
+		if (!path.empty())
+		{
+			rmx::FileSystem::normalizePath(path, true);
+			if (isSourcePath(path))
+				sourcePath = path;
+			return sourcePath;
+		}
+
+		// Search upwards from the executable's directory, which is inside the source tree for a locally built game
+		rmx::FileSystem::splitPath(getExecutableFilename(), &path, nullptr, nullptr);
+		rmx::FileSystem::normalizePath(path, true);
+		for (int k = 0; k < 4 && path.length() > 1; ++k)
+		{
+			if (isSourcePath(path))
+			{
+				sourcePath = path;
+				break;
+			}
+			const size_t slashPos = path.find_last_of(L'/', path.length() - 2);
+			if (slashPos == std::wstring::npos)
+				break;
+			path.resize(slashPos + 1);
+		}
+		return sourcePath;
+	}
+
+	// Hash identifying the executable build and everything else the native modules get compiled with
+	//  -> Shared objects built for a different executable must never get loaded, as they call into it directly and depend on its exact data layouts
+	uint64 getBuildIdentityHash()
+	{
+		static uint64 buildIdentityHash = 0;
+		if (buildIdentityHash != 0)
+			return buildIdentityHash;
+
+		const std::wstring executableFilename = getExecutableFilename();
+		uint64 fileSize = 0;
+		time_t fileTime = 0;
+		rmx::FileIO::getFileSize(executableFilename, fileSize);
+		rmx::FileIO::getFileTime(executableFilename, fileTime);
+		const int64 fileTime64 = (int64)fileTime;
+
+		const Configuration& config = Configuration::instance();
+		const std::string sourcePath = WString(findEngineSourcePath()).toStdString();
+		uint64 hash = rmx::startFNV1a_64();
+		hash = rmx::addToFNV1a_64(hash, (const uint8*)&fileSize, sizeof(fileSize));
+		hash = rmx::addToFNV1a_64(hash, (const uint8*)&fileTime64, sizeof(fileTime64));
+		hash = rmx::addToFNV1a_64(hash, (const uint8*)config.mModNativizationCompiler.data(), config.mModNativizationCompiler.length());
+		hash = rmx::addToFNV1a_64(hash, (const uint8*)config.mModNativizationCompilerFlags.data(), config.mModNativizationCompilerFlags.length());
+		hash = rmx::addToFNV1a_64(hash, (const uint8*)sourcePath.data(), sourcePath.length());
+		buildIdentityHash = std::max<uint64>(hash, 1);
+		return buildIdentityHash;
+	}
+
+#if defined(SUPPORT_MOD_NATIVIZATION)
+	// Starts the compiler as a child process, with its output written to the log file
+	//  -> No shell is involved, so paths and config values get passed on as they are, no matter which characters they contain
+	//  -> Returns the child's process ID, or -1 if it could not get started
+	pid_t startCompiler(const std::vector<std::string>& arguments, const std::string& logFilename)
+	{
+		std::vector<char*> argv;
+		for (const std::string& argument : arguments)
+			argv.push_back(const_cast<char*>(argument.c_str()));
+		argv.push_back(nullptr);
+
+		posix_spawn_file_actions_t fileActions;
+		posix_spawn_file_actions_init(&fileActions);
+		posix_spawn_file_actions_addopen(&fileActions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+		posix_spawn_file_actions_addopen(&fileActions, STDOUT_FILENO, logFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		posix_spawn_file_actions_adddup2(&fileActions, STDOUT_FILENO, STDERR_FILENO);
+
+		pid_t pid = -1;
+		const int result = posix_spawnp(&pid, argv[0], &fileActions, nullptr, argv.data(), environ);
+		posix_spawn_file_actions_destroy(&fileActions);
+		return (result == 0) ? pid : -1;
+	}
+#endif
+}
+
+
+bool ModNativizationCache::loadNativeModule(lemon::NativizedOpcodeProvider& provider, const lemon::Module& module, uint32 appVersion)
+{
+#if defined(SUPPORT_MOD_NATIVIZATION)
+	const uint64 moduleHash = getModuleHash(module, appVersion);
+	void* handle = nullptr;
+
+	const auto it = mLoadedLibraries.find(moduleHash);
+	if (it != mLoadedLibraries.end())
+	{
+		handle = it->second;
+	}
+	else
+	{
+		const std::wstring filename = getCacheFilenameBase(moduleHash) + L".so";
+		if (!FTX::FileSystem->exists(filename))
+			return false;
+
+		handle = dlopen(WString(filename).toStdString().c_str(), RTLD_NOW | RTLD_LOCAL);
+		if (nullptr == handle)
+		{
+			RMX_LOG_INFO("Failed to load native module for script module '" << module.getModuleName() << "': " << dlerror());
+			return false;
+		}
+		mLoadedLibraries.emplace(moduleHash, handle);
+	}
+
+	const lemon::NativizedOpcodeProvider::BuildFunction buildFunction = (lemon::NativizedOpcodeProvider::BuildFunction)dlsym(handle, LOOKUP_FUNCTION_NAME);
+	if (nullptr == buildFunction)
+		return false;
+
+	provider.mergeLookup(buildFunction);
+	RMX_LOG_INFO("Using native module for script module '" << module.getModuleName() << "'");
+	return true;
+#else
+	return false;
+#endif
+}
+
+void ModNativizationCache::buildNativeModule(const lemon::Module& module, const lemon::Program& program, lemon::MemoryAccessHandler& memoryAccessHandler, uint32 appVersion)
+{
+#if defined(SUPPORT_MOD_NATIVIZATION)
+	const uint64 moduleHash = getModuleHash(module, appVersion);
+	const std::wstring filenameBase = getCacheFilenameBase(moduleHash);
+	if (mStartedBuilds.count(moduleHash) != 0 || FTX::FileSystem->exists(filenameBase + L".so"))
+		return;
+	mStartedBuilds.insert(moduleHash);
+
+	// Generate the C++ code
+	String code;
+	lemon::Nativizer().build(code, module, program, memoryAccessHandler);
+	if (code.findString("createNativizedCodeLookup") < 0)
+	{
+		// Nothing that could be nativized in this module
+		return;
+	}
+
+	const std::wstring sourcePath = findEngineSourcePath();
+	if (sourcePath.empty())
+	{
+		RMX_LOG_INFO("Can't build native module for script module '" << module.getModuleName() << "', as the engine sources were not found");
+		return;
+	}
+
+	const Configuration& config = Configuration::instance();
+	std::wstring directory;
+	FTX::FileSystem->splitPath(filenameBase, &directory, nullptr, nullptr);
+	FTX::FileSystem->createDirectory(directory);
+
+	String source;
+	source << SOURCE_PROLOGUE << code << SOURCE_EPILOGUE;
+	const std::string sourceFilename = WString(filenameBase + L".cpp").toStdString();
+	if (!FTX::FileSystem->saveFile(sourceFilename, *source, (size_t)source.length()))
+		return;
+
+	// Compile in the background, so loading does not get stalled by this
+	//  -> The output is written to a temporary file first, so that a build that is not complete yet (e.g. when the game gets closed early) won't ever get loaded
+	//  -> Compiler flags from the config get split at spaces, each part is passed as a separate argument
+	const std::string outputFilename = WString(filenameBase + L".so").toStdString();
+	const std::string tempFilename = outputFilename + ".tmp";
+	const std::string logFilename = WString(filenameBase + L".log").toStdString();
+	const std::string sourcePathString = WString(sourcePath).toStdString();
+	std::vector<std::string> arguments = { config.mModNativizationCompiler };
+	{
+		std::vector<String> flags;
+		String(config.mModNativizationCompilerFlags).split(flags, ' ');
+		for (const String& flag : flags)
+		{
+			if (!flag.empty())
+				arguments.push_back(flag.toStdString());
+		}
+	}
+	for (const char* flag : { "-std=c++17", "-shared", "-fPIC", "-fvisibility=hidden" })
+	{
+		arguments.emplace_back(flag);
+	}
+	arguments.push_back("-I" + sourcePathString + "Oxygen/lemonscript/source");
+	arguments.push_back("-I" + sourcePathString + "librmx/source");
+	arguments.push_back("-o");
+	arguments.push_back(tempFilename);
+	arguments.push_back(sourceFilename);
+
+	RMX_LOG_INFO("Building native module for script module '" << module.getModuleName() << "'");
+	const pid_t pid = startCompiler(arguments, logFilename);
+	if (pid < 0)
+	{
+		RMX_LOG_INFO("Failed to start building the native module");
+		return;
+	}
+
+	// Wait for the compiler on a separate thread, and only rename the output once it was successful
+	std::thread([pid, tempFilename, outputFilename]()
+	{
+		int status = 0;
+		while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+		{
+		}
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+		{
+			std::rename(tempFilename.c_str(), outputFilename.c_str());
+		}
+		else
+		{
+			std::remove(tempFilename.c_str());
+		}
+	}).detach();
+#endif
+}
+
+uint64 ModNativizationCache::getModuleHash(const lemon::Module& module, uint32 appVersion)
+{
+	// The nativized code only depends on the opcodes, but the module's dependency hash, the app version and the build identity get included as well,
+	//  as the shared object is only compatible with the executable it was built for
+	uint64 hash = rmx::startFNV1a_64();
+	const uint64 buildIdentityHash = getBuildIdentityHash();
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&buildIdentityHash, sizeof(buildIdentityHash));
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)module.getModuleName().data(), module.getModuleName().length());
+	const uint32 dependencyHash = module.buildDependencyHash();
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&dependencyHash, sizeof(dependencyHash));
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&appVersion, sizeof(appVersion));
+
+	for (const lemon::ScriptFunction* function : module.getScriptFunctions())
+	{
+		for (const lemon::Opcode& opcode : function->mOpcodes)
+		{
+			hash = rmx::addToFNV1a_64(hash, (const uint8*)&opcode.mType, sizeof(opcode.mType));
+			hash = rmx::addToFNV1a_64(hash, (const uint8*)&opcode.mDataType, sizeof(opcode.mDataType));
+			hash = rmx::addToFNV1a_64(hash, (const uint8*)&opcode.mParameter, sizeof(opcode.mParameter));
+		}
+	}
+	return hash;
+}
+
+std::wstring ModNativizationCache::getCacheFilenameBase(uint64 moduleHash)
+{
+	return Configuration::instance().mAppDataPath + L"cache/nativized/" + *String(rmx::hexString(moduleHash, 16, "")).toWString();
+}
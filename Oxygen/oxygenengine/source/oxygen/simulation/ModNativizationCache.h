@@ -0,0 +1,48 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <rmxbase.h>
+
+// Building native modules requires a system compiler and loading of shared objects at runtime
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_MAC)
+	#define SUPPORT_MOD_NATIVIZATION
+#endif
+
+namespace lemon
+{
+	class MemoryAccessHandler;
+	class Module;
+	class NativizedOpcodeProvider;
+	class Program;
+}
+
+
+// Nativization of script mods, which can't make use of the nativized code built into the game:
+//  - On first start with a mod, the nativizer output for its module gets compiled into a shared object in the background
+//  - Later starts load that shared object and merge its lookup into the nativized opcode provider
+//  - Cached files are keyed by a hash over the module's opcodes, so any change in the mod's scripts leads to a rebuild
+//  - The key also includes the executable build and compiler settings, so that an engine update never loads shared objects built for an older executable
+class ModNativizationCache
+{
+public:
+	// Returns true if a native module for the given module was found in the cache and merged into the provider
+	bool loadNativeModule(lemon::NativizedOpcodeProvider& provider, const lemon::Module& module, uint32 appVersion);
+
+	// Starts building the native module for the next start, unless there's one already or it has no nativizable code at all
+	void buildNativeModule(const lemon::Module& module, const lemon::Program& program, lemon::MemoryAccessHandler& memoryAccessHandler, uint32 appVersion);
+
+private:
+	static uint64 getModuleHash(const lemon::Module& module, uint32 appVersion);
+	static std::wstring getCacheFilenameBase(uint64 moduleHash);
+
+private:
+	std::map<uint64, void*> mLoadedLibraries;	// These never get unloaded, as runtime opcodes may still refer to their functions
+	std::set<uint64> mStartedBuilds;
+};
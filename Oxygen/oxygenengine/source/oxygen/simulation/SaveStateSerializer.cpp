@@ -16,6 +16,8 @@
 #include "oxygen/rendering/parts/palette/PaletteManager.h"
 #include "oxygen/rendering/parts/RenderParts.h"
 
+#include <atomic>
+
 
 namespace
 {
@@ -26,6 +28,66 @@ namespace
 	//  - 5: Added data for ROM based sprites
 	//  - 6: Added spaces manager serialization
 	static const constexpr uint8 OXYGEN_SAVESTATE_FORMATVERSION = 6;
+
+	// Pages of emulator memory in delta save states
+	static const constexpr size_t MEMORY_PAGE_SIZE = 0x400;
+
+	// Pages of the serialized engine state, which is a lot smaller, but changes in more places
+	static const constexpr size_t ENGINE_STATE_PAGE_SIZE = 0x100;
+
+	// Only needs to be unique over all delta references, even if multiple simulations are running
+	std::atomic<uint32> gLastDeltaReferenceId = 0;
+
+	template<size_t NUM_PAGES>
+	void writeChangedPages(VectorBinarySerializer& serializer, const uint8* data, const uint8* referenceData, const BitArray<NUM_PAGES>* candidatePages)
+	{
+		// Only pages marked as candidates can have changed, or all pages if there's no candidates given
+		uint16 changedPages[NUM_PAGES];
+		uint16 numChangedPages = 0;
+		for (int page = (nullptr == candidatePages) ? 0 : candidatePages->getNextSetBit(0); page >= 0 && page < (int)NUM_PAGES; )
+		{
+			const size_t offset = (size_t)page * MEMORY_PAGE_SIZE;
+			if (memcmp(&data[offset], &referenceData[offset], MEMORY_PAGE_SIZE) != 0)
+			{
+				changedPages[numChangedPages] = (uint16)page;
+				++numChangedPages;
+			}
+			page = (nullptr == candidatePages) ? (page + 1) : candidatePages->getNextSetBit(page + 1);
+		}
+
+		serializer.write(numChangedPages);
+		for (uint16 k = 0; k < numChangedPages; ++k)
+		{
+			serializer.write(changedPages[k]);
+			serializer.write(&data[(size_t)changedPages[k] * MEMORY_PAGE_SIZE], MEMORY_PAGE_SIZE);
+		}
+	}
+
+	template<size_t NUM_PAGES>
+	bool readChangedPages(VectorBinarySerializer& serializer, uint8* data, BitArray<NUM_PAGES>& outChangedPages)
+	{
+		outChangedPages.clearAllBits();
+		const uint16 numChangedPages = serializer.read<uint16>();
+		for (uint16 k = 0; k < numChangedPages; ++k)
+		{
+			const uint16 page = serializer.read<uint16>();
+			if (serializer.hasError() || page >= NUM_PAGES)
+				return false;
+			serializer.read(&data[(size_t)page * MEMORY_PAGE_SIZE], MEMORY_PAGE_SIZE);
+			outChangedPages.setBit(page);
+		}
+		return !serializer.hasError();
+	}
+
+	template<size_t NUM_PAGES>
+	void restoreFromReference(uint8* data, const uint8* referenceData, const BitArray<NUM_PAGES>& pages)
+	{
+		for (int page = pages.getNextSetBit(0); page >= 0 && page < (int)NUM_PAGES; page = pages.getNextSetBit(page + 1))
+		{
+			const size_t offset = (size_t)page * MEMORY_PAGE_SIZE;
+			memcpy(&data[offset], &referenceData[offset], MEMORY_PAGE_SIZE);
+		}
+	}
 }
 
 
@@ -111,6 +173,9 @@ bool SaveStateSerializer::serializeState(VectorBinarySerializer& serializer, Sta
 		{
 			RMX_ERROR("Unrecognized save state format", return false);
 		}
+
+		// Memory gets overwritten without tracking dirty pages
+		emulatorInterface.getRuntimeMemory().mDirtyPagesReferenceId = 0;
 	}
 	else
 	{
@@ -170,34 +235,317 @@ bool SaveStateSerializer::serializeState(VectorBinarySerializer& serializer, Sta
 			}
 		}
 
-		// CRAM, actually part of palette manager's data
-		mRenderParts.getPaletteManager().serializeSaveState(serializer, formatVersion);
+		// Everything else
+		if (!serializeEngineState(serializer, formatVersion))
+			return false;
+	}
+
+	if (serializer.isReading() && mSimulation.isDefaultInstance())
+	{
+		VideoOut::instance().initAfterSaveStateLoad();
+	}
 
-		// VSRAM
-		serializer.serialize(emulatorInterface.getVSRam(), 0x80);
+	return true;
+}
 
-		// Engine graphics state
-		mRenderParts.getPlaneManager().serializeSaveState(serializer, formatVersion);
-		mRenderParts.getScrollOffsetsManager().serializeSaveState(serializer, formatVersion);
-		mRenderParts.getSpriteManager().serializeSaveState(serializer, formatVersion);
-		mRenderParts.getSpacesManager().serializeSaveState(serializer, formatVersion);
+bool SaveStateSerializer::serializeEngineState(VectorBinarySerializer& serializer, uint8 formatVersion)
+{
+	EmulatorInterface& emulatorInterface = mCodeExec.getEmulatorInterface();
 
-		// Lemon script runtime state
-		if (!mCodeExec.getLemonScriptRuntime().serializeRuntime(serializer))
+	// CRAM, actually part of palette manager's data
+	mRenderParts.getPaletteManager().serializeSaveState(serializer, formatVersion);
+
+	// VSRAM
+	serializer.serialize(emulatorInterface.getVSRam(), 0x80);
+
+	// Engine graphics state
+	mRenderParts.getPlaneManager().serializeSaveState(serializer, formatVersion);
+	mRenderParts.getScrollOffsetsManager().serializeSaveState(serializer, formatVersion);
+	mRenderParts.getSpriteManager().serializeSaveState(serializer, formatVersion);
+	mRenderParts.getSpacesManager().serializeSaveState(serializer, formatVersion);
+
+	// Lemon script runtime state
+	if (!mCodeExec.getLemonScriptRuntime().serializeRuntime(serializer))
+		return false;
+
+	// Simulation state
+	mSimulation.getSimulationState().serializeSaveState(serializer, formatVersion);
+	return true;
+}
+
+bool SaveStateSerializer::saveDeltaReference(DeltaReference& outReference)
+{
+	EmulatorInterface& emulatorInterface = mCodeExec.getEmulatorInterface();
+	RuntimeMemory& runtimeMemory = emulatorInterface.getRuntimeMemory();
+
+	outReference.mEngineState.clear();
+	VectorBinarySerializer serializer(false, outReference.mEngineState);
+	if (!serializeEngineState(serializer, OXYGEN_SAVESTATE_FORMATVERSION))
+	{
+		outReference.mId = 0;
+		return false;
+	}
+
+	outReference.mId = ++gLastDeltaReferenceId;
+	outReference.mRam.assign(runtimeMemory.mRam, runtimeMemory.mRam + sizeof(runtimeMemory.mRam));
+	outReference.mVRam.assign(runtimeMemory.mVRam, runtimeMemory.mVRam + sizeof(runtimeMemory.mVRam));
+	outReference.mSharedMemory.assign(runtimeMemory.mSharedMemory, runtimeMemory.mSharedMemory + sizeof(runtimeMemory.mSharedMemory));
+	outReference.mSharedMemoryUsage = runtimeMemory.mSharedMemoryUsage;
+
+	// Start tracking dirty pages from here on
+	runtimeMemory.mVRamDirtyPages.clearAllBits();
+	runtimeMemory.mSharedMemoryDirtyPages.clearAllBits();
+	runtimeMemory.mDirtyPagesReferenceId = outReference.mId;
+	return true;
+}
+
+bool SaveStateSerializer::saveDeltaState(std::vector<uint8>& output, const DeltaReference& reference)
+{
+	RMX_CHECK(reference.isValid(), "Invalid delta save state reference", return false);
+	EmulatorInterface& emulatorInterface = mCodeExec.getEmulatorInterface();
+	RuntimeMemory& runtimeMemory = emulatorInterface.getRuntimeMemory();
+
+	VectorBinarySerializer serializer(false, output);
+
+	// Signature and reference
+	char signature[16];
+	memcpy(signature, "Oxygen_Delta__", 15);
+	signature[15] = OXYGEN_SAVESTATE_FORMATVERSION;
+	serializer.serialize(signature, 16);
+	serializer.write(reference.mId);
+
+	// Registers
+	for (size_t i = 0; i < 16; ++i)
+	{
+		serializer.write(emulatorInterface.getRegister(i));
+	}
+
+	// RAM gets written directly by compiled scripts, so it has to be compared as a whole
+	writeChangedPages<0x40>(serializer, runtimeMemory.mRam, &reference.mRam[0], nullptr);
+
+	// VRAM and shared memory only need to be compared where they got written, if the dirty pages refer to this reference
+	const bool useDirtyPages = (runtimeMemory.mDirtyPagesReferenceId == reference.mId);
+	writeChangedPages<0x40>(serializer, runtimeMemory.mVRam, &reference.mVRam[0], useDirtyPages ? &runtimeMemory.mVRamDirtyPages : nullptr);
+	serializer.write(runtimeMemory.mSharedMemoryUsage);
+	writeChangedPages<0x400>(serializer, runtimeMemory.mSharedMemory, &reference.mSharedMemory[0], useDirtyPages ? &runtimeMemory.mSharedMemoryDirtyPages : nullptr);
+
+	// Engine state
+	{
+		thread_local std::vector<uint8> engineState;
+		engineState.clear();
+		VectorBinarySerializer engineStateSerializer(false, engineState);
+		if (!serializeEngineState(engineStateSerializer, OXYGEN_SAVESTATE_FORMATVERSION))
 			return false;
 
-		// Simulation state
-		mSimulation.getSimulationState().serializeSaveState(serializer, formatVersion);
+		// Everything behind the end of the reference's engine state counts as changed
+		const uint32 engineStateSize = (uint32)engineState.size();
+		serializer.write(engineStateSize);
+		for (size_t offset = 0; offset < engineState.size(); offset += ENGINE_STATE_PAGE_SIZE)
+		{
+			const size_t bytes = std::min(ENGINE_STATE_PAGE_SIZE, engineState.size() - offset);
+			if (offset + bytes <= reference.mEngineState.size() && memcmp(&engineState[offset], &reference.mEngineState[offset], bytes) == 0)
+				continue;
+
+			serializer.write((uint32)offset);
+			serializer.write(&engineState[offset], bytes);
+		}
+		serializer.write(engineStateSize);	// Marks the end, as no page can start there
 	}
+	return true;
+}
 
-	if (serializer.isReading())
+bool SaveStateSerializer::loadDeltaState(const std::vector<uint8>& input, const DeltaReference& reference)
+{
+	RMX_CHECK(reference.isValid(), "Invalid delta save state reference", return false);
+	EmulatorInterface& emulatorInterface = mCodeExec.getEmulatorInterface();
+	RuntimeMemory& runtimeMemory = emulatorInterface.getRuntimeMemory();
+
+	VectorBinarySerializer serializer(true, input);
+
+	// Signature and reference
+	char signature[16];
+	serializer.serialize(signature, 16);
+	if (memcmp(signature, "Oxygen_Delta__", 15) != 0 || (uint8)signature[15] != OXYGEN_SAVESTATE_FORMATVERSION)
 	{
-		VideoOut::instance().initAfterSaveStateLoad();
+		RMX_ERROR("Unrecognized delta save state format", return false);
+	}
+	if (serializer.read<uint32>() != reference.mId)
+	{
+		RMX_ERROR("Delta save state does not belong to the given reference", return false);
+	}
+
+	// Registers
+	for (size_t i = 0; i < 16; ++i)
+	{
+		emulatorInterface.getRegister(i) = serializer.read<uint32>();
+	}
+
+	// Memory pages not contained in the delta are restored from the reference
+	//  -> For VRAM and shared memory, this is only needed for pages that got written since then, if that's known
+	const bool useDirtyPages = (runtimeMemory.mDirtyPagesReferenceId == reference.mId);
+	if (!useDirtyPages)
+	{
+		memcpy(runtimeMemory.mVRam, &reference.mVRam[0], sizeof(runtimeMemory.mVRam));
+		memcpy(runtimeMemory.mSharedMemory, &reference.mSharedMemory[0], sizeof(runtimeMemory.mSharedMemory));
+		runtimeMemory.mVRamChangeBits.setAllBits();
+	}
+	memcpy(runtimeMemory.mRam, &reference.mRam[0], sizeof(runtimeMemory.mRam));
+
+	BitArray<0x40> ramPages;
+	BitArray<0x40> vramPages;
+	BitArray<0x400> sharedMemoryPages;
+	bool success = readChangedPages(serializer, runtimeMemory.mRam, ramPages);
+	if (success)
+	{
+		if (useDirtyPages)
+			restoreFromReference(runtimeMemory.mVRam, &reference.mVRam[0], runtimeMemory.mVRamDirtyPages);
+		success = readChangedPages(serializer, runtimeMemory.mVRam, vramPages);
+	}
+	if (success)
+	{
+		runtimeMemory.mSharedMemoryUsage = serializer.read<uint64>();
+		if (useDirtyPages)
+			restoreFromReference(runtimeMemory.mSharedMemory, &reference.mSharedMemory[0], runtimeMemory.mSharedMemoryDirtyPages);
+		success = readChangedPages(serializer, runtimeMemory.mSharedMemory, sharedMemoryPages);
+	}
+	if (!success)
+	{
+		runtimeMemory.mDirtyPagesReferenceId = 0;
+		RMX_ERROR("Invalid memory pages in delta save state", return false);
+	}
+
+	// Let the pattern cache know which parts of VRAM changed
+	if (useDirtyPages)
+	{
+		BitArray<0x40> changedVRamPages;
+		changedVRamPages.makeOR(vramPages, runtimeMemory.mVRamDirtyPages);
+		for (int page = changedVRamPages.getNextSetBit(0); page >= 0 && page < 0x40; page = changedVRamPages.getNextSetBit(page + 1))
+		{
+			runtimeMemory.mVRamChangeBits.setBitsInRange((size_t)page * 0x20, (size_t)page * 0x20 + 0x1f);
+		}
+	}
+
+	// Now the memory only differs from the reference where the delta says so
+	runtimeMemory.mVRamDirtyPages = vramPages;
+	runtimeMemory.mSharedMemoryDirtyPages = sharedMemoryPages;
+	runtimeMemory.mDirtyPagesReferenceId = reference.mId;
+
+	// Engine state
+	{
+		thread_local std::vector<uint8> engineState;
+		const uint32 engineStateSize = serializer.read<uint32>();
+		engineState.assign(reference.mEngineState.begin(), reference.mEngineState.begin() + std::min<size_t>(engineStateSize, reference.mEngineState.size()));
+		engineState.resize(engineStateSize, 0);
+		while (true)
+		{
+			const uint32 offset = serializer.read<uint32>();
+			if (serializer.hasError())
+				return false;
+			if (offset >= engineStateSize)
+				break;
+			const size_t bytes = std::min<size_t>(ENGINE_STATE_PAGE_SIZE, engineStateSize - offset);
+			serializer.read(&engineState[offset], bytes);
+		}
+
+		VectorBinarySerializer engineStateSerializer(true, engineState);
+		if (!serializeEngineState(engineStateSerializer, OXYGEN_SAVESTATE_FORMATVERSION))
+			return false;
 	}
 
+	if (mSimulation.isDefaultInstance())
+	{
+		VideoOut::instance().initAfterSaveStateLoad();
+	}
 	return true;
 }
 
+bool SaveStateSerializer::buildFullState(std::vector<uint8>& output, const std::vector<uint8>& deltaState, uint32 referenceId, const std::vector<uint8>& referenceState)
+{
+	// Memory layout: RAM, VRAM, shared memory
+	thread_local std::vector<uint8> memory;
+	memory.resize(0x120000);
+	uint8* ram = &memory[0];
+	uint8* vram = &memory[0x10000];
+	uint8* sharedMemory = &memory[0x20000];
+
+	// Read the reference state, which must be a full save state in the current format
+	VectorBinarySerializer referenceSerializer(true, referenceState);
+	char signature[16];
+	referenceSerializer.read(signature, 16);
+	if (memcmp(signature, "Oxygen_State__", 15) != 0 || (uint8)signature[15] != OXYGEN_SAVESTATE_FORMATVERSION)
+		return false;
+
+	referenceSerializer.skip(16 * sizeof(uint32));
+	referenceSerializer.read(ram, 0x10000);
+	referenceSerializer.read(vram, 0x10000);
+	{
+		// Shared memory blocks that are not in use are empty after loading a save state
+		memset(sharedMemory, 0, 0x100000);
+		const uint64 usageFlags = referenceSerializer.read<uint64>();
+		for (int bit = 0; bit < 64 && (usageFlags >> bit) != 0; ++bit)
+		{
+			if ((usageFlags >> bit) & 1)
+				referenceSerializer.read(&sharedMemory[0x4000 * bit], 0x4000);
+		}
+	}
+	if (referenceSerializer.hasError())
+		return false;
+
+	// Apply the delta state
+	VectorBinarySerializer deltaSerializer(true, deltaState);
+	deltaSerializer.read(signature, 16);
+	if (memcmp(signature, "Oxygen_Delta__", 15) != 0 || (uint8)signature[15] != OXYGEN_SAVESTATE_FORMATVERSION || deltaSerializer.read<uint32>() != referenceId)
+		return false;
+
+	uint32 registers[16];
+	deltaSerializer.read(registers, sizeof(registers));
+
+	BitArray<0x40> ramPages;
+	BitArray<0x40> vramPages;
+	BitArray<0x400> sharedMemoryPages;
+	if (!readChangedPages(deltaSerializer, ram, ramPages) || !readChangedPages(deltaSerializer, vram, vramPages))
+		return false;
+	const uint64 sharedMemoryUsage = deltaSerializer.read<uint64>();
+	if (!readChangedPages(deltaSerializer, sharedMemory, sharedMemoryPages))
+		return false;
+
+	// The reference's engine state is everything behind its shared memory
+	const size_t referenceEngineStatePosition = referenceSerializer.getReadPosition();
+	const size_t referenceEngineStateSize = referenceState.size() - referenceEngineStatePosition;
+	const uint32 engineStateSize = deltaSerializer.read<uint32>();
+
+	// Write the full save state, in the same way as "serializeState" does
+	output.clear();
+	VectorBinarySerializer serializer(false, output);
+	memcpy(signature, "Oxygen_State__", 15);
+	signature[15] = OXYGEN_SAVESTATE_FORMATVERSION;
+	serializer.write(signature, 16);
+	serializer.write(registers, sizeof(registers));
+	serializer.write(ram, 0x10000);
+	serializer.write(vram, 0x10000);
+	serializer.write(sharedMemoryUsage);
+	for (int bit = 0; bit < 64 && (sharedMemoryUsage >> bit) != 0; ++bit)
+	{
+		if ((sharedMemoryUsage >> bit) & 1)
+			serializer.write(&sharedMemory[0x4000 * bit], 0x4000);
+	}
+
+	const size_t engineStatePosition = output.size();
+	output.resize(engineStatePosition + engineStateSize, 0);
+	memcpy(&output[engineStatePosition], &referenceState[referenceEngineStatePosition], std::min<size_t>(engineStateSize, referenceEngineStateSize));
+	while (true)
+	{
+		const uint32 offset = deltaSerializer.read<uint32>();
+		if (deltaSerializer.hasError())
+			return false;
+		if (offset >= engineStateSize)
+			break;
+		const size_t bytes = std::min<size_t>(ENGINE_STATE_PAGE_SIZE, engineStateSize - offset);
+		deltaSerializer.read(&output[engineStatePosition + offset], bytes);
+	}
+	return !deltaSerializer.hasError();
+}
+
 bool SaveStateSerializer::readGensxState(VectorBinarySerializer& serializer)
 {
 	EmulatorInterface& emulatorInterface = mCodeExec.getEmulatorInterface();
@@ -25,6 +25,21 @@ public:
 		GENSX	= 2
 	};
 
+	// Reference for delta save states, which only contain the memory pages and parts of the state that changed since the reference
+	//  -> Emulator memory writes to VRAM and shared memory get tracked in dirty pages, so only these need to be compared
+	//  -> A reference can be used for any number of delta save states, and must be kept as long as any of these are needed
+	struct DeltaReference
+	{
+		uint32 mId = 0;
+		std::vector<uint8> mRam;
+		std::vector<uint8> mVRam;
+		std::vector<uint8> mSharedMemory;
+		uint64 mSharedMemoryUsage = 0;
+		std::vector<uint8> mEngineState;	// Serialized state of everything except for the emulator memory and registers
+
+		inline bool isValid() const  { return (mId != 0); }
+	};
+
 public:
 	SaveStateSerializer(Simulation& simulation, RenderParts& renderParts);
 
@@ -34,8 +49,17 @@ public:
 	bool saveState(std::vector<uint8>& output);
 	bool saveState(const std::wstring& filename);
 
+	bool saveDeltaReference(DeltaReference& outReference);
+	bool saveDeltaState(std::vector<uint8>& output, const DeltaReference& reference);
+	bool loadDeltaState(const std::vector<uint8>& input, const DeltaReference& reference);
+
+	// Builds the full save state that a delta save state stands for, from a full save state saved together with the delta reference
+	//  -> This works without a simulation, for delta save states that only get stored, like keyframes in the game recorder
+	static bool buildFullState(std::vector<uint8>& output, const std::vector<uint8>& deltaState, uint32 referenceId, const std::vector<uint8>& referenceState);
+
 private:
 	bool serializeState(VectorBinarySerializer& serializer, StateType& stateType);
+	bool serializeEngineState(VectorBinarySerializer& serializer, uint8 formatVersion);
 	bool readGensxState(VectorBinarySerializer& serializer);
 
 private:
@@ -0,0 +1,132 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/simulation/ScriptModuleCache.h"
+
+#include <lemon/program/GlobalsLookup.h>
+#include <lemon/program/Module.h>
+
+
+uint64 ScriptModuleCache::buildInitialKey(const lemon::Module& scriptModule, uint32 appVersion)
+{
+	// Everything a mod module gets compiled against that is not covered by the preprocessor definitions:
+	//  the core modules (which only change with the app version) and the compiled code of the main script module
+	uint64 hash = rmx::startFNV1a_64();
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&appVersion, sizeof(appVersion));
+	const uint32 dependencyHash = scriptModule.buildDependencyHash();
+	hash = rmx::addToFNV1a_64(hash, (const uint8*)&dependencyHash, sizeof(dependencyHash));
+	for (const lemon::ScriptFunction* function : scriptModule.getScriptFunctions())
+	{
+		hash = function->addToCompiledHash(hash);
+	}
+	return hash;
+}
+
+uint64 ScriptModuleCache::buildModuleKey(uint64 previousKey, const lemon::GlobalsLookup& globalsLookup, const std::wstring& scriptsPath)
+{
+	uint64 hash = rmx::addToFNV1a_64(rmx::startFNV1a_64(), (const uint8*)&previousKey, sizeof(previousKey));
+
+	// Preprocessor definitions can change e.g. with mod settings
+	for (const auto& pair : globalsLookup.mPreprocessorDefinitions.getDefinitions())
+	{
+		hash = rmx::addToFNV1a_64(hash, (const uint8*)&pair.first, sizeof(pair.first));
+		hash = rmx::addToFNV1a_64(hash, (const uint8*)&pair.second.mValue, sizeof(pair.second.mValue));
+	}
+
+	// Include all script files of the mod, not only the ones that actually got included last time,
+	//  as wildcard includes can pick up new files
+	std::vector<rmx::FileIO::FileEntry> fileEntries;
+	FTX::FileSystem->listFilesByMask(scriptsPath + L"*.lemon", true, fileEntries);
+	std::sort(fileEntries.begin(), fileEntries.end(), [](const rmx::FileIO::FileEntry& a, const rmx::FileIO::FileEntry& b) { return (a.mPath == b.mPath) ? (a.mFilename < b.mFilename) : (a.mPath < b.mPath); });
+
+	std::vector<uint8> content;
+	for (const rmx::FileIO::FileEntry& fileEntry : fileEntries)
+	{
+		const std::wstring filePath = fileEntry.mPath + fileEntry.mFilename;
+		hash = rmx::addToFNV1a_64(hash, (const uint8*)filePath.data(), filePath.length() * sizeof(wchar_t));
+		if (FTX::FileSystem->readFile(filePath, content) && !content.empty())
+		{
+			hash = rmx::addToFNV1a_64(hash, &content[0], content.size());
+		}
+	}
+	return hash;
+}
+
+bool ScriptModuleCache::loadModule(lemon::Module& module, uint64 key, const lemon::GlobalsLookup& globalsLookup, uint32 dependencyHash, uint32 appVersion)
+{
+	const std::wstring filename = getCacheFilename(key);
+	std::vector<uint8> buffer;
+	if (!FTX::FileSystem->readFile(filename, buffer))
+		return false;
+
+	VectorBinarySerializer serializer(true, buffer);
+	if (!module.serialize(serializer, globalsLookup, dependencyHash, appVersion))
+	{
+		// Cache file is outdated or broken, so get rid of it
+		module.clear();
+		FTX::FileSystem->removeFile(filename);
+		return false;
+	}
+
+	mUsedKeys.insert(key);
+	return true;
+}
+
+void ScriptModuleCache::saveModule(lemon::Module& module, uint64 key, const lemon::GlobalsLookup& globalsLookup, uint32 dependencyHash, uint32 appVersion)
+{
+	std::vector<uint8> buffer;
+	VectorBinarySerializer serializer(false, buffer);
+	if (!module.serialize(serializer, globalsLookup, dependencyHash, appVersion))
+		return;
+
+	FTX::FileSystem->createDirectory(getCacheDirectory());
+	if (FTX::FileSystem->saveFile(getCacheFilename(key), buffer))
+	{
+		mUsedKeys.insert(key);
+		enforceSizeLimit();
+	}
+}
+
+std::wstring ScriptModuleCache::getCacheDirectory()
+{
+	return Configuration::instance().mAppDataPath + L"cache/scripts/";
+}
+
+std::wstring ScriptModuleCache::getCacheFilename(uint64 key)
+{
+	return getCacheDirectory() + *String(rmx::hexString(key, 16, "")).toWString() + L".bin";
+}
+
+void ScriptModuleCache::enforceSizeLimit()
+{
+	const size_t sizeLimit = (size_t)std::max(Configuration::instance().mModScriptCacheSizeLimit, 0) * 1024 * 1024;
+
+	std::vector<rmx::FileIO::FileEntry> fileEntries;
+	FTX::FileSystem->listFilesByMask(getCacheDirectory() + L"*.bin", false, fileEntries);
+
+	size_t totalSize = 0;
+	for (const rmx::FileIO::FileEntry& fileEntry : fileEntries)
+		totalSize += fileEntry.mSize;
+	if (totalSize <= sizeLimit)
+		return;
+
+	// Remove oldest files first
+	std::sort(fileEntries.begin(), fileEntries.end(), [](const rmx::FileIO::FileEntry& a, const rmx::FileIO::FileEntry& b) { return a.mTime < b.mTime; });
+	for (const rmx::FileIO::FileEntry& fileEntry : fileEntries)
+	{
+		const uint64 key = rmx::parseInteger(String("0x") + WString(fileEntry.mFilename).toString());
+		if (mUsedKeys.count(key) != 0)
+			continue;
+
+		FTX::FileSystem->removeFile(fileEntry.mPath + fileEntry.mFilename);
+		totalSize -= std::min(fileEntry.mSize, totalSize);
+		if (totalSize <= sizeLimit)
+			break;
+	}
+}
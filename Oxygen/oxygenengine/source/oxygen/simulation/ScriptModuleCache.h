@@ -0,0 +1,42 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include <rmxbase.h>
+
+namespace lemon
+{
+	class GlobalsLookup;
+	class Module;
+}
+
+
+// On-disk cache of compiled script modules of mods, so they don't need to get recompiled on each start
+//  - Cache files are content-addressed: the key is a hash over all script files of the mod and the current preprocessor definitions
+//  - Keys get chained from one module to the next, as the compiled code also depends on everything defined by previously loaded modules
+//  - When the cache exceeds its size limit, the oldest files that were not used in this session get removed
+class ScriptModuleCache
+{
+public:
+	static uint64 buildInitialKey(const lemon::Module& scriptModule, uint32 appVersion);
+	static uint64 buildModuleKey(uint64 previousKey, const lemon::GlobalsLookup& globalsLookup, const std::wstring& scriptsPath);
+
+public:
+	bool loadModule(lemon::Module& module, uint64 key, const lemon::GlobalsLookup& globalsLookup, uint32 dependencyHash, uint32 appVersion);
+	void saveModule(lemon::Module& module, uint64 key, const lemon::GlobalsLookup& globalsLookup, uint32 dependencyHash, uint32 appVersion);
+
+private:
+	static std::wstring getCacheDirectory();
+	static std::wstring getCacheFilename(uint64 key);
+
+	void enforceSizeLimit();
+
+private:
+	std::set<uint64> mUsedKeys;		// Keys used in this session, these are never removed when enforcing the size limit
+};
@@ -15,6 +15,7 @@
 #include "oxygen/simulation/SaveStateSerializer.h"
 #include "oxygen/simulation/SimulationState.h"
 #include "oxygen/simulation/analyse/ROMDataAnalyser.h"
+#include "oxygen/simulation/sound/SimulationAudioState.h"
 #include "oxygen/application/Configuration.h"
 #include "oxygen/application/EngineMain.h"
 #include "oxygen/application/audio/AudioOutBase.h"
@@ -31,14 +32,31 @@ namespace
 {
 	void recordKeyFrame(uint32 frameNumber, Simulation& simulation, GameRecorder& gameRecorder, const GameRecorder::InputData& inputData)
 	{
-		static std::vector<uint8> data;
+		thread_local std::vector<uint8> data;
 		data.reserve(0x128000);
 		data.clear();
 
 		SaveStateSerializer serializer(simulation, RenderParts::instance());
-		serializer.saveState(data);
+		const GameRecorder::KeyframeCapture capture = gameRecorder.getKeyframeCapture(frameNumber);
+		if (capture == GameRecorder::KeyframeCapture::DELTA_STATE && serializer.saveDeltaState(data, gameRecorder.getDeltaReference()))
+		{
+			gameRecorder.addDeltaKeyFrame(frameNumber, inputData, data);
+		}
+		else
+		{
+			data.clear();
+			serializer.saveState(data);
 
-		gameRecorder.addKeyFrame(frameNumber, inputData, data);
+			// The delta reference must be taken right after the full save state, so that both describe the same state
+			uint32 deltaReferenceId = 0;
+			if (capture == GameRecorder::KeyframeCapture::NEW_ANCHOR)
+			{
+				SaveStateSerializer::DeltaReference& deltaReference = gameRecorder.getDeltaReference();
+				if (serializer.saveDeltaReference(deltaReference))
+					deltaReferenceId = deltaReference.mId;
+			}
+			gameRecorder.addKeyFrame(frameNumber, inputData, data, deltaReferenceId);
+		}
 	}
 }
 
@@ -46,10 +64,11 @@ namespace
 Simulation::Simulation() :
 	mCodeExec(*new CodeExec()),
 	mSimulationState(*new SimulationState()),
+	mAudioState(*new SimulationAudioState()),
 	mGameRecorder(*new GameRecorder()),
 	mInputRecorder(*new InputRecorder())
 {
-	if (EngineMain::getDelegate().useDeveloperFeatures())
+	if (EngineMain::getDelegate().useDeveloperFeatures() && isDefaultInstance())
 	{
 		mROMDataAnalyser = new ROMDataAnalyser();
 	}
@@ -59,6 +78,7 @@ Simulation::~Simulation()
 {
 	delete &mCodeExec;
 	delete &mSimulationState;
+	delete &mAudioState;
 	delete &mGameRecorder;
 	delete &mInputRecorder;
 	delete mROMDataAnalyser;
@@ -79,6 +99,10 @@ bool Simulation::startup()
 		mCodeExec.reinitRuntime(nullptr, CodeExec::CallStackInitPolicy::RESET);
 	}
 
+	// Everything below is only meant for the main simulation, other simulations get controlled from outside
+	if (!isDefaultInstance())
+		return success;
+
 	// Optionally load save state
 	mStateLoaded.clear();
 	if (success && EngineMain::getDelegate().useDeveloperFeatures() && !config.mLoadSaveState.empty())
@@ -89,16 +113,27 @@ bool Simulation::startup()
 	}
 	RMX_LOG_INFO("Runtime environment ready");
 
-	if (EngineMain::getDelegate().useDeveloperFeatures())
+	if (EngineMain::getDelegate().useDeveloperFeatures() || config.mHeadless.mEnabled)
 	{
 		// Startup input recorder
 		mInputRecorder.initFromConfig();
 	}
 
-	if (mGameRecorder.isPlaying())
+	if (mGameRecorder.isPlaying() && config.mHeadless.mBatchDirectory.empty())	// In batch mode, the headless runner selects the game recordings to play back
 	{
+		if (!config.mGameRecorder.mPlaybackFilename.empty())
+		{
+			if (mGameRecorder.loadRecording(config.mGameRecorder.mPlaybackFilename))
+			{
+				RMX_LOG_INFO("Playback of '" << WString(config.mGameRecorder.mPlaybackFilename).toStdString() << "'");
+			}
+			else
+			{
+				RMX_LOG_INFO("Failed to load game recording '" << WString(config.mGameRecorder.mPlaybackFilename).toStdString() << "'");
+			}
+		}
 		// Try the long and short name
-		if (mGameRecorder.loadRecording(L"gamerecording.bin"))
+		else if (mGameRecorder.loadRecording(L"gamerecording.bin"))
 		{
 			RMX_LOG_INFO("Playback of 'gamerecording.bin'");
 		}
@@ -142,7 +177,8 @@ EmulatorInterface& Simulation::getEmulatorInterface()
 
 void Simulation::resetState()
 {
-	EngineMain::instance().getAudioOut().reset();
+	if (isDefaultInstance())
+		EngineMain::instance().getAudioOut().reset();
 	resetIntoGame(nullptr);
 }
 
@@ -155,8 +191,16 @@ void Simulation::resetIntoGame(const std::vector<std::pair<std::string, std::str
 	mSimulationState.reset();
 
 	// Reset video & audio
-	VideoOut::instance().reset();
-	EngineMain::instance().getAudioOut().resetGame();
+	mAudioState.clear();
+	if (isDefaultInstance())
+	{
+		VideoOut::instance().reset();
+		EngineMain::instance().getAudioOut().resetGame();
+	}
+	else
+	{
+		RenderParts::instance().reset();
+	}
 
 	// Reset code execution
 	mCodeExec.reset();
@@ -195,8 +239,16 @@ void Simulation::reloadLastState()
 
 bool Simulation::loadState(const std::wstring& filename, bool showError)
 {
-	VideoOut::instance().reset();
-	EngineMain::instance().getAudioOut().reset();
+	mAudioState.clear();
+	if (isDefaultInstance())
+	{
+		VideoOut::instance().reset();
+		EngineMain::instance().getAudioOut().reset();
+	}
+	else
+	{
+		RenderParts::instance().reset();
+	}
 
 	SaveStateSerializer::StateType stateType;
 	SaveStateSerializer serializer(*this, RenderParts::instance());
@@ -234,9 +286,12 @@ void Simulation::saveState(const std::wstring& filename)
 	RMX_CHECK(success, "Failed to save save state '" << WString(filename).toStdString() << "'", return);
 
 	// Also save a screenshot
-	Bitmap bmp;
-	VideoOut::instance().getScreenshot(bmp);
-	bmp.save(filename + L".bmp");
+	if (isDefaultInstance())
+	{
+		Bitmap bmp;
+		VideoOut::instance().getScreenshot(bmp);
+		bmp.save(filename + L".bmp");
+	}
 
 	// Set as default for "reloadLastState"
 	mStateLoaded = filename;
@@ -255,6 +310,17 @@ bool Simulation::triggerFullScriptsReload()
 	}
 }
 
+bool Simulation::triggerScriptsReload()
+{
+	if (Configuration::instance().mDevMode.mIncrementalScriptReload)
+	{
+		const LemonScriptProgram::LoadScriptsResult result = mCodeExec.reloadChangedScripts();
+		if (result != LemonScriptProgram::LoadScriptsResult::FULL_RELOAD_NEEDED)
+			return (result != LemonScriptProgram::LoadScriptsResult::FAILED);
+	}
+	return triggerFullScriptsReload();
+}
+
 void Simulation::update(float timeElapsed)
 {
 	if (!isRunning() || !mCodeExec.isCodeExecutionPossible())
@@ -353,6 +419,7 @@ void Simulation::update(float timeElapsed)
 bool Simulation::generateFrame()
 {
 	ControlsIn& controlsIn = ControlsIn::instance();
+	const bool isMainSimulation = isDefaultInstance();
 
 	const bool beginningNewFrame = mCodeExec.willBeginNewFrame();
 	const float tickLength = 1.0f / getSimulationFrequency();
@@ -363,14 +430,17 @@ bool Simulation::generateFrame()
 	if (beginningNewFrame)
 	{
 		// Check if we can even begin a new frame
-		if (!NetplayManager::instance().canBeginNextFrame(mFrameNumber))
+		if (isMainSimulation && !NetplayManager::instance().canBeginNextFrame(mFrameNumber))
 			return false;
 
 		// Tell game instance
 		EngineMain::getDelegate().onPreFrameUpdate();
 
 		// Tell video that we begin a new frame
-		VideoOut::instance().preFrameUpdate();
+		if (isMainSimulation)
+			VideoOut::instance().preFrameUpdate();
+		else
+			RenderParts::instance().preFrameUpdate();
 
 		// Game recorder: Save initial frame
 		if (mGameRecorder.isRecording() && mGameRecorder.getRangeEnd() == 0)
@@ -381,7 +451,8 @@ bool Simulation::generateFrame()
 		controlsIn.beginInputUpdate();
 
 		// Update netplay
-		NetplayManager::instance().onFrameUpdate(controlsIn, mFrameNumber);
+		if (isMainSimulation)
+			NetplayManager::instance().onFrameUpdate(controlsIn, mFrameNumber);
 
 		// If game recorder has input data for the frame transition, then use that
 		//  -> This is particularly relevant for rewinds, namely for the small fast forwards from the previous keyframe
@@ -413,7 +484,7 @@ bool Simulation::generateFrame()
 		}
 
 		// Input recorder playback
-		if (EngineMain::getDelegate().useDeveloperFeatures())
+		if ((EngineMain::getDelegate().useDeveloperFeatures() || Configuration::instance().mHeadless.mEnabled) && isMainSimulation)
 		{
 			if (mInputRecorder.isPlaying())
 			{
@@ -444,10 +515,16 @@ bool Simulation::generateFrame()
 		// Tell game instance
 		EngineMain::getDelegate().onPostFrameUpdate();
 
+		// Advance the simulation's own audio playback state
+		mAudioState.updateFrame();
+
 		// Tell video that we begin a new frame
-		VideoOut::instance().postFrameUpdate();
+		if (isMainSimulation)
+			VideoOut::instance().postFrameUpdate();
+		else
+			RenderParts::instance().postFrameUpdate();
 
-		if (EngineMain::getDelegate().useDeveloperFeatures())
+		if (EngineMain::getDelegate().useDeveloperFeatures() && isMainSimulation)
 		{
 			// Update input recording
 			if (mInputRecorder.isRecording())
@@ -481,7 +558,7 @@ bool Simulation::generateFrame()
 				}
 			}
 		}
-		else if (mGameRecorder.isPlaying() && EngineMain::getDelegate().useDeveloperFeatures())
+		else if (mGameRecorder.isPlaying() && EngineMain::getDelegate().useDeveloperFeatures() && !Configuration::instance().mHeadless.mEnabled)
 		{
 			// Generate a keyframe every 10 frames, to allow for quick rewinds during game recording playback as well
 			const int keyframeFrequency = 10;
@@ -540,6 +617,7 @@ bool Simulation::jumpToFrame(uint32 frameNumber, bool clearRecordingAfterwards)
 			mCodeExec.reinitRuntime(nullptr, (stateType == SaveStateSerializer::StateType::GENSX) ? CodeExec::CallStackInitPolicy::READ_FROM_ASM : CodeExec::CallStackInitPolicy::USE_EXISTING);
 			mFrameNumber = keyframeNumber;
 			mCurrentTargetFrame = (float)frameNumber;
+			mAudioState.clear();
 
 			if (clearRecordingAfterwards)
 			{
@@ -553,6 +631,23 @@ bool Simulation::jumpToFrame(uint32 frameNumber, bool clearRecordingAfterwards)
 	return false;
 }
 
+bool Simulation::startGameRecordingPlayback(const std::wstring& filename)
+{
+	if (!mGameRecorder.isPlaying())
+		return false;
+
+	if (!mGameRecorder.loadRecording(filename) || mGameRecorder.getCurrentNumberOfFrames() < 2)
+	{
+		RMX_LOG_INFO("Failed to load game recording '" << WString(filename).toStdString() << "'");
+		return false;
+	}
+
+	// Only the initial keyframe gets used, everything after that gets simulated from the recorded inputs
+	//  -> Game recordings saved during gameplay usually don't start at frame 0
+	mGameRecorder.setIgnoreKeys(true);
+	return jumpToFrame(mGameRecorder.getRangeStart(), false);
+}
+
 int Simulation::setRewind(int rewindSteps)
 {
 	mRewindSteps = rewindSteps;
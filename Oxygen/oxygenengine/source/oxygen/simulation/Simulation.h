@@ -14,10 +14,14 @@ class CodeExec;
 class GameRecorder;
 class InputRecorder;
 class ROMDataAnalyser;
+class SimulationAudioState;
 class SimulationState;
 
 
-class Simulation
+// Simulation of the game, running the scripts on the emulator interface
+//  - There's one main simulation owned by the application, but more simulations can run in parallel on other threads, see "PerThreadInstance"
+//  - Simulations running in parallel don't use video output, audio output or netplay, and only play back game recordings
+class Simulation : public PerThreadInstance<Simulation>
 {
 public:
 	enum class BreakCondition
@@ -40,6 +44,7 @@ public:
 
 	CodeExec& getCodeExec()				  { return mCodeExec; }
 	SimulationState& getSimulationState() { return mSimulationState; }
+	SimulationAudioState& getAudioState() { return mAudioState; }
 	GameRecorder& getGameRecorder()		  { return mGameRecorder; }
 	ROMDataAnalyser* getROMDataAnalyser() { return mROMDataAnalyser; }
 	EmulatorInterface& getEmulatorInterface();
@@ -53,12 +58,14 @@ public:
 	void saveState(const std::wstring& filename);
 
 	bool triggerFullScriptsReload();
+	bool triggerScriptsReload();	// Tries an incremental reload first, if enabled
 
 	inline uint32 getFrameNumber() const  { return mFrameNumber; }
 
 	void update(float timePassed);
 	bool generateFrame();
 	bool jumpToFrame(uint32 frameNumber, bool clearRecordingAfterwards = true);
+	bool startGameRecordingPlayback(const std::wstring& filename);
 
 	int setRewind(int rewindSteps);
 
@@ -89,6 +96,7 @@ private:
 private:
 	CodeExec& mCodeExec;
 	SimulationState& mSimulationState;
+	SimulationAudioState& mAudioState;
 	GameRecorder& mGameRecorder;
 	InputRecorder& mInputRecorder;
 	ROMDataAnalyser* mROMDataAnalyser = nullptr;
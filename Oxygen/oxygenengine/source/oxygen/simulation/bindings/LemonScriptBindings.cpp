@@ -17,8 +17,11 @@
 #include "oxygen/simulation/Simulation.h"
 #include "oxygen/simulation/SimulationState.h"
 #include "oxygen/simulation/analyse/ROMDataAnalyser.h"
+#include "oxygen/simulation/sound/SimulationAudioState.h"
 #include "oxygen/application/Application.h"
+#include "oxygen/application/Configuration.h"
 #include "oxygen/application/EngineMain.h"
+#include "oxygen/application/audio/AudioCollection.h"
 #include "oxygen/application/audio/AudioOutBase.h"
 #include "oxygen/application/input/ControlsIn.h"
 #include "oxygen/application/input/InputManager.h"
@@ -95,6 +98,13 @@ namespace
 		return *lemon::Runtime::getActiveEnvironmentSafe<RuntimeEnvironment>().mEmulatorInterface;
 	}
 
+	// Simulations running in parallel to the main simulation (like in the headless runner's batch mode) have no audio output,
+	//  and must not change any state outside of their own, like persistent data or controller rumble
+	inline bool isMainSimulation()
+	{
+		return Simulation::instance().isDefaultInstance();
+	}
+
 	int64* accessRegister(size_t index)
 	{
 		uint32& reg = getEmulatorInterface().getRegister(index);
@@ -247,6 +257,8 @@ namespace
 
 	void System_savePersistentData_shared(uint32 sourceAddress, uint32 bytes, lemon::StringRef file, lemon::StringRef key, bool localFile, std::optional<uint32> offset)
 	{
+		if (!isMainSimulation())
+			return;
 		if (!key.isValid() || key.isEmpty() || !file.isValid())
 			return;
 		if (file.isEmpty())
@@ -299,6 +311,8 @@ namespace
 
 	void System_removePersistentData(lemon::StringRef file, lemon::StringRef key, bool localFile)
 	{
+		if (!isMainSimulation())
+			return;
 		if (!key.isValid() || key.isEmpty() || !file.isValid())
 			return;
 		if (file.isEmpty())
@@ -400,13 +414,13 @@ namespace
 
 	uint32 System_rand()
 	{
-		RandomNumberGenerator& rng = Application::instance().getSimulation().getSimulationState().getRandomNumberGenerator();
+		RandomNumberGenerator& rng = Simulation::instance().getSimulationState().getRandomNumberGenerator();
 		return (uint32)rng.getRandomUint64();
 	}
 
 	float System_randomFloat()
 	{
-		RandomNumberGenerator& rng = Application::instance().getSimulation().getSimulationState().getRandomNumberGenerator();
+		RandomNumberGenerator& rng = Simulation::instance().getSimulationState().getRandomNumberGenerator();
 		return (float)(rng.getRandomUint64() % 8388608) / 8388607.0f;	// 8388608 is 2^23
 	}
 
@@ -644,7 +658,7 @@ namespace
 
 	void debugLogValueStack()
 	{
-		const size_t valueStackSize = Application::instance().getSimulation().getCodeExec().getLemonScriptRuntime().getInternalLemonRuntime().getActiveControlFlow()->getValueStackSize();
+		const size_t valueStackSize = Simulation::instance().getCodeExec().getLemonScriptRuntime().getInternalLemonRuntime().getActiveControlFlow()->getValueStackSize();
 		const std::string valueString = *String(0, "Value Stack Size = %d", valueStackSize);
 		debugLogInternal(valueString);
 	}
@@ -716,11 +730,15 @@ namespace
 
 	void Input_setTouchInputMode(uint8 mode)
 	{
+		if (!isMainSimulation())
+			return;
 		return InputManager::instance().setTouchInputMode((InputManager::TouchInputMode)mode);
 	}
 
 	void Input_resetControllerRumble(int8 playerIndex)
 	{
+		if (!isMainSimulation())
+			return;
 		if (playerIndex < 0)
 		{
 			// All players
@@ -735,6 +753,8 @@ namespace
 
 	void Input_setControllerRumble(int8 playerIndex, float lowFrequencyRumble, float highFrequencyRumble, uint16 milliseconds)
 	{
+		if (!isMainSimulation())
+			return;
 		// Limit length to 30 seconds
 		milliseconds = std::min<uint16>(milliseconds, 30000);
 		if (playerIndex < 0)
@@ -751,6 +771,8 @@ namespace
 
 	void Input_setControllerLEDs(uint8 playerIndex, uint32 color)
 	{
+		if (!isMainSimulation())
+			return;
 		InputManager::instance().setControllerLEDsForPlayer(playerIndex, Color::fromABGR32(color));
 	}
 
@@ -765,18 +787,29 @@ namespace
 
 	uint8 Audio_getAudioKeyType(uint64 sfxId)
 	{
+		// This only depends on the audio collection, not on playback, so all simulations get the same result
 		return (uint8)EngineMain::instance().getAudioOut().getAudioKeyType(sfxId);
 	}
 
+	// Headless runs track the audio playback state inside each simulation, so that all simulations get the same results for playback queries
+	//  -> Otherwise this returns null, and only the main simulation's audio output is used
+	inline SimulationAudioState* getSimulationAudioState()
+	{
+		return Configuration::instance().mHeadless.mEnabled ? &Simulation::instance().getAudioState() : nullptr;
+	}
+
 	bool Audio_isPlayingAudio(uint64 sfxId)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			return audioState->isPlayingSfxId(sfxId);
+		if (!isMainSimulation())
+			return false;
 		return EngineMain::instance().getAudioOut().isPlayingSfxId(sfxId);
 	}
 
 	void Audio_playAudio1(uint64 sfxId, uint8 contextId)
 	{
-		const bool success = EngineMain::instance().getAudioOut().playAudioBase(sfxId, contextId);
-		if (!success)
+		if (nullptr == AudioCollection::instance().getSourceRegistration(sfxId))
 		{
 			// Audio collections expect lowercase IDs, so we might need to do the conversion here first
 			lemon::Runtime* runtime = lemon::Runtime::getActiveRuntime();
@@ -790,15 +823,20 @@ namespace
 					// Does the string contain any uppercase letters?
 					if (containsByPredicate(textString, [](char ch) { return (ch >= 'A' && ch <= 'Z'); } ))
 					{
-						// Convert to lowercase and try again
+						// Convert to lowercase and use that instead
 						String tempStr = textString;
 						tempStr.lowerCase();
 						sfxId = rmx::getMurmur2_64(tempStr);
-						EngineMain::instance().getAudioOut().playAudioBase(sfxId, contextId);
 					}
 				}
 			}
 		}
+
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->playAudio(sfxId, contextId);
+		if (!isMainSimulation())
+			return;
+		EngineMain::instance().getAudioOut().playAudioBase(sfxId, contextId);
 	}
 
 	void Audio_playAudio2(uint64 sfxId)
@@ -808,61 +846,107 @@ namespace
 
 	void Audio_pauseChannel(uint8 channel)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->pauseChannel(channel, true);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().getAudioPlayer().pauseAllSoundsByChannel(channel);
 	}
 
 	void Audio_resumeChannel(uint8 channel)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->pauseChannel(channel, false);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().getAudioPlayer().resumeAllSoundsByChannel(channel);
 	}
 
 	void Audio_stopChannel(uint8 channel)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->stopChannel(channel);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().getAudioPlayer().stopAllSoundsByChannel(channel);
 	}
 
 	void Audio_pauseContext(uint8 contextId)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->pauseContext(contextId, true);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().getAudioPlayer().pauseAllSoundsByContext(contextId);
 	}
 
 	void Audio_resumeContext(uint8 contextId)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->pauseContext(contextId, false);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().getAudioPlayer().resumeAllSoundsByContext(contextId);
 	}
 
 	void Audio_stopContext(uint8 contextId)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->stopContext(contextId);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().getAudioPlayer().stopAllSoundsByContext(contextId);
 	}
 
 	void Audio_fadeInChannel(uint8 channel, float seconds)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->fadeInChannel(channel);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().fadeInChannel(channel, seconds);
 	}
 
 	void Audio_fadeInChannel2(uint8 channel, uint16 length)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->fadeInChannel(channel);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().fadeInChannel(channel, (float)length / 256.0f);
 	}
 
 	void Audio_fadeOutChannel(uint8 channel, float seconds)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->fadeOutChannel(channel, seconds);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().fadeOutChannel(channel, seconds);
 	}
 
 	void Audio_fadeOutChannel2(uint8 channel, uint16 length)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->fadeOutChannel(channel, (float)length / 256.0f);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().fadeOutChannel(channel, (float)length / 256.0f);
 	}
 
 	void Audio_playOverride(uint64 sfxId, uint8 contextId, uint8 channelId, uint8 overriddenChannelId)
 	{
+		if (SimulationAudioState* audioState = getSimulationAudioState())
+			audioState->playOverride(sfxId, contextId, channelId, overriddenChannelId);
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().playOverride(sfxId, contextId, channelId, overriddenChannelId);
 	}
 
 	void Audio_enableAudioModifier(uint8 channel, uint8 contextId, lemon::StringRef postfix, float relativeSpeed)
 	{
+		if (!isMainSimulation())
+			return;
 		if (postfix.isValid())
 		{
 			EngineMain::instance().getAudioOut().enableAudioModifier(channel, contextId, postfix.getString(), relativeSpeed);
@@ -871,6 +955,8 @@ namespace
 
 	void Audio_enableAudioModifier2(uint8 channel, uint8 contextId, lemon::StringRef postfix, uint32 relativeSpeed)
 	{
+		if (!isMainSimulation())
+			return;
 		if (postfix.isValid())
 		{
 			EngineMain::instance().getAudioOut().enableAudioModifier(channel, contextId, postfix.getString(), (float)relativeSpeed / 65536.0f);
@@ -879,6 +965,8 @@ namespace
 
 	void Audio_disableAudioModifier(uint8 channel, uint8 contextId)
 	{
+		if (!isMainSimulation())
+			return;
 		EngineMain::instance().getAudioOut().disableAudioModifier(channel, contextId);
 	}
 
@@ -970,7 +1058,7 @@ namespace
 	{
 		if (Configuration::instance().mEnableROMDataAnalyser)
 		{
-			ROMDataAnalyser* analyser = Application::instance().getSimulation().getROMDataAnalyser();
+			ROMDataAnalyser* analyser = Simulation::instance().getROMDataAnalyser();
 			if (nullptr != analyser)
 			{
 				if (category.isValid())
@@ -986,7 +1074,7 @@ namespace
 	{
 		if (Configuration::instance().mEnableROMDataAnalyser)
 		{
-			ROMDataAnalyser* analyser = Application::instance().getSimulation().getROMDataAnalyser();
+			ROMDataAnalyser* analyser = Simulation::instance().getROMDataAnalyser();
 			if (nullptr != analyser)
 			{
 				if (category.isValid())
@@ -1001,7 +1089,7 @@ namespace
 	{
 		if (Configuration::instance().mEnableROMDataAnalyser)
 		{
-			ROMDataAnalyser* analyser = Application::instance().getSimulation().getROMDataAnalyser();
+			ROMDataAnalyser* analyser = Simulation::instance().getROMDataAnalyser();
 			if (nullptr != analyser)
 			{
 				analyser->endEntry();
@@ -1013,7 +1101,7 @@ namespace
 	{
 		if (Configuration::instance().mEnableROMDataAnalyser)
 		{
-			ROMDataAnalyser* analyser = Application::instance().getSimulation().getROMDataAnalyser();
+			ROMDataAnalyser* analyser = Simulation::instance().getROMDataAnalyser();
 			if (nullptr != analyser)
 			{
 				if (key.isValid() && value.isValid())
@@ -1028,7 +1116,7 @@ namespace
 	{
 		if (Configuration::instance().mEnableROMDataAnalyser)
 		{
-			ROMDataAnalyser* analyser = Application::instance().getSimulation().getROMDataAnalyser();
+			ROMDataAnalyser* analyser = Simulation::instance().getROMDataAnalyser();
 			if (nullptr != analyser)
 			{
 				if (key.isValid())
@@ -1043,7 +1131,7 @@ namespace
 	{
 		if (Configuration::instance().mEnableROMDataAnalyser)
 		{
-			ROMDataAnalyser* analyser = Application::instance().getSimulation().getROMDataAnalyser();
+			ROMDataAnalyser* analyser = Simulation::instance().getROMDataAnalyser();
 			if (nullptr != analyser)
 			{
 				analyser->endObject();
@@ -24,5 +24,5 @@ public:
 	void setDebugNotificationInterface(DebugNotificationInterface* debugNotificationInterface);
 
 public:
-	static inline DebugNotificationInterface* mDebugNotificationInterface = nullptr;
+	static inline thread_local DebugNotificationInterface* mDebugNotificationInterface = nullptr;
 };
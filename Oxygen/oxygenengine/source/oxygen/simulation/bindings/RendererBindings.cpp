@@ -14,6 +14,7 @@
 #include "oxygen/resources/FontCollection.h"
 #include "oxygen/simulation/EmulatorInterface.h"
 #include "oxygen/simulation/RuntimeEnvironment.h"
+#include "oxygen/simulation/Simulation.h"
 
 #include <lemon/program/ModuleBindingsBuilder.h>
 
@@ -570,7 +571,10 @@ namespace
 	{
 		width = clamp(width, 128, 1024);
 		height = clamp(height, 128, 1024);
-		VideoOut::instance().setScreenSize(width, height);
+
+		// Simulations running in parallel to the main simulation don't have a video output of their own
+		if (Simulation::instance().isDefaultInstance())
+			VideoOut::instance().setScreenSize(width, height);
 	}
 
 	void Renderer_resetViewport(uint16 renderQueue)
@@ -13,7 +13,6 @@
 #include "oxygen/simulation/LemonScriptProgram.h"
 #include "oxygen/simulation/LemonScriptRuntime.h"
 #include "oxygen/simulation/Simulation.h"
-#include "oxygen/application/Application.h"
 #include "oxygen/rendering/parts/palette/PaletteManager.h"
 
 #include <lemon/program/Function.h>
@@ -110,7 +109,7 @@ void DebugTracking::clearScriptLogValue(const std::string& key)
 
 DebugTracking::ScriptLogSingleEntry& DebugTracking::updateScriptLogValue(std::string_view key, std::string_view value)
 {
-	const uint32 frameNumber = Application::instance().getSimulation().getFrameNumber();
+	const uint32 frameNumber = Simulation::instance().getFrameNumber();
 	ScriptLogEntry& entry = mScriptLogEntries[std::string(key)];
 	if (frameNumber != entry.mLastUpdate)
 	{
@@ -146,7 +145,7 @@ void DebugTracking::addColorLogEntry(std::string_view name, uint32 startAddress,
 	}
 	addColorLogEntry(entry);
 
-	Application::instance().getSimulation().sendBreakSignal(Simulation::BreakCondition::DEBUG_LOG);
+	Simulation::instance().sendBreakSignal(Simulation::BreakCondition::DEBUG_LOG);
 }
 
 bool DebugTracking::hasWatch(uint32 address, uint16 bytes) const
@@ -331,7 +330,7 @@ void DebugTracking::onScriptLog(std::string_view key, std::string_view value)
 	mLemonScriptRuntime.getCurrentExecutionLocation(scriptLogSingleEntry.mLocation.mFunction, pc);
 	scriptLogSingleEntry.mLocation.mProgramCounter = pc;
 
-	Application::instance().getSimulation().sendBreakSignal(Simulation::BreakCondition::DEBUG_LOG);
+	Simulation::instance().sendBreakSignal(Simulation::BreakCondition::DEBUG_LOG);
 }
 
 void DebugTracking::onWatchTriggered(size_t watchIndex, uint32 address, uint16 bytes)
@@ -360,7 +359,7 @@ void DebugTracking::onWatchTriggered(size_t watchIndex, uint32 address, uint16 b
 	}
 	watch.mLastHitLocation = location;
 
-	Application::instance().getSimulation().sendBreakSignal(Simulation::BreakCondition::WATCH_HIT);
+	Simulation::instance().sendBreakSignal(Simulation::BreakCondition::WATCH_HIT);
 }
 
 void DebugTracking::onVRAMWrite(uint16 address, uint16 bytes)
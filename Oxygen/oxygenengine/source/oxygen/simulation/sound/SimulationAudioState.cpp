@@ -0,0 +1,298 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "oxygen/pch.h"
+#include "oxygen/simulation/sound/SimulationAudioState.h"
+#include "oxygen/application/audio/AudioCollection.h"
+
+
+SimulationAudioState::SimulationAudioState()
+{
+}
+
+SimulationAudioState::~SimulationAudioState()
+{
+}
+
+void SimulationAudioState::clear()
+{
+	mPlayingSounds.clear();
+	mChannelOverrides.clear();
+}
+
+void SimulationAudioState::updateFrame()
+{
+	for (size_t k = 0; k < mPlayingSounds.size(); ++k)
+	{
+		PlayingSound& sound = mPlayingSounds[k];
+		bool isPlaying = true;
+		if (!sound.mOverridden)
+		{
+			if (sound.mFadeOutFrames > 0)
+			{
+				--sound.mFadeOutFrames;
+				isPlaying = (sound.mFadeOutFrames > 0);
+			}
+			if (isPlaying && !sound.mPaused && nullptr != sound.mSoundDriver)
+			{
+				isPlaying = (sound.mSoundDriver->update() == SoundDriver::UpdateResult::CONTINUE);
+			}
+		}
+
+		if (!isPlaying)
+		{
+			mPlayingSounds.erase(mPlayingSounds.begin() + k);
+			--k;
+		}
+	}
+
+	// Channel overrides end together with the overriding sound
+	for (size_t k = 0; k < mChannelOverrides.size(); ++k)
+	{
+		ChannelOverride& channelOverride = mChannelOverrides[k];
+		if (channelOverride.mActive && nullptr == findSound(channelOverride.mPlayingSoundUniqueId))
+		{
+			channelOverride.mActive = false;
+		}
+
+		if (!channelOverride.mActive)
+		{
+			const int overriddenChannelId = channelOverride.mOverriddenChannelId;
+			const int contextId = channelOverride.mContextId;
+			mChannelOverrides.erase(mChannelOverrides.begin() + k);
+			--k;
+
+			if (!isChannelOverridden(overriddenChannelId, contextId))
+			{
+				setChannelOverridden(overriddenChannelId, contextId, false);
+			}
+		}
+	}
+}
+
+bool SimulationAudioState::isPlayingSfxId(uint64 sfxId) const
+{
+	for (const PlayingSound& sound : mPlayingSounds)
+	{
+		if (sound.mSfxId == sfxId)
+			return true;
+	}
+	return false;
+}
+
+void SimulationAudioState::playAudio(uint64 sfxId, uint8 contextId)
+{
+	const AudioCollection::AudioDefinition* audioDefinition = AudioCollection::instance().getAudioDefinition(sfxId);
+	if (nullptr != audioDefinition)
+	{
+		startSound(sfxId, audioDefinition->mChannel, contextId);
+	}
+}
+
+void SimulationAudioState::playOverride(uint64 sfxId, uint8 contextId, uint8 channelId, uint8 overriddenChannelId)
+{
+	// Deactivate duplicates first
+	for (ChannelOverride& channelOverride : mChannelOverrides)
+	{
+		if (channelOverride.mPlayingChannelId == channelId && channelOverride.mContextId == contextId)
+		{
+			channelOverride.mActive = false;
+		}
+	}
+
+	PlayingSound* sound = startSound(sfxId, channelId, contextId);
+	if (nullptr != sound)
+	{
+		ChannelOverride& channelOverride = vectorAdd(mChannelOverrides);
+		channelOverride.mPlayingChannelId = channelId;
+		channelOverride.mOverriddenChannelId = overriddenChannelId;
+		channelOverride.mContextId = contextId;
+		channelOverride.mPlayingSoundUniqueId = sound->mUniqueId;
+
+		setChannelOverridden(overriddenChannelId, contextId, true);
+	}
+}
+
+void SimulationAudioState::pauseChannel(uint8 channelId, bool pause)
+{
+	for (PlayingSound& sound : mPlayingSounds)
+	{
+		if (sound.mChannelId == channelId && !sound.mOverridden)
+			sound.mPaused = pause;
+	}
+}
+
+void SimulationAudioState::pauseContext(uint8 contextId, bool pause)
+{
+	for (PlayingSound& sound : mPlayingSounds)
+	{
+		if (sound.mContextId == contextId && !sound.mOverridden)
+			sound.mPaused = pause;
+	}
+}
+
+void SimulationAudioState::stopChannel(uint8 channelId)
+{
+	for (size_t k = 0; k < mPlayingSounds.size(); ++k)
+	{
+		if (mPlayingSounds[k].mChannelId == channelId)
+		{
+			mPlayingSounds.erase(mPlayingSounds.begin() + k);
+			--k;
+		}
+	}
+}
+
+void SimulationAudioState::stopContext(uint8 contextId)
+{
+	// Just like in the audio player, overridden sounds are not affected
+	for (size_t k = 0; k < mPlayingSounds.size(); ++k)
+	{
+		if (mPlayingSounds[k].mContextId == contextId && !mPlayingSounds[k].mOverridden)
+		{
+			mPlayingSounds.erase(mPlayingSounds.begin() + k);
+			--k;
+		}
+	}
+}
+
+void SimulationAudioState::fadeInChannel(uint8 channelId)
+{
+	for (PlayingSound& sound : mPlayingSounds)
+	{
+		if (sound.mChannelId == channelId && !sound.mOverridden)
+			sound.mFadeOutFrames = -1;
+	}
+}
+
+void SimulationAudioState::fadeOutChannel(uint8 channelId, float seconds)
+{
+	// The audio player treats a fade-out without a length as a fade-in
+	if (seconds <= 0.0f)
+	{
+		fadeInChannel(channelId);
+		return;
+	}
+
+	// Counting in frames at 60 Hz, not in real time
+	const int frames = std::max(roundToInt(seconds * 60.0f), 1);
+	for (PlayingSound& sound : mPlayingSounds)
+	{
+		if (sound.mChannelId == channelId && !sound.mOverridden)
+			sound.mFadeOutFrames = frames;
+	}
+}
+
+SimulationAudioState::PlayingSound* SimulationAudioState::startSound(uint64 sfxId, int channelId, int contextId)
+{
+	using SourceRegistration = AudioCollection::SourceRegistration;
+	const AudioCollection& audioCollection = AudioCollection::instance();
+	const SourceRegistration* sourceReg = audioCollection.getSourceRegistration(sfxId);
+	if (nullptr == sourceReg)
+		return nullptr;
+
+	// Stop all old sounds of this channel, like the audio player does
+	if (channelId != 0xff && sourceReg->mType != SourceRegistration::Type::EMULATION_CONTINUOUS)
+	{
+		for (size_t k = 0; k < mPlayingSounds.size(); ++k)
+		{
+			if (mPlayingSounds[k].mChannelId == channelId && mPlayingSounds[k].mContextId == contextId)
+			{
+				mPlayingSounds.erase(mPlayingSounds.begin() + k);
+				--k;
+			}
+		}
+	}
+
+	// Use the original soundtrack for the timing where possible, so that it does not depend on the selected soundtrack
+	const SourceRegistration& timingSourceReg = *audioCollection.getSourceRegistration(sfxId, AudioCollection::Package::ORIGINAL);
+	const bool isEmulated = (timingSourceReg.mType != SourceRegistration::Type::FILE);
+	const bool isDynamic = (timingSourceReg.mType == SourceRegistration::Type::EMULATION_DIRECT || timingSourceReg.mType == SourceRegistration::Type::EMULATION_CONTINUOUS);
+
+	if (isDynamic)
+	{
+		// Just tell the sound driver to play the new ID as well, and continue with this instance
+		for (PlayingSound& sound : mPlayingSounds)
+		{
+			if (sound.mDynamic && sound.mSfxId == sfxId)
+			{
+				sound.mSoundDriver->playSound(timingSourceReg.mEmulationSfxId);
+				return &sound;
+			}
+		}
+	}
+
+	PlayingSound& sound = vectorAdd(mPlayingSounds);
+	sound.mUniqueId = ++mLastUniqueId;
+	sound.mSfxId = sfxId;
+	sound.mChannelId = channelId;
+	sound.mContextId = contextId;
+	sound.mOverridden = isChannelOverridden(channelId, contextId);
+
+	if (isEmulated)
+	{
+		sound.mSoundDriver = std::make_unique<SoundDriver>();
+		if (!timingSourceReg.mSourceFile.empty())
+		{
+			// Note that moving the playing sound inside the vector does not move the content buffer
+			if (FTX::FileSystem->readFile(timingSourceReg.mSourceFile, sound.mContent) && !sound.mContent.empty())
+				sound.mSoundDriver->setFixedContent(&sound.mContent[0], (uint32)sound.mContent.size(), timingSourceReg.mContentOffset);
+			else
+				sound.mSoundDriver.reset();
+		}
+		else if (timingSourceReg.mSourceAddress != 0)
+		{
+			sound.mSoundDriver->setSourceAddress(timingSourceReg.mSourceAddress);
+		}
+	}
+
+	if (nullptr != sound.mSoundDriver)
+	{
+		sound.mDynamic = isDynamic;
+		sound.mSoundDriver->reset();
+		sound.mSoundDriver->playSound(timingSourceReg.mEmulationSfxId);
+	}
+	return &sound;
+}
+
+SimulationAudioState::PlayingSound* SimulationAudioState::findSound(uint32 uniqueId)
+{
+	for (PlayingSound& sound : mPlayingSounds)
+	{
+		if (sound.mUniqueId == uniqueId)
+			return &sound;
+	}
+	return nullptr;
+}
+
+bool SimulationAudioState::isChannelOverridden(int channelId, int contextId) const
+{
+	for (const ChannelOverride& channelOverride : mChannelOverrides)
+	{
+		if (channelOverride.mOverriddenChannelId == channelId && channelOverride.mContextId == contextId && channelOverride.mActive)
+			return true;
+	}
+	return false;
+}
+
+void SimulationAudioState::setChannelOverridden(int channelId, int contextId, bool overridden)
+{
+	for (PlayingSound& sound : mPlayingSounds)
+	{
+		if (sound.mChannelId == channelId && sound.mContextId == contextId && sound.mOverridden != overridden)
+		{
+			sound.mOverridden = overridden;
+			if (!overridden)
+			{
+				// Active again, the audio player fades it in and resumes it even if it was paused before
+				sound.mPaused = false;
+				sound.mFadeOutFrames = -1;
+			}
+		}
+	}
+}
@@ -0,0 +1,75 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "oxygen/simulation/sound/SoundDriver.h"
+
+
+// Playback state of the audio that scripts started, tracked by each simulation on its own and advanced once per simulated frame
+//  - Used instead of the audio output in headless runs, so that scripts querying the playback state get the same results in each simulation, independent of timing
+//  - Emulated sounds run their own sound driver instance to find out when they end; this always uses the original soundtrack's emulated source if there is one
+//  - Sounds without an emulated source count as playing until they get stopped or replaced
+//  - Audio modifiers (like faster music variants) are not considered
+class SimulationAudioState
+{
+public:
+	SimulationAudioState();
+	~SimulationAudioState();
+
+	void clear();
+	void updateFrame();
+
+	bool isPlayingSfxId(uint64 sfxId) const;
+
+	void playAudio(uint64 sfxId, uint8 contextId);
+	void playOverride(uint64 sfxId, uint8 contextId, uint8 channelId, uint8 overriddenChannelId);
+
+	void pauseChannel(uint8 channelId, bool pause);
+	void pauseContext(uint8 contextId, bool pause);
+	void stopChannel(uint8 channelId);
+	void stopContext(uint8 contextId);
+
+	void fadeInChannel(uint8 channelId);
+	void fadeOutChannel(uint8 channelId, float seconds);
+
+private:
+	struct PlayingSound
+	{
+		uint32 mUniqueId = 0;
+		uint64 mSfxId = 0;
+		int mChannelId = -1;
+		int mContextId = -1;
+		std::unique_ptr<SoundDriver> mSoundDriver;	// Only set for emulated sounds
+		std::vector<uint8> mContent;				// Only used for emulated sounds with custom content
+		bool mDynamic = false;						// Repeated starts are processed by the sound driver
+		bool mPaused = false;
+		bool mOverridden = false;					// Paused as well, while another channel overrides this one
+		int mFadeOutFrames = -1;					// Number of frames until the sound gets stopped, or -1 if not fading out
+	};
+
+	struct ChannelOverride
+	{
+		int mPlayingChannelId = -1;
+		int mOverriddenChannelId = -1;
+		int mContextId = -1;
+		uint32 mPlayingSoundUniqueId = 0;
+		bool mActive = true;
+	};
+
+private:
+	PlayingSound* startSound(uint64 sfxId, int channelId, int contextId);
+	PlayingSound* findSound(uint32 uniqueId);
+	bool isChannelOverridden(int channelId, int contextId) const;
+	void setChannelOverridden(int channelId, int contextId, bool overridden);
+
+private:
+	std::vector<PlayingSound> mPlayingSounds;
+	std::vector<ChannelOverride> mChannelOverrides;
+	uint32 mLastUniqueId = 0;
+};
@@ -433,6 +433,11 @@ public:
 		mEnforcedSourceAddress = sourceAddress;
 	}
 
+	void setRomReadTracking(SoundDriver::RomReadTracking* romReadTracking)
+	{
+		mRomReadTracking = romReadTracking;
+	}
+
 	void setTempoSpeedup(uint8 tempoSpeedup)
 	{
 		zTempoSpeedup = tempoSpeedup;
@@ -469,6 +474,13 @@ private:
 			if (nullptr == mFixedContentData || zBankBaseAddress != 0)
 			{
 				const uint32 fullAddress = zBankBaseAddress + (address & 0x7fff);
+				if (nullptr != mRomReadTracking)
+				{
+					if (fullAddress < 0x400000)
+						mRomReadTracking->mReadPages.setBit(fullAddress / SoundDriver::RomReadTracking::PAGE_SIZE);
+					else
+						mRomReadTracking->mReadOutsideRom = true;
+				}
 				return EmulatorInterface::instance().readMemory8(fullAddress);
 			}
 			else
@@ -3597,6 +3609,7 @@ private:
 	uint32 mFixedContentOffset = 0;
 	uint32 zBankBaseAddress = 0;
 	uint32 mEnforcedSourceAddress = 0;
+	SoundDriver::RomReadTracking* mRomReadTracking = nullptr;
 	uint32 mCycles = 0;
 	uint32 mFrameNumber = 0;
 	uint32 mNumFramesCalculated = 0;
@@ -3679,6 +3692,11 @@ void SoundDriver::setSourceAddress(uint32 sourceAddress)
 	mInternal.setSourceAddress(sourceAddress);
 }
 
+void SoundDriver::setRomReadTracking(RomReadTracking* romReadTracking)
+{
+	mInternal.setRomReadTracking(romReadTracking);
+}
+
 void SoundDriver::reset()
 {
 	mInternal.reset();
@@ -26,12 +26,25 @@ public:
 		STOP		// Enforce stop of sound incl. sound chips (used for 1-up jingle)
 	};
 
+	// Optional recording of which parts of the ROM the sound driver read, so that the output can be checked for changes in the ROM later on
+	struct RomReadTracking
+	{
+		static const constexpr uint32 PAGE_SIZE = 0x100;
+		static const constexpr uint32 NUM_PAGES = 0x400000 / PAGE_SIZE;
+
+		BitArray<NUM_PAGES> mReadPages;		// One bit for each page of ROM that got read
+		bool mReadOutsideRom = false;		// Set if there was any read from outside of the ROM, e.g. from RAM
+
+		void clear()  { mReadPages.clearAllBits(); mReadOutsideRom = false; }
+	};
+
 public:
 	SoundDriver();
 	~SoundDriver();
 
 	void setFixedContent(const uint8* data, uint32 size, uint32 offset);
 	void setSourceAddress(uint32 sourceAddress);
+	void setRomReadTracking(RomReadTracking* romReadTracking);
 
 	void reset();
 	void playSound(uint8 sfxId);
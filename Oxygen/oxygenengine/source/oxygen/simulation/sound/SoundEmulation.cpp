@@ -12,6 +12,7 @@
 #include "oxygen/simulation/sound/sn76489.h"
 #include "oxygen/simulation/sound/ym2612.h"
 #include "oxygen/helper/FileHelper.h"
+#include "oxygen/helper/HighResolutionTimer.h"
 
 
 struct SoundEmulation::Internal
@@ -230,3 +231,137 @@ void SoundEmulation::fmUpdate(uint32 cycles)
 		fm_cycles_count += samples * fm_cycles_ratio;
 	}
 }
+
+bool SoundEmulation::runBenchmark()
+{
+	// Synthetic songs made of random FM register writes, covering all algorithms, LFO, key on/off and frequency changes at random cycles
+	//  -> Songs with extra features also use SSG-EG, 3-slot and CSM mode, timers and the DAC, which the game's sound driver rarely or never does
+	//  -> The expected checksums are from the original FM chip implementation, so that any change in the output gets noticed
+	struct Scenario
+	{
+		const char* mName;
+		uint32 mSeed;
+		bool mExtraFeatures;
+		uint64 mExpectedChecksum;
+	};
+	static const Scenario SCENARIOS[] =
+	{
+		{ "Synthetic song 1", 0x1234, false, 0xd1a1930f743537b2 },
+		{ "Synthetic song 2", 0x5678, false, 0xc0c8214093e5edbf },
+		{ "Synthetic song with extra features 1", 0x9abc, true, 0xd34576c7df7eecb8 },
+		{ "Synthetic song with extra features 2", 0xdef0, true, 0x6c7ce152ac218b0e }
+	};
+
+	constexpr int SAMPLE_RATE = 48000;
+	constexpr int NUM_FRAMES = 60 * 60;		// One minute of audio
+	RMX_LOG_INFO("");
+	RMX_LOG_INFO("--- SOUND EMULATION BENCHMARK ---");
+
+	std::vector<SoundChipWrite> writes;
+	std::vector<int16> outBuffer(0x10000);
+	bool allMatching = true;
+	for (const Scenario& scenario : SCENARIOS)
+	{
+		uint32 rng = scenario.mSeed;
+		const auto nextRandom = [&]() { rng = rng * 1103515245 + 12345; return rng >> 16; };
+
+		uint32 cycles = 0;
+		const auto writeRegister = [&](int part, uint32 address, uint32 data)
+		{
+			SoundChipWrite& write = vectorAdd(writes);
+			write.mTarget = (part == 0) ? SoundChipWrite::Target::YAMAHA_FMI : SoundChipWrite::Target::YAMAHA_FMII;
+			write.mAddress = (uint8)address;
+			write.mData = (uint8)data;
+			write.mCycles = cycles;
+		};
+
+		std::unique_ptr<SoundEmulation> soundEmulation = std::make_unique<SoundEmulation>();
+		soundEmulation->init(SAMPLE_RATE, 60.0);
+
+		uint64 checksum = rmx::startFNV1a_64();
+		double seconds = 0.0;
+		HighResolutionTimer timer;
+
+		for (int frame = 0; frame < NUM_FRAMES; ++frame)
+		{
+			writes.clear();
+			cycles = nextRandom() % (MCYCLES_PER_FRAME / 2);
+			if (frame == 0)
+			{
+				writeRegister(0, 0x22, 0x08 | (nextRandom() & 0x07));	// LFO
+			}
+
+			if (nextRandom() % 3 == 0)
+			{
+				const int channel = nextRandom() % 6;
+				const int part = channel / 3;
+				const int c = channel % 3;
+
+				// New instrument
+				if (nextRandom() % 3 == 0)
+				{
+					for (int op = 0; op < 4; ++op)
+					{
+						const int offset = c + op * 4;
+						writeRegister(part, 0x30 + offset, nextRandom() & 0x7f);		// Detune, multiple
+						writeRegister(part, 0x40 + offset, nextRandom() % 0x30);		// Total level
+						writeRegister(part, 0x50 + offset, nextRandom() & 0xdf);		// Key scale, attack rate
+						writeRegister(part, 0x60 + offset, nextRandom() & 0x9f);		// AM enable, decay rate
+						writeRegister(part, 0x70 + offset, nextRandom() & 0x1f);		// Sustain rate
+						writeRegister(part, 0x80 + offset, nextRandom() & 0xff);		// Sustain level, release rate
+						writeRegister(part, 0x90 + offset, (scenario.mExtraFeatures && nextRandom() % 4 == 0) ? (0x08 | (nextRandom() & 0x07)) : 0);	// SSG-EG
+					}
+					writeRegister(part, 0xb0 + c, nextRandom() & 0x3f);				// Feedback, algorithm
+					writeRegister(part, 0xb4 + c, 0xc0 ^ ((nextRandom() % 4 == 0) ? 0x40 : 0) ^ (nextRandom() & 0x37));	// Panning, AMS, PMS
+				}
+
+				// Frequency and key on / off
+				const int block = nextRandom() & 0x07;
+				const int fnum = 0x200 + nextRandom() % 0x300;
+				writeRegister(part, 0xa4 + c, (block << 3) | (fnum >> 8));
+				writeRegister(part, 0xa0 + c, fnum & 0xff);
+				writeRegister(0, 0x28, ((nextRandom() % 4 == 0) ? 0x00 : 0xf0) | c | (part << 2));
+
+				if (scenario.mExtraFeatures)
+				{
+					switch (nextRandom() % 16)
+					{
+						case 0:  writeRegister(0, 0x27, 0x40);  break;		// 3-slot mode
+						case 1:  writeRegister(0, 0x27, 0x00);  break;
+						case 2:  writeRegister(0, 0x24, nextRandom() & 0xff);  writeRegister(0, 0x25, 0x03);  writeRegister(0, 0x27, 0x85);  break;	// CSM mode with timer A
+						case 3:  writeRegister(0, 0x2b, 0x80);  break;		// DAC on
+						case 4:  writeRegister(0, 0x2b, 0x00);  break;		// DAC off
+						case 5:  writeRegister(0, 0xac + nextRandom() % 3, nextRandom() & 0x3f);  writeRegister(0, 0xa8 + nextRandom() % 3, nextRandom() & 0xff);  break;	// 3-slot frequencies
+						case 6:  writeRegister(0, 0x22, nextRandom() & 0x0f);  break;		// LFO on / off
+					}
+				}
+			}
+
+			if (scenario.mExtraFeatures)
+			{
+				// DAC samples spread over the frame
+				while (cycles < MCYCLES_PER_FRAME - 0x4000)
+				{
+					cycles += 0x800 + nextRandom() % 0x2000;
+					writeRegister(0, 0x2a, nextRandom() & 0xff);
+				}
+			}
+
+			timer.start();
+			const int length = soundEmulation->update(&outBuffer[0], writes);
+			seconds += timer.getSecondsSinceStart();
+			checksum = rmx::addToFNV1a_64(checksum, (const uint8*)&outBuffer[0], length * 2 * sizeof(int16));
+		}
+
+		const bool matching = (checksum == scenario.mExpectedChecksum);
+		allMatching = allMatching && matching;
+		RMX_LOG_INFO(scenario.mName << ":");
+		RMX_LOG_INFO("   Emulation:  " << roundToInt(seconds * 1000.0) << " ms per minute of audio (checksum " << rmx::hexString(checksum, 16) << (matching ? ", OK)" : ", MISMATCH)"));
+	}
+
+	if (!allMatching)
+	{
+		RMX_LOG_ERROR("Sound emulation output differs from the expected output");
+	}
+	return allMatching;
+}
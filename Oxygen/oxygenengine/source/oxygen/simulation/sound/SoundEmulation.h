@@ -24,6 +24,8 @@ public:
 	void shutdown();
 	int update(int16* outBuffer, const std::vector<SoundChipWrite>& inputData);
 
+	static bool runBenchmark();
+
 private:
 	int internalUpdate(uint32 cycles, const std::vector<SoundChipWrite>& inputData);
 	void fmUpdate(uint32 cycles);
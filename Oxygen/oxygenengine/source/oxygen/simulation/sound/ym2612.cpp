@@ -142,6 +142,16 @@
 #include "oxygen/pch.h"
 #include "oxygen/simulation/sound/ym2612.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+	#define YM2612_SIMD
+	#define YM2612_SSE2
+	#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define YM2612_SIMD
+	#define YM2612_NEON
+	#include <arm_neon.h>
+#endif
+
 
 namespace soundemulation
 {
@@ -232,6 +242,10 @@ namespace soundemulation
 		/*18 */ 0, 0, 0, 0, 0, 0, 0, 0, /* infinity rates for attack and decay(s) */
 	};
 
+	/* the rows of eg_inc with one 4-bit increment per cycle, so the increment can be extracted with shifts only */
+	/* row 17 is never selected (see eg_rate_select), all other increments fit into 4 bits */
+	static uint32 eg_inc_rows[19];
+
 
 	#define O(a) (a*RATE_STEPS)
 
@@ -491,10 +505,101 @@ namespace soundemulation
 	#define SLOT4 3
 
 
+	/* EG increment for the current cycle, from a row of eg_inc_rows */
+	inline uint32 eg_increment(uint32 row, uint32 shift, uint32 eg_cnt)
+	{
+		return (row >> (((eg_cnt >> shift) & 7) * 4)) & 0x0f;
+	}
+
+	/* operator state in FM_CH is stored as arrays indexed by SLOT, so each of the four SLOTs of a channel gets processed in its own SIMD lane */
+#if defined(YM2612_SSE2)
+	typedef __m128i Lanes;
+
+	inline Lanes loadLanes(const void* ptr)				{ return _mm_loadu_si128((const __m128i*)ptr); }
+	inline void storeLanes(void* ptr, Lanes x)			{ _mm_storeu_si128((__m128i*)ptr, x); }
+	inline Lanes broadcast(int32 x)						{ return _mm_set1_epi32(x); }
+	inline Lanes add(Lanes a, Lanes b)					{ return _mm_add_epi32(a, b); }
+	inline Lanes bitAnd(Lanes a, Lanes b)				{ return _mm_and_si128(a, b); }
+	inline Lanes bitAndNot(Lanes a, Lanes b)			{ return _mm_andnot_si128(a, b); }		/* ~a & b */
+	inline Lanes bitOr(Lanes a, Lanes b)				{ return _mm_or_si128(a, b); }
+	inline Lanes bitNot(Lanes a)						{ return _mm_xor_si128(a, _mm_set1_epi32(-1)); }
+	inline Lanes equal(Lanes a, Lanes b)				{ return _mm_cmpeq_epi32(a, b); }
+	inline Lanes greater(Lanes a, Lanes b)				{ return _mm_cmpgt_epi32(a, b); }		/* signed */
+	inline Lanes select(Lanes mask, Lanes a, Lanes b)	{ return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+	inline bool anyLane(Lanes mask)						{ return _mm_movemask_epi8(mask) != 0; }
+	template<int N> Lanes shiftLeft(Lanes a)			{ return _mm_slli_epi32(a, N); }
+	template<int N> Lanes shiftRightArithmetic(Lanes a)	{ return _mm_srai_epi32(a, N); }
+
+	inline Lanes multiplySmall(Lanes a, Lanes b)
+	{
+		/* both values need to fit into 16 bits (signed a, non-negative b): then the multiply-add of 16-bit halves gives the exact 32-bit product */
+		return _mm_madd_epi16(a, b);
+	}
+
+	inline Lanes shiftRightVariable(Lanes value, Lanes count)
+	{
+		/* SSE2 has no per-lane shift, so shift by each bit of the count (0..31) separately */
+		const auto step = [&](Lanes shifted, int bit)
+		{
+			const Lanes mask = equal(bitAnd(count, broadcast(bit)), broadcast(bit));
+			value = select(mask, shifted, value);
+		};
+		step(_mm_srli_epi32(value, 1), 1);
+		step(_mm_srli_epi32(value, 2), 2);
+		step(_mm_srli_epi32(value, 4), 4);
+		step(_mm_srli_epi32(value, 8), 8);
+		step(_mm_srli_epi32(value, 16), 16);
+		return value;
+	}
+#elif defined(YM2612_NEON)
+	typedef int32x4_t Lanes;
+
+	inline Lanes loadLanes(const void* ptr)				{ return vld1q_s32((const int32_t*)ptr); }
+	inline void storeLanes(void* ptr, Lanes x)			{ vst1q_s32((int32_t*)ptr, x); }
+	inline Lanes broadcast(int32 x)						{ return vdupq_n_s32(x); }
+	inline Lanes add(Lanes a, Lanes b)					{ return vaddq_s32(a, b); }
+	inline Lanes bitAnd(Lanes a, Lanes b)				{ return vandq_s32(a, b); }
+	inline Lanes bitAndNot(Lanes a, Lanes b)			{ return vbicq_s32(b, a); }		/* ~a & b */
+	inline Lanes bitOr(Lanes a, Lanes b)				{ return vorrq_s32(a, b); }
+	inline Lanes bitNot(Lanes a)						{ return vmvnq_s32(a); }
+	inline Lanes equal(Lanes a, Lanes b)				{ return vreinterpretq_s32_u32(vceqq_s32(a, b)); }
+	inline Lanes greater(Lanes a, Lanes b)				{ return vreinterpretq_s32_u32(vcgtq_s32(a, b)); }		/* signed */
+	inline Lanes select(Lanes mask, Lanes a, Lanes b)	{ return vbslq_s32(vreinterpretq_u32_s32(mask), a, b); }
+	inline bool anyLane(Lanes mask)						{ return vmaxvq_u32(vreinterpretq_u32_s32(mask)) != 0; }
+	template<int N> Lanes shiftLeft(Lanes a)			{ return vshlq_n_s32(a, N); }
+	template<int N> Lanes shiftRightArithmetic(Lanes a)	{ return vshrq_n_s32(a, N); }
+	inline Lanes multiplySmall(Lanes a, Lanes b)		{ return vmulq_s32(a, b); }
+	inline Lanes shiftRightVariable(Lanes value, Lanes count)	{ return vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(value), vnegq_s32(count))); }
+#endif
+
+#if defined(YM2612_SIMD)
+	static const int32 LANE_BITS[4] = { 1, 2, 4, 8 };
+#endif
+
+	/* phase counters of all four SLOTs of a channel advance together */
+	inline void advance_phases(uint32* phase, const uint32* incr)
+	{
+	#if defined(YM2612_SIMD)
+		storeLanes(phase, add(loadLanes(phase), loadLanes(incr)));
+	#else
+		for (int s = 0; s < 4; ++s)
+			phase[s] += incr[s];
+	#endif
+	}
+
+
 	/***********************************************************/
 	/* YM2612 chip                                             */
 	/***********************************************************/
 
+	/* set counter shift and increments of the EG rate used in the given state */
+	void YM2612::set_eg_rate(FM_CH *channel, int s, int state, uint8 shift, uint8 rate_select)
+	{
+		channel->eg_sh[state][s] = shift;
+		channel->eg_mask[state][s] = (1 << shift) - 1;
+		channel->eg_inc_row[state][s] = eg_inc_rows[rate_select / RATE_STEPS];
+	}
+
 	void YM2612::FM_KEYON(FM_CH *channel, int s)
 	{
 		FM_SLOT *SLOT = &channel->SLOT[s];
@@ -502,29 +607,29 @@ namespace soundemulation
 		if (!SLOT->key && !OPN.SL3.key_csm)
 		{
 			/* restart Phase Generator */
-			SLOT->phase = 0;
+			channel->phase[s] = 0;
 
 			/* reset SSG-EG inversion flag */
 			SLOT->ssgn = 0;
 
 			if ((SLOT->ar + SLOT->ksr) < 94 /*32+62*/)
 			{
-				SLOT->state = (SLOT->volume <= MIN_ATT_INDEX) ? ((SLOT->sl == MIN_ATT_INDEX) ? EG_SUS : EG_DEC) : EG_ATT;
+				channel->state[s] = (channel->volume[s] <= MIN_ATT_INDEX) ? ((channel->sl[s] == MIN_ATT_INDEX) ? EG_SUS : EG_DEC) : EG_ATT;
 			}
 			else
 			{
 				/* force attenuation level to 0 */
-				SLOT->volume = MIN_ATT_INDEX;
+				channel->volume[s] = MIN_ATT_INDEX;
 
 				/* directly switch to Decay (or Sustain) */
-				SLOT->state = (SLOT->sl == MIN_ATT_INDEX) ? EG_SUS : EG_DEC;
+				channel->state[s] = (channel->sl[s] == MIN_ATT_INDEX) ? EG_SUS : EG_DEC;
 			}
 
 			/* recalculate EG output */
 			if ((SLOT->ssg & 0x08) && (SLOT->ssgn ^ (SLOT->ssg & 0x04)))
-				SLOT->vol_out = ((uint32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+				channel->vol_out[s] = ((uint32)(0x200 - channel->volume[s]) & MAX_ATT_INDEX) + channel->tl[s];
 			else
-				SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
+				channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
 		}
 
 		SLOT->key = 1;
@@ -536,26 +641,26 @@ namespace soundemulation
 
 		if (SLOT->key && !OPN.SL3.key_csm)
 		{
-			if (SLOT->state > EG_REL)
+			if (channel->state[s] > EG_REL)
 			{
-				SLOT->state = EG_REL; /* phase -> Release */
+				channel->state[s] = EG_REL; /* phase -> Release */
 
 				/* SSG-EG specific update */
 				if (SLOT->ssg & 0x08)
 				{
 					/* convert EG attenuation level */
 					if (SLOT->ssgn ^ (SLOT->ssg & 0x04))
-						SLOT->volume = (0x200 - SLOT->volume);
+						channel->volume[s] = (0x200 - channel->volume[s]);
 
 					/* force EG attenuation level */
-					if (SLOT->volume >= 0x200)
+					if (channel->volume[s] >= 0x200)
 					{
-						SLOT->volume = MAX_ATT_INDEX;
-						SLOT->state = EG_OFF;
+						channel->volume[s] = MAX_ATT_INDEX;
+						channel->state[s] = EG_OFF;
 					}
 
 					/* recalculate EG output */
-					SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
+					channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
 				}
 			}
 		}
@@ -570,29 +675,29 @@ namespace soundemulation
 		if (!SLOT->key && !OPN.SL3.key_csm)
 		{
 			/* restart Phase Generator */
-			SLOT->phase = 0;
+			channel->phase[s] = 0;
 
 			/* reset SSG-EG inversion flag */
 			SLOT->ssgn = 0;
 
 			if ((SLOT->ar + SLOT->ksr) < 94 /*32+62*/)
 			{
-				SLOT->state = (SLOT->volume <= MIN_ATT_INDEX) ? ((SLOT->sl == MIN_ATT_INDEX) ? EG_SUS : EG_DEC) : EG_ATT;
+				channel->state[s] = (channel->volume[s] <= MIN_ATT_INDEX) ? ((channel->sl[s] == MIN_ATT_INDEX) ? EG_SUS : EG_DEC) : EG_ATT;
 			}
 			else
 			{
 				/* force attenuation level to 0 */
-				SLOT->volume = MIN_ATT_INDEX;
+				channel->volume[s] = MIN_ATT_INDEX;
 
 				/* directly switch to Decay (or Sustain) */
-				SLOT->state = (SLOT->sl == MIN_ATT_INDEX) ? EG_SUS : EG_DEC;
+				channel->state[s] = (channel->sl[s] == MIN_ATT_INDEX) ? EG_SUS : EG_DEC;
 			}
 
 			/* recalculate EG output */
 			if ((SLOT->ssg & 0x08) && (SLOT->ssgn ^ (SLOT->ssg & 0x04)))
-				SLOT->vol_out = ((uint32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+				channel->vol_out[s] = ((uint32)(0x200 - channel->volume[s]) & MAX_ATT_INDEX) + channel->tl[s];
 			else
-				SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
+				channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
 		}
 	}
 
@@ -601,26 +706,26 @@ namespace soundemulation
 		FM_SLOT *SLOT = &channel->SLOT[s];
 		if (!SLOT->key)
 		{
-			if (SLOT->state > EG_REL)
+			if (channel->state[s] > EG_REL)
 			{
-				SLOT->state = EG_REL; /* phase -> Release */
+				channel->state[s] = EG_REL; /* phase -> Release */
 
 				/* SSG-EG specific update */
 				if (SLOT->ssg & 0x08)
 				{
 					/* convert EG attenuation level */
 					if (SLOT->ssgn ^ (SLOT->ssg & 0x04))
-						SLOT->volume = (0x200 - SLOT->volume);
+						channel->volume[s] = (0x200 - channel->volume[s]);
 
 					/* force EG attenuation level */
-					if (SLOT->volume >= 0x200)
+					if (channel->volume[s] >= 0x200)
 					{
-						SLOT->volume = MAX_ATT_INDEX;
-						SLOT->state = EG_OFF;
+						channel->volume[s] = MAX_ATT_INDEX;
+						channel->state[s] = EG_OFF;
 					}
 
 					/* recalculate EG output */
-					SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
+					channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
 				}
 			}
 		}
@@ -693,7 +798,7 @@ namespace soundemulation
 		if ((OPN.ST.mode ^ v) & 0xC0)
 		{
 			/* phase increment need to be recalculated */
-			mChannels[2].SLOT[SLOT1].Incr = -1;
+			mChannels[2].Incr[SLOT1] = -1;
 
 			/* CSM mode disabled and CSM key ON active*/
 			if (((v & 0xC0) != 0x80) && OPN.SL3.key_csm)
@@ -719,117 +824,32 @@ namespace soundemulation
 		OPN.ST.mode = v;
 	}
 
-	/* set algorithm connection */
-	void YM2612::setup_connection(FM_CH *channel, int ch)
-	{
-		int32 *carrier = &out_fm[ch];
-
-		int32 **om1 = &channel->connect1;
-		int32 **om2 = &channel->connect3;
-		int32 **oc1 = &channel->connect2;
-
-		int32 **memc = &channel->mem_connect;
-
-		switch (channel->ALGO)
-		{
-			case 0:
-				/* M1---C1---MEM---M2---C2---OUT */
-				*om1 = &c1;
-				*oc1 = &mem;
-				*om2 = &c2;
-				*memc = &m2;
-				break;
-			case 1:
-				/* M1------+-MEM---M2---C2---OUT */
-				/*      C1-+                     */
-				*om1 = &mem;
-				*oc1 = &mem;
-				*om2 = &c2;
-				*memc = &m2;
-				break;
-			case 2:
-				/* M1-----------------+-C2---OUT */
-				/*      C1---MEM---M2-+          */
-				*om1 = &c2;
-				*oc1 = &mem;
-				*om2 = &c2;
-				*memc = &m2;
-				break;
-			case 3:
-				/* M1---C1---MEM------+-C2---OUT */
-				/*                 M2-+          */
-				*om1 = &c1;
-				*oc1 = &mem;
-				*om2 = &c2;
-				*memc = &c2;
-				break;
-			case 4:
-				/* M1---C1-+-OUT */
-				/* M2---C2-+     */
-				/* MEM: not used */
-				*om1 = &c1;
-				*oc1 = carrier;
-				*om2 = &c2;
-				*memc = &mem;  /* store it anywhere where it will not be used */
-				break;
-			case 5:
-				/*    +----C1----+     */
-				/* M1-+-MEM---M2-+-OUT */
-				/*    +----C2----+     */
-				*om1 = 0;  /* special mark */
-				*oc1 = carrier;
-				*om2 = carrier;
-				*memc = &m2;
-				break;
-			case 6:
-				/* M1---C1-+     */
-				/*      M2-+-OUT */
-				/*      C2-+     */
-				/* MEM: not used */
-				*om1 = &c1;
-				*oc1 = carrier;
-				*om2 = carrier;
-				*memc = &mem;  /* store it anywhere where it will not be used */
-				break;
-			case 7:
-				/* M1-+     */
-				/* C1-+-OUT */
-				/* M2-+     */
-				/* C2-+     */
-				/* MEM: not used*/
-				*om1 = carrier;
-				*oc1 = carrier;
-				*om2 = carrier;
-				*memc = &mem;  /* store it anywhere where it will not be used */
-				break;
-		}
-
-		channel->connect4 = carrier;
-	}
-
 	/* set detune & multiple */
-	void YM2612::set_det_mul(FM_CH *channel, FM_SLOT *SLOT, int v)
+	void YM2612::set_det_mul(FM_CH *channel, int s, int v)
 	{
+		FM_SLOT *SLOT = &channel->SLOT[s];
 		SLOT->mul = (v & 0x0f) ? (v & 0x0f) * 2 : 1;
 		SLOT->DT = OPN.ST.dt_tab[(v >> 4) & 7];
-		channel->SLOT[SLOT1].Incr = -1;
+		channel->Incr[SLOT1] = -1;
 	}
 
 	/* set total level */
-	void YM2612::set_tl(FM_SLOT *SLOT, int v)
+	void YM2612::set_tl(FM_CH *channel, int s, int v)
 	{
-		SLOT->tl = (v & 0x7f) << (ENV_BITS - 7); /* 7bit TL */
+		FM_SLOT *SLOT = &channel->SLOT[s];
+		channel->tl[s] = (v & 0x7f) << (ENV_BITS - 7); /* 7bit TL */
 
 		/* recalculate EG output */
-		if ((SLOT->ssg & 0x08) && (SLOT->ssgn ^ (SLOT->ssg & 0x04)) && (SLOT->state > EG_REL))
-			SLOT->vol_out = ((uint32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+		if ((SLOT->ssg & 0x08) && (SLOT->ssgn ^ (SLOT->ssg & 0x04)) && (channel->state[s] > EG_REL))
+			channel->vol_out[s] = ((uint32)(0x200 - channel->volume[s]) & MAX_ATT_INDEX) + channel->tl[s];
 		else
-			SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
+			channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
 	}
 
 	/* set attack rate & key scale  */
-	void YM2612::set_ar_ksr(FM_CH *channel, FM_SLOT *SLOT, int v)
+	void YM2612::set_ar_ksr(FM_CH *channel, int s, int v)
 	{
+		FM_SLOT *SLOT = &channel->SLOT[s];
 		uint8 old_KSR = SLOT->KSR;
 
 		SLOT->ar = (v & 0x1f) ? 32 + ((v & 0x1f) << 1) : 0;
@@ -837,7 +857,7 @@ namespace soundemulation
 		SLOT->KSR = 3 - (v >> 6);
 		if (SLOT->KSR != old_KSR)
 		{
-			channel->SLOT[SLOT1].Incr = -1;
+			channel->Incr[SLOT1] = -1;
 		}
 
 		/* Even if it seems unnecessary to do it here, it could happen that KSR and KC  */
@@ -846,49 +866,46 @@ namespace soundemulation
 		/* This actually fixes the intro of "The Adventures of Batman & Robin" (Eke-Eke)         */
 		if ((SLOT->ar + SLOT->ksr) < (32 + 62))
 		{
-			SLOT->eg_sh_ar = eg_rate_shift[SLOT->ar + SLOT->ksr];
-			SLOT->eg_sel_ar = eg_rate_select[SLOT->ar + SLOT->ksr];
+			set_eg_rate(channel, s, EG_ATT, eg_rate_shift[SLOT->ar + SLOT->ksr], eg_rate_select[SLOT->ar + SLOT->ksr]);
 		}
 		else
 		{
 			/* verified by Nemesis on real hardware (Attack phase is blocked) */
-			SLOT->eg_sh_ar = 0;
-			SLOT->eg_sel_ar = 18 * RATE_STEPS;
+			set_eg_rate(channel, s, EG_ATT, 0, 18 * RATE_STEPS);
 		}
 	}
 
 	/* set decay rate */
-	void YM2612::set_dr(FM_SLOT *SLOT, int v)
+	void YM2612::set_dr(FM_CH *channel, int s, int v)
 	{
+		FM_SLOT *SLOT = &channel->SLOT[s];
 		SLOT->d1r = (v & 0x1f) ? 32 + ((v & 0x1f) << 1) : 0;
 
-		SLOT->eg_sh_d1r = eg_rate_shift[SLOT->d1r + SLOT->ksr];
-		SLOT->eg_sel_d1r = eg_rate_select[SLOT->d1r + SLOT->ksr];
-
+		set_eg_rate(channel, s, EG_DEC, eg_rate_shift[SLOT->d1r + SLOT->ksr], eg_rate_select[SLOT->d1r + SLOT->ksr]);
 	}
 
 	/* set sustain rate */
-	void YM2612::set_sr(FM_SLOT *SLOT, int v)
+	void YM2612::set_sr(FM_CH *channel, int s, int v)
 	{
+		FM_SLOT *SLOT = &channel->SLOT[s];
 		SLOT->d2r = (v & 0x1f) ? 32 + ((v & 0x1f) << 1) : 0;
 
-		SLOT->eg_sh_d2r = eg_rate_shift[SLOT->d2r + SLOT->ksr];
-		SLOT->eg_sel_d2r = eg_rate_select[SLOT->d2r + SLOT->ksr];
+		set_eg_rate(channel, s, EG_SUS, eg_rate_shift[SLOT->d2r + SLOT->ksr], eg_rate_select[SLOT->d2r + SLOT->ksr]);
 	}
 
 	/* set release rate */
-	void YM2612::set_sl_rr(FM_SLOT *SLOT, int v)
+	void YM2612::set_sl_rr(FM_CH *channel, int s, int v)
 	{
-		SLOT->sl = sl_table[v >> 4];
+		FM_SLOT *SLOT = &channel->SLOT[s];
+		channel->sl[s] = sl_table[v >> 4];
 
 		/* check EG state changes */
-		if ((SLOT->state == EG_DEC) && (SLOT->volume >= (int32)(SLOT->sl)))
-			SLOT->state = EG_SUS;
+		if ((channel->state[s] == EG_DEC) && (channel->volume[s] >= (int32)(channel->sl[s])))
+			channel->state[s] = EG_SUS;
 
 		SLOT->rr = 34 + ((v & 0x0f) << 2);
 
-		SLOT->eg_sh_rr = eg_rate_shift[SLOT->rr + SLOT->ksr];
-		SLOT->eg_sel_rr = eg_rate_select[SLOT->rr + SLOT->ksr];
+		set_eg_rate(channel, s, EG_REL, eg_rate_shift[SLOT->rr + SLOT->ksr], eg_rate_select[SLOT->rr + SLOT->ksr]);
 	}
 
 	/* advance LFO to next sample */
@@ -920,162 +937,218 @@ namespace soundemulation
 		}
 	}
 
-	void YM2612::advance_eg_channels(FM_CH *channel, unsigned int eg_cnt)
+	/* advance the envelope generator of a single SLOT */
+	void YM2612::advance_eg_slot(FM_CH *channel, int s, unsigned int eg_cnt)
 	{
-		unsigned int i = 6; /* six channels */
-		unsigned int j;
-		FM_SLOT *SLOT;
+		FM_SLOT *SLOT = &channel->SLOT[s];
+		const uint32 state = channel->state[s];
 
-		do
+		/* the EG state only changes when the counter matches the rate of the current phase */
+		if ((state == EG_OFF) || (eg_cnt & channel->eg_mask[state][s]))
+			return;
+
+		const int32 inc = (int32)eg_increment(channel->eg_inc_row[state][s], channel->eg_sh[state][s], eg_cnt);
+
+		switch (state)
 		{
-			SLOT = &channel->SLOT[SLOT1];
-			j = 4; /* four operators per channel */
-			do
+			case EG_ATT:    /* attack phase */
 			{
-				switch (SLOT->state)
+				/* update attenuation level */
+				channel->volume[s] += (~channel->volume[s] * inc) >> 4;
+
+				/* check phase transition*/
+				if (channel->volume[s] <= MIN_ATT_INDEX)
 				{
-					case EG_ATT:    /* attack phase */
-					{
-						if (!(eg_cnt & ((1 << SLOT->eg_sh_ar) - 1)))
-						{
-							/* update attenuation level */
-							SLOT->volume += (~SLOT->volume * (eg_inc[SLOT->eg_sel_ar + ((eg_cnt >> SLOT->eg_sh_ar) & 7)])) >> 4;
+					channel->volume[s] = MIN_ATT_INDEX;
+					channel->state[s] = (channel->sl[s] == MIN_ATT_INDEX) ? EG_SUS : EG_DEC; /* special case where SL=0 */
+				}
 
-							/* check phase transition*/
-							if (SLOT->volume <= MIN_ATT_INDEX)
-							{
-								SLOT->volume = MIN_ATT_INDEX;
-								SLOT->state = (SLOT->sl == MIN_ATT_INDEX) ? EG_SUS : EG_DEC; /* special case where SL=0 */
-							}
+				/* recalculate EG output */
+				if ((SLOT->ssg & 0x08) && (SLOT->ssgn ^ (SLOT->ssg & 0x04)))  /* SSG-EG Output Inversion */
+					channel->vol_out[s] = ((uint32)(0x200 - channel->volume[s]) & MAX_ATT_INDEX) + channel->tl[s];
+				else
+					channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
+				break;
+			}
 
-							/* recalculate EG output */
-							if ((SLOT->ssg & 0x08) && (SLOT->ssgn ^ (SLOT->ssg & 0x04)))  /* SSG-EG Output Inversion */
-								SLOT->vol_out = ((uint32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
-							else
-								SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
-						}
-						break;
+			case EG_DEC:  /* decay phase */
+			{
+				/* SSG EG type */
+				if (SLOT->ssg & 0x08)
+				{
+					/* update attenuation level */
+					if (channel->volume[s] < 0x200)
+					{
+						channel->volume[s] += 4 * inc;
+
+						/* recalculate EG output */
+						if (SLOT->ssgn ^ (SLOT->ssg & 0x04))   /* SSG-EG Output Inversion */
+							channel->vol_out[s] = ((uint32)(0x200 - channel->volume[s]) & MAX_ATT_INDEX) + channel->tl[s];
+						else
+							channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
 					}
+				}
+				else
+				{
+					/* update attenuation level */
+					channel->volume[s] += inc;
 
-					case EG_DEC:  /* decay phase */
-					{
-						if (!(eg_cnt & ((1 << SLOT->eg_sh_d1r) - 1)))
-						{
-							/* SSG EG type */
-							if (SLOT->ssg & 0x08)
-							{
-								/* update attenuation level */
-								if (SLOT->volume < 0x200)
-								{
-									SLOT->volume += 4 * eg_inc[SLOT->eg_sel_d1r + ((eg_cnt >> SLOT->eg_sh_d1r) & 7)];
+					/* recalculate EG output */
+					channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
+				}
 
-									/* recalculate EG output */
-									if (SLOT->ssgn ^ (SLOT->ssg & 0x04))   /* SSG-EG Output Inversion */
-										SLOT->vol_out = ((uint32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
-									else
-										SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
-								}
-							}
-							else
-							{
-								/* update attenuation level */
-								SLOT->volume += eg_inc[SLOT->eg_sel_d1r + ((eg_cnt >> SLOT->eg_sh_d1r) & 7)];
+				/* check phase transition*/
+				if (channel->volume[s] >= (int32)(channel->sl[s]))
+					channel->state[s] = EG_SUS;
+				break;
+			}
 
-								/* recalculate EG output */
-								SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
-							}
+			case EG_SUS:  /* sustain phase */
+			{
+				/* SSG EG type */
+				if (SLOT->ssg & 0x08)
+				{
+					/* update attenuation level */
+					if (channel->volume[s] < 0x200)
+					{
+						channel->volume[s] += 4 * inc;
 
-							/* check phase transition*/
-							if (SLOT->volume >= (int32)(SLOT->sl))
-								SLOT->state = EG_SUS;
-						}
-						break;
+						/* recalculate EG output */
+						if (SLOT->ssgn ^ (SLOT->ssg & 0x04))   /* SSG-EG Output Inversion */
+							channel->vol_out[s] = ((uint32)(0x200 - channel->volume[s]) & MAX_ATT_INDEX) + channel->tl[s];
+						else
+							channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
 					}
+				}
+				else
+				{
+					/* update attenuation level */
+					channel->volume[s] += inc;
 
-					case EG_SUS:  /* sustain phase */
-					{
-						if (!(eg_cnt & ((1 << SLOT->eg_sh_d2r) - 1)))
-						{
-							/* SSG EG type */
-							if (SLOT->ssg & 0x08)
-							{
-								/* update attenuation level */
-								if (SLOT->volume < 0x200)
-								{
-									SLOT->volume += 4 * eg_inc[SLOT->eg_sel_d2r + ((eg_cnt >> SLOT->eg_sh_d2r) & 7)];
+					/* check phase transition*/
+					if (channel->volume[s] >= MAX_ATT_INDEX)
+						channel->volume[s] = MAX_ATT_INDEX;
+					/* do not change SLOT->state (verified on real chip) */
 
-									/* recalculate EG output */
-									if (SLOT->ssgn ^ (SLOT->ssg & 0x04))   /* SSG-EG Output Inversion */
-										SLOT->vol_out = ((uint32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
-									else
-										SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
-								}
-							}
-							else
-							{
-								/* update attenuation level */
-								SLOT->volume += eg_inc[SLOT->eg_sel_d2r + ((eg_cnt >> SLOT->eg_sh_d2r) & 7)];
+					/* recalculate EG output */
+					channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
+				}
+				break;
+			}
 
-								/* check phase transition*/
-								if (SLOT->volume >= MAX_ATT_INDEX)
-									SLOT->volume = MAX_ATT_INDEX;
-								/* do not change SLOT->state (verified on real chip) */
+			case EG_REL:  /* release phase */
+			{
+				/* SSG EG type */
+				if (SLOT->ssg & 0x08)
+				{
+					/* update attenuation level */
+					if (channel->volume[s] < 0x200)
+						channel->volume[s] += 4 * inc;
 
-								/* recalculate EG output */
-								SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
-							}
-						}
-						break;
+					/* check phase transition */
+					if (channel->volume[s] >= 0x200)
+					{
+						channel->volume[s] = MAX_ATT_INDEX;
+						channel->state[s] = EG_OFF;
 					}
+				}
+				else
+				{
+					/* update attenuation level */
+					channel->volume[s] += inc;
 
-					case EG_REL:  /* release phase */
+					/* check phase transition*/
+					if (channel->volume[s] >= MAX_ATT_INDEX)
 					{
-						if (!(eg_cnt & ((1 << SLOT->eg_sh_rr) - 1)))
-						{
-							/* SSG EG type */
-							if (SLOT->ssg & 0x08)
-							{
-								/* update attenuation level */
-								if (SLOT->volume < 0x200)
-									SLOT->volume += 4 * eg_inc[SLOT->eg_sel_rr + ((eg_cnt >> SLOT->eg_sh_rr) & 7)];
+						channel->volume[s] = MAX_ATT_INDEX;
+						channel->state[s] = EG_OFF;
+					}
+				}
 
-								/* check phase transition */
-								if (SLOT->volume >= 0x200)
-								{
-									SLOT->volume = MAX_ATT_INDEX;
-									SLOT->state = EG_OFF;
-								}
-							}
-							else
-							{
-								/* update attenuation level */
-								SLOT->volume += eg_inc[SLOT->eg_sel_rr + ((eg_cnt >> SLOT->eg_sh_rr) & 7)];
+				/* recalculate EG output */
+				channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
+				break;
+			}
+		}
+	}
 
-								/* check phase transition*/
-								if (SLOT->volume >= MAX_ATT_INDEX)
-								{
-									SLOT->volume = MAX_ATT_INDEX;
-									SLOT->state = EG_OFF;
-								}
-							}
+#if defined(YM2612_SIMD)
+	/* advance the envelope generator of all four SLOTs of a channel at once, one SLOT per SIMD lane */
+	/* SLOTs with SSG-EG are left out (see "skipped_slots"), they're handled by "advance_eg_slot" instead */
+	void YM2612::advance_eg_lanes(FM_CH *channel, unsigned int eg_cnt, uint32 skipped_slots)
+	{
+		const Lanes zero = broadcast(0);
+		const Lanes state = loadLanes(channel->state);
+		const Lanes isAttack = equal(state, broadcast(EG_ATT));
+		const Lanes isDecay = equal(state, broadcast(EG_DEC));
+		const Lanes isSustain = equal(state, broadcast(EG_SUS));
+		const Lanes isRelease = equal(state, broadcast(EG_REL));
+
+		/* get the rate parameters of each SLOT's current phase */
+		const auto selectByState = [&](const uint32 (&values)[5][4])
+		{
+			return bitOr(bitOr(bitAnd(isAttack, loadLanes(values[EG_ATT])), bitAnd(isDecay, loadLanes(values[EG_DEC]))),
+						 bitOr(bitAnd(isSustain, loadLanes(values[EG_SUS])), bitAnd(isRelease, loadLanes(values[EG_REL]))));
+		};
+		const Lanes counter = broadcast((int32)eg_cnt);
+		const Lanes isActive = bitOr(bitOr(isAttack, isDecay), bitOr(isSustain, isRelease));
+		const Lanes isSkipped = equal(bitAnd(broadcast((int32)skipped_slots), loadLanes(LANE_BITS)), loadLanes(LANE_BITS));
+		const Lanes update = bitAndNot(isSkipped, bitAnd(isActive, equal(bitAnd(counter, selectByState(channel->eg_mask)), zero)));
+		if (!anyLane(update))
+			return;
+
+		/* eg_inc[cycle], with cycle = (eg_cnt >> eg_sh) & 7 */
+		const Lanes cycle = bitAnd(shiftRightVariable(counter, selectByState(channel->eg_sh)), broadcast(7));
+		const Lanes inc = bitAnd(shiftRightVariable(selectByState(channel->eg_inc_row), shiftLeft<2>(cycle)), broadcast(0x0f));
+
+		/* update attenuation level: (~volume * inc) >> 4 during attack, inc otherwise */
+		const Lanes volume = loadLanes(channel->volume);
+		const Lanes attackStep = shiftRightArithmetic<4>(multiplySmall(bitNot(volume), inc));
+		Lanes newVolume = add(volume, select(isAttack, attackStep, inc));
+
+		/* check phase transitions */
+		const Lanes sl = loadLanes(channel->sl);
+		const Lanes attackDone = bitAnd(isAttack, greater(broadcast(MIN_ATT_INDEX + 1), newVolume));
+		const Lanes decayDone = bitAndNot(greater(sl, newVolume), isDecay);
+		const Lanes atMaximum = bitAnd(bitOr(isSustain, isRelease), greater(newVolume, broadcast(MAX_ATT_INDEX - 1)));
+		newVolume = select(attackDone, broadcast(MIN_ATT_INDEX), select(atMaximum, broadcast(MAX_ATT_INDEX), newVolume));
+
+		Lanes newState = select(attackDone, select(equal(sl, broadcast(MIN_ATT_INDEX)), broadcast(EG_SUS), broadcast(EG_DEC)), state);  /* special case where SL=0 */
+		newState = select(decayDone, broadcast(EG_SUS), newState);
+		newState = select(bitAnd(atMaximum, isRelease), broadcast(EG_OFF), newState);  /* do not change state in sustain phase (verified on real chip) */
+
+		/* recalculate EG output */
+		const Lanes newVolOut = add(newVolume, loadLanes(channel->tl));
 
-							/* recalculate EG output */
-							SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
+		storeLanes(channel->volume, select(update, newVolume, volume));
+		storeLanes(channel->state, select(update, newState, state));
+		storeLanes(channel->vol_out, select(update, newVolOut, loadLanes(channel->vol_out)));
+	}
+#endif
 
-						}
-						break;
-					}
-				}
+	void YM2612::advance_eg_channels(FM_CH *channel, unsigned int eg_cnt)
+	{
+		uint32 slots = ssg_slots;
 
-				/* next slot */
-				SLOT++;
+		for (int c = 0; c < 6; ++c)
+		{
+		#if defined(YM2612_SIMD)
+			/* SLOTs without SSG-EG are processed together, the others one by one */
+			advance_eg_lanes(&channel[c], eg_cnt, slots & 0x0f);
+			if (slots & 0x0f)
+			{
+				for (int s = 0; s < 4; ++s)
+				{
+					if (slots & (1 << s))
+						advance_eg_slot(&channel[c], s, eg_cnt);
+				}
 			}
-			while (--j);
-
-			/* next channel */
-			channel++;
+		#else
+			for (int s = 0; s < 4; ++s)
+				advance_eg_slot(&channel[c], s, eg_cnt);
+		#endif
+			slots >>= 4;
 		}
-		while (--i);
 	}
 
 	/* SSG-EG update process */
@@ -1084,66 +1157,65 @@ namespace soundemulation
 	void YM2612::update_ssg_eg_channels(FM_CH *channel)
 	{
 		unsigned int i = 6; /* six channels */
-		unsigned int j;
-		FM_SLOT *SLOT;
+		uint32 slots = ssg_slots;
 
 		do
 		{
-			j = 4; /* four operators per channel */
-			SLOT = &channel->SLOT[SLOT1];
-
-			do
+			/* skip channels without any SSG-EG SLOT */
+			if (slots & 0x0f)
 			{
-				/* detect SSG-EG transition */
-				/* this is not required during release phase as the attenuation has been forced to MAX and output invert flag is not used */
-				/* if an Attack Phase is programmed, inversion can occur on each sample */
-				if ((SLOT->ssg & 0x08) && (SLOT->volume >= 0x200) && (SLOT->state > EG_REL))
+				for (int s = 0; s < 4; ++s) /* four operators per channel */
 				{
-					if (SLOT->ssg & 0x01)  /* bit 0 = hold SSG-EG */
-					{
-						/* set inversion flag */
-						if (SLOT->ssg & 0x02)
-							SLOT->ssgn = 4;
+					FM_SLOT *SLOT = &channel->SLOT[s];
 
-						/* force attenuation level during decay phases */
-						if ((SLOT->state != EG_ATT) && !(SLOT->ssgn ^ (SLOT->ssg & 0x04)))
-							SLOT->volume = MAX_ATT_INDEX;
-					}
-					else  /* loop SSG-EG */
+					/* detect SSG-EG transition */
+					/* this is not required during release phase as the attenuation has been forced to MAX and output invert flag is not used */
+					/* if an Attack Phase is programmed, inversion can occur on each sample */
+					if ((SLOT->ssg & 0x08) && (channel->volume[s] >= 0x200) && (channel->state[s] > EG_REL))
 					{
-						/* toggle output inversion flag or reset Phase Generator */
-						if (SLOT->ssg & 0x02)
-							SLOT->ssgn ^= 4;
-						else
-							SLOT->phase = 0;
+						if (SLOT->ssg & 0x01)  /* bit 0 = hold SSG-EG */
+						{
+							/* set inversion flag */
+							if (SLOT->ssg & 0x02)
+								SLOT->ssgn = 4;
 
-						/* same as Key ON */
-						if (SLOT->state != EG_ATT)
+							/* force attenuation level during decay phases */
+							if ((channel->state[s] != EG_ATT) && !(SLOT->ssgn ^ (SLOT->ssg & 0x04)))
+								channel->volume[s] = MAX_ATT_INDEX;
+						}
+						else  /* loop SSG-EG */
 						{
-							if ((SLOT->ar + SLOT->ksr) < 94 /*32+62*/)
-							{
-								SLOT->state = (SLOT->volume <= MIN_ATT_INDEX) ? ((SLOT->sl == MIN_ATT_INDEX) ? EG_SUS : EG_DEC) : EG_ATT;
-							}
+							/* toggle output inversion flag or reset Phase Generator */
+							if (SLOT->ssg & 0x02)
+								SLOT->ssgn ^= 4;
 							else
+								channel->phase[s] = 0;
+
+							/* same as Key ON */
+							if (channel->state[s] != EG_ATT)
 							{
-								/* Attack Rate is maximal: directly switch to Decay or Substain */
-								SLOT->volume = MIN_ATT_INDEX;
-								SLOT->state = (SLOT->sl == MIN_ATT_INDEX) ? EG_SUS : EG_DEC;
+								if ((SLOT->ar + SLOT->ksr) < 94 /*32+62*/)
+								{
+									channel->state[s] = (channel->volume[s] <= MIN_ATT_INDEX) ? ((channel->sl[s] == MIN_ATT_INDEX) ? EG_SUS : EG_DEC) : EG_ATT;
+								}
+								else
+								{
+									/* Attack Rate is maximal: directly switch to Decay or Substain */
+									channel->volume[s] = MIN_ATT_INDEX;
+									channel->state[s] = (channel->sl[s] == MIN_ATT_INDEX) ? EG_SUS : EG_DEC;
+								}
 							}
 						}
-					}
 
-					/* recalculate EG output */
-					if (SLOT->ssgn ^ (SLOT->ssg & 0x04))
-						SLOT->vol_out = ((uint32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
-					else
-						SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
+						/* recalculate EG output */
+						if (SLOT->ssgn ^ (SLOT->ssg & 0x04))
+							channel->vol_out[s] = ((uint32)(0x200 - channel->volume[s]) & MAX_ATT_INDEX) + channel->tl[s];
+						else
+							channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
+					}
 				}
-
-				/* next slot */
-				SLOT++;
 			}
-			while (--j);
+			slots >>= 4;
 
 			/* next channel */
 			channel++;
@@ -1151,8 +1223,10 @@ namespace soundemulation
 		while (--i);
 	}
 
-	void YM2612::update_phase_lfo_slot(FM_SLOT *SLOT, int32 pms, uint32 block_fnum)
+	void YM2612::update_phase_lfo_slot(FM_CH *channel, int s, int32 pms, uint32 block_fnum)
 	{
+		FM_SLOT *SLOT = &channel->SLOT[s];
+
 		int32 lfo_fn_table_index_offset = lfo_pm_table[(((block_fnum & 0x7f0) >> 4) << 8) + pms + OPN.LFO_PM];
 
 		if (lfo_fn_table_index_offset)  /* LFO phase modulation active */
@@ -1173,15 +1247,17 @@ namespace soundemulation
 			fc = (((block_fnum << 5) >> (7 - blk)) + SLOT->DT[kc]) & DT_MASK;
 
 			/* update phase */
-			SLOT->phase += (fc * SLOT->mul) >> 1;
+			channel->phase[s] += (fc * SLOT->mul) >> 1;
 		}
 		else  /* LFO phase modulation  = zero */
 		{
-			SLOT->phase += SLOT->Incr;
+			channel->phase[s] += channel->Incr[s];
 		}
 	}
 
-	void YM2612::update_phase_lfo_channel(FM_CH *channel)
+	/* calculate the phase increments of all SLOTs for the current LFO PM step */
+	/* the result only changes with the LFO PM step (or a register write), so it gets reused for all samples in between */
+	void YM2612::refresh_lfo_incr_channel(FM_CH *channel)
 	{
 		uint32 block_fnum = channel->block_fnum;
 
@@ -1205,30 +1281,26 @@ namespace soundemulation
 			fc = (block_fnum << 5) >> (7 - blk);
 
 			/* apply DETUNE & MUL operator specific values */
-			finc = (fc + channel->SLOT[SLOT1].DT[kc]) & DT_MASK;
-			channel->SLOT[SLOT1].phase += (finc*channel->SLOT[SLOT1].mul) >> 1;
-
-			finc = (fc + channel->SLOT[SLOT2].DT[kc]) & DT_MASK;
-			channel->SLOT[SLOT2].phase += (finc*channel->SLOT[SLOT2].mul) >> 1;
-
-			finc = (fc + channel->SLOT[SLOT3].DT[kc]) & DT_MASK;
-			channel->SLOT[SLOT3].phase += (finc*channel->SLOT[SLOT3].mul) >> 1;
-
-			finc = (fc + channel->SLOT[SLOT4].DT[kc]) & DT_MASK;
-			channel->SLOT[SLOT4].phase += (finc*channel->SLOT[SLOT4].mul) >> 1;
+			for (int s = 0; s < 4; ++s)
+			{
+				finc = (fc + channel->SLOT[s].DT[kc]) & DT_MASK;
+				channel->lfo_incr[s] = (finc * channel->SLOT[s].mul) >> 1;
+			}
 		}
 		else  /* LFO phase modulation  = zero */
 		{
-			channel->SLOT[SLOT1].phase += channel->SLOT[SLOT1].Incr;
-			channel->SLOT[SLOT2].phase += channel->SLOT[SLOT2].Incr;
-			channel->SLOT[SLOT3].phase += channel->SLOT[SLOT3].Incr;
-			channel->SLOT[SLOT4].phase += channel->SLOT[SLOT4].Incr;
+			for (int s = 0; s < 4; ++s)
+				channel->lfo_incr[s] = (uint32)channel->Incr[s];
 		}
+
+		channel->lfo_pm_step = OPN.LFO_PM;
 	}
 
 	/* update phase increment and envelope generator */
-	void YM2612::refresh_fc_eg_slot(FM_SLOT *SLOT, unsigned int fc, unsigned int kc)
+	void YM2612::refresh_fc_eg_slot(FM_CH *channel, int s, unsigned int fc, unsigned int kc)
 	{
+		FM_SLOT *SLOT = &channel->SLOT[s];
+
 		/* add detune value */
 		fc += SLOT->DT[kc];
 
@@ -1236,7 +1308,7 @@ namespace soundemulation
 		fc &= DT_MASK;
 
 		/* (frequency) phase increment counter */
-		SLOT->Incr = (fc * SLOT->mul) >> 1;
+		channel->Incr[s] = (fc * SLOT->mul) >> 1;
 
 		/* ksr */
 		kc = kc >> SLOT->KSR;
@@ -1248,46 +1320,38 @@ namespace soundemulation
 			/* recalculate envelope generator rates */
 			if ((SLOT->ar + kc) < (32 + 62))
 			{
-				SLOT->eg_sh_ar = eg_rate_shift[SLOT->ar + kc];
-				SLOT->eg_sel_ar = eg_rate_select[SLOT->ar + kc];
+				set_eg_rate(channel, s, EG_ATT, eg_rate_shift[SLOT->ar + kc], eg_rate_select[SLOT->ar + kc]);
 			}
 			else
 			{
 				/* verified by Nemesis on real hardware (Attack phase is blocked) */
-				SLOT->eg_sh_ar = 0;
-				SLOT->eg_sel_ar = 18 * RATE_STEPS;
+				set_eg_rate(channel, s, EG_ATT, 0, 18 * RATE_STEPS);
 			}
 
-			SLOT->eg_sh_d1r = eg_rate_shift[SLOT->d1r + kc];
-			SLOT->eg_sel_d1r = eg_rate_select[SLOT->d1r + kc];
-
-			SLOT->eg_sh_d2r = eg_rate_shift[SLOT->d2r + kc];
-			SLOT->eg_sel_d2r = eg_rate_select[SLOT->d2r + kc];
-
-			SLOT->eg_sh_rr = eg_rate_shift[SLOT->rr + kc];
-			SLOT->eg_sel_rr = eg_rate_select[SLOT->rr + kc];
+			set_eg_rate(channel, s, EG_DEC, eg_rate_shift[SLOT->d1r + kc], eg_rate_select[SLOT->d1r + kc]);
+			set_eg_rate(channel, s, EG_SUS, eg_rate_shift[SLOT->d2r + kc], eg_rate_select[SLOT->d2r + kc]);
+			set_eg_rate(channel, s, EG_REL, eg_rate_shift[SLOT->rr + kc], eg_rate_select[SLOT->rr + kc]);
 		}
 	}
 
 	/* update phase increment counters */
 	void YM2612::refresh_fc_eg_chan(FM_CH *channel)
 	{
-		if (channel->SLOT[SLOT1].Incr == -1)
+		if (channel->Incr[SLOT1] == -1)
 		{
 			int fc = channel->fc;
 			int kc = channel->kcode;
-			refresh_fc_eg_slot(&channel->SLOT[SLOT1], fc, kc);
-			refresh_fc_eg_slot(&channel->SLOT[SLOT2], fc, kc);
-			refresh_fc_eg_slot(&channel->SLOT[SLOT3], fc, kc);
-			refresh_fc_eg_slot(&channel->SLOT[SLOT4], fc, kc);
+			refresh_fc_eg_slot(channel, SLOT1, fc, kc);
+			refresh_fc_eg_slot(channel, SLOT2, fc, kc);
+			refresh_fc_eg_slot(channel, SLOT3, fc, kc);
+			refresh_fc_eg_slot(channel, SLOT4, fc, kc);
 		}
 	}
 
-	#define volume_calc(OP) ((OP)->vol_out + (AM & (OP)->AMmask))
-
+	/* env is the EG output including AM, already shifted left by 3 to be used as tl_tab offset */
 	signed int op_calc(uint32 phase, unsigned int env, unsigned int pm)
 	{
-		uint32 p = (env << 3) + sin_tab[((phase >> SIN_BITS) + (pm >> 1)) & SIN_MASK];
+		uint32 p = env + sin_tab[((phase >> SIN_BITS) + (pm >> 1)) & SIN_MASK];
 
 		if (p >= TL_TAB_LEN)
 			return 0;
@@ -1296,7 +1360,7 @@ namespace soundemulation
 
 	signed int op_calc1(uint32 phase, unsigned int env, unsigned int pm)
 	{
-		uint32 p = (env << 3) + sin_tab[((phase + pm) >> SIN_BITS) & SIN_MASK];
+		uint32 p = env + sin_tab[((phase + pm) >> SIN_BITS) & SIN_MASK];
 
 		if (p >= TL_TAB_LEN)
 			return 0;
@@ -1307,52 +1371,97 @@ namespace soundemulation
 	{
 		do
 		{
-			uint32 AM = OPN.LFO_AM >> channel->ams;
-			unsigned int eg_out = volume_calc(&channel->SLOT[SLOT1]);
-
-			m2 = c1 = c2 = mem = 0;
+			int32& carrier = out_fm[channel - mChannels];
+
+			/* EG outputs of all four SLOTs including AM from LFO, shifted to be used as tl_tab offsets */
+			uint32 env[4];
+		#if defined(YM2612_SIMD)
+			const Lanes AM = broadcast((int32)(OPN.LFO_AM >> channel->ams));
+			storeLanes(env, shiftLeft<3>(add(loadLanes(channel->vol_out), bitAnd(AM, loadLanes(channel->AMmask)))));
+		#else
+			const uint32 AM = OPN.LFO_AM >> channel->ams;
+			for (int s = 0; s < 4; ++s)
+				env[s] = (channel->vol_out[s] + (AM & channel->AMmask[s])) << 3;
+		#endif
+
+			/* output of an operator, or zero if its envelope is quiet */
+			const auto slot_calc = [&](int s, int32 pm) -> int32
+			{
+				return (env[s] < (ENV_QUIET << 3)) ? op_calc(channel->phase[s], env[s], pm) : 0;
+			};
 
-			*channel->mem_connect = channel->mem_value;  /* restore delayed sample (MEM) value to m2 or c2 */
+			/* SLOT 1 with self-feedback; its output reaches the other operators one sample later */
+			const int32 op1 = channel->op1_out[1];
 			{
 				int32 out = channel->op1_out[0] + channel->op1_out[1];
-				channel->op1_out[0] = channel->op1_out[1];
-
-				if (!channel->connect1)
-				{
-					/* algorithm 5  */
-					mem = c1 = c2 = channel->op1_out[0];
-				}
-				else
-				{
-					/* other algorithms */
-					*channel->connect1 += channel->op1_out[0];
-				}
-
+				channel->op1_out[0] = op1;
 				channel->op1_out[1] = 0;
-				if (eg_out < ENV_QUIET)  /* SLOT 1 */
+
+				if (env[SLOT1] < (ENV_QUIET << 3))
 				{
 					if (!channel->FB)
 						out = 0;
 
-					channel->op1_out[1] = op_calc1(channel->SLOT[SLOT1].phase, eg_out, (out << channel->FB));
+					channel->op1_out[1] = op_calc1(channel->phase[SLOT1], env[SLOT1], (out << channel->FB));
 				}
 			}
 
-			eg_out = volume_calc(&channel->SLOT[SLOT3]);
-			if (eg_out < ENV_QUIET)    /* SLOT 3 */
-				*channel->connect3 += op_calc(channel->SLOT[SLOT3].phase, eg_out, m2);
-
-			eg_out = volume_calc(&channel->SLOT[SLOT2]);
-			if (eg_out < ENV_QUIET)    /* SLOT 2 */
-				*channel->connect2 += op_calc(channel->SLOT[SLOT2].phase, eg_out, c1);
-
-			eg_out = volume_calc(&channel->SLOT[SLOT4]);
-			if (eg_out < ENV_QUIET)    /* SLOT 4 */
-				*channel->connect4 += op_calc(channel->SLOT[SLOT4].phase, eg_out, c2);
-
-
-			/* store current MEM */
-			channel->mem_value = mem;
+			/* route the operators according to the algorithm, with the modulation inputs kept in locals instead of going through connection pointers */
+			const int32 mem = channel->mem_value;
+			switch (channel->ALGO)
+			{
+				case 0:
+					/* M1---C1---MEM---M2---C2---OUT */
+					carrier += slot_calc(SLOT4, slot_calc(SLOT3, mem));
+					channel->mem_value = slot_calc(SLOT2, op1);
+					break;
+				case 1:
+					/* M1------+-MEM---M2---C2---OUT */
+					/*      C1-+                     */
+					carrier += slot_calc(SLOT4, slot_calc(SLOT3, mem));
+					channel->mem_value = op1 + slot_calc(SLOT2, 0);
+					break;
+				case 2:
+					/* M1-----------------+-C2---OUT */
+					/*      C1---MEM---M2-+          */
+					carrier += slot_calc(SLOT4, op1 + slot_calc(SLOT3, mem));
+					channel->mem_value = slot_calc(SLOT2, 0);
+					break;
+				case 3:
+					/* M1---C1---MEM------+-C2---OUT */
+					/*                 M2-+          */
+					carrier += slot_calc(SLOT4, mem + slot_calc(SLOT3, 0));
+					channel->mem_value = slot_calc(SLOT2, op1);
+					break;
+				case 4:
+					/* M1---C1-+-OUT */
+					/* M2---C2-+     */
+					/* MEM: not used */
+					carrier += slot_calc(SLOT2, op1) + slot_calc(SLOT4, slot_calc(SLOT3, 0));
+					break;
+				case 5:
+					/*    +----C1----+     */
+					/* M1-+-MEM---M2-+-OUT */
+					/*    +----C2----+     */
+					carrier += slot_calc(SLOT3, mem) + slot_calc(SLOT2, op1) + slot_calc(SLOT4, op1);
+					channel->mem_value = op1;
+					break;
+				case 6:
+					/* M1---C1-+     */
+					/*      M2-+-OUT */
+					/*      C2-+     */
+					/* MEM: not used */
+					carrier += slot_calc(SLOT3, 0) + slot_calc(SLOT2, op1) + slot_calc(SLOT4, 0);
+					break;
+				case 7:
+					/* M1-+     */
+					/* C1-+-OUT */
+					/* M2-+     */
+					/* C2-+     */
+					/* MEM: not used*/
+					carrier += op1 + slot_calc(SLOT3, 0) + slot_calc(SLOT2, 0) + slot_calc(SLOT4, 0);
+					break;
+			}
 
 			/* update phase counters AFTER output calculations */
 			if (channel->pms)
@@ -1360,22 +1469,22 @@ namespace soundemulation
 				/* add support for 3 slot mode */
 				if ((OPN.ST.mode & 0xC0) && (channel == &channel[2]))
 				{
-					update_phase_lfo_slot(&channel->SLOT[SLOT1], channel->pms, OPN.SL3.block_fnum[1]);
-					update_phase_lfo_slot(&channel->SLOT[SLOT2], channel->pms, OPN.SL3.block_fnum[2]);
-					update_phase_lfo_slot(&channel->SLOT[SLOT3], channel->pms, OPN.SL3.block_fnum[0]);
-					update_phase_lfo_slot(&channel->SLOT[SLOT4], channel->pms, channel->block_fnum);
+					update_phase_lfo_slot(channel, SLOT1, channel->pms, OPN.SL3.block_fnum[1]);
+					update_phase_lfo_slot(channel, SLOT2, channel->pms, OPN.SL3.block_fnum[2]);
+					update_phase_lfo_slot(channel, SLOT3, channel->pms, OPN.SL3.block_fnum[0]);
+					update_phase_lfo_slot(channel, SLOT4, channel->pms, channel->block_fnum);
 				}
 				else
 				{
-					update_phase_lfo_channel(channel);
+					if (channel->lfo_pm_step != OPN.LFO_PM)
+						refresh_lfo_incr_channel(channel);
+
+					advance_phases(channel->phase, channel->lfo_incr);
 				}
 			}
 			else  /* no LFO phase modulation */
 			{
-				channel->SLOT[SLOT1].phase += channel->SLOT[SLOT1].Incr;
-				channel->SLOT[SLOT2].phase += channel->SLOT[SLOT2].Incr;
-				channel->SLOT[SLOT3].phase += channel->SLOT[SLOT3].Incr;
-				channel->SLOT[SLOT4].phase += channel->SLOT[SLOT4].Incr;
+				advance_phases(channel->phase, reinterpret_cast<const uint32*>(channel->Incr));
 			}
 
 			/* next channel */
@@ -1450,45 +1559,52 @@ namespace soundemulation
 			c += 3;
 
 		FM_CH* channel = &mChannels[c];
-		FM_SLOT* SLOT = &(channel->SLOT[OPN_SLOT(r)]);
+		const int s = OPN_SLOT(r);
+		FM_SLOT* SLOT = &(channel->SLOT[s]);
 
 		switch (r & 0xf0)
 		{
 			case 0x30:  /* DET , MUL */
-				set_det_mul(channel, SLOT, v);
+				set_det_mul(channel, s, v);
 				break;
 
 			case 0x40:  /* TL */
-				set_tl(SLOT, v);
+				set_tl(channel, s, v);
 				break;
 
 			case 0x50:  /* KS, AR */
-				set_ar_ksr(channel, SLOT, v);
+				set_ar_ksr(channel, s, v);
 				break;
 
 			case 0x60:  /* bit7 = AM ENABLE, DR */
-				set_dr(SLOT, v);
-				SLOT->AMmask = (v & 0x80) ? ~0 : 0;
+				set_dr(channel, s, v);
+				channel->AMmask[s] = (v & 0x80) ? ~0 : 0;
 				break;
 
 			case 0x70:  /*     SR */
-				set_sr(SLOT, v);
+				set_sr(channel, s, v);
 				break;
 
 			case 0x80:  /* SL, RR */
-				set_sl_rr(SLOT, v);
+				set_sl_rr(channel, s, v);
 				break;
 
 			case 0x90:  /* SSG-EG */
 				SLOT->ssg = v & 0x0f;
 
+				/* keep track of the SLOTs using SSG-EG, so its update can be skipped if there are none */
+				if (SLOT->ssg & 0x08)
+					ssg_slots |= (1 << (c * 4 + s));
+				else
+					ssg_slots &= ~(1 << (c * 4 + s));
+
 				/* recalculate EG output */
-				if (SLOT->state > EG_REL)
+				if (channel->state[s] > EG_REL)
 				{
 					if ((SLOT->ssg & 0x08) && (SLOT->ssgn ^ (SLOT->ssg & 0x04)))
-						SLOT->vol_out = ((uint32)(0x200 - SLOT->volume) & MAX_ATT_INDEX) + SLOT->tl;
+						channel->vol_out[s] = ((uint32)(0x200 - channel->volume[s]) & MAX_ATT_INDEX) + channel->tl[s];
 					else
-						SLOT->vol_out = (uint32)SLOT->volume + SLOT->tl;
+						channel->vol_out[s] = (uint32)channel->volume[s] + channel->tl[s];
 				}
 
 				/* SSG-EG envelope shapes :
@@ -1582,7 +1698,7 @@ namespace soundemulation
 						/* store fnum in clear form for LFO PM calculations */
 						channel->block_fnum = (blk << 11) | fn;
 
-						channel->SLOT[SLOT1].Incr = -1;
+						channel->Incr[SLOT1] = -1;
 						break;
 					}
 					case 1:    /* 0xa4-0xa6 : FNUM2,BLK */
@@ -1598,7 +1714,7 @@ namespace soundemulation
 							/* phase increment counter */
 							OPN.SL3.fc[c] = (fn << 6) >> (7 - blk);
 							OPN.SL3.block_fnum[c] = (blk << 11) | fn;
-							channel[2].SLOT[SLOT1].Incr = -1;
+							channel[2].Incr[SLOT1] = -1;
 						}
 						break;
 					case 3:    /* 0xac-0xae : 3CH FNUM2,BLK */
@@ -1615,7 +1731,6 @@ namespace soundemulation
 					{
 						channel->ALGO = v & 7;
 						channel->FB = (v >> 3) & 7;
-						setup_connection(channel, c);
 						break;
 					}
 					case 1:    /* 0xb4-0xb6 : L , R , AMS , PMS */
@@ -1645,21 +1760,21 @@ namespace soundemulation
 			channel[c].op1_out[1] = 0;
 			for (s = 0; s < 4; s++)
 			{
-				channel[c].SLOT[s].Incr = -1;
+				channel[c].Incr[s] = -1;
 				channel[c].SLOT[s].key = 0;
-				channel[c].SLOT[s].phase = 0;
+				channel[c].phase[s] = 0;
 				channel[c].SLOT[s].ssgn = 0;
-				channel[c].SLOT[s].state = EG_OFF;
-				channel[c].SLOT[s].volume = MAX_ATT_INDEX;
-				channel[c].SLOT[s].vol_out = MAX_ATT_INDEX;
+				channel[c].state[s] = EG_OFF;
+				channel[c].volume[s] = MAX_ATT_INDEX;
+				channel[c].vol_out[s] = MAX_ATT_INDEX;
 			}
 		}
 	}
 
-	/* initialize generic tables */
-	void YM2612::init_tables()
+	/* initialize tables shared by all chip instances */
+	static void init_static_tables()
 	{
-		signed int d, i, x;
+		signed int i, x;
 		signed int n;
 		double o, m;
 
@@ -1721,6 +1836,15 @@ namespace soundemulation
 			sin_tab[i] = n * 2 + (m >= 0.0 ? 0 : 1);
 		}
 
+		/* build packed EG increment rows */
+		for (i = 0; i < 19; i++)
+		{
+			uint32 row = 0;
+			for (x = 0; x < RATE_STEPS; x++)
+				row |= (uint32)(eg_inc[i * RATE_STEPS + x] & 0x0f) << (x * 4);
+			eg_inc_rows[i] = row;
+		}
+
 		/* build LFO PM modulation table */
 		for (i = 0; i < 8; i++) /* 8 PM depths */
 		{
@@ -1752,6 +1876,16 @@ namespace soundemulation
 				}
 			}
 		}
+	}
+
+	/* initialize generic tables */
+	void YM2612::init_tables()
+	{
+		/* the shared tables get built only once, as multiple sound emulations may run on different threads */
+		static const bool staticTablesInitialized = (init_static_tables(), true);
+		(void)staticTablesInitialized;
+
+		signed int d, i;
 
 		/* build DETUNE table */
 		for (d = 0; d <= 3; d++)
@@ -1877,12 +2011,12 @@ namespace soundemulation
 		else
 		{
 			/* 3SLOT MODE (operator order is 0,1,3,2) */
-			if (mChannels[2].SLOT[SLOT1].Incr == -1)
+			if (mChannels[2].Incr[SLOT1] == -1)
 			{
-				refresh_fc_eg_slot(&mChannels[2].SLOT[SLOT1], OPN.SL3.fc[1], OPN.SL3.kcode[1]);
-				refresh_fc_eg_slot(&mChannels[2].SLOT[SLOT2], OPN.SL3.fc[2], OPN.SL3.kcode[2]);
-				refresh_fc_eg_slot(&mChannels[2].SLOT[SLOT3], OPN.SL3.fc[0], OPN.SL3.kcode[0]);
-				refresh_fc_eg_slot(&mChannels[2].SLOT[SLOT4], mChannels[2].fc, mChannels[2].kcode);
+				refresh_fc_eg_slot(&mChannels[2], SLOT1, OPN.SL3.fc[1], OPN.SL3.kcode[1]);
+				refresh_fc_eg_slot(&mChannels[2], SLOT2, OPN.SL3.fc[2], OPN.SL3.kcode[2]);
+				refresh_fc_eg_slot(&mChannels[2], SLOT3, OPN.SL3.fc[0], OPN.SL3.kcode[0]);
+				refresh_fc_eg_slot(&mChannels[2], SLOT4, mChannels[2].fc, mChannels[2].kcode);
 			}
 		}
 
@@ -1890,6 +2024,10 @@ namespace soundemulation
 		refresh_fc_eg_chan(&mChannels[4]);
 		refresh_fc_eg_chan(&mChannels[5]);
 
+		/* LFO PM phase increments need to be recalculated, as register writes may have changed them */
+		for (FM_CH& channel : mChannels)
+			channel.lfo_pm_step = ~0u;
+
 		/* buffering */
 		for (int i = 0; i < length; i++)
 		{
@@ -1902,7 +2040,8 @@ namespace soundemulation
 			out_fm[5] = 0;
 
 			/* update SSG-EG output */
-			update_ssg_eg_channels(&mChannels[0]);
+			if (ssg_slots)
+				update_ssg_eg_channels(&mChannels[0]);
 
 			/* calculate FM */
 			if (!dacen)
@@ -51,49 +51,33 @@ namespace soundemulation
 			uint8   ksr;        /* key scale rate  :kcode>>(3-KSR)  */
 			uint32  mul;        /* multiple        :ML_TABLE[ML]    */
 
-			/* Phase Generator */
-			uint32  phase;      /* phase counter */
-			int32   Incr;       /* phase step */
-
-			/* Envelope Generator */
-			uint8   state;      /* phase type */
-			uint32  tl;         /* total level: TL << 3 */
-			int32   volume;     /* envelope counter */
-			uint32  sl;         /* sustain level:sl_table[SL] */
-			uint32  vol_out;    /* current output from EG circuit (without AM from LFO) */
-
-			uint8  eg_sh_ar;    /*  (attack state)  */
-			uint8  eg_sel_ar;   /*  (attack state)  */
-			uint8  eg_sh_d1r;   /*  (decay state)   */
-			uint8  eg_sel_d1r;  /*  (decay state)   */
-			uint8  eg_sh_d2r;   /*  (sustain state) */
-			uint8  eg_sel_d2r;  /*  (sustain state) */
-			uint8  eg_sh_rr;    /*  (release state) */
-			uint8  eg_sel_rr;   /*  (release state) */
-
 			uint8  ssg;         /* SSG-EG waveform  */
 			uint8  ssgn;        /* SSG-EG negated output  */
 
 			uint8  key;         /* 0=last key was KEY OFF, 1=KEY ON */
-
-			/* LFO */
-			uint32  AMmask;     /* AM enable flag */
 		};
 
 		struct FM_CH
 		{
 			FM_SLOT  SLOT[4];     /* four SLOTs (operators) */
 
+			/* Phase and Envelope Generator state of the four SLOTs, indexed by SLOT, so they can be processed together as SIMD lanes */
+			uint32  phase[4];     /* phase counter */
+			int32   Incr[4];      /* phase step */
+			uint32  state[4];     /* phase type */
+			uint32  tl[4];        /* total level: TL << 3 */
+			int32   volume[4];    /* envelope counter */
+			uint32  sl[4];        /* sustain level:sl_table[SL] */
+			uint32  vol_out[4];   /* current output from EG circuit (without AM from LFO) */
+			uint32  AMmask[4];    /* AM enable flag */
+
+			uint32  eg_sh[5][4];       /* EG counter shift of the rate used in each state */
+			uint32  eg_mask[5][4];     /* EG counter mask, (1 << eg_sh) - 1 */
+			uint32  eg_inc_row[5][4];  /* EG increments per cycle, see eg_inc_rows */
+
 			uint8   ALGO;         /* algorithm */
 			uint8   FB;           /* feedback shift */
 			int32   op1_out[2];   /* op1 output for feedback */
-
-			int32   *connect1;    /* SLOT1 output pointer */
-			int32   *connect3;    /* SLOT3 output pointer */
-			int32   *connect2;    /* SLOT2 output pointer */
-			int32   *connect4;    /* SLOT4 output pointer */
-
-			int32   *mem_connect; /* where to put the delayed sample (MEM) */
 			int32   mem_value;    /* delayed sample (MEM) value */
 
 			int32   pms;          /* channel PMS */
@@ -102,6 +86,9 @@ namespace soundemulation
 			uint32  fc;           /* fnum,blk */
 			uint8   kcode;        /* key code */
 			uint32  block_fnum;   /* blk/fnum value (for LFO PM calculations) */
+
+			uint32  lfo_pm_step;  /* LFO PM step that lfo_incr got calculated for, or ~0 if it needs to be recalculated */
+			uint32  lfo_incr[4];  /* phase increments of the four SLOTs including LFO PM */
 		};
 
 		struct FM_ST
@@ -156,19 +143,21 @@ namespace soundemulation
 		void INTERNAL_TIMER_A();
 		void INTERNAL_TIMER_B(int step);
 		void set_timers(int v);
-		void setup_connection(FM_CH *CH, int ch);
-		void set_det_mul(FM_CH *CH, FM_SLOT *SLOT, int v);
-		void set_tl(FM_SLOT *SLOT, int v);
-		void set_ar_ksr(FM_CH *CH, FM_SLOT *SLOT, int v);
-		void set_dr(FM_SLOT *SLOT, int v);
-		void set_sr(FM_SLOT *SLOT, int v);
-		void set_sl_rr(FM_SLOT *SLOT, int v);
+		static void set_eg_rate(FM_CH *CH, int s, int state, uint8 shift, uint8 rate_select);
+		void set_det_mul(FM_CH *CH, int s, int v);
+		void set_tl(FM_CH *CH, int s, int v);
+		void set_ar_ksr(FM_CH *CH, int s, int v);
+		void set_dr(FM_CH *CH, int s, int v);
+		void set_sr(FM_CH *CH, int s, int v);
+		void set_sl_rr(FM_CH *CH, int s, int v);
 		void advance_lfo();
+		void advance_eg_slot(FM_CH *CH, int s, unsigned int eg_cnt);
+		void advance_eg_lanes(FM_CH *CH, unsigned int eg_cnt, uint32 skipped_slots);
 		void advance_eg_channels(FM_CH *CH, unsigned int eg_cnt);
 		void update_ssg_eg_channels(FM_CH *CH);
-		void update_phase_lfo_slot(FM_SLOT *SLOT, int32 pms, uint32 block_fnum);
-		void update_phase_lfo_channel(FM_CH *CH);
-		void refresh_fc_eg_slot(FM_SLOT *SLOT, unsigned int fc, unsigned int kc);
+		void update_phase_lfo_slot(FM_CH *CH, int s, int32 pms, uint32 block_fnum);
+		void refresh_lfo_incr_channel(FM_CH *CH);
+		void refresh_fc_eg_slot(FM_CH *CH, int s, unsigned int fc, unsigned int kc);
 		void refresh_fc_eg_chan(FM_CH *CH);
 		void chan_calc(FM_CH *CH, int num);
 		void OPNWriteMode(int r, int v);
@@ -182,8 +171,7 @@ namespace soundemulation
 		int32   dacout; /* DAC output */
 		FM_OPN  OPN;    /* OPN state */
 
-		int32  m2, c1, c2;   /* Phase Modulation input for operators 2,3,4 */
-		int32  mem;        /* one sample delay memory */
+		uint32 ssg_slots;  /* one bit for each SLOT with SSG-EG enabled (bit index = channel * 4 + slot) */
 		int32  out_fm[8];  /* outputs of working channels */
 		uint32 bitmask;    /* working channels output bitmasking (DAC quantization) */
 	};
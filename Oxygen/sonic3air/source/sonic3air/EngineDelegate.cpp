@@ -9,6 +9,7 @@
 #include "sonic3air/pch.h"
 #include "sonic3air/EngineDelegate.h"
 #include "sonic3air/ConfigurationImpl.h"
+#include "sonic3air/GameSimulationState.h"
 #include "sonic3air/audio/AudioOut.h"
 #include "sonic3air/menu/GameApp.h"
 #include "sonic3air/menu/MenuBackground.h"
@@ -34,6 +35,12 @@ namespace lemon
 	extern void createNativizedCodeLookup(Nativizer::LookupDictionary& dict);
 }
 
+namespace
+{
+	// Game state of a simulation running in parallel to the main simulation, on its own thread
+	thread_local std::unique_ptr<GameSimulationState> gParallelSimulationState;
+}
+
 
 const EngineDelegateInterface::AppMetaData& EngineDelegate::getAppMetaData()
 {
@@ -135,7 +142,7 @@ void EngineDelegate::updateGame(float timeElapsed)
 
 void EngineDelegate::registerScriptBindings(lemon::Module& module)
 {
-	Game::instance().registerScriptBindings(module);
+	GameSimulationState::instance().registerScriptBindings(module);
 }
 
 void EngineDelegate::registerNativizedCode(lemon::Program& program)
@@ -157,17 +164,22 @@ void EngineDelegate::onRuntimeInit(CodeExec& codeExec)
 
 void EngineDelegate::onPreFrameUpdate()
 {
-	mGame.onPreUpdateFrame();
+	if (GameSimulationState::instance().isDefaultInstance())
+		mGame.onPreUpdateFrame();
 }
 
 void EngineDelegate::onPostFrameUpdate()
 {
-	mGame.onPostUpdateFrame();
+	// Only the main simulation updates the game itself, which includes its simulation state
+	if (GameSimulationState::instance().isDefaultInstance())
+		mGame.onPostUpdateFrame();
+	else
+		GameSimulationState::instance().onPostUpdateFrame();
 }
 
 void EngineDelegate::onControlsUpdate()
 {
-	mGame.onUpdateControls();
+	GameSimulationState::instance().onUpdateControls();
 }
 
 void EngineDelegate::onPreSaveStateLoad()
@@ -186,6 +198,16 @@ void EngineDelegate::onApplicationLostFocus()
 #endif
 }
 
+void EngineDelegate::startupParallelSimulation()
+{
+	gParallelSimulationState = std::make_unique<GameSimulationState>();
+}
+
+void EngineDelegate::shutdownParallelSimulation()
+{
+	gParallelSimulationState.reset();
+}
+
 bool EngineDelegate::mayLoadScriptMods()
 {
 	return allowModdedData();
@@ -193,7 +215,7 @@ bool EngineDelegate::mayLoadScriptMods()
 
 bool EngineDelegate::allowModdedData()
 {
-	return !mGame.isInTimeAttackMode();
+	return !GameSimulationState::instance().isInTimeAttackMode();
 }
 
 bool EngineDelegate::useDeveloperFeatures()
@@ -238,7 +260,7 @@ void EngineDelegate::serializeGameSettings(VectorBinarySerializer& serializer)
 
 void EngineDelegate::onGameRecordingHeaderLoaded(const std::string& buildString, const std::vector<uint8>& buffer)
 {
-	mGame.onGameRecordingHeaderLoaded(buildString, buffer);
+	GameSimulationState::instance().onGameRecordingHeaderLoaded(buffer);
 }
 
 void EngineDelegate::onGameRecordingHeaderSave(std::vector<uint8>& buffer)
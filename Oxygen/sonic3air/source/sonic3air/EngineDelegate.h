@@ -38,6 +38,9 @@ public:
 	void onPreSaveStateLoad() override;
 
 	void onApplicationLostFocus() override;
+	bool supportsParallelSimulations() override  { return true; }
+	void startupParallelSimulation() override;
+	void shutdownParallelSimulation() override;
 
 	bool mayLoadScriptMods() override;
 	bool allowModdedData() override;
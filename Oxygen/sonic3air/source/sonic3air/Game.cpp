@@ -32,44 +32,6 @@
 #include "oxygen/simulation/EmulatorInterface.h"
 #include "oxygen/simulation/Simulation.h"
 
-#include <lemon/program/FunctionWrapper.h>
-#include <lemon/program/Module.h>
-
-
-namespace
-{
-	const constexpr float CUTSCENE_SKIPPING_SPEED = 4.0f;	// Should be more or less "unique", not one of the debug game speeds (3.0f or 5.0f)
-
-	void setDiscordDetails(lemon::StringRef text)
-	{
-		if (text.isValid())
-			DiscordIntegration::setModdedDetails(text.getString());
-	}
-
-	void setDiscordState(lemon::StringRef text)
-	{
-		if (text.isValid())
-			DiscordIntegration::setModdedState(text.getString());
-	}
-
-	void setDiscordLargeImage(lemon::StringRef imageName)
-	{
-		if (imageName.isValid())
-			DiscordIntegration::setModdedLargeImage(imageName.getString());
-	}
-
-	void setDiscordSmallImage(lemon::StringRef imageName)
-	{
-		if (imageName.isValid())
-			DiscordIntegration::setModdedSmallImage(imageName.getString());
-	}
-
-	void setUnderwaterAudioEffect(uint8 value)
-	{
-		AudioOut::instance().enableUnderwaterEffect((float)value / 255.0f);
-	}
-}
-
 
 Game::Game()
 {
@@ -109,7 +71,7 @@ void Game::update(float timeElapsed)
 		mTimeoutUntilDiscordRefresh -= timeElapsed;
 		if (mTimeoutUntilDiscordRefresh <= 0.0f)
 		{
-			DiscordIntegration::updateInfo(mMode, mSubMode, *mEmulatorInterface);
+			DiscordIntegration::updateInfo(mSimulationState.getMode(), mSimulationState.getSubMode(), *mEmulatorInterface);
 			mTimeoutUntilDiscordRefresh = 3.0f;
 		}
 		DiscordIntegration::update();
@@ -140,194 +102,20 @@ void Game::update(float timeElapsed)
 	}
 	else if (mRestartTriggered)
 	{
-		startIntoLevel(mMode, mSubMode, mLastZoneAndAct, mLastCharacters);
+		startIntoLevel(mSimulationState.getMode(), mSimulationState.getSubMode(), mLastZoneAndAct, mLastCharacters);
 		mRestartTriggered = false;
 	}
 }
 
-void Game::registerScriptBindings(lemon::Module& module)
-{
-	const BitFlagSet<lemon::Function::Flag> defaultFlags(lemon::Function::Flag::ALLOW_INLINE_EXECUTION);
-	const BitFlagSet<lemon::Function::Flag> noInlineExecution;
-
-	// Game
-	{
-		module.addNativeFunction("Game.getSetting", lemon::wrap(*this, &Game::useSetting), defaultFlags)
-			.setParameterInfo(0, "settingId");
-
-		module.addNativeFunction("Game.isSecretUnlocked", lemon::wrap(*this, &Game::isSecretUnlocked), defaultFlags)
-			.setParameterInfo(0, "secretId");
-
-		module.addNativeFunction("Game.setSecretUnlocked", lemon::wrap(*this, &Game::setSecretUnlocked), defaultFlags)
-			.setParameterInfo(0, "secretId");
-
-		module.addNativeFunction("Game.triggerRestart", lemon::wrap(*this, &Game::triggerRestart), defaultFlags);
-
-		module.addNativeFunction("Game.onGamePause", lemon::wrap(*this, &Game::onGamePause), defaultFlags)
-			.setParameterInfo(0, "canRestart");
-
-		module.addNativeFunction("Game.allowRestartInGamePause", lemon::wrap(*this, &Game::allowRestartInGamePause), defaultFlags)
-			.setParameterInfo(0, "canRestart");
-
-		module.addNativeFunction("Game.onLevelStart", lemon::wrap(*this, &Game::onLevelStart), defaultFlags);
-
-		module.addNativeFunction("Game.onZoneActCompleted", lemon::wrap(*this, &Game::onZoneActCompleted), defaultFlags)
-			.setParameterInfo(0, "zoneAndAct");
-
-		module.addNativeFunction("Game.onTriggerNextZone", lemon::wrap(*this, &Game::onTriggerNextZone), defaultFlags)
-			.setParameterInfo(0, "zoneAndAct");
-
-		module.addNativeFunction("Game.onFadedOutLoadingZone", lemon::wrap(*this, &Game::onFadedOutLoadingZone), defaultFlags)
-			.setParameterInfo(0, "zoneAndAct");
-
-		module.addNativeFunction("Game.onCharacterDied", lemon::wrap(*this, &Game::onCharacterDied), noInlineExecution)		// No inline execution as this function manipulated the call stack
-			.setParameterInfo(0, "playerIndex");
-
-		module.addNativeFunction("Game.returnToMainMenu", lemon::wrap(*this, &Game::returnToMainMenu), defaultFlags);
-		module.addNativeFunction("Game.openOptionsMenu", lemon::wrap(*this, &Game::openOptionsMenu), defaultFlags);
-
-		module.addNativeFunction("Game.isNormalGame", lemon::wrap(*this, &Game::isNormalGame), defaultFlags);
-		module.addNativeFunction("Game.isTimeAttack", lemon::wrap(*this, &Game::isTimeAttack), defaultFlags);
-		module.addNativeFunction("Game.onTimeAttackFinish", lemon::wrap(*this, &Game::onTimeAttackFinish), defaultFlags);
-
-		module.addNativeFunction("Game.changePlanePatternRectAtex", lemon::wrap(*this, &Game::changePlanePatternRectAtex), defaultFlags)
-			.setParameterInfo(0, "px")
-			.setParameterInfo(1, "py")
-			.setParameterInfo(2, "width")
-			.setParameterInfo(3, "height")
-			.setParameterInfo(4, "planeIndex")
-			.setParameterInfo(5, "atex");
-
-		module.addNativeFunction("Game.setupBlueSpheresGroundSprites", lemon::wrap(*this, &Game::setupBlueSpheresGroundSprites), defaultFlags);
-
-		module.addNativeFunction("Game.writeBlueSpheresData", lemon::wrap(*this, &Game::writeBlueSpheresData), defaultFlags)
-			.setParameterInfo(0, "targetAddress")
-			.setParameterInfo(1, "sourceAddress")
-			.setParameterInfo(2, "px")
-			.setParameterInfo(3, "py")
-			.setParameterInfo(4, "rotation");
-
-		module.addNativeFunction("Game.getAchievementValue", lemon::wrap(*this, &Game::getAchievementValue), defaultFlags)
-			.setParameterInfo(0, "achievementId");
-
-		module.addNativeFunction("Game.setAchievementValue", lemon::wrap(*this, &Game::setAchievementValue), defaultFlags)
-			.setParameterInfo(0, "achievementId")
-			.setParameterInfo(1, "value");
-
-		module.addNativeFunction("Game.isAchievementComplete", lemon::wrap(*this, &Game::isAchievementComplete), defaultFlags)
-			.setParameterInfo(0, "achievementId");
-
-		module.addNativeFunction("Game.setAchievementComplete", lemon::wrap(*this, &Game::setAchievementComplete), defaultFlags)
-			.setParameterInfo(0, "achievementId");
-
-		module.addNativeFunction("Game.startSkippableCutscene", lemon::wrap(*this, &Game::startSkippableCutscene), defaultFlags);
-		module.addNativeFunction("Game.endSkippableCutscene", lemon::wrap(*this, &Game::endSkippableCutscene), defaultFlags);
-		module.addNativeFunction("Game.isInSkippableCutscene", lemon::wrap(*this, &Game::isInSkippableCutscene), defaultFlags);
-	}
-
-	// Discord
-	{
-		module.addNativeFunction("Game.setDiscordDetails", lemon::wrap(&setDiscordDetails), defaultFlags)
-			.setParameterInfo(0, "text");
-
-		module.addNativeFunction("Game.setDiscordState", lemon::wrap(&setDiscordState), defaultFlags)
-			.setParameterInfo(0, "text");
-
-		module.addNativeFunction("Game.setDiscordLargeImage", lemon::wrap(&setDiscordLargeImage), defaultFlags)
-			.setParameterInfo(0, "imageName");
-
-		module.addNativeFunction("Game.setDiscordSmallImage", lemon::wrap(&setDiscordSmallImage), defaultFlags)
-			.setParameterInfo(0, "imageName");
-	}
-
-	// Audio
-	{
-		module.addNativeFunction("Game.setUnderwaterAudioEffect", lemon::wrap(&setUnderwaterAudioEffect), defaultFlags)
-			.setParameterInfo(0, "value");
-	}
-
-	ScriptImplementations::registerScriptBindings(module);
-}
-
-uint32 Game::getSetting(uint32 settingId, bool ignoreGameMode) const
-{
-	const SharedDatabase::Setting* setting = SharedDatabase::getSetting(settingId);
-
-	if (!ignoreGameMode && isInTimeAttackMode())
-	{
-		// In Time Attack, non-visual settings are always using the default value
-		if ((settingId & 0x80000000) == 0)
-		{
-			const bool explicitlyAllowInTimeAttack = (nullptr != setting && setting->mAllowInTimeAttack);
-			if (!explicitlyAllowInTimeAttack)
-			{
-				// Only exception are the "max control" settings
-				if (settingId == SharedDatabase::Setting::SETTING_DROPDASH || settingId == SharedDatabase::Setting::SETTING_SUPER_PEELOUT)
-				{
-					return (mSubMode == 0x11) ? 1 : 0;
-				}
-				else
-				{
-					return (settingId & 0xff);
-				}
-			}
-		}
-	}
-
-	if (nullptr != setting)
-	{
-		const uint32 value = ConfigurationImpl::instance().mActiveGameSettings->getValue(settingId);
-
-		// Special handling for Debug Mode setting in dev mode
-		if (settingId == SharedDatabase::Setting::SETTING_DEBUG_MODE)
-		{
-			if (value == 0)
-			{
-				if (EngineMain::getDelegate().useDeveloperFeatures() && ConfigurationImpl::instance().mDevModeImpl.mEnforceDebugMode)
-					return true;
-			}
-		}
-		return value;
-	}
-	else
-	{
-		// Use default value
-		return (settingId & 0xff);
-	}
-}
-
 void Game::setSetting(uint32 settingId, uint32 value)
 {
 	RMX_CHECK(nullptr != SharedDatabase::getSetting(settingId), "Setting not found", return);
 	ConfigurationImpl::instance().mActiveGameSettings->setValue(settingId, value);
 }
 
-void Game::checkForUnlockedSecrets()
-{
-	// Check for unlocked secrets
-	uint32 achievementsCompleted = 0;
-	for (const SharedDatabase::Achievement& achievement : SharedDatabase::getAchievements())
-	{
-		if (mPlayerProgress.mAchievements.getAchievementState(achievement.mType) > 0)
-		{
-			++achievementsCompleted;
-		}
-	}
-
-	for (const SharedDatabase::Secret& secret : SharedDatabase::getSecrets())
-	{
-		if (secret.mUnlockedByAchievements && !mPlayerProgress.mUnlocks.isSecretUnlocked(secret.mType) && achievementsCompleted >= secret.mRequiredAchievements)
-		{
-			// Unlock secret now
-			mPlayerProgress.mUnlocks.setSecretUnlocked(secret.mType);
-			GameApp::instance().showUnlockedWindow(SecretUnlockedWindow::EntryType::SECRET, "Secret unlocked!", secret.mName);
-		}
-	}
-}
-
 void Game::startIntoTitleScreen()
 {
-	mMode = Mode::TITLE_SCREEN;
+	mSimulationState.setMode(Mode::TITLE_SCREEN);
 
 	Simulation& simulation = Application::instance().getSimulation();
 	simulation.resetState();
@@ -337,7 +125,7 @@ void Game::startIntoTitleScreen()
 
 void Game::startIntoDataSelect()
 {
-	mMode = Mode::NORMAL_GAME;
+	mSimulationState.setMode(Mode::NORMAL_GAME);
 
 	Simulation& simulation = Application::instance().getSimulation();
 	simulation.resetIntoGame("EntryFunctions.dataSelect");
@@ -347,7 +135,7 @@ void Game::startIntoDataSelect()
 
 void Game::startIntoActSelect()
 {
-	mMode = Mode::ACT_SELECT;
+	mSimulationState.setMode(Mode::ACT_SELECT);
 
 	Simulation& simulation = Application::instance().getSimulation();
 	simulation.resetIntoGame("EntryFunctions.actSelectMenu");
@@ -357,8 +145,8 @@ void Game::startIntoActSelect()
 
 void Game::startIntoLevel(Mode mode, uint32 submode, uint16 zoneAndAct, uint8 characters)
 {
-	mMode = mode;
-	mSubMode = submode;
+	mSimulationState.setMode(mode);
+	mSimulationState.setSubMode(submode);
 
 	Simulation& simulation = Application::instance().getSimulation();
 	simulation.resetIntoGame("EntryFunctions.actSelect");
@@ -370,7 +158,7 @@ void Game::startIntoLevel(Mode mode, uint32 submode, uint16 zoneAndAct, uint8 ch
 	mEmulatorInterface->writeMemory16(0xfffffe10, zoneAndAct);
 	mEmulatorInterface->writeMemory16(0xffffff0a, characters);
 
-	if (mMode == Mode::TIME_ATTACK)
+	if (isInTimeAttackMode())
 	{
 		mPlayerRecorder.setMaxGhosts(getSetting(SharedDatabase::Setting::SETTING_TIME_ATTACK_GHOSTS, true));
 
@@ -405,7 +193,7 @@ void Game::restartTimeAttack(bool skipFadeout)
 {
 	if (skipFadeout)
 	{
-		startIntoLevel(mMode, mSubMode, mLastZoneAndAct, mLastCharacters);
+		startIntoLevel(mSimulationState.getMode(), mSimulationState.getSubMode(), mLastZoneAndAct, mLastCharacters);
 	}
 	else
 	{
@@ -421,7 +209,7 @@ void Game::restartTimeAttack(bool skipFadeout)
 
 void Game::startIntoCompetitionMode()
 {
-	mMode = Mode::COMPETITION;
+	mSimulationState.setMode(Mode::COMPETITION);
 
 	Simulation& simulation = Application::instance().getSimulation();
 	simulation.resetIntoGame("EntryFunctions.competitionMode");
@@ -431,7 +219,7 @@ void Game::startIntoCompetitionMode()
 
 void Game::startIntoBlueSphere()
 {
-	mMode = Mode::BLUE_SPHERE;
+	mSimulationState.setMode(Mode::BLUE_SPHERE);
 
 	Simulation& simulation = Application::instance().getSimulation();
 	simulation.resetIntoGame("EntryFunctions.blueSphereGame");
@@ -441,7 +229,7 @@ void Game::startIntoBlueSphere()
 
 void Game::startIntoLevelSelect()
 {
-	mMode = Mode::ACT_SELECT;
+	mSimulationState.setMode(Mode::ACT_SELECT);
 
 	Simulation& simulation = Application::instance().getSimulation();
 	simulation.resetIntoGame("EntryFunctions.levelSelect");
@@ -451,7 +239,7 @@ void Game::startIntoLevelSelect()
 
 void Game::startIntoMainMenuBG()
 {
-	mMode = Mode::MAIN_MENU_BG;
+	mSimulationState.setMode(Mode::MAIN_MENU_BG);
 
 	Simulation& simulation = Application::instance().getSimulation();
 	simulation.resetIntoGame("EntryFunctions.mainMenuBG");
@@ -470,7 +258,7 @@ void Game::onPostUpdateFrame()
 	// If code execution stopped, return to the main menu
 	if (!Application::instance().getSimulation().getCodeExec().isCodeExecutionPossible())
 	{
-		if (mMode != Mode::UNDEFINED && mMode != Mode::MAIN_MENU_BG)
+		if (mSimulationState.getMode() != Mode::UNDEFINED && !isInMainMenuMode())
 		{
 			GameApp::instance().returnToMenu();
 		}
@@ -495,35 +283,8 @@ void Game::onPostUpdateFrame()
 		}
 	}
 
-	// Update skippable cutscene
-	if (mSkippableCutsceneFrames > 0)
-	{
-		--mSkippableCutsceneFrames;
-		if (mSkippableCutsceneFrames == 0)
-		{
-			endSkippableCutscene();
-		}
-		else
-		{
-			Simulation& simulation = Application::instance().getSimulation();
-			if (mButtonYPressedDuringSkippableCutscene)
-			{
-				if (simulation.getSpeed() == 1.0f)
-				{
-					simulation.setSpeed(CUTSCENE_SKIPPING_SPEED);
-					GameApp::instance().showSkippableCutsceneWindow(true);
-				}
-			}
-			else
-			{
-				if (simulation.getSpeed() == CUTSCENE_SKIPPING_SPEED)
-				{
-					simulation.setSpeed(simulation.getDefaultSpeed());
-				}
-				GameApp::instance().showSkippableCutsceneWindow(false);
-			}
-		}
-	}
+	// Update skippable cutscene and check for unlocked secrets
+	mSimulationState.onPostUpdateFrame();
 
 	// Update player recorder
 	mPlayerRecorder.onPostUpdateFrame();
@@ -531,24 +292,7 @@ void Game::onPostUpdateFrame()
 	// Update ghost sync
 	GameClient::instance().getGhostSync().onPostUpdateFrame();
 
-	// Check for unlocked hidden secrets
-	//  - SECRET_LEVELSELECT	unlocked when u8[0x02219e] changes from 0xb2 to 0x14
-	//  - SECRET_TITLE_SK		unlocked when u8[0x065fde] changes from 0x08 to 0x93
-	//  - SECRET_GAME_SPEED		unlocked when u64[0x003e32] changes from 0xd522427870e16100 to 0x0101020201010101 (= up, up, down, down, up, up, up, up)
-	if (emulatorInterface.readMemory8(0x02219e) == 0x14)
-	{
-		setSecretUnlocked(SharedDatabase::Secret::SECRET_LEVELSELECT);
-	}
-	if (emulatorInterface.readMemory8(0x065fde) == 0x93)
-	{
-		setSecretUnlocked(SharedDatabase::Secret::SECRET_TITLE_SK);
-	}
-	if (emulatorInterface.readMemory64(0x003e32) == 0x0101020201010101ull)
-	{
-		setSecretUnlocked(SharedDatabase::Secret::SECRET_GAME_SPEED);
-	}
-
-	if (mReceivedTimeAttackFinished)
+	if (mSimulationState.hasReceivedTimeAttackFinished())
 	{
 		int hundreds = 0;
 		std::vector<int> otherTimes;
@@ -559,19 +303,6 @@ void Game::onPostUpdateFrame()
 	}
 }
 
-void Game::onUpdateControls()
-{
-	if (mSkippableCutsceneFrames > 0 || mButtonYPressedDuringSkippableCutscene)	// Last check makes sure we'll ignore the press until it gets released
-	{
-		// Block input to the game
-		mButtonYPressedDuringSkippableCutscene = ControlsIn::instance().getGamepad(0).isPressed(ControlsIn::Button::Y);
-		if (mButtonYPressedDuringSkippableCutscene)
-		{
-			ControlsIn::instance().injectEmptyInputs();
-		}
-	}
-}
-
 void Game::updateSpecialInput(float timeElapsed)
 {
 	// In time attack mode: Restart if holding Y button for a while
@@ -801,22 +532,6 @@ void Game::fillDebugVisualization(Bitmap& bitmap, int& mode)
 	}
 }
 
-void Game::onGameRecordingHeaderLoaded(const std::string& buildString, const std::vector<uint8>& buffer)
-{
-	// Switch to using the alternative set of settings
-	ConfigurationImpl::instance().mActiveGameSettings = &ConfigurationImpl::instance().mAlternativeGameSettings;
-
-	const std::unordered_map<uint32, SharedDatabase::Setting>& settings = SharedDatabase::getSettings();
-	VectorBinarySerializer serializer(true, buffer);
-	const size_t numSettings = serializer.read<uint32>();
-	for (size_t i = 0; i < numSettings; ++i)
-	{
-		const uint32 settingId = serializer.read<uint32>();
-		const uint32 value = serializer.read<uint32>();
-		ConfigurationImpl::instance().mActiveGameSettings->setValue(settingId, value);
-	}
-}
-
 void Game::onGameRecordingHeaderSave(std::vector<uint8>& buffer)
 {
 	std::vector<const SharedDatabase::Setting*> relevantSettings;
@@ -861,8 +576,7 @@ void Game::startIntoGameInternal()
 	// Setup defaults -- these should not get used outside of Time Attack anyway
 	mLastZoneAndAct = 0;
 	mLastCharacters = 0;
-	mReceivedTimeAttackFinished = false;
-	mSkippableCutsceneFrames = 0;
+	mSimulationState.resetScriptState();
 
 	Simulation& simulation = Application::instance().getSimulation();
 	simulation.setRunning(true);
@@ -876,8 +590,6 @@ void Game::startIntoGameInternal()
 
 	setSetting(SharedDatabase::Setting::SETTING_KNUCKLES_AND_TAILS, false);		// Not queried by scripts at all, but it can't hurt to set it to false nevertheless
 
-	SharedDatabase::resetAchievementValues();
-
 	if (!isInMainMenuMode())
 	{
 		AudioOut::instance().moveMenuMusicToIngame();	// Needed only for the data select music to continue from main menu to data select
@@ -891,75 +603,6 @@ void Game::startIntoGameInternal()
 	mTimeoutUntilDiscordRefresh = 0.0f;
 }
 
-uint32 Game::useSetting(uint32 settingId)
-{
-	return getSetting(settingId, false);
-}
-
-int32 Game::getAchievementValue(uint32 achievementId)
-{
-	SharedDatabase::Achievement* achievement = SharedDatabase::getAchievement(achievementId);
-	return (nullptr == achievement) ? 0 : achievement->mValue;
-}
-
-void Game::setAchievementValue(uint32 achievementId, int32 value)
-{
-	SharedDatabase::Achievement* achievement = SharedDatabase::getAchievement(achievementId);
-	if (nullptr != achievement)
-	{
-		achievement->mValue = value;
-	}
-}
-
-bool Game::isAchievementComplete(uint32 achievementId)
-{
-	return (mPlayerProgress.mAchievements.getAchievementState(achievementId) != 0);
-}
-
-void Game::setAchievementComplete(uint32 achievementId)
-{
-	// Can't affect achievements in debug mode (except if dev mode is active)
-	const bool hasDebugModeActive = getSetting(SharedDatabase::Setting::SETTING_DEBUG_MODE, true) != 0;
-	if (hasDebugModeActive && !EngineMain::getDelegate().useDeveloperFeatures())
-		return;
-
-	if (mPlayerProgress.mAchievements.getAchievementState(achievementId) == 0)
-	{
-		mPlayerProgress.mAchievements.mAchievementStates[achievementId] = 1;
-		SharedDatabase::Achievement* achievement = SharedDatabase::getAchievement(achievementId);
-		if (nullptr != achievement)
-		{
-			GameApp::instance().showUnlockedWindow(SecretUnlockedWindow::EntryType::ACHIEVEMENT, "Achievement complete", achievement->mName);
-		}
-		else
-		{
-			RMX_ERROR("Achievement not found", );
-		}
-
-		checkForUnlockedSecrets();
-		mPlayerProgress.save();
-	}
-}
-
-bool Game::isSecretUnlocked(uint32 secretId)
-{
-	return mPlayerProgress.mUnlocks.isSecretUnlocked(secretId);
-}
-
-void Game::setSecretUnlocked(uint32 secretId)
-{
-	SharedDatabase::Secret* secret = SharedDatabase::getSecret(secretId);
-	RMX_CHECK(nullptr != secret, "Secret with ID " << secretId << " not found", return);
-
-	if (!mPlayerProgress.mUnlocks.isSecretUnlocked(secretId))
-	{
-		mPlayerProgress.mUnlocks.setSecretUnlocked(secretId);
-		const char* text = (secret->mType == SharedDatabase::Secret::SECRET_DOOMSDAY_ZONE) ? "Unlocked in Act Select" : "Found hidden secret!";
-		GameApp::instance().showUnlockedWindow(SecretUnlockedWindow::EntryType::SECRET, text, secret->mName);
-		mPlayerProgress.save();
-	}
-}
-
 void Game::triggerRestart()
 {
 	mRestartTriggered = true;
@@ -991,32 +634,6 @@ void Game::onZoneActCompleted(uint16 zoneAndAct)
 	mPlayerProgress.save();
 }
 
-uint16 Game::onTriggerNextZone(uint16 zoneAndAct)
-{
-	return zoneAndAct;
-}
-
-uint16 Game::onFadedOutLoadingZone(uint16 zoneAndAct)
-{
-	return zoneAndAct;
-}
-
-bool Game::onCharacterDied(uint8 playerIndex)
-{
-	// Death in time attack means level restart
-	if (isInTimeAttackMode())
-	{
-		if (mReceivedTimeAttackFinished)
-		{
-			// No death allowed!
-			return false;
-		}
-
-		Application::instance().getSimulation().getCodeExec().getLemonScriptRuntime().callFunctionByName("restartTimeAttack");
-	}
-	return true;
-}
-
 void Game::returnToMainMenu()
 {
 	mReturnToMenuTriggered = true;
@@ -1040,49 +657,7 @@ void Game::openOptionsMenu()
 	GameApp::instance().openOptionsMenuInGame();
 }
 
-bool Game::onTimeAttackFinish()
-{
-	if (!isInTimeAttackMode() || mReceivedTimeAttackFinished)
-		return false;
-
-	mReceivedTimeAttackFinished = true;
-	return true;
-}
-
-void Game::changePlanePatternRectAtex(uint16 px, uint16 py, uint16 width, uint16 height, uint8 planeIndex, uint8 atex)
-{
-	s3air::changePlanePatternRectAtex(*mEmulatorInterface, px, py, width, height, planeIndex, atex);
-}
-
 void Game::setupBlueSpheresGroundSprites()
 {
 	mBlueSpheresRendering.createSprites(VideoOut::instance().getScreenSize());
 }
-
-void Game::writeBlueSpheresData(uint32 targetAddress, uint32 sourceAddress, uint16 px, uint16 py, uint8 rotation)
-{
-	mBlueSpheresRendering.writeVisibleSpheresData(targetAddress, sourceAddress, px, py, rotation, *mEmulatorInterface);
-}
-
-void Game::startSkippableCutscene()
-{
-	mSkippableCutsceneFrames = 5 * 60 * 60;		// Limit cutscene length to five minutes
-}
-
-void Game::endSkippableCutscene()
-{
-	mSkippableCutsceneFrames = 0;
-	mButtonYPressedDuringSkippableCutscene = false;
-
-	// Back to normal
-	Simulation& simulation = Application::instance().getSimulation();
-	if (simulation.getSpeed() == CUTSCENE_SKIPPING_SPEED)
-		simulation.setSpeed(simulation.getDefaultSpeed());
-
-	GameApp::instance().showSkippableCutsceneWindow(false);
-}
-
-bool Game::isInSkippableCutscene()
-{
-	return mSkippableCutsceneFrames > 0;
-}
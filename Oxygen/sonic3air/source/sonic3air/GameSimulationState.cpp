@@ -0,0 +1,567 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#include "sonic3air/pch.h"
+#include "sonic3air/GameSimulationState.h"
+#include "sonic3air/ConfigurationImpl.h"
+#include "sonic3air/Game.h"
+#include "sonic3air/audio/AudioOut.h"
+#include "sonic3air/data/SharedDatabase.h"
+#include "sonic3air/helper/DiscordIntegration.h"
+#include "sonic3air/helper/GameUtils.h"
+#include "sonic3air/menu/GameApp.h"
+#include "sonic3air/scriptimpl/ScriptImplementations.h"
+
+#include "oxygen/application/Application.h"
+#include "oxygen/application/input/ControlsIn.h"
+#include "oxygen/simulation/CodeExec.h"
+#include "oxygen/simulation/EmulatorInterface.h"
+#include "oxygen/simulation/Simulation.h"
+
+#include <lemon/program/FunctionWrapper.h>
+#include <lemon/program/Module.h>
+
+
+namespace
+{
+	const constexpr float CUTSCENE_SKIPPING_SPEED = 4.0f;	// Should be more or less "unique", not one of the debug game speeds (3.0f or 5.0f)
+
+	// Discord and audio output only exist once, so only the main simulation gets to change them
+	inline bool isMainSimulation()
+	{
+		return GameSimulationState::instance().isDefaultInstance();
+	}
+
+	void setDiscordDetails(lemon::StringRef text)
+	{
+		if (text.isValid() && isMainSimulation())
+			DiscordIntegration::setModdedDetails(text.getString());
+	}
+
+	void setDiscordState(lemon::StringRef text)
+	{
+		if (text.isValid() && isMainSimulation())
+			DiscordIntegration::setModdedState(text.getString());
+	}
+
+	void setDiscordLargeImage(lemon::StringRef imageName)
+	{
+		if (imageName.isValid() && isMainSimulation())
+			DiscordIntegration::setModdedLargeImage(imageName.getString());
+	}
+
+	void setDiscordSmallImage(lemon::StringRef imageName)
+	{
+		if (imageName.isValid() && isMainSimulation())
+			DiscordIntegration::setModdedSmallImage(imageName.getString());
+	}
+
+	void setUnderwaterAudioEffect(uint8 value)
+	{
+		if (isMainSimulation())
+			AudioOut::instance().enableUnderwaterEffect((float)value / 255.0f);
+	}
+}
+
+
+GameSimulationState::GameSimulationState()
+{
+	if (!isDefaultInstance())
+	{
+		// Start with the same settings and progress as the main simulation
+		mGameSettings = ConfigurationImpl::instance().mLocalGameSettings;
+		if (PlayerProgress::hasInstance())
+		{
+			mAchievements = PlayerProgress::instance().mAchievements;
+			mUnlocks = PlayerProgress::instance().mUnlocks;
+		}
+	}
+}
+
+void GameSimulationState::registerScriptBindings(lemon::Module& module)
+{
+	const BitFlagSet<lemon::Function::Flag> defaultFlags(lemon::Function::Flag::ALLOW_INLINE_EXECUTION);
+	const BitFlagSet<lemon::Function::Flag> noInlineExecution;
+
+	// Game
+	{
+		module.addNativeFunction("Game.getSetting", lemon::wrap(*this, &GameSimulationState::useSetting), defaultFlags)
+			.setParameterInfo(0, "settingId");
+
+		module.addNativeFunction("Game.isSecretUnlocked", lemon::wrap(*this, &GameSimulationState::isSecretUnlocked), defaultFlags)
+			.setParameterInfo(0, "secretId");
+
+		module.addNativeFunction("Game.setSecretUnlocked", lemon::wrap(*this, &GameSimulationState::setSecretUnlocked), defaultFlags)
+			.setParameterInfo(0, "secretId");
+
+		module.addNativeFunction("Game.triggerRestart", lemon::wrap(*this, &GameSimulationState::triggerRestart), defaultFlags);
+
+		module.addNativeFunction("Game.onGamePause", lemon::wrap(*this, &GameSimulationState::onGamePause), defaultFlags)
+			.setParameterInfo(0, "canRestart");
+
+		module.addNativeFunction("Game.allowRestartInGamePause", lemon::wrap(*this, &GameSimulationState::allowRestartInGamePause), defaultFlags)
+			.setParameterInfo(0, "canRestart");
+
+		module.addNativeFunction("Game.onLevelStart", lemon::wrap(*this, &GameSimulationState::onLevelStart), defaultFlags);
+
+		module.addNativeFunction("Game.onZoneActCompleted", lemon::wrap(*this, &GameSimulationState::onZoneActCompleted), defaultFlags)
+			.setParameterInfo(0, "zoneAndAct");
+
+		module.addNativeFunction("Game.onTriggerNextZone", lemon::wrap(*this, &GameSimulationState::onTriggerNextZone), defaultFlags)
+			.setParameterInfo(0, "zoneAndAct");
+
+		module.addNativeFunction("Game.onFadedOutLoadingZone", lemon::wrap(*this, &GameSimulationState::onFadedOutLoadingZone), defaultFlags)
+			.setParameterInfo(0, "zoneAndAct");
+
+		module.addNativeFunction("Game.onCharacterDied", lemon::wrap(*this, &GameSimulationState::onCharacterDied), noInlineExecution)		// No inline execution as this function manipulated the call stack
+			.setParameterInfo(0, "playerIndex");
+
+		module.addNativeFunction("Game.returnToMainMenu", lemon::wrap(*this, &GameSimulationState::returnToMainMenu), defaultFlags);
+		module.addNativeFunction("Game.openOptionsMenu", lemon::wrap(*this, &GameSimulationState::openOptionsMenu), defaultFlags);
+
+		module.addNativeFunction("Game.isNormalGame", lemon::wrap(*this, &GameSimulationState::isNormalGame), defaultFlags);
+		module.addNativeFunction("Game.isTimeAttack", lemon::wrap(*this, &GameSimulationState::isTimeAttack), defaultFlags);
+		module.addNativeFunction("Game.onTimeAttackFinish", lemon::wrap(*this, &GameSimulationState::onTimeAttackFinish), defaultFlags);
+
+		module.addNativeFunction("Game.changePlanePatternRectAtex", lemon::wrap(*this, &GameSimulationState::changePlanePatternRectAtex), defaultFlags)
+			.setParameterInfo(0, "px")
+			.setParameterInfo(1, "py")
+			.setParameterInfo(2, "width")
+			.setParameterInfo(3, "height")
+			.setParameterInfo(4, "planeIndex")
+			.setParameterInfo(5, "atex");
+
+		module.addNativeFunction("Game.setupBlueSpheresGroundSprites", lemon::wrap(*this, &GameSimulationState::setupBlueSpheresGroundSprites), defaultFlags);
+
+		module.addNativeFunction("Game.writeBlueSpheresData", lemon::wrap(*this, &GameSimulationState::writeBlueSpheresData), defaultFlags)
+			.setParameterInfo(0, "targetAddress")
+			.setParameterInfo(1, "sourceAddress")
+			.setParameterInfo(2, "px")
+			.setParameterInfo(3, "py")
+			.setParameterInfo(4, "rotation");
+
+		module.addNativeFunction("Game.getAchievementValue", lemon::wrap(*this, &GameSimulationState::getAchievementValue), defaultFlags)
+			.setParameterInfo(0, "achievementId");
+
+		module.addNativeFunction("Game.setAchievementValue", lemon::wrap(*this, &GameSimulationState::setAchievementValue), defaultFlags)
+			.setParameterInfo(0, "achievementId")
+			.setParameterInfo(1, "value");
+
+		module.addNativeFunction("Game.isAchievementComplete", lemon::wrap(*this, &GameSimulationState::isAchievementComplete), defaultFlags)
+			.setParameterInfo(0, "achievementId");
+
+		module.addNativeFunction("Game.setAchievementComplete", lemon::wrap(*this, &GameSimulationState::setAchievementComplete), defaultFlags)
+			.setParameterInfo(0, "achievementId");
+
+		module.addNativeFunction("Game.startSkippableCutscene", lemon::wrap(*this, &GameSimulationState::startSkippableCutscene), defaultFlags);
+		module.addNativeFunction("Game.endSkippableCutscene", lemon::wrap(*this, &GameSimulationState::endSkippableCutscene), defaultFlags);
+		module.addNativeFunction("Game.isInSkippableCutscene", lemon::wrap(*this, &GameSimulationState::isInSkippableCutscene), defaultFlags);
+	}
+
+	// Discord
+	{
+		module.addNativeFunction("Game.setDiscordDetails", lemon::wrap(&setDiscordDetails), defaultFlags)
+			.setParameterInfo(0, "text");
+
+		module.addNativeFunction("Game.setDiscordState", lemon::wrap(&setDiscordState), defaultFlags)
+			.setParameterInfo(0, "text");
+
+		module.addNativeFunction("Game.setDiscordLargeImage", lemon::wrap(&setDiscordLargeImage), defaultFlags)
+			.setParameterInfo(0, "imageName");
+
+		module.addNativeFunction("Game.setDiscordSmallImage", lemon::wrap(&setDiscordSmallImage), defaultFlags)
+			.setParameterInfo(0, "imageName");
+	}
+
+	// Audio
+	{
+		module.addNativeFunction("Game.setUnderwaterAudioEffect", lemon::wrap(&setUnderwaterAudioEffect), defaultFlags)
+			.setParameterInfo(0, "value");
+	}
+
+	ScriptImplementations::registerScriptBindings(module);
+}
+
+uint32 GameSimulationState::getSetting(uint32 settingId, bool ignoreGameMode) const
+{
+	const SharedDatabase::Setting* setting = SharedDatabase::getSetting(settingId);
+
+	if (!ignoreGameMode && isInTimeAttackMode())
+	{
+		// In Time Attack, non-visual settings are always using the default value
+		if ((settingId & 0x80000000) == 0)
+		{
+			const bool explicitlyAllowInTimeAttack = (nullptr != setting && setting->mAllowInTimeAttack);
+			if (!explicitlyAllowInTimeAttack)
+			{
+				// Only exception are the "max control" settings
+				if (settingId == SharedDatabase::Setting::SETTING_DROPDASH || settingId == SharedDatabase::Setting::SETTING_SUPER_PEELOUT)
+				{
+					return (mSubMode == 0x11) ? 1 : 0;
+				}
+				else
+				{
+					return (settingId & 0xff);
+				}
+			}
+		}
+	}
+
+	if (nullptr != setting)
+	{
+		const GameSettings& gameSettings = isDefaultInstance() ? *ConfigurationImpl::instance().mActiveGameSettings : mGameSettings;
+		const uint32 value = gameSettings.getValue(settingId);
+
+		// Special handling for Debug Mode setting in dev mode
+		if (settingId == SharedDatabase::Setting::SETTING_DEBUG_MODE)
+		{
+			if (value == 0)
+			{
+				if (EngineMain::getDelegate().useDeveloperFeatures() && ConfigurationImpl::instance().mDevModeImpl.mEnforceDebugMode)
+					return true;
+			}
+		}
+		return value;
+	}
+	else
+	{
+		// Use default value
+		return (settingId & 0xff);
+	}
+}
+
+void GameSimulationState::checkForUnlockedSecrets()
+{
+	// Check for unlocked secrets
+	const detail::PlayerAchievementsData& achievements = getAchievements();
+	detail::PlayerUnlocksData& unlocks = getUnlocks();
+	uint32 achievementsCompleted = 0;
+	for (const SharedDatabase::Achievement& achievement : SharedDatabase::getAchievements())
+	{
+		if (achievements.getAchievementState(achievement.mType) > 0)
+		{
+			++achievementsCompleted;
+		}
+	}
+
+	for (const SharedDatabase::Secret& secret : SharedDatabase::getSecrets())
+	{
+		if (secret.mUnlockedByAchievements && !unlocks.isSecretUnlocked(secret.mType) && achievementsCompleted >= secret.mRequiredAchievements)
+		{
+			// Unlock secret now
+			unlocks.setSecretUnlocked(secret.mType);
+			if (isDefaultInstance())
+				GameApp::instance().showUnlockedWindow(SecretUnlockedWindow::EntryType::SECRET, "Secret unlocked!", secret.mName);
+		}
+	}
+}
+
+void GameSimulationState::resetScriptState()
+{
+	mReceivedTimeAttackFinished = false;
+	mSkippableCutsceneFrames = 0;
+	mButtonYPressedDuringSkippableCutscene = false;
+	mAchievementValues.clear();
+}
+
+void GameSimulationState::onPostUpdateFrame()
+{
+	// Update skippable cutscene
+	if (mSkippableCutsceneFrames > 0)
+	{
+		--mSkippableCutsceneFrames;
+		if (mSkippableCutsceneFrames == 0)
+		{
+			endSkippableCutscene();
+		}
+		else if (isDefaultInstance())
+		{
+			Simulation& simulation = Application::instance().getSimulation();
+			if (mButtonYPressedDuringSkippableCutscene)
+			{
+				if (simulation.getSpeed() == 1.0f)
+				{
+					simulation.setSpeed(CUTSCENE_SKIPPING_SPEED);
+					GameApp::instance().showSkippableCutsceneWindow(true);
+				}
+			}
+			else
+			{
+				if (simulation.getSpeed() == CUTSCENE_SKIPPING_SPEED)
+				{
+					simulation.setSpeed(simulation.getDefaultSpeed());
+				}
+				GameApp::instance().showSkippableCutsceneWindow(false);
+			}
+		}
+	}
+
+	// Check for unlocked hidden secrets
+	//  - SECRET_LEVELSELECT	unlocked when u8[0x02219e] changes from 0xb2 to 0x14
+	//  - SECRET_TITLE_SK		unlocked when u8[0x065fde] changes from 0x08 to 0x93
+	//  - SECRET_GAME_SPEED		unlocked when u64[0x003e32] changes from 0xd522427870e16100 to 0x0101020201010101 (= up, up, down, down, up, up, up, up)
+	EmulatorInterface& emulatorInterface = EmulatorInterface::instance();
+	if (emulatorInterface.readMemory8(0x02219e) == 0x14)
+	{
+		setSecretUnlocked(SharedDatabase::Secret::SECRET_LEVELSELECT);
+	}
+	if (emulatorInterface.readMemory8(0x065fde) == 0x93)
+	{
+		setSecretUnlocked(SharedDatabase::Secret::SECRET_TITLE_SK);
+	}
+	if (emulatorInterface.readMemory64(0x003e32) == 0x0101020201010101ull)
+	{
+		setSecretUnlocked(SharedDatabase::Secret::SECRET_GAME_SPEED);
+	}
+}
+
+void GameSimulationState::onUpdateControls()
+{
+	if (mSkippableCutsceneFrames > 0 || mButtonYPressedDuringSkippableCutscene)	// Last check makes sure we'll ignore the press until it gets released
+	{
+		// Block input to the game
+		mButtonYPressedDuringSkippableCutscene = ControlsIn::instance().getGamepad(0).isPressed(ControlsIn::Button::Y);
+		if (mButtonYPressedDuringSkippableCutscene)
+		{
+			ControlsIn::instance().injectEmptyInputs();
+		}
+	}
+}
+
+void GameSimulationState::onGameRecordingHeaderLoaded(const std::vector<uint8>& buffer)
+{
+	// Start from the local settings, as the recording only contains the settings that are not purely visual
+	ConfigurationImpl& config = ConfigurationImpl::instance();
+	GameSettings* gameSettings = &mGameSettings;
+	if (isDefaultInstance())
+	{
+		// Switch to using the alternative set of settings
+		config.mActiveGameSettings = &config.mAlternativeGameSettings;
+		gameSettings = config.mActiveGameSettings;
+	}
+	*gameSettings = config.mLocalGameSettings;
+
+	VectorBinarySerializer serializer(true, buffer);
+	const size_t numSettings = serializer.read<uint32>();
+	for (size_t i = 0; i < numSettings; ++i)
+	{
+		const uint32 settingId = serializer.read<uint32>();
+		const uint32 value = serializer.read<uint32>();
+		gameSettings->setValue(settingId, value);
+	}
+
+	// The playback starts from a save state, so any state the scripts used before does not apply any more
+	resetScriptState();
+}
+
+detail::PlayerAchievementsData& GameSimulationState::getAchievements()
+{
+	return isDefaultInstance() ? PlayerProgress::instance().mAchievements : mAchievements;
+}
+
+detail::PlayerUnlocksData& GameSimulationState::getUnlocks()
+{
+	return isDefaultInstance() ? PlayerProgress::instance().mUnlocks : mUnlocks;
+}
+
+uint32 GameSimulationState::useSetting(uint32 settingId)
+{
+	return getSetting(settingId, false);
+}
+
+int32 GameSimulationState::getAchievementValue(uint32 achievementId)
+{
+	const int32* value = mapFind(mAchievementValues, achievementId);
+	return (nullptr == value) ? 0 : *value;
+}
+
+void GameSimulationState::setAchievementValue(uint32 achievementId, int32 value)
+{
+	if (nullptr != SharedDatabase::getAchievement(achievementId))
+	{
+		mAchievementValues[achievementId] = value;
+	}
+}
+
+bool GameSimulationState::isAchievementComplete(uint32 achievementId)
+{
+	return (getAchievements().getAchievementState(achievementId) != 0);
+}
+
+void GameSimulationState::setAchievementComplete(uint32 achievementId)
+{
+	// Can't affect achievements in debug mode (except if dev mode is active)
+	const bool hasDebugModeActive = getSetting(SharedDatabase::Setting::SETTING_DEBUG_MODE, true) != 0;
+	if (hasDebugModeActive && !EngineMain::getDelegate().useDeveloperFeatures())
+		return;
+
+	detail::PlayerAchievementsData& achievements = getAchievements();
+	if (achievements.getAchievementState(achievementId) == 0)
+	{
+		achievements.mAchievementStates[achievementId] = 1;
+		if (isDefaultInstance())
+		{
+			SharedDatabase::Achievement* achievement = SharedDatabase::getAchievement(achievementId);
+			if (nullptr != achievement)
+			{
+				GameApp::instance().showUnlockedWindow(SecretUnlockedWindow::EntryType::ACHIEVEMENT, "Achievement complete", achievement->mName);
+			}
+			else
+			{
+				RMX_ERROR("Achievement not found", );
+			}
+		}
+
+		checkForUnlockedSecrets();
+		if (isDefaultInstance())
+			PlayerProgress::instance().save();
+	}
+}
+
+bool GameSimulationState::isSecretUnlocked(uint32 secretId)
+{
+	return getUnlocks().isSecretUnlocked(secretId);
+}
+
+void GameSimulationState::setSecretUnlocked(uint32 secretId)
+{
+	SharedDatabase::Secret* secret = SharedDatabase::getSecret(secretId);
+	RMX_CHECK(nullptr != secret, "Secret with ID " << secretId << " not found", return);
+
+	detail::PlayerUnlocksData& unlocks = getUnlocks();
+	if (!unlocks.isSecretUnlocked(secretId))
+	{
+		unlocks.setSecretUnlocked(secretId);
+		if (isDefaultInstance())
+		{
+			const char* text = (secret->mType == SharedDatabase::Secret::SECRET_DOOMSDAY_ZONE) ? "Unlocked in Act Select" : "Found hidden secret!";
+			GameApp::instance().showUnlockedWindow(SecretUnlockedWindow::EntryType::SECRET, text, secret->mName);
+			PlayerProgress::instance().save();
+		}
+	}
+}
+
+void GameSimulationState::triggerRestart()
+{
+	if (isDefaultInstance())
+		Game::instance().triggerRestart();
+}
+
+void GameSimulationState::onGamePause(uint8 canRestart)
+{
+	if (isDefaultInstance())
+		Game::instance().onGamePause(canRestart);
+}
+
+void GameSimulationState::allowRestartInGamePause(uint8 canRestart)
+{
+	if (isDefaultInstance())
+		Game::instance().allowRestartInGamePause(canRestart);
+}
+
+void GameSimulationState::onLevelStart()
+{
+	if (isDefaultInstance())
+		Game::instance().onLevelStart();
+}
+
+void GameSimulationState::onZoneActCompleted(uint16 zoneAndAct)
+{
+	if (isDefaultInstance())
+		Game::instance().onZoneActCompleted(zoneAndAct);
+}
+
+uint16 GameSimulationState::onTriggerNextZone(uint16 zoneAndAct)
+{
+	return zoneAndAct;
+}
+
+uint16 GameSimulationState::onFadedOutLoadingZone(uint16 zoneAndAct)
+{
+	return zoneAndAct;
+}
+
+bool GameSimulationState::onCharacterDied(uint8 playerIndex)
+{
+	// Death in time attack means level restart
+	if (isInTimeAttackMode())
+	{
+		if (mReceivedTimeAttackFinished)
+		{
+			// No death allowed!
+			return false;
+		}
+
+		Simulation::instance().getCodeExec().getLemonScriptRuntime().callFunctionByName("restartTimeAttack");
+	}
+	return true;
+}
+
+void GameSimulationState::returnToMainMenu()
+{
+	if (isDefaultInstance())
+		Game::instance().returnToMainMenu();
+}
+
+void GameSimulationState::openOptionsMenu()
+{
+	if (isDefaultInstance())
+		Game::instance().openOptionsMenu();
+}
+
+bool GameSimulationState::onTimeAttackFinish()
+{
+	if (!isInTimeAttackMode() || mReceivedTimeAttackFinished)
+		return false;
+
+	mReceivedTimeAttackFinished = true;
+	return true;
+}
+
+void GameSimulationState::changePlanePatternRectAtex(uint16 px, uint16 py, uint16 width, uint16 height, uint8 planeIndex, uint8 atex)
+{
+	s3air::changePlanePatternRectAtex(EmulatorInterface::instance(), px, py, width, height, planeIndex, atex);
+}
+
+void GameSimulationState::setupBlueSpheresGroundSprites()
+{
+	if (isDefaultInstance())
+		Game::instance().setupBlueSpheresGroundSprites();
+}
+
+void GameSimulationState::writeBlueSpheresData(uint32 targetAddress, uint32 sourceAddress, uint16 px, uint16 py, uint8 rotation)
+{
+	// This does not change the blue spheres rendering's state, so it's fine to use from any simulation
+	Game::instance().getBlueSpheresRendering().writeVisibleSpheresData(targetAddress, sourceAddress, px, py, rotation, EmulatorInterface::instance());
+}
+
+void GameSimulationState::startSkippableCutscene()
+{
+	mSkippableCutsceneFrames = 5 * 60 * 60;		// Limit cutscene length to five minutes
+}
+
+void GameSimulationState::endSkippableCutscene()
+{
+	mSkippableCutsceneFrames = 0;
+	mButtonYPressedDuringSkippableCutscene = false;
+
+	if (isDefaultInstance())
+	{
+		// Back to normal
+		Simulation& simulation = Application::instance().getSimulation();
+		if (simulation.getSpeed() == CUTSCENE_SKIPPING_SPEED)
+			simulation.setSpeed(simulation.getDefaultSpeed());
+
+		GameApp::instance().showSkippableCutsceneWindow(false);
+	}
+}
+
+bool GameSimulationState::isInSkippableCutscene()
+{
+	return mSkippableCutsceneFrames > 0;
+}
@@ -0,0 +1,115 @@
+/*
+*	Part of the Oxygen Engine / Sonic 3 A.I.R. software distribution.
+*	Copyright (C) 2017-2025 by Eukaryot
+*
+*	Published under the GNU GPLv3 open source software license, see license.txt
+*	or https://www.gnu.org/licenses/gpl-3.0.en.html
+*/
+
+#pragma once
+
+#include "sonic3air/data/GameSettings.h"
+#include "sonic3air/data/PlayerProgress.h"
+
+namespace lemon
+{
+	class Module;
+}
+
+
+// Game state that the "Game" script bindings and frame callbacks work with, one instance per simulation
+//  - The default instance belongs to the main simulation and is owned by "Game", which it forwards everything to that affects the application (like menus or saving player progress)
+//  - Simulations running in parallel have their own instance with copies of the game settings and player progress, and keep all changes to themselves
+class GameSimulationState : public PerThreadInstance<GameSimulationState>
+{
+public:
+	enum class Mode
+	{
+		UNDEFINED = 0,	// Undefined mode is used in debugging
+		TITLE_SCREEN,	// SEGA logo, intro, title screen
+		NORMAL_GAME,	// Normal game (started from the menu)
+		ACT_SELECT,		// Act Select mode
+		TIME_ATTACK,	// Time Attack mode
+		COMPETITION,	// Competition mode
+		BLUE_SPHERE,	// Blue Sphere game mode
+		MAIN_MENU_BG	// Main menu background
+	};
+
+public:
+	GameSimulationState();
+
+	void registerScriptBindings(lemon::Module& module);
+
+	inline Mode getMode() const				{ return mMode; }
+	inline uint32 getSubMode() const		{ return mSubMode; }
+	inline void setMode(Mode mode)			{ mMode = mode; }
+	inline void setSubMode(uint32 subMode)	{ mSubMode = subMode; }
+
+	inline bool isInTimeAttackMode() const	{ return mMode == Mode::TIME_ATTACK; }
+	inline bool hasReceivedTimeAttackFinished() const  { return mReceivedTimeAttackFinished; }
+
+	uint32 getSetting(uint32 settingId, bool ignoreGameMode) const;
+
+	void checkForUnlockedSecrets();
+	void resetScriptState();
+
+	void onPostUpdateFrame();
+	void onUpdateControls();
+
+	void onGameRecordingHeaderLoaded(const std::vector<uint8>& buffer);
+
+private:
+	detail::PlayerAchievementsData& getAchievements();
+	detail::PlayerUnlocksData& getUnlocks();
+
+	// Script bindings
+	uint32 useSetting(uint32 settingId);
+
+	int32 getAchievementValue(uint32 achievementId);
+	void setAchievementValue(uint32 achievementId, int32 value);
+	bool isAchievementComplete(uint32 achievementId);
+	void setAchievementComplete(uint32 achievementId);
+
+	bool isSecretUnlocked(uint32 secretId);
+	void setSecretUnlocked(uint32 secretId);
+
+	void triggerRestart();
+	void onGamePause(uint8 canRestart);
+	void allowRestartInGamePause(uint8 canRestart);
+	void onLevelStart();
+	void onZoneActCompleted(uint16 zoneAndAct);
+	uint16 onTriggerNextZone(uint16 zoneAndAct);
+	uint16 onFadedOutLoadingZone(uint16 zoneAndAct);
+	bool onCharacterDied(uint8 playerIndex);
+	void returnToMainMenu();
+	void openOptionsMenu();
+
+	inline bool isNormalGame()	{ return mMode == Mode::NORMAL_GAME; }
+	inline bool isTimeAttack()	{ return isInTimeAttackMode(); }
+	bool onTimeAttackFinish();
+
+	void changePlanePatternRectAtex(uint16 px, uint16 py, uint16 width, uint16 height, uint8 planeIndex, uint8 atex);
+
+	void setupBlueSpheresGroundSprites();
+	void writeBlueSpheresData(uint32 targetAddress, uint32 sourceAddress, uint16 px, uint16 py, uint8 rotation);
+
+	void startSkippableCutscene();
+	void endSkippableCutscene();
+	bool isInSkippableCutscene();
+
+private:
+	Mode mMode = Mode::UNDEFINED;
+	uint32 mSubMode = 0;
+
+	bool mReceivedTimeAttackFinished = false;
+
+	uint32 mSkippableCutsceneFrames = 0;	// If > 0, a skippable cutscene is active
+	bool mButtonYPressedDuringSkippableCutscene = false;
+
+	std::unordered_map<uint32, int32> mAchievementValues;	// Temporary values used by scripts for whatever they need to store, using achievement IDs as keys
+
+	// Only used by simulations running in parallel, the main simulation uses the configuration's active game settings and the player progress
+	GameSettings mGameSettings;
+	detail::PlayerAchievementsData mAchievements;
+	detail::PlayerUnlocksData mUnlocks;
+};
@@ -171,6 +171,16 @@ void AudioOut::enableUnderwaterEffect(float value)
 	}
 }
 
+void AudioOut::runBenchmark()
+{
+	AudioOutBase::runBenchmark();
+
+	// Once more with the underwater effect, which adds a filter in the ingame audio mixer
+	//  -> It gets switched on anew for each pass, so that each pass starts with the same filter state
+	runMixerBenchmark("Ingame mixing with underwater effect", [this]() { enableUnderwaterEffect(0.0f); enableUnderwaterEffect(0.5f); });
+	enableUnderwaterEffect(0.0f);
+}
+
 void AudioOut::determineActiveSourceRegistrations()
 {
 	const bool preferOriginal = (ConfigurationImpl::instance().mActiveSoundtrack != 1);
@@ -50,6 +50,8 @@ public:
 	void onSoundtrackPreferencesChanged();
 	void enableUnderwaterEffect(float value);
 
+	void runBenchmark() override;
+
 protected:
 	void determineActiveSourceRegistrations() override;
 
@@ -9,6 +9,47 @@
 #include "sonic3air/pch.h"
 #include "sonic3air/audio/CustomAudioMixer.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+	#define CUSTOMAUDIOMIXER_SSE2
+	#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define CUSTOMAUDIOMIXER_NEON
+	#include <arm_neon.h>
+#endif
+
+
+namespace
+{
+	// Writes the quotients of the given sums and the divisor, rounded towards zero like an integer division
+	//  -> Doubles represent the sums exactly (they are way below 2^53), and then the correctly rounded double division truncates to the same result as the integer division
+	//  -> That's the case as long as the results fit into 32 bits, which is a given for actual audio data
+	void divideSums(int32* output, const double* sums, size_t numSamples, int divisor)
+	{
+		size_t i = 0;
+	#if defined(CUSTOMAUDIOMIXER_SSE2)
+		const __m128d divisors = _mm_set1_pd((double)divisor);
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			const __m128i low  = _mm_cvttpd_epi32(_mm_div_pd(_mm_loadu_pd(&sums[i]),     divisors));
+			const __m128i high = _mm_cvttpd_epi32(_mm_div_pd(_mm_loadu_pd(&sums[i + 2]), divisors));
+			_mm_storeu_si128((__m128i*)&output[i], _mm_unpacklo_epi64(low, high));
+		}
+	#elif defined(CUSTOMAUDIOMIXER_NEON)
+		const float64x2_t divisors = vdupq_n_f64((double)divisor);
+		for (; i + 4 <= numSamples; i += 4)
+		{
+			const int32x2_t low  = vmovn_s64(vcvtq_s64_f64(vdivq_f64(vld1q_f64(&sums[i]),     divisors)));
+			const int32x2_t high = vmovn_s64(vcvtq_s64_f64(vdivq_f64(vld1q_f64(&sums[i + 2]), divisors)));
+			vst1q_s32(&output[i], vcombine_s32(low, high));
+		}
+	#endif
+		for (; i < numSamples; ++i)
+		{
+			output[i] = (int32)(sums[i] / (double)divisor);
+		}
+	}
+}
+
 
 void CustomAudioMixer::setUnderwaterEffect(int effect, float volumeMultiplier)
 {
@@ -77,6 +118,27 @@ void CustomAudioMixer::performAudioMix(const MixerParameters& parameters)
 	const int divisor = roundToInt((float)effect / volume);
 
 	// Now do the post-processing
+	if (rmx::AudioMixer::getUseOptimizedMixing())
+	{
+		// Same as below, but the accumulator values get collected first, and all divisions are done afterwards in one go
+		for (size_t k = 0; k < MAX_NUM_CHANNELS; ++k)
+		{
+			ChannelData& data = mChannelData[k];
+			for (size_t i = 0; i < parameters.mOutputSamples; ++i)
+			{
+				const int32 inputValue = data.mOutputBuffer[i];
+				const size_t lookupIndex = (data.mIndexInHistory - effect + ACCUMULATION_BUFFER_SIZE) % ACCUMULATION_BUFFER_SIZE;
+				data.mAccumulator += (int64)(inputValue - data.mHistoryBuffer[lookupIndex]);
+				mSums[i] = (double)data.mAccumulator;
+
+				data.mHistoryBuffer[data.mIndexInHistory] = inputValue;
+				data.mIndexInHistory = (data.mIndexInHistory + 1) % ACCUMULATION_BUFFER_SIZE;
+			}
+			divideSums(parameters.mOutputBuffers[k], mSums, parameters.mOutputSamples, divisor);
+		}
+		return;
+	}
+
 	for (size_t k = 0; k < MAX_NUM_CHANNELS; ++k)
 	{
 		ChannelData& data = mChannelData[k];
@@ -37,4 +37,5 @@ private:
 		int64 mAccumulator = 0;
 	};
 	ChannelData mChannelData[MAX_NUM_CHANNELS];
+	double mSums[OUTPUT_BUFFER_SIZE] = { 0.0 };		// Temporary buffer for the accumulator values of one channel
 };
@@ -232,14 +232,6 @@ const std::vector<SharedDatabase::Achievement>& SharedDatabase::getAchievements(
 	return mAchievements;
 }
 
-void SharedDatabase::resetAchievementValues()
-{
-	for (Achievement& achievement : mAchievements)
-	{
-		achievement.mValue = 0;
-	}
-}
-
 SharedDatabase::Secret* SharedDatabase::getSecret(uint32 secretId)
 {
 	// No additional std::map used to optimize this, as the number of secrets is very low
@@ -159,7 +159,6 @@ public:
 		std::string mDescription;
 		std::string mHint;
 		std::string mImage;
-		int32 mValue = 0;	// Temporary value used by scripts for whatever they need to store
 	};
 
 	struct Secret
@@ -208,7 +207,6 @@ public:
 
 	static Achievement* getAchievement(uint32 achievementId);
 	static const std::vector<Achievement>& getAchievements();
-	static void resetAchievementValues();
 
 	static Secret* getSecret(uint32 secretId);
 	static inline const std::vector<Secret>& getSecrets()  { return mSecrets; }
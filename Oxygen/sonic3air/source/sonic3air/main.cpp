@@ -87,6 +87,7 @@ int main(int argc, char** argv)
 	// Randomization is quite important for server communication
 	randomize();
 
+	int exitCode = 0;
 	try
 	{
 		// Create engine delegate and engine main instance
@@ -108,12 +109,12 @@ int main(int argc, char** argv)
 		}
 
 		// Now run the game
-		myMain.execute();
+		exitCode = myMain.execute();
 	}
 	catch (const std::exception& e)
 	{
 		RMX_ERROR("Caught unhandled exception in main loop: " << e.what(), );
 	}
 
-	return 0;
+	return exitCode;
 }
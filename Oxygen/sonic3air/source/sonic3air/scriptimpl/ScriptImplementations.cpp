@@ -102,6 +102,7 @@ namespace s3air
 				src += 2;
 				dst += 2;
 			}
+			emulatorInterface.markVRamChanged(targetInVRAM, bytes);
 
 			if (size < 0x1000)
 				break;
@@ -40,3 +40,60 @@ private:
 };
 
 template<typename CLASS> CLASS* SingleInstance<CLASS>::mSingleInstance = nullptr;
+
+
+// Variant of SingleInstance that allows for one instance per thread
+//  - The first instance created is the default instance, used by all threads that don't have an instance of their own
+//  - Each further instance gets bound to the thread that created it, and must be destroyed by that thread as well
+//  - Helper threads working on behalf of another thread can temporarily use its instance, see "ScopedBinding"
+template<class CLASS> class PerThreadInstance
+{
+public:
+	// Binds the given instance to the calling thread for the lifetime of this object; nullptr means using the default instance
+	class ScopedBinding
+	{
+	public:
+		explicit ScopedBinding(CLASS* instance) : mPreviousInstance(mThreadInstance)  { mThreadInstance = instance; }
+		~ScopedBinding()  { mThreadInstance = mPreviousInstance; }
+
+	private:
+		CLASS* mPreviousInstance = nullptr;
+	};
+
+public:
+	static bool hasInstance()
+	{
+		return (nullptr != mThreadInstance || nullptr != mDefaultInstance);
+	}
+
+	static CLASS& instance()
+	{
+		return (nullptr != mThreadInstance) ? *mThreadInstance : *mDefaultInstance;
+	}
+
+	bool isDefaultInstance() const
+	{
+		return (static_cast<const CLASS*>(this) == mDefaultInstance);
+	}
+
+protected:
+	PerThreadInstance()
+	{
+		if (nullptr == mDefaultInstance)
+			mDefaultInstance = static_cast<CLASS*>(this);
+		else
+			mThreadInstance = static_cast<CLASS*>(this);
+	}
+
+	virtual ~PerThreadInstance()
+	{
+		if (mDefaultInstance == static_cast<CLASS*>(this))
+			mDefaultInstance = nullptr;
+		if (mThreadInstance == static_cast<CLASS*>(this))
+			mThreadInstance = nullptr;
+	}
+
+private:
+	static inline CLASS* mDefaultInstance = nullptr;
+	static inline thread_local CLASS* mThreadInstance = nullptr;
+};
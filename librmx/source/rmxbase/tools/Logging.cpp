@@ -20,6 +20,7 @@
 #include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 
 
@@ -41,6 +42,9 @@ namespace rmx
 			std::strftime(buf, sizeof(buf), "[%Y-%m-%d %T] ", &tstruct);
 			return buf;
 		}
+
+		// Logging may happen from multiple threads, e.g. with simulations running in parallel
+		std::mutex loggingMutex;
 	}
 
 
@@ -159,6 +163,7 @@ namespace rmx
 
 	void Logging::log(LogLevel logLevel, const std::string& string)
 	{
+		std::lock_guard<std::mutex> lock(detail::loggingMutex);
 		for (LoggerBase* logger : mLoggers)
 		{
 			logger->performLogging(logLevel, string);
@@ -234,9 +234,7 @@ bool OggLoader::updateStreaming()
 					mSkipAudioSampleOutput = 0;
 				}
 
-				mAudioBuffer->lock();
 				mAudioBuffer->addData(source, samples);
-				mAudioBuffer->unlock();
 			}
 
 			vorbis_synthesis_read(&mVorbisDspState, memcount);
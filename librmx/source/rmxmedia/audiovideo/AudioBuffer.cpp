@@ -28,6 +28,8 @@ AudioBuffer::AudioFrame::~AudioFrame()
 
 AudioBuffer::AudioBuffer()
 {
+	for (int i = 0; i < MAX_CHUNKS; ++i)
+		mChunks[i].store(nullptr, std::memory_order_relaxed);
 }
 
 AudioBuffer::~AudioBuffer()
@@ -37,16 +39,17 @@ AudioBuffer::~AudioBuffer()
 
 void AudioBuffer::clear(int frequency, int channels)
 {
-	RMX_ASSERT(mMutexLockCounter > 0, "Audio buffer mutex should be locked in 'AudioBuffer::clear' method");
+	// The audio mixer must not access the audio frames while they get deleted
+	lock();
 	clearInternal();
 	mFrequency = clamp(frequency, 22050, 48000);
 	mChannels = clamp(channels, 1, 2);
-	mCompleted = false;
+	mCompleted.store(false, std::memory_order_release);
+	unlock();
 }
 
 void AudioBuffer::addData(short** data, int length, int frequency, int channels)
 {
-	RMX_ASSERT(mMutexLockCounter > 0, "Audio buffer mutex should be locked in 'AudioBuffer::addData' method");
 	if (nullptr == data || length <= 0)
 		return;
 
@@ -56,29 +59,34 @@ void AudioBuffer::addData(short** data, int length, int frequency, int channels)
 	if (frequency <= 0)
 		frequency = mDefaultFrequency;
 */
+	int bufferLength = mLength.load(std::memory_order_relaxed);
 	int offset = 0;
 	while (offset < length)
 	{
 		// Get or create working frame
-		AudioFrame& workingFrame = getWorkingFrame();
+		AudioFrame* workingFrame = getWorkingFrame(bufferLength);
+		if (nullptr == workingFrame)
+			break;
 
 		// Copy data
-		int len = std::min(length - offset, MAX_FRAME_LENGTH - workingFrame.mLength);
+		const int localPosition = bufferLength % MAX_FRAME_LENGTH;
+		const int len = std::min(length - offset, MAX_FRAME_LENGTH - localPosition);
 		for (int i = 0; i < mChannels; ++i)
 		{
 			short* src = &data[i][offset];
-			short* dst = &workingFrame.mData[i][workingFrame.mLength];
+			short* dst = &workingFrame->mData[i][localPosition];
 			memcpy(dst, src, len * sizeof(short));
 		}
 		offset += len;
-		workingFrame.mLength += len;
-		mLength += len;
+		bufferLength += len;
 	}
+
+	// Make the new data visible to the audio mixer only now that it got written completely
+	mLength.store(bufferLength, std::memory_order_release);
 }
 
 void AudioBuffer::addData(float** data, int length, int frequency, int channels)
 {
-	RMX_ASSERT(mMutexLockCounter > 0, "Audio buffer mutex should be locked in 'AudioBuffer::addData' method");
 	if (nullptr == data || length <= 0)
 		return;
 
@@ -88,18 +96,22 @@ void AudioBuffer::addData(float** data, int length, int frequency, int channels)
 	if (frequency <= 0)
 		frequency = mDefaultFrequency;
 */
+	int bufferLength = mLength.load(std::memory_order_relaxed);
 	int offset = 0;
 	while (offset < length)
 	{
 		// Get or create working frame
-		AudioFrame& workingFrame = getWorkingFrame();
+		AudioFrame* workingFrame = getWorkingFrame(bufferLength);
+		if (nullptr == workingFrame)
+			break;
 
 		// Copy data
-		const int len = std::min(length - offset, MAX_FRAME_LENGTH - workingFrame.mLength);
+		const int localPosition = bufferLength % MAX_FRAME_LENGTH;
+		const int len = std::min(length - offset, MAX_FRAME_LENGTH - localPosition);
 		for (int i = 0; i < mChannels; ++i)
 		{
 			const float* src = &data[i][offset];
-			short* dst = &workingFrame.mData[i][workingFrame.mLength];
+			short* dst = &workingFrame->mData[i][localPosition];
 			for (int j = 0; j < len; ++j)
 			{
 				const int value = (int)(src[j] * 0x8000 + 0.5f);
@@ -107,29 +119,44 @@ void AudioBuffer::addData(float** data, int length, int frequency, int channels)
 			}
 		}
 		offset += len;
-		workingFrame.mLength += len;
-		mLength += len;
+		bufferLength += len;
 	}
+
+	// Make the new data visible to the audio mixer only now that it got written completely
+	mLength.store(bufferLength, std::memory_order_release);
 }
 
 void AudioBuffer::markPurgeableSamples(int purgePosition)
 {
 	RMX_ASSERT(!mPersistent, "'AudioBuffer::markPurgeableSamples' is meant only for non-persistent audio buffers");
-	RMX_ASSERT(mMutexLockCounter > 0, "Audio buffer mutex should be locked in 'AudioBuffer::markPurgeableSamples' method");
-	int numFramesToPurge = purgePosition / MAX_FRAME_LENGTH;
-	numFramesToPurge = clamp(numFramesToPurge, 0, mPurgedFrames + (int)mFrames.size() - 1);
-	const int difference = numFramesToPurge - mPurgedFrames;
 
-	// To avoid the expensive copying all the time, don't purge any frames unless it's at least 32 frames to be moved
-	if (difference >= 32)
+	// Only frames that were filled completely can get purged, as the producer won't write to them any more
+	const int numFramesToPurge = clamp(purgePosition, 0, getLength()) / MAX_FRAME_LENGTH;
+	if (numFramesToPurge > mPurgeMark.load(std::memory_order_relaxed))
 	{
-		const int framesRemaining = (int)mFrames.size() - difference;
-		for (int i = 0; i < difference; ++i)
-			delete mFrames[i];
-		for (int i = 0; i < framesRemaining; ++i)
-			mFrames[i] = mFrames[i + difference];
-		mFrames.resize(framesRemaining);
-		mPurgedFrames = numFramesToPurge;
+		mPurgeMark.store(numFramesToPurge, std::memory_order_release);
+	}
+}
+
+void AudioBuffer::purgeMarkedSamples()
+{
+	// Frames don't get moved, so purging is only the deletion of frames, and of chunks that are not needed any more
+	const int purgeMark = mPurgeMark.load(std::memory_order_acquire);
+	for (; mPurgedFrames < purgeMark; ++mPurgedFrames)
+	{
+		std::atomic<FrameChunk*>& chunkSlot = mChunks[(mPurgedFrames / FRAMES_PER_CHUNK) % MAX_CHUNKS];
+		FrameChunk* chunk = chunkSlot.load(std::memory_order_acquire);
+		if (nullptr == chunk)
+			continue;
+
+		AudioFrame*& frame = chunk->mFrames[mPurgedFrames % FRAMES_PER_CHUNK];
+		SAFE_DELETE(frame);
+		if ((mPurgedFrames + 1) % FRAMES_PER_CHUNK == 0)
+		{
+			// This was the chunk's last frame, so its slot can be reused by the producer
+			chunkSlot.store(nullptr, std::memory_order_release);
+			delete chunk;
+		}
 	}
 }
 
@@ -148,12 +175,13 @@ bool AudioBuffer::load(const String& source, const String& params)
 
 float AudioBuffer::getLengthInSec() const
 {
-	return (float)mLength / (float)mFrequency;
+	return (float)getLength() / (float)mFrequency;
 }
 
 size_t AudioBuffer::getMemoryUsage() const
 {
-	return mFrames.size() * MAX_FRAME_LENGTH * sizeof(short) * mChannels;
+	const int numFrames = (getLength() + MAX_FRAME_LENGTH - 1) / MAX_FRAME_LENGTH - mPurgeMark.load(std::memory_order_relaxed);
+	return (size_t)std::max(numFrames, 0) * MAX_FRAME_LENGTH * sizeof(short) * mChannels;
 }
 
 void AudioBuffer::setPersistent(bool persistent)
@@ -163,35 +191,30 @@ void AudioBuffer::setPersistent(bool persistent)
 
 void AudioBuffer::setCompleted(bool completed)
 {
-	mCompleted = completed;
+	mCompleted.store(completed, std::memory_order_release);
 }
 
 int AudioBuffer::getData(short** output, int position) const
 {
 	// Access audio data
-	RMX_ASSERT(mMutexLockCounter > 0, "Audio buffer mutex should be locked in 'AudioBuffer::getData' method");
+	//  -> Only data that the producer made visible by updating the length is accessed, so there's no locking needed
 	output[0] = nullptr;
 	output[1] = nullptr;
-	if (position < 0)
+	const int length = getLength();
+	if (position < 0 || position >= length)
 		return 0;
 
-	const int frameIndex = (position / MAX_FRAME_LENGTH) - mPurgedFrames;
-	RMX_ASSERT(frameIndex >= 0 && frameIndex <= (int)mFrames.size(), "Invalid frame index " << frameIndex);  // Equality with frame size is okay and does not trigger the assert, but caught by the if-check
-	if (frameIndex >= 0 && frameIndex < (int)mFrames.size())
-	{
-		const AudioFrame* frame = mFrames[frameIndex];
-		if (nullptr != frame)
-		{
-			const int localPosition = position % MAX_FRAME_LENGTH;
-			if (localPosition < frame->mLength)
-			{
-				output[0] = &frame->mData[0][localPosition];
-				output[1] = &frame->mData[1][localPosition];
-				return frame->mLength - localPosition;
-			}
-		}
-	}
-	return 0;
+	const int frameIndex = position / MAX_FRAME_LENGTH;
+	RMX_ASSERT(frameIndex >= mPurgeMark.load(std::memory_order_relaxed), "Invalid frame index " << frameIndex << ", frame was purged already");
+	if (frameIndex < mPurgeMark.load(std::memory_order_acquire))
+		return 0;
+
+	const FrameChunk* chunk = mChunks[(frameIndex / FRAMES_PER_CHUNK) % MAX_CHUNKS].load(std::memory_order_acquire);
+	const AudioFrame* frame = chunk->mFrames[frameIndex % FRAMES_PER_CHUNK];
+	const int localPosition = position % MAX_FRAME_LENGTH;
+	output[0] = &frame->mData[0][localPosition];
+	output[1] = (nullptr == frame->mData[1]) ? nullptr : &frame->mData[1][localPosition];
+	return std::min(length - frameIndex * MAX_FRAME_LENGTH, MAX_FRAME_LENGTH) - localPosition;
 }
 
 void AudioBuffer::lock()
@@ -201,6 +224,14 @@ void AudioBuffer::lock()
 	++mMutexLockCounter;
 }
 
+bool AudioBuffer::tryLock()
+{
+	if (!mMutex.tryLock())
+		return false;
+	++mMutexLockCounter;
+	return true;
+}
+
 void AudioBuffer::unlock()
 {
 	--mMutexLockCounter;
@@ -210,20 +241,41 @@ void AudioBuffer::unlock()
 void AudioBuffer::clearInternal()
 {
 	// Clear all frames
-	for (int i = 0; i < (int)mFrames.size(); ++i)
-		delete mFrames[i];
-	mFrames.clear();
+	mLength.store(0, std::memory_order_release);
+	for (int i = 0; i < MAX_CHUNKS; ++i)
+	{
+		FrameChunk* chunk = mChunks[i].load(std::memory_order_acquire);
+		if (nullptr != chunk)
+		{
+			for (AudioFrame* frame : chunk->mFrames)
+				delete frame;
+			delete chunk;
+			mChunks[i].store(nullptr, std::memory_order_release);
+		}
+	}
+	mPurgeMark.store(0, std::memory_order_release);
 	mPurgedFrames = 0;
-	mLength = 0;
 }
 
-AudioBuffer::AudioFrame& AudioBuffer::getWorkingFrame()
+AudioBuffer::AudioFrame* AudioBuffer::getWorkingFrame(int length)
 {
-	AudioFrame* workingFrame = mFrames.empty() ? nullptr : mFrames[mFrames.size()-1];
-	if (nullptr == workingFrame || workingFrame->mLength >= MAX_FRAME_LENGTH)
+	const int frameIndex = length / MAX_FRAME_LENGTH;
+	std::atomic<FrameChunk*>& chunkSlot = mChunks[(frameIndex / FRAMES_PER_CHUNK) % MAX_CHUNKS];
+	FrameChunk* chunk = chunkSlot.load(std::memory_order_acquire);
+	if (length % (MAX_FRAME_LENGTH * FRAMES_PER_CHUNK) == 0)
+	{
+		// Start a new chunk, but only if its slot in the ring got free again
+		RMX_ASSERT(nullptr == chunk, "Audio buffer is full, played audio frames need to get purged first");
+		if (nullptr != chunk)
+			return nullptr;
+		chunk = new FrameChunk();
+		chunkSlot.store(chunk, std::memory_order_release);
+	}
+
+	AudioFrame*& workingFrame = chunk->mFrames[frameIndex % FRAMES_PER_CHUNK];
+	if (nullptr == workingFrame)
 	{
 		workingFrame = new AudioFrame(mChannels);
-		mFrames.push_back(workingFrame);
 	}
-	return *workingFrame;
+	return workingFrame;
 }
@@ -11,6 +11,8 @@
 
 #pragma once
 
+#include <atomic>
+
 
 class API_EXPORT AudioBuffer
 {
@@ -23,19 +25,25 @@ public:
 	AudioBuffer();
 	~AudioBuffer();
 
+	// Note that only one thread at a time may write to the audio buffer (using "clear" or "addData"), while the audio mixer reads from it
+	//  -> Adding data and reading it is lock-free, only clearing locks the audio buffer, as the audio frames get deleted
 	void clear(int frequency = 44100, int channels = 2);
 
 	void addData(short** data, int length, int frequency = 0, int channels = 0);
 	void addData(float** data, int length, int frequency = 0, int channels = 0);
 
+	// Purging of played audio frames is split into two steps, so that it never blocks the audio mixer
+	//  -> First mark the purgeable samples while the audio device is locked; afterwards the audio mixer won't access them any more
+	//  -> Then delete the marked samples after unlocking the audio device again
 	void markPurgeableSamples(int purgePosition);
+	void purgeMarkedSamples();
 
 	bool load(const String& source, const String& params = String());
 
 	inline int getFrequency() const { return mFrequency; }
 	inline int getChannels() const  { return mChannels; }
 
-	inline int getLength() const	{ return mLength; }
+	inline int getLength() const	{ return mLength.load(std::memory_order_acquire); }
 	float getLengthInSec() const;
 
 	size_t getMemoryUsage() const;
@@ -43,40 +51,51 @@ public:
 	inline bool isPersistent()  { return mPersistent; }
 	void setPersistent(bool persistent);
 
-	inline bool isCompleted() const  { return mCompleted; }
+	inline bool isCompleted() const  { return mCompleted.load(std::memory_order_acquire); }
 	void setCompleted(bool completed = true);
 
 	int getData(short** output, int position) const;
 
 	void lock();
+	bool tryLock();
 	void unlock();
 
 private:
 	static const constexpr int MAX_FRAME_LENGTH = 4096;		// Maximum length of an audio frame in samples -- this is the length of all audio frames, except the last
+	static const constexpr int FRAMES_PER_CHUNK = 256;		// Number of audio frames in a chunk, i.e. around 22 seconds at 48 kHz
+	static const constexpr int MAX_CHUNKS = 256;			// Size of the chunk ring; this limits the audio data held at the same time to around 93 minutes at 48 kHz
 
 	struct AudioFrame
 	{
 		short* mBuffer = nullptr;				// Holds all audio data
 		short* mData[2] = { nullptr, nullptr };	// Pointers into the buffer, one for each channel
-		int mLength = 0;						// Length in samples
 
 		explicit AudioFrame(int channels);
 		~AudioFrame();
 	};
 
+	struct FrameChunk
+	{
+		AudioFrame* mFrames[FRAMES_PER_CHUNK] = { nullptr };
+	};
+
 private:
 	void clearInternal();
-	AudioFrame& getWorkingFrame();
+	AudioFrame* getWorkingFrame(int length);
 
 private:
-	std::vector<AudioFrame*> mFrames;	// Array of audio frames
-	int mPurgedFrames = 0;
-	int mLength = 0;					// In samples
+	// Audio frames are stored in a ring of chunks, so they never get moved in memory while the audio mixer reads them
+	//  -> Frame with index n is found in chunk slot (n / FRAMES_PER_CHUNK) % MAX_CHUNKS
+	//  -> For non-persistent audio buffers, chunks get deleted when all their frames got purged, which makes their slot available again
+	std::atomic<FrameChunk*> mChunks[MAX_CHUNKS];
+	std::atomic<int> mPurgeMark = 0;	// Number of frames that are marked as purgeable and won't be accessed any more
+	int mPurgedFrames = 0;				// Number of frames actually deleted
+	std::atomic<int> mLength = 0;		// In samples; written by the producer only after the data got added
 
 	int mChannels = 2;					// 1 for Mono, 2 for Stereo
 	int mFrequency = 44100;				// Sampling frequency, e.g. 44100 Hz
 	bool mPersistent = true;			// If false, played audio frames get deleted (e.g. for music streams)
-	bool mCompleted = false;			// Set to true when loading / streaming is completed
+	std::atomic<bool> mCompleted = false;	// Set to true when loading / streaming is completed
 
 	rmx::Mutex mMutex;
 	int mMutexLockCounter = 0;
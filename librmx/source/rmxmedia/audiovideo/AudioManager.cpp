@@ -179,13 +179,17 @@ namespace rmx
 			// Now update the audio buffers
 			for (auto& bufferPair : audioBufferPurgePositions)
 			{
-				AudioBuffer* audioBuffer = bufferPair.first;
-				audioBuffer->lock();
-				audioBuffer->markPurgeableSamples(bufferPair.second);
-				audioBuffer->unlock();
+				bufferPair.first->markPurgeableSamples(bufferPair.second);
 			}
 
 			unlockAudio();
+
+			// Delete the marked samples only after unlocking, so the audio callback does not have to wait for that
+			//  -> Any audio mix from now on respects the purge marks set above
+			for (auto& bufferPair : audioBufferPurgePositions)
+			{
+				bufferPair.first->purgeMarkedSamples();
+			}
 		}
 	}
 
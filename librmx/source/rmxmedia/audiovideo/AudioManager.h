@@ -102,9 +102,13 @@ namespace rmx
 
 		inline int getOutputBufferSize() const		  { return mFormat.samples; }
 		inline int getOutputFrequency() const		  { return mFormat.freq; }
+		inline int getOutputChannels() const		  { return mFormat.channels; }
 		inline uint32 getGlobalPlayedSamples() const  { return mPlayedSamples; }
 		inline double getGlobalPlaybackTime() const   { return (double)mPlayedSamples / (double)mFormat.freq; }
 
+		// This gets called by the audio callback; calling it from elsewhere (e.g. for benchmarks) is only safe while the audio is locked
+		void mixAudio(uint8* outputStream, int outputBytes);
+
 	private:
 		void registerAudioMixer(AudioMixer& audioMixer, int parentMixerId);
 
@@ -112,7 +116,6 @@ namespace rmx
 		void processRemoveIDs();
 
 		static void mixAudioStatic(void* _userdata, uint8* outputStream, int outputBytes);
-		void mixAudio(uint8* outputStream, int outputBytes);
 
 	private:
 		SDL_AudioDeviceID mAudioDeviceID = 0;		// Audio device opened by SDL
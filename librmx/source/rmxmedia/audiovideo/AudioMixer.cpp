@@ -8,18 +8,166 @@
 
 #include "rmxmedia.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+	#define RMX_AUDIOMIXER_SSE2
+	#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define RMX_AUDIOMIXER_NEON
+	#include <arm_neon.h>
+#endif
+
 
 namespace rmx
 {
 
 	namespace
 	{
+	#if defined(RMX_AUDIOMIXER_SSE2)
+		inline __m128i loadSamplesAsInt32(const short* input)
+		{
+			// Load 4 samples and sign-extend them to 32 bits
+			const __m128i samples = _mm_loadl_epi64((const __m128i*)input);
+			return _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+		}
+
+		inline __m128i multiplyInt32(__m128i a, __m128i b)
+		{
+			// SSE2 has no 32-bit multiplication that keeps the lower bits, so multiply even and odd lanes separately
+			const __m128i even = _mm_mul_epu32(a, b);
+			const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+			return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		}
+	#endif
+
+		// Mixes in samples that don't need resampling, i.e. are read one after the other, with a constant volume
+		//  -> With AVERAGE set, the sum of both inputs gets mixed in, otherwise only the first input is used
+		template<bool AVERAGE>
+		void accumulateSamples(int32* RESTRICT output, const short* input0, const short* input1, int numSamples, int volume)
+		{
+			int i = 0;
+		#if defined(RMX_AUDIOMIXER_SSE2)
+			if (AudioMixer::getUseOptimizedMixing() && volume >= -0x8000 && volume <= 0x7fff)
+			{
+				// Multiply-add of 16-bit pairs (input0, input1) or (input0, 0) with the volume results in exactly the 32-bit values needed
+				const __m128i factors = _mm_set1_epi16((short)volume);
+				for (; i + 8 <= numSamples; i += 8)
+				{
+					const __m128i samples0 = _mm_loadu_si128((const __m128i*)&input0[i]);
+					__m128i samples1 = _mm_setzero_si128();
+					if constexpr (AVERAGE)
+					{
+						samples1 = _mm_loadu_si128((const __m128i*)&input1[i]);
+					}
+					__m128i* out = (__m128i*)&output[i];
+					_mm_storeu_si128(out,     _mm_add_epi32(_mm_loadu_si128(out),     _mm_madd_epi16(_mm_unpacklo_epi16(samples0, samples1), factors)));
+					_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_madd_epi16(_mm_unpackhi_epi16(samples0, samples1), factors)));
+				}
+			}
+		#elif defined(RMX_AUDIOMIXER_NEON)
+			if (AudioMixer::getUseOptimizedMixing() && volume >= -0x8000 && volume <= 0x7fff)
+			{
+				const int16x4_t factor = vdup_n_s16((int16_t)volume);
+				for (; i + 8 <= numSamples; i += 8)
+				{
+					const int16x8_t samples0 = vld1q_s16(&input0[i]);
+					int32x4_t low  = vmlal_s16(vld1q_s32(&output[i]),     vget_low_s16(samples0),  factor);
+					int32x4_t high = vmlal_s16(vld1q_s32(&output[i + 4]), vget_high_s16(samples0), factor);
+					if constexpr (AVERAGE)
+					{
+						const int16x8_t samples1 = vld1q_s16(&input1[i]);
+						low  = vmlal_s16(low,  vget_low_s16(samples1),  factor);
+						high = vmlal_s16(high, vget_high_s16(samples1), factor);
+					}
+					vst1q_s32(&output[i], low);
+					vst1q_s32(&output[i + 4], high);
+				}
+			}
+		#endif
+
+			for (; i < numSamples; ++i)
+			{
+				if constexpr (AVERAGE)
+				{
+					output[i] += (input0[i] + input1[i]) * volume;
+				}
+				else
+				{
+					output[i] += input0[i] * volume;
+				}
+			}
+		}
+
+		// Same as "accumulateSamples", but with a volume ramp, i.e. the volume (in 8.8 fixed point) changing linearly from sample to sample
+		template<bool AVERAGE>
+		void accumulateSamplesWithRamp(int32* RESTRICT output, const short* input0, const short* input1, int numSamples, int volume, int volumeChange)
+		{
+			int i = 0;
+		#if defined(RMX_AUDIOMIXER_SSE2)
+			if (AudioMixer::getUseOptimizedMixing())
+			{
+				__m128i volumes = _mm_setr_epi32(volume, volume + volumeChange, volume + volumeChange * 2, volume + volumeChange * 3);
+				const __m128i volumeStep = _mm_set1_epi32(volumeChange * 4);
+				for (; i + 4 <= numSamples; i += 4)
+				{
+					__m128i samples = loadSamplesAsInt32(&input0[i]);
+					if constexpr (AVERAGE)
+					{
+						samples = _mm_add_epi32(samples, loadSamplesAsInt32(&input1[i]));
+					}
+					__m128i* out = (__m128i*)&output[i];
+					_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), _mm_srai_epi32(multiplyInt32(samples, volumes), 8)));
+					volumes = _mm_add_epi32(volumes, volumeStep);
+				}
+				volume += volumeChange * i;
+			}
+		#elif defined(RMX_AUDIOMIXER_NEON)
+			if (AudioMixer::getUseOptimizedMixing())
+			{
+				const int32_t initialVolumes[4] = { volume, volume + volumeChange, volume + volumeChange * 2, volume + volumeChange * 3 };
+				int32x4_t volumes = vld1q_s32(initialVolumes);
+				const int32x4_t volumeStep = vdupq_n_s32(volumeChange * 4);
+				for (; i + 4 <= numSamples; i += 4)
+				{
+					int32x4_t samples = vmovl_s16(vld1_s16(&input0[i]));
+					if constexpr (AVERAGE)
+					{
+						samples = vaddq_s32(samples, vmovl_s16(vld1_s16(&input1[i])));
+					}
+					vst1q_s32(&output[i], vaddq_s32(vld1q_s32(&output[i]), vshrq_n_s32(vmulq_s32(samples, volumes), 8)));
+					volumes = vaddq_s32(volumes, volumeStep);
+				}
+				volume += volumeChange * i;
+			}
+		#endif
+
+			for (; i < numSamples; ++i)
+			{
+				if constexpr (AVERAGE)
+				{
+					output[i] += ((input0[i] + input1[i]) * volume) >> 8;
+				}
+				else
+				{
+					output[i] += (input0[i] * volume) >> 8;
+				}
+				volume += volumeChange;
+			}
+		}
+
 		void mixInSamples(int32* output, const short* input, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume, int volumeChange)
 		{
+			// Without resampling, the input samples get read one after the other, so the kernels above can be used
+			const bool useKernel = (sourceIndexAdvance == 0x10000);
 			int j = sourceIndexStart;
 			if (volumeChange == 0)
 			{
 				volume >>= 8;
+				if (useKernel)
+				{
+					accumulateSamples<false>(output, &input[j >> 16], nullptr, numSamples, volume);
+					return;
+				}
+
 				for (int i = 0; i < numSamples; ++i)
 				{
 					output[i] += input[j >> 16] * volume;
@@ -37,6 +185,12 @@ namespace rmx
 					numSamples = (0x10000 - volume) / volumeChange;
 				}
 
+				if (useKernel)
+				{
+					accumulateSamplesWithRamp<false>(output, &input[j >> 16], nullptr, numSamples, volume, volumeChange);
+					return;
+				}
+
 				for (int i = 0; i < numSamples; ++i)
 				{
 					output[i] += (input[j >> 16] * volume) >> 8;
@@ -48,12 +202,19 @@ namespace rmx
 
 		void mixInSampleAverages(int32* output, const short* input0, const short* input1, int numSamples, int sourceIndexStart, int sourceIndexAdvance, int volume, int volumeChange)
 		{
+			const bool useKernel = (sourceIndexAdvance == 0x10000);
 			int j = sourceIndexStart;
 			volume /= 2;
 			volumeChange /= 2;
 			if (volumeChange == 0)
 			{
 				volume >>= 8;
+				if (useKernel)
+				{
+					accumulateSamples<true>(output, &input0[j >> 16], &input1[j >> 16], numSamples, volume);
+					return;
+				}
+
 				for (int i = 0; i < numSamples; ++i)
 				{
 					const int k = j >> 16;
@@ -72,6 +233,12 @@ namespace rmx
 					numSamples = (0x10000 - volume) / volumeChange;
 				}
 
+				if (useKernel)
+				{
+					accumulateSamplesWithRamp<true>(output, &input0[j >> 16], &input1[j >> 16], numSamples, volume, volumeChange);
+					return;
+				}
+
 				for (int i = 0; i < numSamples; ++i)
 				{
 					const int k = j >> 16;
@@ -81,6 +248,30 @@ namespace rmx
 				}
 			}
 		}
+
+		void mixInSamplesStereo(int32* output0, int32* output1, const short* input0, const short* input1, int numSamples, int sourceIndexStart, int sourceIndexAdvance, const int* volume, const int* volumeChange)
+		{
+			// Resampling with constant volume is the most common case for sound effects, so mix in both channels in one go there, to share the resampling
+			//  -> Otherwise, use one call per channel, which uses the SIMD kernels if possible
+			if (AudioMixer::getUseOptimizedMixing() && sourceIndexAdvance != 0x10000 && volumeChange[0] == 0 && volumeChange[1] == 0)
+			{
+				const int volume0 = volume[0] >> 8;
+				const int volume1 = volume[1] >> 8;
+				int j = sourceIndexStart;
+				for (int i = 0; i < numSamples; ++i)
+				{
+					const int k = j >> 16;
+					output0[i] += input0[k] * volume0;
+					output1[i] += input1[k] * volume1;
+					j += sourceIndexAdvance;
+				}
+			}
+			else
+			{
+				mixInSamples(output0, input0, numSamples, sourceIndexStart, sourceIndexAdvance, volume[0], volumeChange[0]);
+				mixInSamples(output1, input1, numSamples, sourceIndexStart, sourceIndexAdvance, volume[1], volumeChange[1]);
+			}
+		}
 	}
 
 
@@ -202,7 +393,11 @@ namespace rmx
 		}
 
 		// Perform the actual audio mixing
-		audioBuffer.lock();
+		//  -> Reading the audio data is lock-free, the audio buffer lock is only held while the audio buffer gets cleared
+		//  -> In that case, don't wait for the other thread in the audio callback, but just leave out this instance for now
+		if (!audioBuffer.tryLock())
+			return;
+
 		const bool result = mixAudioBufferInner(audioInstance, output, numOutputSamplesNeeded, outputFormat, sourceIndexAdvance);
 		audioBuffer.unlock();
 
@@ -243,20 +438,30 @@ namespace rmx
 					// We don't have any more data yet, sorry
 					return true;
 				}
-				else if (audioInstance.mLoop)
+
+				// The producer may have added its last data right before completing the stream, so check once more
+				if (audioInstance.mStreaming)
 				{
-					// Restart looped sound
-					audioInstance.mPosition = audioInstance.mLoopStart;
 					numAvailableInputSamples = audioBuffer.getData(instanceData, audioInstance.mPosition);
-					if (numAvailableInputSamples <= 0)
-					{
-						return audioInstance.mStreaming;
-					}
 				}
-				else
+
+				if (numAvailableInputSamples <= 0)
 				{
-					// Stop playback
-					return false;
+					if (audioInstance.mLoop)
+					{
+						// Restart looped sound
+						audioInstance.mPosition = audioInstance.mLoopStart;
+						numAvailableInputSamples = audioBuffer.getData(instanceData, audioInstance.mPosition);
+						if (numAvailableInputSamples <= 0)
+						{
+							return audioInstance.mStreaming;
+						}
+					}
+					else
+					{
+						// Stop playback
+						return false;
+					}
 				}
 			}
 
@@ -315,8 +520,7 @@ namespace rmx
 				// Output as Stereo
 				if (instanceChannels == 1)
 				{
-					mixInSamples(output[0], instanceData[0], numBlockSamples, sourceSamplePositionFraction, sourceIndexAdvance, volume[0], volumeChange[0]);
-					mixInSamples(output[1], instanceData[0], numBlockSamples, sourceSamplePositionFraction, sourceIndexAdvance, volume[1], volumeChange[1]);
+					mixInSamplesStereo(output[0], output[1], instanceData[0], instanceData[0], numBlockSamples, sourceSamplePositionFraction, sourceIndexAdvance, volume, volumeChange);
 				}
 				else if (audioInstance.mPanning)
 				{
@@ -325,8 +529,7 @@ namespace rmx
 				}
 				else
 				{
-					mixInSamples(output[0], instanceData[0], numBlockSamples, sourceSamplePositionFraction, sourceIndexAdvance, volume[0], volumeChange[0]);
-					mixInSamples(output[1], instanceData[1], numBlockSamples, sourceSamplePositionFraction, sourceIndexAdvance, volume[1], volumeChange[1]);
+					mixInSamplesStereo(output[0], output[1], instanceData[0], instanceData[1], numBlockSamples, sourceSamplePositionFraction, sourceIndexAdvance, volume, volumeChange);
 				}
 			}
 
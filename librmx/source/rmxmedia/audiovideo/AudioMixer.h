@@ -46,6 +46,10 @@ namespace rmx
 	public:
 		virtual void performAudioMix(const MixerParameters& parameters);
 
+		// Optimized mixing uses SIMD kernels where available, with exactly the same output as without; switching it off is only meant for testing and benchmarks
+		static inline bool getUseOptimizedMixing()  { return mUseOptimizedMixing; }
+		static inline void setUseOptimizedMixing(bool enable)  { mUseOptimizedMixing = enable; }
+
 	protected:
 		void updateOutputVolume(const MixerParameters& parameters);
 		void mixInAllChildren(const MixerParameters& parameters);
@@ -62,6 +66,8 @@ namespace rmx
 		void removeChildInternal(AudioMixer& child);
 
 	private:
+		static inline bool mUseOptimizedMixing = true;
+
 		int mMixerId = 0;
 		AudioMixer* mParent = nullptr;
 		std::vector<AudioMixer*> mChildren;
@@ -14,64 +14,85 @@ namespace rmx
 
 	JobManager::JobManager()
 	{
-		mConditionVariable = SDL_CreateCond();
-		mConditionLock = SDL_CreateMutex();
+		mWakeUpSemaphore = SDL_CreateSemaphore(0);
+		mThreadsLock = SDL_CreateMutex();
+		mJobStoppedLock = SDL_CreateMutex();
+		mJobStoppedCondition = SDL_CreateCond();
 	}
 
 	JobManager::~JobManager()
 	{
+		// Note that this may get called twice on shutdown, see "EngineMain"
 		stopAllThreads();
-		SDL_DestroyCond(mConditionVariable);
-		SDL_DestroyMutex(mConditionLock);
+		SDL_DestroySemaphore(mWakeUpSemaphore);
+		SDL_DestroyMutex(mThreadsLock);
+		SDL_DestroyCond(mJobStoppedCondition);
+		SDL_DestroyMutex(mJobStoppedLock);
+		mWakeUpSemaphore = nullptr;
+		mThreadsLock = nullptr;
+		mJobStoppedCondition = nullptr;
+		mJobStoppedLock = nullptr;
 	}
 
 	void JobManager::setMaxThreads(int count)
 	{
-		mMaxThreads = clamp(count, 0, 16);
+		mMaxThreads = (count < 0) ? -1 : clamp(count, 0, MAX_THREADS);
 	}
 
 	void JobManager::insertJob(JobBase& job)
 	{
+		SDL_AtomicLock(&job.mJobLock);
 		if (nullptr != job.mRegisteredAtManager)
 		{
-			if (job.mRegisteredAtManager != this)
-				return;
-			if (job.mJobState != JobBase::JobState::INACTIVE && job.mJobState != JobBase::JobState::DONE)
-				return;
-
-			// Job is already registered here, but needs to have its state reset back to waiting
+			// Job is either registered at another manager, or already waiting or running here
+			SDL_AtomicUnlock(&job.mJobLock);
+			return;
 		}
-		else
+
+		// Register job here
+		job.mRegisteredAtManager = this;
+		++mNumRegisteredJobs;
+		job.mJobState = JobBase::JobState::WAITING;
+		SDL_AtomicUnlock(&job.mJobLock);
+
+		if (getEffectiveMaxThreads() == 0 && mNumThreads == 0)
 		{
-			// Register job here
-			job.mRegisteredAtManager = this;
+			// In case there are no worker threads, execute on the calling thread
+			job.executeOnCallingThread();
 
-			// Make sure we have enough worker threads
-			//  -> TODO: Only create a new one if all existing threads are actually busy
-			const int index = (int)mThreads.size();
-			if (index < mMaxThreads)
-			{
-				JobWorkerThread* thread = new JobWorkerThread(*this, index);
-				mThreads.push_back(thread);
-				thread->startThread();
-			}
+			SDL_AtomicLock(&job.mJobLock);
+			job.mRegisteredAtManager = nullptr;
+			--mNumRegisteredJobs;
+			SDL_AtomicUnlock(&job.mJobLock);
+			return;
 		}
 
-		// Job is ready to be processed
-		job.mJobState = JobBase::JobState::WAITING;
+		// Job is ready to be processed by the next worker looking for work
+		//  -> Unless it's still queued from before being removed, in which case that entry is valid again
+		if (!job.mJobQueued.exchange(true))
+			pushInsertedJob(job);
 
-		// Wake up a thread
-		if (!mThreads.empty())
+		// Start another worker thread only if all existing ones are busy
+		bool startedThread = false;
+		if (mNumSleepingThreads == 0 && mNumThreads < getEffectiveMaxThreads())
 		{
-			SDL_LockMutex(mConditionLock);
-			mJobs.push_back(&job);
-			SDL_CondSignal(mConditionVariable);
-			SDL_UnlockMutex(mConditionLock);
+			// Check again under the lock, another thread might have started a worker in the meantime
+			SDL_LockMutex(mThreadsLock);
+			const int numThreads = mNumThreads;
+			if (mNumSleepingThreads == 0 && numThreads < getEffectiveMaxThreads() && mSearchForJobs)
+			{
+				JobWorkerThread* thread = new JobWorkerThread(*this, numThreads);
+				mThreads[numThreads] = thread;
+				mNumThreads = numThreads + 1;
+				thread->startThread();
+				startedThread = true;
+			}
+			SDL_UnlockMutex(mThreadsLock);
 		}
-		else
+
+		if (!startedThread)
 		{
-			// In case there are no worker threads, execute on the calling thread
-			job.executeOnCallingThread();
+			wakeUpWorker();
 		}
 	}
 
@@ -83,160 +104,184 @@ namespace rmx
 
 	void JobManager::removeJob(JobBase& job)
 	{
+		SDL_AtomicLock(&job.mJobLock);
 		if (job.mRegisteredAtManager != this)
+		{
+			SDL_AtomicUnlock(&job.mJobLock);
 			return;
+		}
 
-		bool wasRemoved = false;
-		SDL_LockMutex(mConditionLock);
-		for (size_t i = 0; i < mJobs.size(); ++i)
+		job.mRegisteredAtManager = nullptr;
+		--mNumRegisteredJobs;
+		job.mJobPriority = -1.0f;
+		job.mJobShouldBeRunning = false;
+
+		// A waiting job can't get started by any worker after this
+		//  -> This must be an atomic change, as a worker might just be starting the job; in that case, wait for it to stop below
+		JobBase::JobState expected = JobBase::JobState::WAITING;
+		job.mJobState.compare_exchange_strong(expected, JobBase::JobState::INACTIVE);
+		SDL_AtomicUnlock(&job.mJobLock);
+
+		// Wait until job execution is done
+		waitForJobStop(job);
+
+		// Remove any references to the job, first from the inserted jobs, then from the worker queues
+		//  -> Workers only pick up inserted jobs while holding their queue lock, so the job can't slip through in between
+		JobBase* insertedJob = takeInsertedJobs();
+		bool pushedJobs = false;
+		while (nullptr != insertedJob)
 		{
-			if (mJobs[i] == &job)
+			JobBase* nextJob = insertedJob->mNextInsertedJob;
+			if (insertedJob != &job)
 			{
-				// Swap with last
-				if (i + 1 < mJobs.size())
-				{
-					mJobs[i] = mJobs.back();
-				}
-				mJobs.pop_back();
-				wasRemoved = true;
+				pushInsertedJob(*insertedJob);
+				pushedJobs = true;
 			}
+			insertedJob = nextJob;
 		}
-		job.mRegisteredAtManager = nullptr;
-		SDL_UnlockMutex(mConditionLock);
 
-		if (wasRemoved)
+		// A worker might have gone to sleep while the other jobs were taken out
+		if (pushedJobs)
 		{
-			// Wait until job execution is done
-			job.mJobPriority = -1.0f;
-			job.mJobShouldBeRunning = false;
-			while (job.mJobState == JobBase::JobState::RUNNING)
-			{
-				SDL_Delay(1);
-			}
+			wakeUpWorker();
+		}
+
+		const int numThreads = mNumThreads;
+		for (int k = 0; k < numThreads; ++k)
+		{
+			mThreads[k]->removeJob(job);
+		}
+		job.mJobQueued = false;
+
+		// In case the job got inserted again in the meantime, its entry might just have been removed
+		if (job.mJobState == JobBase::JobState::WAITING && !job.mJobQueued.exchange(true))
+		{
+			pushInsertedJob(job);
+			wakeUpWorker();
 		}
 	}
 
 	int JobManager::getFinishedCount()
 	{
-		int count = 0;
-		SDL_LockMutex(mConditionLock);
-		for (JobBase* job : mJobs)
+		// Finished jobs get unregistered right away
+		return 0;
+	}
+
+	void JobManager::getJobList(std::vector<JobBase*>& output)
+	{
+		output.clear();
+		const int numThreads = mNumThreads;
+		for (int k = 0; k < numThreads; ++k)
 		{
-			if (job->isJobDone())
-				++count;
+			JobWorkerThread& thread = *mThreads[k];
+			SDL_LockMutex(thread.mQueueLock);
+			output.insert(output.end(), thread.mQueue.begin(), thread.mQueue.end());
+			JobBase* runningJob = thread.mRunningJob;
+			if (nullptr != runningJob)
+				output.push_back(runningJob);
+			SDL_UnlockMutex(thread.mQueueLock);
 		}
-		SDL_UnlockMutex(mConditionLock);
-		return count;
 	}
 
-	JobBase* JobManager::getNextJob()
+	void JobManager::onJobChanged()
 	{
-		SDL_LockMutex(mConditionLock);
-		JobBase* job = getNextJobInternal();
-		SDL_UnlockMutex(mConditionLock);
-		return job;
+		wakeUpWorker();
 	}
 
-	JobBase* JobManager::getNextJobBlocking()
+	void JobManager::pushInsertedJob(JobBase& job)
 	{
-		// Wait until there's at leat one job available
-		SDL_LockMutex(mConditionLock);
-		JobBase* job = getNextJobInternal();
-		while (nullptr == job && mSearchforJobs)
+		JobBase* head = mInsertedJobs.load();
+		do
 		{
-			// Using a time-out for two reasons:
-			//  - to have a chance to check if "mShouldBeRunning" changed outside
-			//  - to react to a delayed job, if there's no other jobs at the moment
-			uint32 timeoutMilliseconds = 100;
-			if (mNextDelayedJobTicks != 0xffffffff)
-			{
-				const uint32 currentTicks = SDL_GetTicks();
-				if (mNextDelayedJobTicks > currentTicks)
-					timeoutMilliseconds = mNextDelayedJobTicks - currentTicks;
-			}
-			SDL_CondWaitTimeout(mConditionVariable, mConditionLock, timeoutMilliseconds);
-			job = getNextJobInternal();
+			job.mNextInsertedJob = head;
 		}
-		SDL_UnlockMutex(mConditionLock);
-		return job;
+		while (!mInsertedJobs.compare_exchange_weak(head, &job));
 	}
 
-	void JobManager::getJobList(std::vector<JobBase*>& output)
+	JobBase* JobManager::takeInsertedJobs()
 	{
-		SDL_LockMutex(mConditionLock);
-		output = mJobs;
-		SDL_UnlockMutex(mConditionLock);
+		return mInsertedJobs.exchange(nullptr);
 	}
 
-	void JobManager::onJobChanged()
+	int JobManager::getEffectiveMaxThreads() const
 	{
-		SDL_LockMutex(mConditionLock);
-		SDL_CondSignal(mConditionVariable);
-		SDL_UnlockMutex(mConditionLock);
+		if (mMaxThreads >= 0)
+			return mMaxThreads;
+
+		// Leave one core for the main thread, and don't go overboard, as jobs are usually short-running
+		return clamp(SDL_GetCPUCount() - 1, 1, 4);
 	}
 
-	JobBase* JobManager::getNextJobInternal()
+	void JobManager::wakeUpWorker()
 	{
-		// Select waiting job with highest priority
-		mNextDelayedJobTicks = 0xffffffff;	// This will get updated as well
-		JobBase* bestJob = nullptr;
-		const uint32 currentTicks = SDL_GetTicks();
-		for (JobBase* job : mJobs)
+		++mWakeUpCounter;
+		if (mNumSleepingThreads > 0)
 		{
-			if (job->mJobState == JobBase::JobState::WAITING)
-			{
-				if (job->mJobDelayUntilTicks <= currentTicks)
-				{
-					if (nullptr == bestJob || job->mJobPriority > bestJob->mJobPriority)
-					{
-						bestJob = job;
-					}
-				}
-				else
-				{
-					if (job->mJobPriority >= 0.0f && job->mJobDelayUntilTicks < mNextDelayedJobTicks)
-					{
-						mNextDelayedJobTicks = job->mJobDelayUntilTicks;
-					}
-				}
-			}
+			SDL_SemPost(mWakeUpSemaphore);
 		}
-		if (nullptr != bestJob)
+	}
+
+	void JobManager::waitForJobStop(JobBase& job)
+	{
+		SDL_LockMutex(mJobStoppedLock);
+		++mNumWaitingForJobStop;
+		while (job.mJobState == JobBase::JobState::RUNNING)
 		{
-			// Ignore priorities below 0.0f
-			if (bestJob->mJobPriority >= 0.0f)
-			{
-				bestJob->mJobShouldBeRunning = true;
-				bestJob->mJobState = JobBase::JobState::RUNNING;
-			}
-			else
-			{
-				bestJob = nullptr;
-			}
+			SDL_CondWait(mJobStoppedCondition, mJobStoppedLock);
+		}
+		--mNumWaitingForJobStop;
+		SDL_UnlockMutex(mJobStoppedLock);
+
+		// Make sure the worker is completely done with changing the job
+		SDL_AtomicLock(&job.mJobLock);
+		SDL_AtomicUnlock(&job.mJobLock);
+	}
+
+	void JobManager::onJobStopped()
+	{
+		// Only signal if anyone is actually waiting, to keep workers from contending on the lock
+		if (mNumWaitingForJobStop > 0)
+		{
+			SDL_LockMutex(mJobStoppedLock);
+			SDL_CondBroadcast(mJobStoppedCondition);
+			SDL_UnlockMutex(mJobStoppedLock);
 		}
-		return bestJob;
 	}
 
 	void JobManager::stopAllThreads()
 	{
-		mSearchforJobs = false;
-		for (JobWorkerThread* thread : mThreads)
+		if (nullptr == mThreadsLock)
+			return;
+
+		SDL_LockMutex(mThreadsLock);
+		mSearchForJobs = false;
+		const int numThreads = mNumThreads;
+		for (int k = 0; k < numThreads; ++k)
 		{
-			thread->signalStopThread(false);
+			mThreads[k]->signalStopThread(false);
+			SDL_SemPost(mWakeUpSemaphore);
 		}
-		for (JobWorkerThread* thread : mThreads)
+		for (int k = 0; k < numThreads; ++k)
 		{
-			thread->joinThread();
+			mThreads[k]->joinThread();
 		}
-		for (JobWorkerThread* thread : mThreads)
+		for (int k = 0; k < numThreads; ++k)
 		{
-			delete thread;
+			SAFE_DELETE(mThreads[k]);
 		}
-		mThreads.clear();
+		mNumThreads = 0;
+		SDL_UnlockMutex(mThreadsLock);
 	}
 
 
 
+	JobBase::~JobBase()
+	{
+		// A worker that just finished this job might still be about to release it
+		SDL_AtomicLock(&mJobLock);
+		SDL_AtomicUnlock(&mJobLock);
+	}
+
 	void JobBase::setJobPriority(float priority)
 	{
 		// Jobs with negative priority are deactivated, i.e. won't get processed
@@ -244,9 +289,10 @@ namespace rmx
 		const bool wakeUpThread = (mJobPriority < 0.0f && priority >= 0.0f);
 		mJobPriority = priority;
 
-		if (wakeUpThread && nullptr != mRegisteredAtManager)
+		JobManager* jobManager = mRegisteredAtManager;
+		if (wakeUpThread && nullptr != jobManager)
 		{
-			mRegisteredAtManager->onJobChanged();
+			jobManager->onJobChanged();
 		}
 	}
 
@@ -256,9 +302,10 @@ namespace rmx
 		const bool wakeUpThread = (sdlTicks < mJobDelayUntilTicks);
 		mJobDelayUntilTicks = sdlTicks;
 
-		if (wakeUpThread && nullptr != mRegisteredAtManager)
+		JobManager* jobManager = mRegisteredAtManager;
+		if (wakeUpThread && nullptr != jobManager)
 		{
-			mRegisteredAtManager->onJobChanged();
+			jobManager->onJobChanged();
 		}
 	}
 
@@ -302,34 +349,198 @@ namespace rmx
 
 
 	JobWorkerThread::JobWorkerThread(JobManager& jobManager, int index) :
-		mJobManager(jobManager)
+		mJobManager(jobManager),
+		mIndex(index)
+	{
+		mQueueLock = SDL_CreateMutex();
+	}
+
+	JobWorkerThread::~JobWorkerThread()
 	{
-		// Index goes unused at the moment
+		SDL_DestroyMutex(mQueueLock);
 	}
 
 	void JobWorkerThread::threadFunc()
 	{
-		while (mShouldBeRunning)
+		while (mShouldBeRunning && mJobManager.mSearchForJobs)
+		{
+			const uint32 wakeUpCounter = mJobManager.mWakeUpCounter;
+			uint32 nextDelayedJobTicks = 0xffffffff;
+			JobBase* job = getNextJob(nextDelayedJobTicks);
+			if (nullptr == job)
+			{
+				// Sleep until a job gets inserted or changed, using a time-out for two reasons:
+				//  - to have a chance to check if "mShouldBeRunning" changed outside
+				//  - to react to a delayed job, if there's no other jobs at the moment
+				uint32 timeoutMilliseconds = 100;
+				if (nextDelayedJobTicks != 0xffffffff)
+				{
+					const uint32 currentTicks = SDL_GetTicks();
+					timeoutMilliseconds = (nextDelayedJobTicks > currentTicks) ? std::min(nextDelayedJobTicks - currentTicks, timeoutMilliseconds) : 0;
+				}
+
+				// Check for changes again, as a job might have been inserted or changed right before the sleeping count got increased
+				++mJobManager.mNumSleepingThreads;
+				if (mJobManager.mWakeUpCounter == wakeUpCounter)
+				{
+					SDL_SemWaitTimeout(mJobManager.mWakeUpSemaphore, timeoutMilliseconds);
+				}
+				--mJobManager.mNumSleepingThreads;
+				continue;
+			}
+
+			// Execute job
+			mRunningJob = job;
+			const bool result = job->jobFunc();
+			mRunningJob = nullptr;
+
+			SDL_AtomicLock(&job->mJobLock);
+			if (result)
+			{
+				// Job is done
+				job->mJobState = JobBase::JobState::DONE;
+				if (job->mRegisteredAtManager == &mJobManager)
+				{
+					job->mJobPriority = -1.0f;
+					--mJobManager.mNumRegisteredJobs;
+					job->mRegisteredAtManager = nullptr;
+				}
+			}
+			else if (job->mRegisteredAtManager == &mJobManager)
+			{
+				// Set back to waiting state, and keep it in this worker's queue
+				//  -> Note that the job's priority might have changed, or there's another job with higher priority now, so don't just continue with this job
+				job->mJobState = JobBase::JobState::WAITING;
+				if (!job->mJobQueued.exchange(true))
+					addJob(*job);
+			}
+			else
+			{
+				// Job got removed in the meantime
+				job->mJobState = JobBase::JobState::INACTIVE;
+			}
+			SDL_AtomicUnlock(&job->mJobLock);
+
+			mJobManager.onJobStopped();
+		}
+	}
+
+	JobBase* JobWorkerThread::getNextJob(uint32& outNextDelayedJobTicks)
+	{
+		const uint32 currentTicks = SDL_GetTicks();
+
+		// Prefer own jobs, incl. all jobs inserted since the last check
+		SDL_LockMutex(mQueueLock);
+		JobBase* insertedJob = mJobManager.takeInsertedJobs();
+		while (nullptr != insertedJob)
+		{
+			mQueue.push_back(insertedJob);
+			insertedJob = insertedJob->mNextInsertedJob;
+		}
+		JobBase* job = takeBestJob(currentTicks, outNextDelayedJobTicks);
+		SDL_UnlockMutex(mQueueLock);
+		if (nullptr != job)
+			return job;
+
+		// Steal from other workers, the job will stay with this worker afterwards
+		const int numThreads = mJobManager.mNumThreads;
+		for (int k = 1; k < numThreads; ++k)
 		{
-			JobBase* job = mJobManager.getNextJobBlocking();
+			JobWorkerThread& other = *mJobManager.mThreads[(mIndex + k) % numThreads];
+			SDL_LockMutex(other.mQueueLock);
+			job = other.takeBestJob(currentTicks, outNextDelayedJobTicks);
+			SDL_UnlockMutex(other.mQueueLock);
 			if (nullptr != job)
+				return job;
+		}
+		return nullptr;
+	}
+
+	JobBase* JobWorkerThread::takeBestJob(uint32 currentTicks, uint32& outNextDelayedJobTicks)
+	{
+		// Select waiting job with highest priority
+		while (true)
+		{
+			size_t bestIndex = mQueue.size();
+			float bestPriority = 0.0f;
+			for (size_t i = 0; i < mQueue.size(); )
 			{
-				// Execute job
-				const bool result = job->jobFunc();
-				if (result)
+				JobBase* job = mQueue[i];
+				if (job->mJobState != JobBase::JobState::WAITING)
+				{
+					// Job got removed, but not yet taken out of the queue
+					mQueue[i] = mQueue.back();
+					mQueue.pop_back();
+					dropQueueEntry(*job);
+					continue;
+				}
+
+				// Ignore priorities below 0.0f
+				const float priority = job->mJobPriority;
+				const uint32 delayUntilTicks = job->mJobDelayUntilTicks;
+				if (delayUntilTicks > currentTicks)
 				{
-					// Job is done
-					job->mJobState = JobBase::JobState::DONE;
-					job->mRegisteredAtManager->removeJob(*job);
+					if (priority >= 0.0f && delayUntilTicks < outNextDelayedJobTicks)
+						outNextDelayedJobTicks = delayUntilTicks;
 				}
-				else
+				else if (priority >= 0.0f && (bestIndex == mQueue.size() || priority > bestPriority))
 				{
-					// Set back to waiting state
-					//  -> Note that the job's priority might have changed, or there's another job with higher priority now, so don't just continue with this job
-					job->mJobState = JobBase::JobState::WAITING;
+					bestIndex = i;
+					bestPriority = priority;
 				}
+				++i;
+			}
+
+			if (bestIndex == mQueue.size())
+				return nullptr;
+
+			// The job might have been removed right now, in which case it must not get started any more
+			JobBase* job = mQueue[bestIndex];
+			mQueue[bestIndex] = mQueue.back();
+			mQueue.pop_back();
+
+			JobBase::JobState expected = JobBase::JobState::WAITING;
+			if (job->mJobState.compare_exchange_strong(expected, JobBase::JobState::RUNNING))
+			{
+				// Only signal the job to run now that it's really started, and don't overwrite a stop request of "removeJob" that came in between
+				job->mJobQueued = false;
+				job->mJobShouldBeRunning = true;
+				if (job->mRegisteredAtManager != &mJobManager)
+					job->mJobShouldBeRunning = false;
+				return job;
 			}
+			dropQueueEntry(*job);
+		}
+	}
+
+	void JobWorkerThread::dropQueueEntry(JobBase& job)
+	{
+		// The job might have been inserted again in the meantime, relying on this entry; then it has to be queued again
+		job.mJobQueued = false;
+		if (job.mJobState == JobBase::JobState::WAITING && !job.mJobQueued.exchange(true))
+		{
+			mQueue.push_back(&job);
+		}
+	}
+
+	void JobWorkerThread::addJob(JobBase& job)
+	{
+		SDL_LockMutex(mQueueLock);
+		mQueue.push_back(&job);
+		SDL_UnlockMutex(mQueueLock);
+	}
+
+	bool JobWorkerThread::removeJob(JobBase& job)
+	{
+		SDL_LockMutex(mQueueLock);
+		const auto it = std::find(mQueue.begin(), mQueue.end(), &job);
+		const bool found = (it != mQueue.end());
+		if (found)
+		{
+			mQueue.erase(it);
 		}
+		SDL_UnlockMutex(mQueueLock);
+		return found;
 	}
 
 }
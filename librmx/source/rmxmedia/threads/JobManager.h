@@ -6,11 +6,13 @@
 *	or https://www.gnu.org/licenses/gpl-3.0.en.html
 *
 *	JobManager
-*		Manages jobs to execute minor tasks in a separate thread.
+*		Manages jobs to execute minor tasks in separate threads.
 */
 
 #pragma once
 
+#include <atomic>
+
 
 namespace rmx
 {
@@ -19,46 +21,63 @@ namespace rmx
 
 
 	// Job manager
+	//  - Each worker thread has its own job queue, and steals jobs from other workers' queues when running out of work
+	//  - Newly inserted jobs go into a lock-free list first, which gets picked up by the next worker looking for work
+	//  - Worker threads get started on demand, i.e. only when all existing workers are busy
 	class JobManager
 	{
+	friend class JobWorkerThread;
+
+	public:
+		static const int MAX_THREADS = 16;
+
 	public:
 		JobManager();
 		~JobManager();
 
+		// Sets the maximum number of worker threads; a negative value means to choose automatically depending on the CPU count, and 0 to execute jobs on the calling thread
 		void setMaxThreads(int count);
 
 		void insertJob(JobBase& job);
 		void insertJob(JobBase& job, float priority);
 		void removeJob(JobBase& job);
 
-		int getJobCount()  { return (int)mJobs.size(); }
+		int getJobCount()  { return mNumRegisteredJobs; }
 		int getFinishedCount();
 
-		JobBase* getNextJob();
-		JobBase* getNextJobBlocking();
-
 		void getJobList(std::vector<JobBase*>& output);
 
 		void onJobChanged();
 
 	private:
-		JobBase* getNextJobInternal();
+		void pushInsertedJob(JobBase& job);
+		JobBase* takeInsertedJobs();
+		int getEffectiveMaxThreads() const;
+		void wakeUpWorker();
+		void waitForJobStop(JobBase& job);
+		void onJobStopped();
 		void stopAllThreads();
 
 	private:
-		SDL_cond* mConditionVariable = nullptr;
-		SDL_mutex* mConditionLock = nullptr;
-
-		// Worker threads
-		int mMaxThreads = 1;
-		std::vector<JobWorkerThread*> mThreads;
-
-		// Registered jobs
-		//  -> Not using a data structure optimized for getting the next job (using priority);
-		//     but that's probably overkill anyways if the number of active jobs is not more than a few dozens
-		std::vector<JobBase*> mJobs;
-		uint32 mNextDelayedJobTicks = 0;
-		bool mSearchforJobs = true;
+		// Worker threads, only ever get added while running, so workers can access them without locking
+		//  -> Adding and stopping threads is done under "mThreadsLock" though, as jobs might get inserted from multiple threads
+		int mMaxThreads = -1;
+		JobWorkerThread* mThreads[MAX_THREADS] = { nullptr };
+		std::atomic<int> mNumThreads = 0;
+		SDL_mutex* mThreadsLock = nullptr;
+		std::atomic<int> mNumSleepingThreads = 0;
+		std::atomic<uint32> mWakeUpCounter = 0;		// Incremented whenever a sleeping worker might have something to do
+		SDL_sem* mWakeUpSemaphore = nullptr;
+		std::atomic<bool> mSearchForJobs = true;
+
+		// Lock-free list of inserted jobs not yet picked up by a worker, linked via "JobBase::mNextInsertedJob"
+		std::atomic<JobBase*> mInsertedJobs = nullptr;
+		std::atomic<int> mNumRegisteredJobs = 0;
+
+		// Signaling of jobs that stopped running, for "removeJob"
+		SDL_mutex* mJobStoppedLock = nullptr;
+		SDL_cond* mJobStoppedCondition = nullptr;
+		std::atomic<int> mNumWaitingForJobStop = 0;
 	};
 
 
@@ -70,7 +89,7 @@ namespace rmx
 	friend class JobWorkerThread;
 
 	public:
-		inline virtual ~JobBase()  {}
+		virtual ~JobBase();
 
 		inline const String& getJobType() const		{ return mJobType; }
 
@@ -101,18 +120,21 @@ namespace rmx
 	private:
 		enum class JobState
 		{
-			INACTIVE,	// Initial state before being added to the job manager
+			INACTIVE,	// Initial state before being added to the job manager, and after being removed
 			WAITING,	// Waiting for execution
 			RUNNING,	// Currently being executed
 			DONE		// Job finished, nothing left to do
 		};
 
 	private:
-		JobManager* mRegisteredAtManager = nullptr;	// Job manager instance this is registered at (should actually always be FTX::JobManager or nullptr)
-		JobState mJobState = JobState::INACTIVE;	// Current state
-		bool mJobShouldBeRunning = false;			// Can be set to false while running to signal the jobFunc that it should abort
-		float mJobPriority = 0.0f;					// Priority, higher values will be preferred; jobs with negative priorities won't get processed at all
-		uint32 mJobDelayUntilTicks = 0;				// SDL ticks value until when the job should get delayed; 0 if no delay active (which is the default)
+		std::atomic<JobManager*> mRegisteredAtManager = nullptr;	// Job manager instance this is registered at (should actually always be FTX::JobManager or nullptr)
+		std::atomic<JobState> mJobState = JobState::INACTIVE;		// Current state; workers may only start a job by switching it from waiting to running
+		std::atomic<bool> mJobShouldBeRunning = false;				// Can be set to false while running to signal the jobFunc that it should abort
+		std::atomic<bool> mJobQueued = false;						// Set while the job has an entry in the list of inserted jobs or in a worker queue, so it never gets queued twice
+		std::atomic<float> mJobPriority = 0.0f;						// Priority, higher values will be preferred; jobs with negative priorities won't get processed at all
+		std::atomic<uint32> mJobDelayUntilTicks = 0;				// SDL ticks value until when the job should get delayed; 0 if no delay active (which is the default)
+		SDL_SpinLock mJobLock = 0;									// Guards changes of registration and state between job manager calls and worker threads
+		JobBase* mNextInsertedJob = nullptr;						// Only used while in the job manager's list of inserted jobs
 	};
 
 
@@ -120,14 +142,30 @@ namespace rmx
 	// Worker thread processing jobs
 	class JobWorkerThread final : public ThreadBase
 	{
+	friend class JobManager;
+
 	public:
 		JobWorkerThread(JobManager& jobManager, int index);
+		~JobWorkerThread();
+
 		void threadFunc();
 
-	public:
-		float mInactivityDelay = 0.1f;
+	private:
+		JobBase* getNextJob(uint32& outNextDelayedJobTicks);
+		JobBase* takeBestJob(uint32 currentTicks, uint32& outNextDelayedJobTicks);
+		void addJob(JobBase& job);
+		bool removeJob(JobBase& job);
+		void dropQueueEntry(JobBase& job);
 
 	private:
 		JobManager& mJobManager;
+		const int mIndex;
+
+		// Jobs owned by this worker
+		//  -> Not using a data structure optimized for getting the next job (using priority);
+		//     but that's probably overkill anyways if the number of active jobs is not more than a few dozens
+		SDL_mutex* mQueueLock = nullptr;
+		std::vector<JobBase*> mQueue;
+		std::atomic<JobBase*> mRunningJob = nullptr;
 	};
 }
@@ -87,9 +87,11 @@ namespace rmx
 
 	void ThreadBase::joinThread()
 	{
-		if (mIsThreadRunning && nullptr != mSDLThread)
+		// Wait even if the thread already left its thread function, as it might still be about to return from it
+		if (nullptr != mSDLThread)
 		{
 			SDL_WaitThread(mSDLThread, nullptr);
+			mSDLThread = nullptr;
 		}
 	}
 
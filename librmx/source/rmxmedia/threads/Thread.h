@@ -26,6 +26,7 @@ namespace rmx
 		inline ~Mutex()		 { SDL_DestroyMutex(mMutex); }
 
 		inline void lock()	 { SDL_LockMutex(mMutex); }
+		inline bool tryLock() { return (SDL_TryLockMutex(mMutex) == 0); }
 		inline void unlock() { SDL_UnlockMutex(mMutex); }
 
 	private: